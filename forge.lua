@@ -73,6 +73,8 @@ buildfile 'src/zlib/zlib.forge';
 cc:all {
     'src/lalr/all',
     'src/reyes/all',
+    'src/reyes/reyes_benchmark/all',
     'src/reyes/reyes_examples/all',
+    'src/reyes/reyes_shaderc/all',
     'src/reyes/reyes_test/all'
 };
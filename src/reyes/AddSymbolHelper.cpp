@@ -39,7 +39,7 @@ AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*fun
     return *this;
 }
 
-AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, std::shared_ptr<Value> a0), ValueType type, ValueStorage storage )
+AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, Value* a0), ValueType type, ValueStorage storage )
 {
     REYES_ASSERT( symbol_table_ );
 
@@ -50,7 +50,7 @@ AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*fun
     return *this;
 }
 
-AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, std::shared_ptr<Value> a0, std::shared_ptr<Value> a1), ValueType type, ValueStorage storage )
+AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, Value* a0, Value* a1), ValueType type, ValueStorage storage )
 {
     REYES_ASSERT( symbol_table_ );
 
@@ -61,7 +61,7 @@ AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*fun
     return *this;
 }
 
-AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, std::shared_ptr<Value> a0, std::shared_ptr<Value> a1, std::shared_ptr<Value> a2), ValueType type, ValueStorage storage )
+AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, Value* a0, Value* a1, Value* a2), ValueType type, ValueStorage storage )
 {
     REYES_ASSERT( symbol_table_ );
 
@@ -72,7 +72,7 @@ AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*fun
     return *this;
 }
 
-AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, std::shared_ptr<Value> a0, std::shared_ptr<Value> a1, std::shared_ptr<Value> a2, std::shared_ptr<Value> a3), ValueType type, ValueStorage storage )
+AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, Value* a0, Value* a1, Value* a2, Value* a3), ValueType type, ValueStorage storage )
 {
     REYES_ASSERT( symbol_table_ );
 
@@ -83,7 +83,7 @@ AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*fun
     return *this;
 }
 
-AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, std::shared_ptr<Value> a0, std::shared_ptr<Value> a1, std::shared_ptr<Value> a2, std::shared_ptr<Value> a3, std::shared_ptr<Value> a4), ValueType type, ValueStorage storage )
+AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, Value* a0, Value* a1, Value* a2, Value* a3, Value* a4), ValueType type, ValueStorage storage )
 {
     REYES_ASSERT( symbol_table_ );
 
@@ -94,7 +94,7 @@ AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*fun
     return *this;
 }
 
-AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, std::shared_ptr<Value> a0, std::shared_ptr<Value> a1, std::shared_ptr<Value> a2, std::shared_ptr<Value> a3, std::shared_ptr<Value> a4, std::shared_ptr<Value> a5), ValueType type, ValueStorage storage )
+AddSymbolHelper& AddSymbolHelper::operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, Value* a0, Value* a1, Value* a2, Value* a3, Value* a4, Value* a5), ValueType type, ValueStorage storage )
 {
     REYES_ASSERT( symbol_table_ );
     
@@ -28,12 +28,12 @@ public:
     AddSymbolHelper( SymbolTable* symbol_table );
     AddSymbolHelper& operator()( const char* identifier, ValueType type, ValueStorage storage = STORAGE_VARYING );
     AddSymbolHelper& operator()( const char* identifier, void (*function)(const Renderer&, const Grid&), ValueType type, ValueStorage storage = STORAGE_VARYING );
-    AddSymbolHelper& operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, std::shared_ptr<Value> a0), ValueType type, ValueStorage storage = STORAGE_VARYING );
-    AddSymbolHelper& operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, std::shared_ptr<Value> a0, std::shared_ptr<Value> a1), ValueType type, ValueStorage storage = STORAGE_VARYING );
-    AddSymbolHelper& operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, std::shared_ptr<Value> a0, std::shared_ptr<Value> a1, std::shared_ptr<Value> a2), ValueType type, ValueStorage storage = STORAGE_VARYING );
-    AddSymbolHelper& operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, std::shared_ptr<Value> a0, std::shared_ptr<Value> a1, std::shared_ptr<Value> a2, std::shared_ptr<Value> a3), ValueType type, ValueStorage storage = STORAGE_VARYING );
-    AddSymbolHelper& operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, std::shared_ptr<Value> a0, std::shared_ptr<Value> a1, std::shared_ptr<Value> a2, std::shared_ptr<Value> a3, std::shared_ptr<Value> a4), ValueType type, ValueStorage storage = STORAGE_VARYING );
-    AddSymbolHelper& operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, std::shared_ptr<Value> a0, std::shared_ptr<Value> a1, std::shared_ptr<Value> a2, std::shared_ptr<Value> a3, std::shared_ptr<Value> a4, std::shared_ptr<Value> a5), ValueType type, ValueStorage storage = STORAGE_VARYING );
+    AddSymbolHelper& operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, Value* a0), ValueType type, ValueStorage storage = STORAGE_VARYING );
+    AddSymbolHelper& operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, Value* a0, Value* a1), ValueType type, ValueStorage storage = STORAGE_VARYING );
+    AddSymbolHelper& operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, Value* a0, Value* a1, Value* a2), ValueType type, ValueStorage storage = STORAGE_VARYING );
+    AddSymbolHelper& operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, Value* a0, Value* a1, Value* a2, Value* a3), ValueType type, ValueStorage storage = STORAGE_VARYING );
+    AddSymbolHelper& operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, Value* a0, Value* a1, Value* a2, Value* a3, Value* a4), ValueType type, ValueStorage storage = STORAGE_VARYING );
+    AddSymbolHelper& operator()( const char* identifier, void (*function)(const Renderer&, const Grid&, Value* a0, Value* a1, Value* a2, Value* a3, Value* a4, Value* a5), ValueType type, ValueStorage storage = STORAGE_VARYING );
     AddSymbolHelper& operator()( ValueType type, ValueStorage storage = STORAGE_VARYING );
     AddSymbolHelper& operator()( const char* identifier, float value );
 };
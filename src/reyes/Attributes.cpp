@@ -35,9 +35,9 @@ Attributes::Attributes( VirtualMachine* virtual_machine )
   opacity_( 1.0f, 1.0f, 1.0f ),
   u_basis_( NULL ),
   v_basis_( NULL ),
-  displacement_parameters_( NULL ),
+  displacement_parameters_(),
   displacement_shader_( NULL ),
-  surface_parameters_( NULL ),
+  surface_parameters_(),
   surface_shader_( NULL ),
   light_shaders_(),
   active_light_shaders_(),
@@ -45,8 +45,8 @@ Attributes::Attributes( VirtualMachine* virtual_machine )
   named_transforms_()
 {
     REYES_ASSERT( virtual_machine_ );
-    displacement_parameters_ = new Grid();
-    surface_parameters_ = new Grid();
+    displacement_parameters_.reset( new Grid() );
+    surface_parameters_.reset( new Grid() );
 
     const unsigned int LIGHT_SHADERS_RESERVE = 32;
     light_shaders_.reserve( LIGHT_SHADERS_RESERVE );
@@ -67,9 +67,9 @@ Attributes::Attributes( const Attributes& attributes )
   opacity_( attributes.opacity_ ),
   u_basis_( attributes.u_basis_ ),
   v_basis_( attributes.v_basis_ ),
-  displacement_parameters_( NULL ),
+  displacement_parameters_( attributes.displacement_parameters_ ),
   displacement_shader_( attributes.displacement_shader_ ),
-  surface_parameters_( NULL ),
+  surface_parameters_( attributes.surface_parameters_ ),
   surface_shader_( attributes.surface_shader_ ),
   light_shaders_( attributes.light_shaders_ ),
   active_light_shaders_( attributes.active_light_shaders_ ),
@@ -77,17 +77,10 @@ Attributes::Attributes( const Attributes& attributes )
   named_transforms_( attributes.named_transforms_ )
 {
     REYES_ASSERT( virtual_machine_ );
-    displacement_parameters_ = new Grid( *attributes.displacement_parameters_ );
-    surface_parameters_ = new Grid( *attributes.surface_parameters_ );
 }
 
 Attributes::~Attributes()
 {
-    delete surface_parameters_;
-    surface_parameters_ = NULL;
-    
-    delete displacement_parameters_;
-    displacement_parameters_ = NULL;
 }
 
 float Attributes::shading_rate() const
@@ -183,6 +176,46 @@ void Attributes::set_v_basis( const math::vec4* v_basis )
     v_basis_ = v_basis;
 }
 
+void Attributes::set_virtual_machine( VirtualMachine* virtual_machine )
+{
+    REYES_ASSERT( virtual_machine );
+    virtual_machine_ = virtual_machine;
+}
+
+/**
+// Replace the shader parameters shared with the attributes that these were
+// copied from with private copies.
+//
+// The virtual machine binds parameter values directly into registers and
+// shaders may assign to their parameters so attributes used to shade on 
+// one thread mustn't share parameters with attributes used on another.
+*/
+void Attributes::copy_shader_parameters()
+{
+    if ( displacement_parameters_ )
+    {
+        displacement_parameters_.reset( new Grid(*displacement_parameters_) );
+    }
+
+    if ( surface_parameters_ )
+    {
+        surface_parameters_.reset( new Grid(*surface_parameters_) );
+    }
+
+    for ( vector<pair<Shader*, shared_ptr<Grid> > >::iterator i = light_shaders_.begin(); i != light_shaders_.end(); ++i )
+    {
+        shared_ptr<Grid> light_parameters( new Grid(*i->second) );
+        for ( vector<Grid*>::iterator j = active_light_shaders_.begin(); j != active_light_shaders_.end(); ++j )
+        {
+            if ( *j == i->second.get() )
+            {
+                *j = light_parameters.get();
+            }
+        }
+        i->second = light_parameters;
+    }
+}
+
 void Attributes::displacement_shade( Grid& grid )
 {
     if ( displacement_shader_ )
@@ -193,13 +226,19 @@ void Attributes::displacement_shade( Grid& grid )
         virtual_machine_->shade( grid, *displacement_parameters_, *displacement_shader_ );
         remove_coordinate_system( "shader" );
         remove_coordinate_system( "current" );
-        grid.generate_normals(  geometry_left_handed(), true );
+
+        // Normals only need to be regenerated if the shader could have 
+        // moved P.
+        if ( displacement_shader_->global_register(GRID_SLOT_P) >= 0 )
+        {
+            grid.generate_normals( geometry_left_handed(), true );
+        }
     }
 }
 
 void Attributes::set_displacement_shader( Shader* displacement_shader, const math::mat4x4& camera_transform )
 {
-    displacement_parameters_->clear();
+    displacement_parameters_.reset( new Grid() );
     displacement_shader_ = displacement_shader;
     if ( displacement_shader_ )
     {
@@ -229,28 +268,28 @@ void Attributes::surface_shade( Grid& grid )
         grid.generate_normals( geometry_left_handed() );
         light_shade( grid );
 
-        Value& incident_color = grid.value( "Ci", TYPE_COLOR );
+        Value& incident_color = grid.value( GRID_SLOT_CI, TYPE_COLOR );
         incident_color.zero();
 
-        Value& incident_opacity = grid.value( "Oi", TYPE_COLOR );
+        Value& incident_opacity = grid.value( GRID_SLOT_OI, TYPE_COLOR );
         incident_opacity.zero();
 
         // @todo
         //  Adjust the 'I' value in a surface shader if 'P' is not in eye space.
-        if ( !grid.find_value("I") )
+        if ( !grid.find_value(GRID_SLOT_I) )
         {
-            grid.insert_value( "I", grid.find_value("P") );
+            grid.insert_value( GRID_SLOT_I, grid.find_value(GRID_SLOT_P) );
         }
         
-        Value& P = grid["P"];
-        Value& Os = grid.value( "Os", TYPE_COLOR );
+        Value& P = grid[GRID_SLOT_P];
+        Value& Os = grid.value( GRID_SLOT_OS, TYPE_COLOR );
         vec3* values = Os.vec3_values();
         for ( unsigned int i = 0; i < P.size(); ++i )
         {
             values[i] = opacity_;
         }
 
-        Value& Cs = grid.value( "Cs", TYPE_COLOR );
+        Value& Cs = grid.value( GRID_SLOT_CS, TYPE_COLOR );
         values = Cs.vec3_values();
         for ( unsigned int i = 0; i < P.size(); ++i )
         {
@@ -267,7 +306,7 @@ void Attributes::surface_shade( Grid& grid )
 
 void Attributes::set_surface_shader( Shader* surface_shader, const math::mat4x4& camera_transform )
 {
-    surface_parameters_->clear();
+    surface_parameters_.reset( new Grid() );
     surface_shader_ = surface_shader;
     if ( surface_shader_ )
     {
@@ -302,8 +341,9 @@ void Attributes::light_shade( Grid& grid )
         REYES_ASSERT( shader );
         
         Grid light_grid;
+        light_grid.set_value_pool( grid.value_pool() );
         light_grid.resize( grid.width(), grid.height() );
-        light_grid.insert_value( "Ps", grid.find_value("P") );
+        light_grid.insert_value( GRID_SLOT_PS, grid.find_value(GRID_SLOT_P) );
         
         add_coordinate_system( "current", math::identity() );
         add_coordinate_system( "shader", light_parameters->get_transform() );
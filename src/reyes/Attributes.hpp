@@ -22,7 +22,7 @@ class VirtualMachine;
 */
 class Attributes
 {
-    VirtualMachine* virtual_machine_; ///< The VirtualMachine used to initialize shader parameters.
+    VirtualMachine* virtual_machine_; ///< The VirtualMachine used to initialize shader parameters and execute shaders.
     float shading_rate_; ///< The current shading rate.
     bool matte_; ///< The current matte object flag.
     bool two_sided_; ///< The current two sided object flag.
@@ -32,9 +32,9 @@ class Attributes
     math::vec3 opacity_; ///< The current opacity.
     const math::vec4 *u_basis_; ///< The 4 rows that define the cubic basis in the u direction for patches.
     const math::vec4 *v_basis_; ///< The 4 rows that define the cubic basis in the u direction for patches.
-    Grid* displacement_parameters_; ///< The parameters for the currently active displacement shader.
+    std::shared_ptr<Grid> displacement_parameters_; ///< The parameters for the currently active displacement shader (shared with copies until the shader is next set).
     Shader* displacement_shader_; ///< The currently active displacement shader or null if there is no displacement shader.
-    Grid* surface_parameters_; ///< The parameters for the currently active surface shader.
+    std::shared_ptr<Grid> surface_parameters_; ///< The parameters for the currently active surface shader (shared with copies until the shader is next set).
     Shader* surface_shader_; ///< The currently active surface shader or null if there is no surface shader.
     std::vector<std::pair<Shader*, std::shared_ptr<Grid> > > light_shaders_; ///< The currently allocated light shaders.
     std::vector<Grid*> active_light_shaders_; ///< The currently active light shaders.
@@ -67,6 +67,8 @@ public:
     void set_opacity( const math::vec3& opacity );
     void set_u_basis( const math::vec4* u_basis );
     void set_v_basis( const math::vec4* v_basis );
+    void set_virtual_machine( VirtualMachine* virtual_machine );
+    void copy_shader_parameters();
 
     void displacement_shade( Grid& grid );
     void set_displacement_shader( Shader* displacement_shader, const math::mat4x4& camera_transform );
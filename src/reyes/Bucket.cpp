@@ -0,0 +1,72 @@
+//
+// Bucket.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "stdafx.hpp"
+#include "Bucket.hpp"
+#include "assert.hpp"
+
+using std::vector;
+using namespace reyes;
+
+Bucket::Bucket( int x0, int x1, int y0, int y1 )
+: x0_( x0 ),
+  x1_( x1 ),
+  y0_( y0 ),
+  y1_( y1 ),
+  primitives_()
+{
+    REYES_ASSERT( x0_ >= 0 && x0_ < x1_ );
+    REYES_ASSERT( y0_ >= 0 && y0_ < y1_ );
+}
+
+Bucket::~Bucket()
+{
+}
+
+int Bucket::x0() const
+{
+    return x0_;
+}
+
+int Bucket::x1() const
+{
+    return x1_;
+}
+
+int Bucket::y0() const
+{
+    return y0_;
+}
+
+int Bucket::y1() const
+{
+    return y1_;
+}
+
+int Bucket::width() const
+{
+    return x1_ - x0_;
+}
+
+int Bucket::height() const
+{
+    return y1_ - y0_;
+}
+
+const std::vector<Primitive>& Bucket::primitives() const
+{
+    return primitives_;
+}
+
+void Bucket::add_primitive( const Primitive& primitive )
+{
+    primitives_.push_back( primitive );
+}
+
+void Bucket::clear()
+{
+    primitives_.clear();
+    primitives_.shrink_to_fit();
+}
@@ -0,0 +1,39 @@
+#ifndef REYES_BUCKET_HPP_INCLUDED
+#define REYES_BUCKET_HPP_INCLUDED
+
+#include "Primitive.hpp"
+#include <vector>
+
+namespace reyes
+{
+
+/**
+// A rectangular region of the image and the primitives that overlap it.
+*/
+class Bucket
+{
+    int x0_; ///< The x coordinate of the left most pixel in this bucket.
+    int x1_; ///< The x coordinate one past the right most pixel in this bucket.
+    int y0_; ///< The y coordinate of the top most pixel in this bucket.
+    int y1_; ///< The y coordinate one past the bottom most pixel in this bucket.
+    std::vector<Primitive> primitives_; ///< The primitives that overlap this bucket.
+
+public:
+    Bucket( int x0, int x1, int y0, int y1 );
+    ~Bucket();
+
+    int x0() const;
+    int x1() const;
+    int y0() const;
+    int y1() const;
+    int width() const;
+    int height() const;
+    const std::vector<Primitive>& primitives() const;
+
+    void add_primitive( const Primitive& primitive );
+    void clear();
+};
+
+}
+
+#endif
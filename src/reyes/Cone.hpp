@@ -5,8 +5,6 @@
 #include <math/vec2.hpp>
 #include <math/vec3.hpp>
 #include <math/mat4x4.hpp>
-#include <list>
-#include <memory>
 
 namespace reyes
 {
@@ -21,18 +19,15 @@ class Cone : public Geometry
     
 public:
     Cone( float height, float radius, float thetamax );
-    Cone( const Cone& cone, const math::vec2& u_range, const math::vec2& v_range );
 
     bool boundable() const;
-    void bound( const math::mat4x4& transform, math::vec3* minimum, math::vec3* maximum ) const;
+    void bound( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, math::vec3* minimum, math::vec3* maximum ) const;
     bool splittable() const;
-    void split( std::list<std::shared_ptr<Geometry>>* primitives ) const;
     bool diceable() const;
-    void dice( const math::mat4x4& transform, int width, int height, Grid* grid ) const;
+    void dice( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, int width, int height, Grid* grid ) const;
 
 private:
-    math::vec3 position( float u, float v ) const;
-    math::vec3 normal( float u, float v ) const;    
+    void evaluate( float u, float v, math::vec3* position, math::vec3* dpdu, math::vec3* dpdv ) const;
 };
 
 }
@@ -12,33 +12,45 @@
 #include <math/mat4x4.ipp>
 #include "assert.hpp"
 #include <vector>
+#include <memory.h>
 #define _USE_MATH_DEFINES
 #include <math.h>
 
 using std::min;
 using std::max;
 using std::vector;
-using std::shared_ptr;
 using namespace math;
 using namespace reyes;
 
 CubicPatch::CubicPatch( const math::vec3* p, const math::vec4* u_basis, const math::vec4* v_basis )
-: Geometry(vec2(0.0f, 1.0f), vec2(0.0f, 1.0f)),
-  p_( p ),
+: Geometry(),
   u_basis_( u_basis ),
   v_basis_( v_basis )
 {
-    REYES_ASSERT( p_ );
+    REYES_ASSERT( p );
     REYES_ASSERT( u_basis_ );
     REYES_ASSERT( v_basis_ );
-}
+    memcpy( p_, p, sizeof(p_) );
 
-CubicPatch::CubicPatch( const CubicPatch& patch, const math::vec2& u_range, const math::vec2& v_range )
-: Geometry(u_range, v_range),
-  p_( patch.p_ ),
-  u_basis_( patch.u_basis_ ),  
-  v_basis_( patch.v_basis_ )
-{
+    // Multiply the control points through by the basis matrices once so 
+    // that dicing only needs to evaluate a bicubic polynomial.
+    const float* u_matrix = reinterpret_cast<const float*>( u_basis_ );
+    const float* v_matrix = reinterpret_cast<const float*>( v_basis_ );
+    for ( int b = 0; b < 4; ++b )
+    {
+        for ( int a = 0; a < 4; ++a )
+        {
+            vec3 coefficient( 0.0f, 0.0f, 0.0f );
+            for ( int j = 0; j < 4; ++j )
+            {
+                for ( int i = 0; i < 4; ++i )
+                {
+                    coefficient += (u_matrix[i * 4 + a] * v_matrix[j * 4 + b]) * p_[j * 4 + i];
+                }
+            }
+            coefficients_[b * 4 + a] = coefficient;
+        }
+    }
 }
 
 bool CubicPatch::boundable() const
@@ -46,7 +58,7 @@ bool CubicPatch::boundable() const
     return true;
 }
 
-void CubicPatch::bound( const math::mat4x4& transform, math::vec3* minimum, math::vec3* maximum ) const
+void CubicPatch::bound( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, math::vec3* minimum, math::vec3* maximum ) const
 {
     REYES_ASSERT( minimum );
     REYES_ASSERT( maximum );
@@ -54,18 +66,52 @@ void CubicPatch::bound( const math::mat4x4& transform, math::vec3* minimum, math
     *minimum = vec3( FLT_MAX, FLT_MAX, FLT_MAX );
     *maximum = vec3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
     
-    Grid grid;
-    dice( transform, 8, 8, &grid );
-    const vec3* positions = grid["P"].vec3_values();
-    const vec3* positions_end = positions + grid["P"].size();
-    for ( const vec3* i = positions; i != positions_end; ++i )
+    // Express each basis function over the range in u and v as a cubic 
+    // Bezier curve so that the control points of the Bezier patch covering 
+    // the range can be found.  Their convex hull bounds the range of the 
+    // patch and, as the convex hull is preserved by affine transforms, the 
+    // bound of the transformed control points bounds the transformed patch.
+    vec4 u_weights [4];
+    vec4 v_weights [4];
+    for ( int i = 0; i < 4; ++i )
+    {
+        u_weights[i] = bezier_weights( u_basis_[i], u_range );
+        v_weights[i] = bezier_weights( v_basis_[i], v_range );
+    }
+
+    vec3 rows [16];
+    for ( int j = 0; j < 4; ++j )
     {
-        minimum->x = min( minimum->x, i->x );
-        minimum->y = min( minimum->y, i->y );
-        minimum->z = min( minimum->z, i->z );        
-        maximum->x = max( maximum->x, i->x );
-        maximum->y = max( maximum->y, i->y );
-        maximum->z = max( maximum->z, i->z );
+        const vec3* p = &p_[j * 4];
+        rows[j * 4 + 0] = u_weights[0].x * p[0] + u_weights[1].x * p[1] + u_weights[2].x * p[2] + u_weights[3].x * p[3];
+        rows[j * 4 + 1] = u_weights[0].y * p[0] + u_weights[1].y * p[1] + u_weights[2].y * p[2] + u_weights[3].y * p[3];
+        rows[j * 4 + 2] = u_weights[0].z * p[0] + u_weights[1].z * p[1] + u_weights[2].z * p[2] + u_weights[3].z * p[3];
+        rows[j * 4 + 3] = u_weights[0].w * p[0] + u_weights[1].w * p[1] + u_weights[2].w * p[2] + u_weights[3].w * p[3];
+    }
+
+    for ( int i = 0; i < 4; ++i )
+    {
+        const vec3 r0 = rows[0 * 4 + i];
+        const vec3 r1 = rows[1 * 4 + i];
+        const vec3 r2 = rows[2 * 4 + i];
+        const vec3 r3 = rows[3 * 4 + i];
+        const vec3 control_points [4] = 
+        {
+            v_weights[0].x * r0 + v_weights[1].x * r1 + v_weights[2].x * r2 + v_weights[3].x * r3,
+            v_weights[0].y * r0 + v_weights[1].y * r1 + v_weights[2].y * r2 + v_weights[3].y * r3,
+            v_weights[0].z * r0 + v_weights[1].z * r1 + v_weights[2].z * r2 + v_weights[3].z * r3,
+            v_weights[0].w * r0 + v_weights[1].w * r1 + v_weights[2].w * r2 + v_weights[3].w * r3
+        };
+        for ( int j = 0; j < 4; ++j )
+        {
+            const vec3 position = vec3( transform * vec4(control_points[j], 1.0f) );
+            minimum->x = min( minimum->x, position.x );
+            minimum->y = min( minimum->y, position.y );
+            minimum->z = min( minimum->z, position.z );
+            maximum->x = max( maximum->x, position.x );
+            maximum->y = max( maximum->y, position.y );
+            maximum->z = max( maximum->z, position.z );
+        }
     }
 }
 
@@ -74,114 +120,114 @@ bool CubicPatch::splittable() const
     return true;
 }
 
-void CubicPatch::split( std::list<std::shared_ptr<Geometry> >* primitives ) const
-{
-    REYES_ASSERT( primitives );
-    REYES_ASSERT( u_range().y >= u_range().x );
-    REYES_ASSERT( v_range().y >= v_range().x );
-
-    const vec2& u_range = Geometry::u_range();
-    float u0 = u_range.x;
-    float u1 = (u_range.x + u_range.y) / 2.0f;
-    float u2 = u_range.y;
-
-    const vec2& v_range = Geometry::v_range();
-    float v0 = v_range.x;
-    float v1 = (v_range.x + v_range.y) / 2.0f;
-    float v2 = v_range.y;
-
-    shared_ptr<Geometry> cubic_patch;
-    cubic_patch.reset( new CubicPatch(*this, vec2(u0, u1), vec2(v0, v1)) );
-    primitives->push_back( cubic_patch );
-    cubic_patch.reset( new CubicPatch(*this, vec2(u0, u1), vec2(v1, v2)) );
-    primitives->push_back( cubic_patch );
-    cubic_patch.reset( new CubicPatch(*this, vec2(u1, u2), vec2(v0, v1)) );
-    primitives->push_back( cubic_patch );
-    cubic_patch.reset( new CubicPatch(*this, vec2(u1, u2), vec2(v1, v2)) );
-    primitives->push_back( cubic_patch );
-}
-
 bool CubicPatch::diceable() const
 {
     return true;
 }
 
-void CubicPatch::dice( const math::mat4x4& transform, int width, int height, Grid* grid ) const
+void CubicPatch::dice( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, int width, int height, Grid* grid ) const
 {
     REYES_ASSERT( width > 0 );
     REYES_ASSERT( height > 0 );
     REYES_ASSERT( grid );
     
-    const vec2& u_range = Geometry::u_range();
-    const vec2& v_range = Geometry::v_range();
-
     grid->resize( width, height );
     grid->du_ = (u_range.y - u_range.x) / float(width - 1);
     grid->dv_ = (v_range.y - v_range.x) / float(height - 1);
     
-    vec3* positions = grid->value( "P", TYPE_POINT ).vec3_values();
-    float* s = grid->value( "s", TYPE_FLOAT ).float_values();
-    float* t = grid->value( "t", TYPE_FLOAT ).float_values();
+    vec3* positions = grid->value( GRID_SLOT_P, TYPE_POINT ).vec3_values();
+    vec3* u_derivatives = grid->value( GRID_SLOT_DPDU, TYPE_VECTOR ).vec3_values();
+    vec3* v_derivatives = grid->value( GRID_SLOT_DPDV, TYPE_VECTOR ).vec3_values();
+    float* s = grid->value( GRID_SLOT_S, TYPE_FLOAT ).float_values();
+    float* t = grid->value( GRID_SLOT_T, TYPE_FLOAT ).float_values();
+
+    // Transform the polynomial's coefficients into camera space.  Only the
+    // constant coefficient picks up the translation.
+    vec3 coefficients [16];
+    for ( int i = 0; i < 15; ++i )
+    {
+        coefficients[i] = vec3( transform * vec4(coefficients_[i], 0.0f) );
+    }
+    coefficients[15] = vec3( transform * vec4(coefficients_[15], 1.0f) );
     
+    // Evaluate the cubic in u for each row directly and then step along the
+    // row using forward differences.  The derivative in u is the quadratic 
+    // from differentiating the row's cubic and the derivative in v is the 
+    // cubic in u whose coefficients are the derivatives of the row's 
+    // coefficients in v.
     int vertex = 0;
     float v = v_range.x;
     float dv = (v_range.y - v_range.x) / float(height - 1);
+    const float u0 = u_range.x;
+    const float du = (u_range.y - u_range.x) / float(width - 1);
+    const float du2 = du * du;
+    const float du3 = du2 * du;
     for ( int j = 0; j < height; ++j )
     {
-        float u = u_range.x;
-        float du = (u_range.y - u_range.x) / float(width - 1);
+        const vec3 a0 = ((coefficients[0] * v + coefficients[4]) * v + coefficients[8]) * v + coefficients[12];
+        const vec3 a1 = ((coefficients[1] * v + coefficients[5]) * v + coefficients[9]) * v + coefficients[13];
+        const vec3 a2 = ((coefficients[2] * v + coefficients[6]) * v + coefficients[10]) * v + coefficients[14];
+        const vec3 a3 = ((coefficients[3] * v + coefficients[7]) * v + coefficients[11]) * v + coefficients[15];
+        const vec3 b0 = (3.0f * v * coefficients[0] + 2.0f * coefficients[4]) * v + coefficients[8];
+        const vec3 b1 = (3.0f * v * coefficients[1] + 2.0f * coefficients[5]) * v + coefficients[9];
+        const vec3 b2 = (3.0f * v * coefficients[2] + 2.0f * coefficients[6]) * v + coefficients[10];
+        const vec3 b3 = (3.0f * v * coefficients[3] + 2.0f * coefficients[7]) * v + coefficients[11];
+
+        vec3 position = ((a0 * u0 + a1) * u0 + a2) * u0 + a3;
+        vec3 d1 = a0 * (3.0f * u0 * u0 * du + 3.0f * u0 * du2 + du3) + a1 * (2.0f * u0 * du + du2) + a2 * du;
+        vec3 d2 = a0 * (6.0f * u0 * du2 + 6.0f * du3) + a1 * (2.0f * du2);
+        const vec3 d3 = a0 * (6.0f * du3);
+
+        vec3 dpdu = (3.0f * a0 * u0 + 2.0f * a1) * u0 + a2;
+        vec3 dpdu_d1 = a0 * (3.0f * (2.0f * u0 * du + du2)) + a1 * (2.0f * du);
+        const vec3 dpdu_d2 = a0 * (6.0f * du2);
+
+        vec3 dpdv = ((b0 * u0 + b1) * u0 + b2) * u0 + b3;
+        vec3 dpdv_d1 = b0 * (3.0f * u0 * u0 * du + 3.0f * u0 * du2 + du3) + b1 * (2.0f * u0 * du + du2) + b2 * du;
+        vec3 dpdv_d2 = b0 * (6.0f * u0 * du2 + 6.0f * du3) + b1 * (2.0f * du2);
+        const vec3 dpdv_d3 = b0 * (6.0f * du3);
+
+        float u = u0;
         for ( int i = 0; i < width; ++i )
         {
-            positions[vertex] = vec3( transform * vec4(position(u, v), 1.0f) );
+            positions[vertex] = position;
+            u_derivatives[vertex] = dpdu;
+            v_derivatives[vertex] = dpdv;
             s[vertex] = u;
             t[vertex] = v;
             ++vertex;
             u = min( u + du, u_range.y );
+            position += d1;
+            d1 += d2;
+            d2 += d3;
+            dpdu += dpdu_d1;
+            dpdu_d1 += dpdu_d2;
+            dpdv += dpdv_d1;
+            dpdv_d1 += dpdv_d2;
+            dpdv_d2 += dpdv_d3;
         }        
         v = min( v + dv, v_range.y );
     }
 }
 
-math::vec3 CubicPatch::position( float u, float v ) const
-{
-    REYES_ASSERT( u >= 0.0f && u <= 1.0f );
-    REYES_ASSERT( v >= 0.0f && v <= 1.0f );
-
-    vec4 uu( u * u * u, u * u, u, 1.0f );
-    float b0_u = dot( u_basis_[0], uu );
-    float b1_u = dot( u_basis_[1], uu );
-    float b2_u = dot( u_basis_[2], uu );
-    float b3_u = dot( u_basis_[3], uu );
-    
-    vec4 vv( v * v * v, v * v, v, 1.0f );
-    float b0_v = dot( v_basis_[0], vv );
-    float b1_v = dot( v_basis_[1], vv );
-    float b2_v = dot( v_basis_[2], vv );
-    float b3_v = dot( v_basis_[3], vv );
-
-    return 
-        b0_u * b0_v * p_[0] +
-        b1_u * b0_v * p_[1] +
-        b2_u * b0_v * p_[2] +
-        b3_u * b0_v * p_[3] +
-        b0_u * b1_v * p_[4] +
-        b1_u * b1_v * p_[5] +
-        b2_u * b1_v * p_[6] +
-        b3_u * b1_v * p_[7] +
-        b0_u * b2_v * p_[8] +
-        b1_u * b2_v * p_[9] +
-        b2_u * b2_v * p_[10] +
-        b3_u * b2_v * p_[11] +
-        b0_u * b3_v * p_[12] +
-        b1_u * b3_v * p_[13] +
-        b2_u * b3_v * p_[14] +
-        b3_u * b3_v * p_[15]
-    ;
-}
-
-math::vec3 CubicPatch::normal( float u, float v ) const
+math::vec4 CubicPatch::bezier_weights( const math::vec4& basis, const math::vec2& range ) const
 {
-    REYES_ASSERT( u >= 0.0f && u <= 1.0f );
-    REYES_ASSERT( v >= 0.0f && v <= 1.0f );
-    return vec3( 0.0f, 0.0f, -1.0f );
+    // Reparameterize the cubic polynomial with coefficients in \e basis from
+    // the range [u0, u1] to [0, 1] and convert it to the Bernstein basis.
+    const float u0 = range.x;
+    const float d = range.y - range.x;
+    const float a = basis.x;
+    const float b = basis.y;
+    const float c = basis.z;
+    const float e = basis.w;
+    const float c3 = a * d * d * d;
+    const float c2 = (3.0f * a * u0 + b) * d * d;
+    const float c1 = (3.0f * a * u0 * u0 + 2.0f * b * u0 + c) * d;
+    const float c0 = ((a * u0 + b) * u0 + c) * u0 + e;
+    return vec4( 
+        c0, 
+        c0 + c1 / 3.0f, 
+        c0 + (2.0f * c1 + c2) / 3.0f, 
+        c0 + c1 + c2 + c3 
+    );
 }
@@ -5,8 +5,6 @@
 #include <math/vec2.hpp>
 #include <math/vec3.hpp>
 #include <math/mat4x4.hpp>
-#include <list>
-#include <memory>
 
 namespace reyes
 {
@@ -15,24 +13,22 @@ class Grid;
 
 class CubicPatch : public Geometry
 {
-    const math::vec3* p_;
+    math::vec3 p_[16];
+    math::vec3 coefficients_[16]; ///< The coefficients of the patch as a bicubic polynomial in u and v (from u^3 v^3 to u^0 v^0).
     const math::vec4* u_basis_;
     const math::vec4* v_basis_;
     
 public:
     CubicPatch( const math::vec3* positions, const math::vec4* u_basis, const math::vec4* v_basis );
-    CubicPatch( const CubicPatch& patch, const math::vec2& u_range, const math::vec2& v_range );
     
     bool boundable() const;
-    void bound( const math::mat4x4& transform, math::vec3* minimum, math::vec3* maximum ) const;
+    void bound( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, math::vec3* minimum, math::vec3* maximum ) const;
     bool splittable() const;
-    void split( std::list<std::shared_ptr<Geometry>>* primitives ) const;
     bool diceable() const;
-    void dice( const math::mat4x4& transform, int width, int height, Grid* grid ) const;        
+    void dice( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, int width, int height, Grid* grid ) const;        
 
 private:
-    math::vec3 position( float u, float v ) const;
-    math::vec3 normal( float u, float v ) const;    
+    math::vec4 bezier_weights( const math::vec4& basis, const math::vec2& range ) const;
 };
 
 }
@@ -18,14 +18,12 @@
 
 using std::min;
 using std::max;
-using std::list;
 using std::vector;
-using std::shared_ptr;
 using namespace math;
 using namespace reyes;
 
 Cylinder::Cylinder( float radius, float zmin, float zmax, float thetamax )
-: Geometry(vec2(0.0f, 1.0f), vec2(0.0f, 1.0f)),
+: Geometry(),
   radius_( radius ),
   zmin_( zmin ),
   zmax_( zmax ),
@@ -33,21 +31,12 @@ Cylinder::Cylinder( float radius, float zmin, float zmax, float thetamax )
 {   
 }
 
-Cylinder::Cylinder( const Cylinder& cylinder, const math::vec2& u_range, const math::vec2& v_range )
-: Geometry(u_range, v_range),
-  radius_( cylinder.radius_ ),
-  zmin_( cylinder.zmin_ ),
-  zmax_( cylinder.zmax_ ),
-  thetamax_( cylinder.thetamax_ )
-{   
-}
-
 bool Cylinder::boundable() const
 {
     return true;
 }
 
-void Cylinder::bound( const math::mat4x4& transform, vec3* minimum, vec3* maximum ) const
+void Cylinder::bound( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, vec3* minimum, vec3* maximum ) const
 {
     REYES_ASSERT( minimum );
     REYES_ASSERT( maximum );
@@ -55,19 +44,10 @@ void Cylinder::bound( const math::mat4x4& transform, vec3* minimum, vec3* maximu
     *minimum = vec3( FLT_MAX, FLT_MAX, FLT_MAX );
     *maximum = vec3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
     
-    Grid grid;
-    dice( transform, 8, 8, &grid );
-    const vec3* positions = grid["P"].vec3_values();
-    const vec3* positions_end = positions + grid["P"].size();
-    for ( const vec3* i = positions; i != positions_end; ++i )
-    {
-        minimum->x = min( minimum->x, i->x );
-        minimum->y = min( minimum->y, i->y );
-        minimum->z = min( minimum->z, i->z );        
-        maximum->x = max( maximum->x, i->x );
-        maximum->y = max( maximum->y, i->y );
-        maximum->z = max( maximum->z, i->z );
-    }
+    bound_arc( radius_, u_range.x * thetamax_, u_range.y * thetamax_, minimum, maximum );
+    minimum->z = min( v_range.x * (zmax_ - zmin_), v_range.y * (zmax_ - zmin_) );
+    maximum->z = max( v_range.x * (zmax_ - zmin_), v_range.y * (zmax_ - zmin_) );
+    transform_bound( transform, minimum, maximum );
 }
 
 bool Cylinder::splittable() const
@@ -75,54 +55,26 @@ bool Cylinder::splittable() const
     return true;
 }
 
-void Cylinder::split( std::list<std::shared_ptr<Geometry> >* primitives ) const
-{
-    REYES_ASSERT( primitives );
-    REYES_ASSERT( u_range().y >= u_range().x );
-    REYES_ASSERT( v_range().y >= v_range().x );
-
-    const vec2& u_range = Geometry::u_range();
-    float u0 = u_range.x;
-    float u1 = (u_range.x + u_range.y) / 2.0f;
-    float u2 = u_range.y;
-
-    const vec2& v_range = Geometry::v_range();
-    float v0 = v_range.x;
-    float v1 = (v_range.x + v_range.y) / 2.0f;
-    float v2 = v_range.y;
-
-    shared_ptr<Geometry> cylinder;
-    cylinder.reset( new Cylinder(*this, vec2(u0, u1), vec2(v0, v1)) );
-    primitives->push_back( cylinder );
-    cylinder.reset( new Cylinder(*this, vec2(u0, u1), vec2(v1, v2)) );
-    primitives->push_back( cylinder );
-    cylinder.reset( new Cylinder(*this, vec2(u1, u2), vec2(v0, v1)) );
-    primitives->push_back( cylinder );
-    cylinder.reset( new Cylinder(*this, vec2(u1, u2), vec2(v1, v2)) );
-    primitives->push_back( cylinder );
-}
-
 bool Cylinder::diceable() const
 {
     return true;
 }
 
-void Cylinder::dice( const math::mat4x4& transform, int width, int height, Grid* grid ) const
+void Cylinder::dice( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, int width, int height, Grid* grid ) const
 {
     REYES_ASSERT( width > 0 );
     REYES_ASSERT( height > 0 );
     REYES_ASSERT( grid );
     
-    const vec2& u_range = Geometry::u_range();
-    const vec2& v_range = Geometry::v_range();
-
     grid->resize( width, height );
     grid->du_ = (u_range.y - u_range.x) / float(width - 1);
     grid->dv_ = (v_range.y - v_range.x) / float(height - 1);
     
-    vec3* positions = grid->value( "P", TYPE_POINT ).vec3_values();
-    float* s = grid->value( "s", TYPE_FLOAT ).float_values();
-    float* t = grid->value( "t", TYPE_FLOAT ).float_values();
+    vec3* positions = grid->value( GRID_SLOT_P, TYPE_POINT ).vec3_values();
+    vec3* u_derivatives = grid->value( GRID_SLOT_DPDU, TYPE_VECTOR ).vec3_values();
+    vec3* v_derivatives = grid->value( GRID_SLOT_DPDV, TYPE_VECTOR ).vec3_values();
+    float* s = grid->value( GRID_SLOT_S, TYPE_FLOAT ).float_values();
+    float* t = grid->value( GRID_SLOT_T, TYPE_FLOAT ).float_values();
     
     int vertex = 0;
     float v = v_range.x;
@@ -133,7 +85,13 @@ void Cylinder::dice( const math::mat4x4& transform, int width, int height, Grid*
         float du = (u_range.y - u_range.x) / float(width - 1);
         for ( int i = 0; i < width; ++i )
         {
-            positions[vertex] = vec3( transform * vec4(position(u, v), 1.0f) );
+            vec3 position;
+            vec3 dpdu;
+            vec3 dpdv;
+            evaluate( u, v, &position, &dpdu, &dpdv );
+            positions[vertex] = vec3( transform * vec4(position, 1.0f) );
+            u_derivatives[vertex] = vec3( transform * vec4(dpdu, 0.0f) );
+            v_derivatives[vertex] = vec3( transform * vec4(dpdv, 0.0f) );
             s[vertex] = u;
             t[vertex] = v;
             u = min( u + du, u_range.y );
@@ -143,14 +101,15 @@ void Cylinder::dice( const math::mat4x4& transform, int width, int height, Grid*
     }    
 }
 
-math::vec3 Cylinder::position( float u, float v ) const
+void Cylinder::evaluate( float u, float v, math::vec3* position, math::vec3* dpdu, math::vec3* dpdv ) const
 {
-    vec3 n = normal( u, v );
-    return vec3( radius_ * n.x, radius_ * n.y, v * (zmax_ - zmin_) );
-}
-
-math::vec3 Cylinder::normal( float u, float /*v*/ ) const
-{    
+    REYES_ASSERT( position );
+    REYES_ASSERT( dpdu );
+    REYES_ASSERT( dpdv );
     float theta = u * thetamax_;
-    return vec3( cosf(theta), sinf(theta), 0.0f );
+    float cos_theta = cosf( theta );
+    float sin_theta = sinf( theta );
+    *position = vec3( radius_ * cos_theta, radius_ * sin_theta, v * (zmax_ - zmin_) );
+    *dpdu = thetamax_ * vec3( -radius_ * sin_theta, radius_ * cos_theta, 0.0f );
+    *dpdv = vec3( 0.0f, 0.0f, zmax_ - zmin_ );
 }
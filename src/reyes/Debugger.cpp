@@ -391,7 +391,7 @@ void Debugger::dump_grid( const Grid& grid, const math::vec4& color, const char*
     fprintf( stream, "\n" );
     fprintf( stream, "   vertices {\n" );
 
-    const vec3* positions = grid["P"].vec3_values();
+    const vec3* positions = grid[GRID_SLOT_P].vec3_values();
     const int width = grid.width();
     const int height = grid.height();
     int i = 0;
@@ -22,6 +22,7 @@ enum ErrorCode
     RENDER_ERROR_OUT_OF_MEMORY, ///< A memory allocation failed.
     RENDER_ERROR_UNKNOWN_COLOR_SPACE, ///< An unknown color space was passed to ctransform() or used in a typecast expression.
     RENDER_ERROR_INVALID_DISPLAY_MODE, ///< A display mode was requested for a device or file format that doesn't support it.
+    RENDER_ERROR_BUCKETS_NOT_SUPPORTED, ///< An operation that needs the sample buffer for the whole frame was requested when rendering in buckets.
     RENDER_ERROR_COUNT
 };
 
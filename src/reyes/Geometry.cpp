@@ -11,18 +11,17 @@
 #include "assert.hpp"
 #include <algorithm>
 #include <vector>
+#define _USE_MATH_DEFINES
+#include <math.h>
 
 using std::min;
 using std::max;
-using std::list;
+using std::swap;
 using std::vector;
-using std::shared_ptr;
 using namespace math;
 using namespace reyes;
 
-Geometry::Geometry( const math::vec2& u_range, const math::vec2& v_range )
-: u_range_( u_range ),
-  v_range_( v_range )
+Geometry::Geometry()
 {   
 }
 
@@ -30,40 +29,105 @@ Geometry::~Geometry()
 {
 }
 
-const math::vec2& Geometry::u_range() const
+bool Geometry::boundable() const
 {
-    return u_range_;
+    return false;
 }
 
-const math::vec2& Geometry::v_range() const
+void Geometry::bound( const math::mat4x4& /*transform*/, const math::vec2& /*u_range*/, const math::vec2& /*v_range*/, vec3* /*minimum*/, vec3* /*maximum*/ ) const
 {
-    return v_range_;
 }
 
-bool Geometry::boundable() const
+bool Geometry::splittable() const
 {
     return false;
 }
 
-void Geometry::bound( const math::mat4x4& /*transform*/, vec3* /*minimum*/, vec3* /*maximum*/ ) const
+void Geometry::split( const math::vec2& u_range, const math::vec2& v_range, math::vec2* u_ranges, math::vec2* v_ranges ) const
 {
+    REYES_ASSERT( u_range.y >= u_range.x );
+    REYES_ASSERT( v_range.y >= v_range.x );
+    REYES_ASSERT( u_ranges );
+    REYES_ASSERT( v_ranges );
+
+    float u0 = u_range.x;
+    float u1 = (u_range.x + u_range.y) / 2.0f;
+    float u2 = u_range.y;
+
+    float v0 = v_range.x;
+    float v1 = (v_range.x + v_range.y) / 2.0f;
+    float v2 = v_range.y;
+
+    u_ranges[0] = vec2( u0, u1 );
+    v_ranges[0] = vec2( v0, v1 );
+    u_ranges[1] = vec2( u0, u1 );
+    v_ranges[1] = vec2( v1, v2 );
+    u_ranges[2] = vec2( u1, u2 );
+    v_ranges[2] = vec2( v0, v1 );
+    u_ranges[3] = vec2( u1, u2 );
+    v_ranges[3] = vec2( v1, v2 );
 }
 
-bool Geometry::splittable() const
+bool Geometry::diceable() const
 {
     return false;
 }
 
-void Geometry::split( std::list<std::shared_ptr<Geometry>>* /*primitives*/ ) const
+void Geometry::dice( const math::mat4x4& /*transform*/, const math::vec2& /*u_range*/, const math::vec2& /*v_range*/, int /*width*/, int /*height*/, Grid* /*grid*/ ) const
 {
-    REYES_ASSERT( false );
 }
 
-bool Geometry::diceable() const
+void Geometry::bound_arc( float radius, float theta0, float theta1, math::vec3* minimum, math::vec3* maximum )
 {
-    return false;
+    REYES_ASSERT( minimum );
+    REYES_ASSERT( maximum );
+
+    if ( theta1 < theta0 )
+    {
+        swap( theta0, theta1 );
+    }
+    const float PI = float(M_PI);
+    theta1 = min( theta1, theta0 + 2.0f * PI );
+
+    // The extents of an arc in x and y are at its end points and at any 
+    // multiple of a quarter turn that it passes through.
+    static const float X [4] = { 1.0f, 0.0f, -1.0f, 0.0f };
+    static const float Y [4] = { 0.0f, 1.0f, 0.0f, -1.0f };
+    const float x0 = radius * cosf( theta0 );
+    const float y0 = radius * sinf( theta0 );
+    const float x1 = radius * cosf( theta1 );
+    const float y1 = radius * sinf( theta1 );
+    minimum->x = min( minimum->x, min(x0, x1) );
+    minimum->y = min( minimum->y, min(y0, y1) );
+    maximum->x = max( maximum->x, max(x0, x1) );
+    maximum->y = max( maximum->y, max(y0, y1) );
+    for ( int quarter = int(ceilf(theta0 / (0.5f * PI))); float(quarter) * 0.5f * PI < theta1; ++quarter )
+    {
+        const int index = ((quarter % 4) + 4) % 4;
+        minimum->x = min( minimum->x, radius * X[index] );
+        minimum->y = min( minimum->y, radius * Y[index] );
+        maximum->x = max( maximum->x, radius * X[index] );
+        maximum->y = max( maximum->y, radius * Y[index] );
+    }
 }
 
-void Geometry::dice( const math::mat4x4& /*transform*/, int /*width*/, int /*height*/, Grid* /*grid*/ ) const
+void Geometry::transform_bound( const math::mat4x4& transform, math::vec3* minimum, math::vec3* maximum )
 {
+    REYES_ASSERT( minimum );
+    REYES_ASSERT( maximum );
+
+    const vec3 lower = *minimum;
+    const vec3 upper = *maximum;
+    *minimum = vec3( FLT_MAX, FLT_MAX, FLT_MAX );
+    *maximum = vec3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+    for ( int corner = 0; corner < 8; ++corner )
+    {
+        vec3 position = vec3( transform * vec4((corner & 1) ? upper.x : lower.x, (corner & 2) ? upper.y : lower.y, (corner & 4) ? upper.z : lower.z, 1.0f) );
+        minimum->x = min( minimum->x, position.x );
+        minimum->y = min( minimum->y, position.y );
+        minimum->z = min( minimum->z, position.z );
+        maximum->x = max( maximum->x, position.x );
+        maximum->y = max( maximum->y, position.y );
+        maximum->z = max( maximum->z, position.z );
+    }
 }
@@ -4,8 +4,6 @@
 #include <math/vec2.hpp>
 #include <math/vec3.hpp>
 #include <math/mat4x4.hpp>
-#include <list>
-#include <memory>
 
 namespace reyes
 {
@@ -14,25 +12,29 @@ class Grid;
 
 /**
 // The base class for geometry types supported by the renderer.
+//
+// Geometry is immutable once it has been passed to the renderer.  Pieces of
+// split geometry are described by the range in u and v that they cover 
+// rather than by new geometry so that splitting doesn't allocate.
 */
 class Geometry
 {
-    math::vec2 u_range_; ///< The range in u covered by this piece of geometry.
-    math::vec2 v_range_; ///< The range in v covered by this piece of geometry.
-    
 public:
-    Geometry( const math::vec2& u_range, const math::vec2& v_range );
+    static const int SPLIT_PIECES = 4; ///< The number of pieces that splitting a range of geometry produces.
+
+    Geometry();
     virtual ~Geometry();
 
-    const math::vec2& u_range() const;
-    const math::vec2& v_range() const;
-    
     virtual bool boundable() const;
-    virtual void bound( const math::mat4x4& transform, math::vec3* minimum, math::vec3* maximum ) const;
+    virtual void bound( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, math::vec3* minimum, math::vec3* maximum ) const;
     virtual bool splittable() const;
-    virtual void split( std::list<std::shared_ptr<Geometry>>* primitives ) const;
+    virtual void split( const math::vec2& u_range, const math::vec2& v_range, math::vec2* u_ranges, math::vec2* v_ranges ) const;
     virtual bool diceable() const;
-    virtual void dice( const math::mat4x4& transform, int width, int height, Grid* grid ) const;
+    virtual void dice( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, int width, int height, Grid* grid ) const;
+
+protected:
+    static void bound_arc( float radius, float theta0, float theta1, math::vec3* minimum, math::vec3* maximum );
+    static void transform_bound( const math::mat4x4& transform, math::vec3* minimum, math::vec3* maximum );
 };
 
 }
@@ -6,27 +6,60 @@
 #include "stdafx.hpp"
 #include "Grid.hpp"
 #include "Value.hpp"
+#include <math/vec3.ipp>
+#include <math/vec4.ipp>
 #include <math/mat4x4.ipp>
 #include "assert.hpp"
 #include <vector>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
 
-using std::map;
 using std::string;
 using std::vector;
 using std::shared_ptr;
 using namespace math;
 using namespace reyes;
 
+/// The identifiers of the standard globals stored in fixed slots (indexed by
+/// GridSlot).
+static const char* GLOBAL_IDENTIFIERS [GRID_SLOT_COUNT] =
+{
+    "P",
+    "N",
+    "Ng",
+    "Ci",
+    "Oi",
+    "Cs",
+    "Os",
+    "s",
+    "t",
+    "u",
+    "v",
+    "I",
+    "E",
+    "du",
+    "dv",
+    "L",
+    "Cl",
+    "Ol",
+    "Ps",
+    "dPdu",
+    "dPdv"
+};
+
 Grid::Grid()
 : width_( 1 ),
   height_( 1 ),
   du_( 0.0f ),
   dv_( 0.0f ),
-  values_(),
-  values_by_identifier_(),
+  values_( GRID_SLOT_COUNT ),
+  identifiers_(),
+  parameter_slots_(),
   lights_(),
   transform_( math::identity() ),
-  shader_( NULL )
+  shader_( NULL ),
+  value_pool_( NULL )
 {
 }
 
@@ -35,11 +68,13 @@ Grid::Grid( Shader* shader )
   height_( 1 ),
   du_( 0.0f ),
   dv_( 0.0f ),
-  values_(),
-  values_by_identifier_(),
+  values_( GRID_SLOT_COUNT ),
+  identifiers_(),
+  parameter_slots_(),
   lights_(),
   transform_( math::identity() ),
-  shader_( shader )
+  shader_( shader ),
+  value_pool_( NULL )
 {
     REYES_ASSERT( shader_ );
 }
@@ -50,17 +85,14 @@ Grid::Grid( const Grid& grid )
   du_( grid.du_ ),
   dv_( grid.dv_ ),
   values_(),
-  values_by_identifier_(),
+  identifiers_(),
+  parameter_slots_( grid.parameter_slots_ ),
   lights_(),
   transform_( grid.transform_ ),
-  shader_( grid.shader_ )
+  shader_( grid.shader_ ),
+  value_pool_( NULL )
 {
-    values_.reserve( grid.values_by_identifier_.size() );
-    const map<string, shared_ptr<Value>>& values_by_identifier = grid.values_by_identifier_;
-    for ( map<string, shared_ptr<Value>>::const_iterator i = values_by_identifier.begin(); i != values_by_identifier.end(); ++i )
-    {
-        copy_value( i->first, i->second );
-    }
+    copy_values( grid );
 }
 
 Grid& Grid::operator=( const Grid& grid )
@@ -74,16 +106,9 @@ Grid& Grid::operator=( const Grid& grid )
         transform_ = grid.transform_;
         shader_ = grid.shader_;
 
-        values_.clear();
-        values_by_identifier_.clear();
+        parameter_slots_ = grid.parameter_slots_;
         lights_.clear();
-        
-        values_.reserve( grid.values_by_identifier_.size() );
-        const map<string, shared_ptr<Value>>& values_by_identifier = grid.values_by_identifier_;
-        for ( map<string, shared_ptr<Value>>::const_iterator i = values_by_identifier.begin(); i != values_by_identifier.end(); ++i )
-        {
-            copy_value( i->first, i->second );
-        }
+        copy_values( grid );
     }
     return *this;
 }
@@ -112,6 +137,16 @@ Shader* Grid::shader() const
     return shader_;
 }
 
+void Grid::set_value_pool( ValuePool* value_pool )
+{
+    value_pool_ = value_pool;
+}
+
+ValuePool* Grid::value_pool() const
+{
+    return value_pool_;
+}
+
 void Grid::clear()
 {
     width_ = 1;
@@ -119,8 +154,10 @@ void Grid::clear()
     du_ = 0.0f;
     dv_ = 0.0f;
     lights_.clear();
-    values_by_identifier_.clear();
+    identifiers_.clear();
+    parameter_slots_.clear();
     values_.clear();
+    values_.resize( GRID_SLOT_COUNT );
 }
 
 void Grid::resize( int width, int height )
@@ -134,117 +171,148 @@ void Grid::resize( int width, int height )
 
 void Grid::generate_normals( bool left_handed, bool force )
 {
-    if ( force || !find_value("N") )
+    if ( force || !find_value(GRID_SLOT_N) )
     {
-        Value& normals = value( "N", TYPE_NORMAL );    
-        const vec3* positions = value("P").vec3_values();
-        REYES_ASSERT( positions );
-        
-        vector<vec4> generated_normals;
-        generated_normals.insert( generated_normals.end(), width_ * height_, vec4(0.0f, 0.0f, 0.0f, 0.0f) );
-
-        int i = 0;
-        for ( int y = 0; y < height_ - 1; ++y )
+        // Derivatives output by dicing no longer match positions that have
+        // been displaced so normals are only generated from them when not 
+        // forced.
+        shared_ptr<Value> u_derivatives = find_value( GRID_SLOT_DPDU );
+        shared_ptr<Value> v_derivatives = find_value( GRID_SLOT_DPDV );
+        if ( !force && u_derivatives && v_derivatives )
         {
-            for ( int x = 0; x < width_ - 1; ++x )
-            {
-                int i0 = i + x;
-                int i1 = i + width_ + x;
-                int i2 = i + width_ + x + 1;
-                int i3 = i + x + 1;
-
-                vec3 u0 = positions[i3] - positions[i0];
-                vec3 u1 = positions[i2] - positions[i1];
-                vec3 u = length(u0) > length(u1) ? u0 : u1;
-                vec3 v0 = positions[i1] - positions[i0];
-                vec3 v1 = positions[i2] - positions[i3];
-                vec3 v = length(v0) > length(v1) ? v0 : v1;     
-                vec3 normal = normalize( left_handed ? cross(u, v) : cross(v, u) );
-
-                generated_normals[i0] += vec4( normal, 1.0f );
-                generated_normals[i1] += vec4( normal, 1.0f );
-                generated_normals[i2] += vec4( normal, 1.0f );
-                generated_normals[i3] += vec4( normal, 1.0f );
-            }
-            i += width_;
+            generate_normals_from_derivatives( left_handed, *u_derivatives, *v_derivatives );
         }
-        
-        normals.clear();
-        normals.reserve( generated_normals.size() );
-        vec3* values = normals.vec3_values();
-        int j = 0;
-        for ( vector<vec4>::const_iterator normal = generated_normals.begin(); normal != generated_normals.end(); ++normal )
+        else
         {
-            values[j] = vec3(*normal) / normal->w;
-            ++j;
-        }  
+            generate_normals_from_positions( left_handed );
+        }
     }
 }
 
-Value& Grid::value( const std::string& identifier, ValueType type )
+int Grid::slots() const
+{
+    return int(values_.size());
+}
+
+int Grid::global_slot( const std::string& identifier )
+{
+    for ( int slot = 0; slot < GRID_SLOT_COUNT; ++slot )
+    {
+        if ( strcmp(GLOBAL_IDENTIFIERS[slot], identifier.c_str()) == 0 )
+        {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+int Grid::find_slot( const std::string& identifier ) const
 {
-    shared_ptr<Value> value = find_value( identifier );
+    int slot = global_slot( identifier );
+    if ( slot >= 0 )
+    {
+        return slot;
+    }
+
+    vector<string>::const_iterator i = std::find( identifiers_.begin(), identifiers_.end(), identifier );
+    return i != identifiers_.end() ? GRID_SLOT_COUNT + int(i - identifiers_.begin()) : -1;
+}
+
+const char* Grid::identifier( int slot ) const
+{
+    REYES_ASSERT( slot >= 0 && slot < int(values_.size()) );
+    return slot < GRID_SLOT_COUNT ? GLOBAL_IDENTIFIERS[slot] : identifiers_[slot - GRID_SLOT_COUNT].c_str();
+}
+
+Value& Grid::value( int slot, ValueType type )
+{
+    shared_ptr<Value> value = find_value( slot );
     if ( !value )
     {
-        value = add_value( identifier, type );
+        value = add_value( slot, type );
     }
     return *value;
 }
 
-const Value& Grid::value( const std::string& identifier ) const
+const Value& Grid::value( int slot ) const
 {
-    shared_ptr<Value> value = find_value( identifier );
+    shared_ptr<Value> value = find_value( slot );
     REYES_ASSERT( value );
     return *value;
 }
 
-Value& Grid::operator[]( const std::string& identifier )
+Value& Grid::operator[]( int slot )
 {
-    return value( identifier, TYPE_NULL );
+    return value( slot, TYPE_NULL );
 }
 
-const Value& Grid::operator[]( const std::string& identifier ) const
+const Value& Grid::operator[]( int slot ) const
 {
-    return value( identifier );
+    return value( slot );
 }
 
-void Grid::copy_value( const std::string& identifier, std::shared_ptr<Value> value )
+void Grid::insert_value( int slot, std::shared_ptr<Value> value )
 {
-    REYES_ASSERT( !identifier.empty() );
-    REYES_ASSERT( !find_value(identifier) );
+    REYES_ASSERT( slot >= 0 && slot < int(values_.size()) );
+    REYES_ASSERT( !values_[slot] );
     REYES_ASSERT( value );
     REYES_ASSERT( int(value->size()) <= width_ * height_ );
+    values_[slot] = value;
+}
 
-    shared_ptr<Value> copied_value( new Value(*value) );
-    values_.push_back( copied_value );
-    values_by_identifier_.insert( make_pair(identifier, copied_value) );
+std::shared_ptr<Value> Grid::add_value( int slot, ValueType type, ValueStorage storage )
+{
+    REYES_ASSERT( slot >= 0 && slot < int(values_.size()) );
+    REYES_ASSERT( !values_[slot] );
+    shared_ptr<Value> value( new Value(type, storage, size(), value_pool_) );
+    values_[slot] = value;
+    return value;
+}
+
+std::shared_ptr<Value> Grid::find_value( int slot ) const
+{
+    REYES_ASSERT( slot >= 0 && slot < int(values_.size()) );
+    return values_[slot];
+}
+
+Value& Grid::value( const std::string& identifier, ValueType type )
+{
+    return value( add_slot(identifier), type );
+}
+
+const Value& Grid::value( const std::string& identifier ) const
+{
+    int slot = find_slot( identifier );
+    REYES_ASSERT( slot >= 0 );
+    return value( slot );
+}
+
+Value& Grid::operator[]( const std::string& identifier )
+{
+    return value( identifier, TYPE_NULL );
+}
+
+const Value& Grid::operator[]( const std::string& identifier ) const
+{
+    return value( identifier );
 }
 
 void Grid::insert_value( const std::string& identifier, std::shared_ptr<Value> value )
 {
     REYES_ASSERT( !identifier.empty() );
-    REYES_ASSERT( !find_value(identifier) );
-    REYES_ASSERT( value );
-    REYES_ASSERT( int(value->size()) <= width_ * height_ );
-    
-    values_by_identifier_.insert( make_pair(identifier, value) );
+    insert_value( add_slot(identifier), value );
 }
 
 std::shared_ptr<Value> Grid::add_value( const std::string& identifier, ValueType type, ValueStorage storage )
 {
     REYES_ASSERT( !identifier.empty() );
-    REYES_ASSERT( !find_value(identifier) );
-    
-    shared_ptr<Value> value( new Value(type, storage, size()) );
-    values_.push_back( value );
-    values_by_identifier_.insert( make_pair(identifier, value) );
-    return value;
+    return add_value( add_slot(identifier), type, storage );
 }
 
 std::shared_ptr<Value> Grid::find_value( const std::string& identifier ) const
 {
-    map<string, shared_ptr<Value> >::const_iterator i = values_by_identifier_.find( identifier );
-    return i != values_by_identifier_.end() ? i->second : std::shared_ptr<Value>();
+    int slot = find_slot( identifier );
+    return slot >= 0 ? values_[slot] : shared_ptr<Value>();
 }
 
 const std::vector<std::shared_ptr<Value>>& Grid::values() const
@@ -252,9 +320,18 @@ const std::vector<std::shared_ptr<Value>>& Grid::values() const
     return values_;
 }
 
-const std::map<std::string, std::shared_ptr<Value>>& Grid::values_by_identifier() const
+int Grid::add_parameter( const std::string& identifier, ValueType type )
 {
-    return values_by_identifier_;
+    REYES_ASSERT( !identifier.empty() );
+    int slot = add_slot( identifier );
+    add_value( slot, type );
+    parameter_slots_.push_back( slot );
+    return slot;
+}
+
+const std::vector<int>& Grid::parameter_slots() const
+{
+    return parameter_slots_;
 }
 
 void Grid::reserve_lights( unsigned int lights )
@@ -287,3 +364,120 @@ const math::mat4x4& Grid::get_transform() const
 {
     return transform_;
 }
+
+int Grid::add_slot( const std::string& identifier )
+{
+    int slot = find_slot( identifier );
+    if ( slot < 0 )
+    {
+        slot = int(values_.size());
+        identifiers_.push_back( identifier );
+        values_.push_back( shared_ptr<Value>() );
+    }
+    return slot;
+}
+
+void Grid::copy_values( const Grid& grid )
+{
+    identifiers_ = grid.identifiers_;
+    values_.clear();
+    values_.reserve( grid.values_.size() );
+    for ( vector<shared_ptr<Value>>::const_iterator i = grid.values_.begin(); i != grid.values_.end(); ++i )
+    {
+        const shared_ptr<Value>& value = *i;
+        values_.push_back( value ? shared_ptr<Value>(new Value(*value)) : shared_ptr<Value>() );
+    }
+}
+
+void Grid::generate_normals_from_derivatives( bool left_handed, const Value& u_derivatives, const Value& v_derivatives )
+{
+    const vec3* positions = value(GRID_SLOT_P).vec3_values();
+    const vec3* dpdu = u_derivatives.vec3_values();
+    const vec3* dpdv = v_derivatives.vec3_values();
+    REYES_ASSERT( positions );
+    REYES_ASSERT( dpdu );
+    REYES_ASSERT( dpdv );
+
+    Value& normals = value( GRID_SLOT_N, TYPE_NORMAL );
+    normals.clear();
+    normals.reserve( size() );
+    vec3* values = normals.vec3_values();
+
+    // Derivatives vanish at degenerate points, e.g. the poles of a sphere or
+    // the apex of a cone, so fall back to the normal of an adjacent face 
+    // there.
+    const float EPSILON = 1e-12f;
+    int i = 0;
+    for ( int y = 0; y < height_; ++y )
+    {
+        for ( int x = 0; x < width_; ++x )
+        {
+            vec3 normal = left_handed ? cross( dpdu[i], dpdv[i] ) : cross( dpdv[i], dpdu[i] );
+            float length_squared = dot( normal, normal );
+            values[i] = length_squared > EPSILON ? normal / sqrtf( length_squared ) : face_normal( left_handed, positions, x, y );
+            ++i;
+        }
+    }
+}
+
+void Grid::generate_normals_from_positions( bool left_handed )
+{
+    Value& normals = value( GRID_SLOT_N, TYPE_NORMAL );    
+    const vec3* positions = value(GRID_SLOT_P).vec3_values();
+    REYES_ASSERT( positions );
+    
+    vector<vec4> generated_normals;
+    generated_normals.insert( generated_normals.end(), width_ * height_, vec4(0.0f, 0.0f, 0.0f, 0.0f) );
+
+    int i = 0;
+    for ( int y = 0; y < height_ - 1; ++y )
+    {
+        for ( int x = 0; x < width_ - 1; ++x )
+        {
+            int i0 = i + x;
+            int i1 = i + width_ + x;
+            int i2 = i + width_ + x + 1;
+            int i3 = i + x + 1;
+            vec3 normal = face_normal( left_handed, positions, x, y );
+            generated_normals[i0] += vec4( normal, 1.0f );
+            generated_normals[i1] += vec4( normal, 1.0f );
+            generated_normals[i2] += vec4( normal, 1.0f );
+            generated_normals[i3] += vec4( normal, 1.0f );
+        }
+        i += width_;
+    }
+    
+    normals.clear();
+    normals.reserve( generated_normals.size() );
+    vec3* values = normals.vec3_values();
+    int j = 0;
+    for ( vector<vec4>::const_iterator normal = generated_normals.begin(); normal != generated_normals.end(); ++normal )
+    {
+        values[j] = vec3(*normal) / normal->w;
+        ++j;
+    }  
+}
+
+math::vec3 Grid::face_normal( bool left_handed, const math::vec3* positions, int x, int y ) const
+{
+    REYES_ASSERT( positions );
+    if ( width_ < 2 || height_ < 2 )
+    {
+        return vec3( 0.0f, 0.0f, 0.0f );
+    }
+
+    x = std::min( x, width_ - 2 );
+    y = std::min( y, height_ - 2 );
+    int i0 = y * width_ + x;
+    int i1 = i0 + width_;
+    int i2 = i0 + width_ + 1;
+    int i3 = i0 + 1;
+
+    vec3 u0 = positions[i3] - positions[i0];
+    vec3 u1 = positions[i2] - positions[i1];
+    vec3 u = length(u0) > length(u1) ? u0 : u1;
+    vec3 v0 = positions[i1] - positions[i0];
+    vec3 v1 = positions[i2] - positions[i3];
+    vec3 v = length(v0) > length(v1) ? v0 : v1;     
+    return normalize( left_handed ? cross(u, v) : cross(v, u) );
+}
@@ -3,10 +3,10 @@
 
 #include "ValueType.hpp"
 #include "ValueStorage.hpp"
+#include "GridSlot.hpp"
 #include <math/mat4x4.hpp>
 #include <string>
 #include <vector>
-#include <map>
 #include <memory>
 
 namespace math
@@ -24,6 +24,7 @@ namespace reyes
 class Value;
 class Light;
 class Shader;
+class ValuePool;
 
 /**
 // A grid of uniform and/or varying values that represents parameters
@@ -37,11 +38,13 @@ public:
     int height_; ///< The number of vertices down the v direction of this grid.
     float du_; ///< Size of increments in u for this grid.
     float dv_; ///< Size of increments in v for this grid.
-    std::vector<std::shared_ptr<Value> > values_; // The values stored in this grid.
-    std::map<std::string, std::shared_ptr<Value> > values_by_identifier_; ///< The values stored in this grid by their identifier.
+    std::vector<std::shared_ptr<Value> > values_; ///< The values stored in this grid indexed by slot.
+    std::vector<std::string> identifiers_; ///< The identifiers of the values in slots after the standard globals.
+    std::vector<int> parameter_slots_; ///< The slots of the parameters of the Shader that this Grid was bound to (indexed by parameter).
     std::vector<std::shared_ptr<Light> > lights_; ///< The lighting values for this grid.
     math::mat4x4 transform_; ///< The object to camera space transform at the time this Grid was bound to a Shader.
     Shader* shader_; ///< The light shader that this Grid stores parameters for or null if this Grid doesn't store parameters.
+    ValuePool* value_pool_; ///< The pool that values added to this Grid are allocated from or null to allocate them from the heap.
     
     public:
         Grid();
@@ -54,21 +57,35 @@ public:
         int height() const;
         int size() const;
         Shader* shader() const;
+        void set_value_pool( ValuePool* value_pool );
+        ValuePool* value_pool() const;
 
         void clear();
         void resize( int width, int height );
         void generate_normals( bool left_handed, bool force = false );
 
+        static int global_slot( const std::string& identifier );
+        int slots() const;
+        int find_slot( const std::string& identifier ) const;
+        const char* identifier( int slot ) const;
+        Value& value( int slot, ValueType type );
+        const Value& value( int slot ) const;
+        Value& operator[]( int slot );
+        const Value& operator[]( int slot ) const;
+        void insert_value( int slot, std::shared_ptr<Value> value );
+        std::shared_ptr<Value> add_value( int slot, ValueType type, ValueStorage storage = STORAGE_VARYING );
+        std::shared_ptr<Value> find_value( int slot ) const;
+
         Value& value( const std::string& identifier, ValueType type );
         const Value& value( const std::string& identifier ) const;
         Value& operator[]( const std::string& identifier );
         const Value& operator[]( const std::string& identifier ) const;
-        void copy_value( const std::string& identifier, std::shared_ptr<Value> value );
         void insert_value( const std::string& identifier, std::shared_ptr<Value> value );
         std::shared_ptr<Value> add_value( const std::string& identifier, ValueType type, ValueStorage storage = STORAGE_VARYING );
         std::shared_ptr<Value> find_value( const std::string& identifier ) const;
         const std::vector<std::shared_ptr<Value> >& values() const;
-        const std::map<std::string, std::shared_ptr<Value> >& values_by_identifier() const;
+        int add_parameter( const std::string& identifier, ValueType type );
+        const std::vector<int>& parameter_slots() const;
         
         void reserve_lights( unsigned int lights );
         void add_light( std::shared_ptr<Light> light );
@@ -77,6 +94,13 @@ public:
         
         void set_transform( const math::mat4x4& transform );
         const math::mat4x4& get_transform() const;
+
+    private:
+        int add_slot( const std::string& identifier );
+        void copy_values( const Grid& grid );
+        void generate_normals_from_derivatives( bool left_handed, const Value& u_derivatives, const Value& v_derivatives );
+        void generate_normals_from_positions( bool left_handed );
+        math::vec3 face_normal( bool left_handed, const math::vec3* positions, int x, int y ) const;
 };
 
 }
@@ -0,0 +1,42 @@
+#ifndef REYES_GRIDSLOT_HPP_INCLUDED
+#define REYES_GRIDSLOT_HPP_INCLUDED
+
+namespace reyes
+{
+
+/**
+// The fixed slots that the standard global variables are stored in in a 
+// Grid.
+//
+// Any other values stored in a grid (e.g. shader parameters) are given 
+// slots after GRID_SLOT_COUNT in the order that they're added.
+*/
+enum GridSlot
+{
+    GRID_SLOT_P, ///< "P", surface position.
+    GRID_SLOT_N, ///< "N", surface shading normal.
+    GRID_SLOT_NG, ///< "Ng", surface geometric normal.
+    GRID_SLOT_CI, ///< "Ci", incident ray color.
+    GRID_SLOT_OI, ///< "Oi", incident ray opacity.
+    GRID_SLOT_CS, ///< "Cs", surface color.
+    GRID_SLOT_OS, ///< "Os", surface opacity.
+    GRID_SLOT_S, ///< "s", surface texture coordinate.
+    GRID_SLOT_T, ///< "t", surface texture coordinate.
+    GRID_SLOT_U, ///< "u", surface parameter.
+    GRID_SLOT_V, ///< "v", surface parameter.
+    GRID_SLOT_I, ///< "I", incident ray direction.
+    GRID_SLOT_E, ///< "E", position of the eye.
+    GRID_SLOT_DU, ///< "du", change in u between vertices.
+    GRID_SLOT_DV, ///< "dv", change in v between vertices.
+    GRID_SLOT_L, ///< "L", incoming light direction.
+    GRID_SLOT_CL, ///< "Cl", incoming light color.
+    GRID_SLOT_OL, ///< "Ol", incoming light opacity.
+    GRID_SLOT_PS, ///< "Ps", surface position passed to light shaders.
+    GRID_SLOT_DPDU, ///< "dPdu", derivative of surface position in u.
+    GRID_SLOT_DPDV, ///< "dPdv", derivative of surface position in v.
+    GRID_SLOT_COUNT
+};
+
+}
+
+#endif
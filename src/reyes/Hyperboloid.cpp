@@ -18,34 +18,24 @@
 
 using std::min;
 using std::max;
-using std::list;
 using std::vector;
-using std::shared_ptr;
 using namespace math;
 using namespace reyes;
 
 Hyperboloid::Hyperboloid( const math::vec3& point1, const math::vec3& point2, float thetamax )
-: Geometry(vec2(0.0f, 1.0f), vec2(0.0f, 1.0f)),
+: Geometry(),
   point1_( point1 ),
   point2_( point2 ),
   thetamax_( thetamax )
 {   
 }
 
-Hyperboloid::Hyperboloid( const Hyperboloid& hyperboloid, const math::vec2& u_range, const math::vec2& v_range )
-: Geometry(u_range, v_range),
-  point1_( hyperboloid.point1_ ),
-  point2_( hyperboloid.point2_ ),
-  thetamax_( hyperboloid.thetamax_ )
-{   
-}
-
 bool Hyperboloid::boundable() const
 {
     return true;
 }
 
-void Hyperboloid::bound( const math::mat4x4& transform, vec3* minimum, vec3* maximum ) const
+void Hyperboloid::bound( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, vec3* minimum, vec3* maximum ) const
 {
     REYES_ASSERT( minimum );
     REYES_ASSERT( maximum );
@@ -53,19 +43,20 @@ void Hyperboloid::bound( const math::mat4x4& transform, vec3* minimum, vec3* max
     *minimum = vec3( FLT_MAX, FLT_MAX, FLT_MAX );
     *maximum = vec3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
     
-    Grid grid;
-    dice( transform, 8, 8, &grid );
-    const vec3* positions = grid["P"].vec3_values();
-    const vec3* positions_end = positions + grid["P"].size();
-    for ( const vec3* i = positions; i != positions_end; ++i )
-    {
-        minimum->x = min( minimum->x, i->x );
-        minimum->y = min( minimum->y, i->y );
-        minimum->z = min( minimum->z, i->z );        
-        maximum->x = max( maximum->x, i->x );
-        maximum->y = max( maximum->y, i->y );
-        maximum->z = max( maximum->z, i->z );
-    }
+    // Each point on the line being swept is offset in angle by its position 
+    // around the z axis and, as the line is straight, the extents are swept 
+    // by the points at either end of the range in v.
+    const float theta0 = u_range.x * thetamax_;
+    const float theta1 = u_range.y * thetamax_;
+    const vec3 r0 = lerp( point1_, point2_, v_range.x );
+    const vec3 r1 = lerp( point1_, point2_, v_range.y );
+    const float alpha0 = atan2f( r0.y, r0.x );
+    const float alpha1 = atan2f( r1.y, r1.x );
+    bound_arc( sqrtf(r0.x * r0.x + r0.y * r0.y), theta0 + alpha0, theta1 + alpha0, minimum, maximum );
+    bound_arc( sqrtf(r1.x * r1.x + r1.y * r1.y), theta0 + alpha1, theta1 + alpha1, minimum, maximum );
+    minimum->z = min( r0.z, r1.z );
+    maximum->z = max( r0.z, r1.z );
+    transform_bound( transform, minimum, maximum );
 }
 
 bool Hyperboloid::splittable() const
@@ -73,54 +64,26 @@ bool Hyperboloid::splittable() const
     return true;
 }
 
-void Hyperboloid::split( std::list<std::shared_ptr<Geometry>>* primitives ) const
-{
-    REYES_ASSERT( primitives );
-    REYES_ASSERT( u_range().y >= u_range().x );
-    REYES_ASSERT( v_range().y >= v_range().x );
-
-    const vec2& u_range = Geometry::u_range();
-    float u0 = u_range.x;
-    float u1 = (u_range.x + u_range.y) / 2.0f;
-    float u2 = u_range.y;
-
-    const vec2& v_range = Geometry::v_range();
-    float v0 = v_range.x;
-    float v1 = (v_range.x + v_range.y) / 2.0f;
-    float v2 = v_range.y;
-
-    shared_ptr<Geometry> hyperboloid;
-    hyperboloid.reset( new Hyperboloid(*this, vec2(u0, u1), vec2(v0, v1)) );
-    primitives->push_back( hyperboloid );
-    hyperboloid.reset( new Hyperboloid(*this, vec2(u0, u1), vec2(v1, v2)) );
-    primitives->push_back( hyperboloid );
-    hyperboloid.reset( new Hyperboloid(*this, vec2(u1, u2), vec2(v0, v1)) );
-    primitives->push_back( hyperboloid );
-    hyperboloid.reset( new Hyperboloid(*this, vec2(u1, u2), vec2(v1, v2)) );
-    primitives->push_back( hyperboloid );
-}
-
 bool Hyperboloid::diceable() const
 {
     return true;
 }
 
-void Hyperboloid::dice( const math::mat4x4& transform, int width, int height, Grid* grid ) const
+void Hyperboloid::dice( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, int width, int height, Grid* grid ) const
 {
     REYES_ASSERT( width > 0 );
     REYES_ASSERT( height > 0 );
     REYES_ASSERT( grid );
     
-    const vec2& u_range = Geometry::u_range();
-    const vec2& v_range = Geometry::v_range();
-
     grid->resize( width, height );
     grid->du_ = (u_range.y - u_range.x) / float(width - 1);
     grid->dv_ = (v_range.y - v_range.x) / float(height - 1);
     
-    vec3* positions = grid->value( "P", TYPE_POINT ).vec3_values();
-    float* s = grid->value( "s", TYPE_FLOAT ).float_values();
-    float* t = grid->value( "t", TYPE_FLOAT ).float_values();
+    vec3* positions = grid->value( GRID_SLOT_P, TYPE_POINT ).vec3_values();
+    vec3* u_derivatives = grid->value( GRID_SLOT_DPDU, TYPE_VECTOR ).vec3_values();
+    vec3* v_derivatives = grid->value( GRID_SLOT_DPDV, TYPE_VECTOR ).vec3_values();
+    float* s = grid->value( GRID_SLOT_S, TYPE_FLOAT ).float_values();
+    float* t = grid->value( GRID_SLOT_T, TYPE_FLOAT ).float_values();
     
     int vertex = 0;
     float v = v_range.x;
@@ -131,7 +94,13 @@ void Hyperboloid::dice( const math::mat4x4& transform, int width, int height, Gr
         float du = (u_range.y - u_range.x) / float(width - 1);
         for ( int i = 0; i < width; ++i )
         {
-            positions[vertex] = vec3( transform * vec4(position(u, v), 1.0f) );
+            vec3 position;
+            vec3 dpdu;
+            vec3 dpdv;
+            evaluate( u, v, &position, &dpdu, &dpdv );
+            positions[vertex] = vec3( transform * vec4(position, 1.0f) );
+            u_derivatives[vertex] = vec3( transform * vec4(dpdu, 0.0f) );
+            v_derivatives[vertex] = vec3( transform * vec4(dpdv, 0.0f) );
             s[vertex] = u;
             t[vertex] = v;
             u = min( u + du, u_range.y );
@@ -141,9 +110,17 @@ void Hyperboloid::dice( const math::mat4x4& transform, int width, int height, Gr
     }    
 }
 
-math::vec3 Hyperboloid::position( float u, float v ) const
+void Hyperboloid::evaluate( float u, float v, math::vec3* position, math::vec3* dpdu, math::vec3* dpdv ) const
 {
+    REYES_ASSERT( position );
+    REYES_ASSERT( dpdu );
+    REYES_ASSERT( dpdv );
     float theta = u * thetamax_;
+    float cos_theta = cosf( theta );
+    float sin_theta = sinf( theta );
     vec3 r = lerp( point1_, point2_, v );
-    return vec3( r.x * cosf(theta) - r.y * sinf(theta), r.x * sinf(theta) + r.y * cosf(theta), r.z );
+    vec3 dr = point2_ - point1_;
+    *position = vec3( r.x * cos_theta - r.y * sin_theta, r.x * sin_theta + r.y * cos_theta, r.z );
+    *dpdu = thetamax_ * vec3( -r.x * sin_theta - r.y * cos_theta, r.x * cos_theta - r.y * sin_theta, 0.0f );
+    *dpdv = vec3( dr.x * cos_theta - dr.y * sin_theta, dr.x * sin_theta + dr.y * cos_theta, dr.z );
 }
@@ -191,9 +191,22 @@ void ImageBuffer::expose( float gain, float gamma )
     }
 }
 
-void ImageBuffer::quantize( const ImageBuffer& image_buffer, float one, int minimum, int maximum, float dither )
+/**
+// Generate dither noise in the range [-1, 1].
+//
+// Each thread quantizing images passes its own generator so that workers
+// don't race on shared random number state.
+*/
+static float dither_noise( std::minstd_rand* random )
+{
+    REYES_ASSERT( random );
+    return float((*random)() - std::minstd_rand::min()) / (float(std::minstd_rand::max() - std::minstd_rand::min()) / 2.0f) - 1.0f;
+}
+
+void ImageBuffer::quantize( const ImageBuffer& image_buffer, float one, int minimum, int maximum, float dither, std::minstd_rand* random )
 {
     REYES_ASSERT( image_buffer.format_ == FORMAT_F32 );
+    REYES_ASSERT( random || dither == 0.0f );
 
     minimum = clamp( minimum, 0, 255 );
     maximum = clamp( maximum, 0, 255 );
@@ -204,10 +217,36 @@ void ImageBuffer::quantize( const ImageBuffer& image_buffer, float one, int mini
     int size = width_ * height_ * elements_;
     for ( int i = 0; i < size; ++i )
     {
-        quantized_pixels[i] = clamp( int(math::round(one * pixels[i] + dither * (float(rand()) / (RAND_MAX / 2) - 1.0f))), minimum, maximum );
+        const float noise = dither != 0.0f ? dither * dither_noise( random ) : 0.0f;
+        quantized_pixels[i] = clamp( int(math::round(one * pixels[i] + noise)), minimum, maximum );
     }    
 }
 
+void ImageBuffer::quantize( const ImageBuffer& image_buffer, int x, int y, float one, int minimum, int maximum, float dither, std::minstd_rand* random )
+{
+    REYES_ASSERT( image_buffer.format_ == FORMAT_F32 );
+    REYES_ASSERT( random || dither == 0.0f );
+    REYES_ASSERT( format_ == FORMAT_U8 );
+    REYES_ASSERT( elements_ == image_buffer.elements_ );
+    REYES_ASSERT( x >= 0 && x + image_buffer.width_ <= width_ );
+    REYES_ASSERT( y >= 0 && y + image_buffer.height_ <= height_ );
+
+    minimum = clamp( minimum, 0, 255 );
+    maximum = clamp( maximum, 0, 255 );
+
+    const int size = image_buffer.width_ * elements_;
+    for ( int yy = 0; yy < image_buffer.height_; ++yy )
+    {
+        unsigned char* quantized_pixels = u8_data( x, y + yy );
+        const float* pixels = image_buffer.f32_data( 0, yy );
+        for ( int i = 0; i < size; ++i )
+        {
+            const float noise = dither != 0.0f ? dither * dither_noise( random ) : 0.0f;
+            quantized_pixels[i] = clamp( int(math::round(one * pixels[i] + noise)), minimum, maximum );
+        }
+    }
+}
+
 void ImageBuffer::load( const char* filename, ErrorPolicy* error_policy )
 {
     REYES_ASSERT( filename );
@@ -2,6 +2,7 @@
 #define REYES_IMAGEBUFFER_HPP_INCLUDED
 
 #include <math/vec4.hpp>
+#include <random>
 
 namespace reyes
 {
@@ -45,7 +46,8 @@ class ImageBuffer
         void swap( ImageBuffer& image_buffer );
         void reset( int width = 0, int height = 0, int elements = 4, int format = 0, const void* data = 0 );
         void expose( float gain, float gamma );
-        void quantize( const ImageBuffer& image_buffer, float one, int minimum, int maximum, float dither );
+        void quantize( const ImageBuffer& image_buffer, float one, int minimum, int maximum, float dither, std::minstd_rand* random = nullptr );
+        void quantize( const ImageBuffer& image_buffer, int x, int y, float one, int minimum, int maximum, float dither, std::minstd_rand* random = nullptr );
 
         void load( const char* filename, ErrorPolicy* error_policy = nullptr );
         void save( const char* filename, ErrorPolicy* error_policy = nullptr ) const;
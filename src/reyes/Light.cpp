@@ -29,12 +29,12 @@ LightType Light::type() const
     return type_;
 }
 
-std::shared_ptr<Value> Light::color() const
+const std::shared_ptr<Value>& Light::color() const
 {
     return color_;
 }
 
-std::shared_ptr<Value> Light::opacity() const
+const std::shared_ptr<Value>& Light::opacity() const
 {
     return opacity_;
 }
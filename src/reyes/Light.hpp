@@ -28,8 +28,8 @@ public:
     ~Light();
     
     LightType type() const;
-    std::shared_ptr<Value> color() const;
-    std::shared_ptr<Value> opacity() const;
+    const std::shared_ptr<Value>& color() const;
+    const std::shared_ptr<Value>& opacity() const;
     const math::vec3& position() const;
     const math::vec3& axis() const;
     float angle() const;
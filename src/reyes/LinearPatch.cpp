@@ -20,12 +20,11 @@
 using std::min;
 using std::max;
 using std::vector;
-using std::shared_ptr;
 using namespace math;
 using namespace reyes;
 
 LinearPatch::LinearPatch( const math::vec3* positions, const math::vec3* normals, const math::vec2* texture_coordinates )
-: Geometry(vec2(0.0f, 1.0f), vec2(0.0f, 1.0f))
+: Geometry()
   //positions_(),
   //normals_(),
   //texture_coordinates_()
@@ -36,23 +35,12 @@ LinearPatch::LinearPatch( const math::vec3* positions, const math::vec3* normals
     memcpy( texture_coordinates_, texture_coordinates, sizeof(texture_coordinates_) );
 }
 
-LinearPatch::LinearPatch( const LinearPatch& patch, const math::vec2& u_range, const math::vec2& v_range )
-: Geometry(u_range, v_range)
-  //positions_(),
-  //normals_(),
-  //texture_coordinates_()
-{
-    memcpy( positions_, patch.positions_, sizeof(positions_) );
-    memcpy( normals_, patch.normals_, sizeof(normals_) );
-    memcpy( texture_coordinates_, patch.texture_coordinates_, sizeof(texture_coordinates_) );
-}
-
 bool LinearPatch::boundable() const
 {
     return true;
 }
 
-void LinearPatch::bound( const math::mat4x4& transform, math::vec3* minimum, math::vec3* maximum ) const
+void LinearPatch::bound( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, math::vec3* minimum, math::vec3* maximum ) const
 {
     REYES_ASSERT( minimum );
     REYES_ASSERT( maximum );
@@ -60,18 +48,23 @@ void LinearPatch::bound( const math::mat4x4& transform, math::vec3* minimum, mat
     *minimum = vec3( FLT_MAX, FLT_MAX, FLT_MAX );
     *maximum = vec3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
     
-    Grid grid;
-    dice( transform, 8, 8, &grid );
-    const vec3* positions = grid["P"].vec3_values();
-    const vec3* positions_end = positions + grid["P"].size();
-    for ( const vec3* i = positions; i != positions_end; ++i )
+    // The bound of a bilinear patch is the bound of its four corners.
+    const vec3 positions [4] = 
+    {
+        bilerp( positions_, u_range.x, v_range.x ),
+        bilerp( positions_, u_range.y, v_range.x ),
+        bilerp( positions_, u_range.y, v_range.y ),
+        bilerp( positions_, u_range.x, v_range.y )
+    };
+    for ( int i = 0; i < 4; ++i )
     {
-        minimum->x = min( minimum->x, i->x );
-        minimum->y = min( minimum->y, i->y );
-        minimum->z = min( minimum->z, i->z );        
-        maximum->x = max( maximum->x, i->x );
-        maximum->y = max( maximum->y, i->y );
-        maximum->z = max( maximum->z, i->z );
+        const vec3 position = vec3( transform * vec4(positions[i], 1.0f) );
+        minimum->x = min( minimum->x, position.x );
+        minimum->y = min( minimum->y, position.y );
+        minimum->z = min( minimum->z, position.z );
+        maximum->x = max( maximum->x, position.x );
+        maximum->y = max( maximum->y, position.y );
+        maximum->z = max( maximum->z, position.z );
     }
 }
 
@@ -80,55 +73,31 @@ bool LinearPatch::splittable() const
     return true;
 }
 
-void LinearPatch::split( std::list<std::shared_ptr<Geometry>>* primitives ) const
-{
-    REYES_ASSERT( primitives );
-    REYES_ASSERT( u_range().y >= u_range().x );
-    REYES_ASSERT( v_range().y >= v_range().x );
-
-    const vec2& u_range = Geometry::u_range();
-    float u0 = u_range.x;
-    float u1 = (u_range.x + u_range.y) / 2.0f;
-    float u2 = u_range.y;
-
-    const vec2& v_range = Geometry::v_range();
-    float v0 = v_range.x;
-    float v1 = (v_range.x + v_range.y) / 2.0f;
-    float v2 = v_range.y;
-
-    shared_ptr<Geometry> linear_patch;
-    linear_patch.reset( new LinearPatch(*this, vec2(u0, u1), vec2(v0, v1)) );
-    primitives->push_back( linear_patch );
-    linear_patch.reset( new LinearPatch(*this, vec2(u0, u1), vec2(v1, v2)) );
-    primitives->push_back( linear_patch );
-    linear_patch.reset( new LinearPatch(*this, vec2(u1, u2), vec2(v0, v1)) );
-    primitives->push_back( linear_patch );
-    linear_patch.reset( new LinearPatch(*this, vec2(u1, u2), vec2(v1, v2)) );
-    primitives->push_back( linear_patch );
-}
-
 bool LinearPatch::diceable() const
 {
     return true;
 }
 
-void LinearPatch::dice( const math::mat4x4& transform, int width, int height, Grid* grid ) const
+void LinearPatch::dice( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, int width, int height, Grid* grid ) const
 {
     REYES_ASSERT( width > 0 );
     REYES_ASSERT( height > 0 );
     REYES_ASSERT( grid );
     
-    const vec2& u_range = Geometry::u_range();
-    const vec2& v_range = Geometry::v_range();
-
     grid->resize( width, height );
     grid->du_ = (u_range.y - u_range.x) / float(width - 1);
     grid->dv_ = (v_range.y - v_range.x) / float(height - 1);
     
-    vec3* positions = grid->value( "P", TYPE_POINT ).vec3_values();
-    vec3* normals = grid->value( "N", TYPE_NORMAL ).vec3_values();
-    float* s = grid->value( "s", TYPE_FLOAT ).float_values();
-    float* t = grid->value( "t", TYPE_FLOAT ).float_values();
+    vec3* positions = grid->value( GRID_SLOT_P, TYPE_POINT ).vec3_values();
+    vec3* normals = grid->value( GRID_SLOT_N, TYPE_NORMAL ).vec3_values();
+    vec3* u_derivatives = grid->value( GRID_SLOT_DPDU, TYPE_VECTOR ).vec3_values();
+    vec3* v_derivatives = grid->value( GRID_SLOT_DPDV, TYPE_VECTOR ).vec3_values();
+    const vec3 dpdu0 = vec3( transform * vec4(positions_[1] - positions_[0], 0.0f) );
+    const vec3 dpdu1 = vec3( transform * vec4(positions_[2] - positions_[3], 0.0f) );
+    const vec3 dpdv0 = vec3( transform * vec4(positions_[3] - positions_[0], 0.0f) );
+    const vec3 dpdv1 = vec3( transform * vec4(positions_[2] - positions_[1], 0.0f) );
+    float* s = grid->value( GRID_SLOT_S, TYPE_FLOAT ).float_values();
+    float* t = grid->value( GRID_SLOT_T, TYPE_FLOAT ).float_values();
     
     int vertex = 0;
     float v = v_range.x;
@@ -141,6 +110,8 @@ void LinearPatch::dice( const math::mat4x4& transform, int width, int height, Gr
         {
             positions[vertex] = vec3( transform * vec4(bilerp(positions_, u, v), 1.0f) );
             normals[vertex] = vec3( transform * vec4(bilerp(normals_, u, v), 1.0f) );
+            u_derivatives[vertex] = lerp( dpdu0, dpdu1, v );
+            v_derivatives[vertex] = lerp( dpdv0, dpdv1, u );
             vec2 st = bilerp( texture_coordinates_, u, v );
             s[vertex] = st.x;
             t[vertex] = st.y;
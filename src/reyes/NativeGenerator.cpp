@@ -0,0 +1,382 @@
+//
+// NativeGenerator.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "stdafx.hpp"
+#include "NativeGenerator.hpp"
+#include "Shader.hpp"
+#include "VirtualMachine.hpp"
+#include <reyes/reyes_virtual_machine/Instruction.hpp>
+#include <reyes/reyes_virtual_machine/Dispatch.hpp>
+#include <reyes/reyes_virtual_machine/Operation.hpp>
+#include "assert.hpp"
+#include <algorithm>
+#include <stdarg.h>
+#include <stdio.h>
+#include <ctype.h>
+
+using std::find;
+using std::vector;
+using std::string;
+using namespace reyes;
+
+/**
+// The kernels that generated code calls directly for operations.
+//
+// The kernel for each operation is named for its family and the dispatch 
+// encoded with the operation (e.g. multiply_v3v3()).  Operations without a
+// kernel here are executed by the virtual machine.
+*/
+namespace reyes
+{
+
+enum KernelForm
+{
+    KERNEL_BINARY, ///< Reset the result to \e type and combine two operands.
+    KERNEL_DOT, ///< Reset the result to a float and take the dot product of two vectors.
+    KERNEL_NEGATE, ///< Reset the result to the operand's type and negate it.
+    KERNEL_ASSIGN, ///< Reset the first operand to the second's type and assign the second to it under the condition mask.
+    KERNEL_UPDATE ///< Update the first operand with the second under the condition mask.
+};
+
+struct Kernel
+{
+    int instruction; ///< The instruction executed by the kernel.
+    const char* name; ///< The name of the kernel family.
+    KernelForm form; ///< The form of the call to the kernel.
+    const char* type; ///< The expression for the type of the result of binary kernels.
+    const char* result; ///< The pointer type that results are passed as.
+    const char* operand; ///< The pointer type that operands are passed as.
+};
+
+}
+
+static const Kernel KERNELS [] =
+{
+    { INSTRUCTION_DOT, "dot", KERNEL_DOT, "reyes::TYPE_FLOAT", "float*", "const float*" },
+    { INSTRUCTION_MULTIPLY, "multiply", KERNEL_BINARY, "lhs->type()", "float*", "const float*" },
+    { INSTRUCTION_DIVIDE, "divide", KERNEL_BINARY, "lhs->type()", "float*", "const float*" },
+    { INSTRUCTION_ADD, "add", KERNEL_BINARY, "lhs->type()", "float*", "const float*" },
+    { INSTRUCTION_SUBTRACT, "subtract", KERNEL_BINARY, "lhs->type()", "float*", "const float*" },
+    { INSTRUCTION_GREATER, "greater", KERNEL_BINARY, "reyes::TYPE_INTEGER", "int*", "const float*" },
+    { INSTRUCTION_GREATER_EQUAL, "greater_equal", KERNEL_BINARY, "reyes::TYPE_INTEGER", "int*", "const float*" },
+    { INSTRUCTION_LESS, "less", KERNEL_BINARY, "reyes::TYPE_INTEGER", "int*", "const float*" },
+    { INSTRUCTION_LESS_EQUAL, "less_equal", KERNEL_BINARY, "reyes::TYPE_INTEGER", "int*", "const float*" },
+    { INSTRUCTION_AND, "logical_and", KERNEL_BINARY, "reyes::TYPE_INTEGER", "int*", "const int*" },
+    { INSTRUCTION_OR, "logical_or", KERNEL_BINARY, "reyes::TYPE_INTEGER", "int*", "const int*" },
+    { INSTRUCTION_EQUAL, "equal", KERNEL_BINARY, "lhs->type()", "int*", "const float*" },
+    { INSTRUCTION_NOT_EQUAL, "not_equal", KERNEL_BINARY, "reyes::TYPE_INTEGER", "int*", "const float*" },
+    { INSTRUCTION_NEGATE, "negate", KERNEL_NEGATE, NULL, "float*", "const float*" },
+    { INSTRUCTION_ASSIGN, "assign", KERNEL_ASSIGN, NULL, "float*", "const float*" },
+    { INSTRUCTION_ADD_ASSIGN, "add_assign", KERNEL_UPDATE, NULL, "float*", "const float*" },
+    { INSTRUCTION_SUBTRACT_ASSIGN, "subtract_assign", KERNEL_UPDATE, NULL, "float*", "const float*" },
+    { INSTRUCTION_MULTIPLY_ASSIGN, "multiply_assign", KERNEL_UPDATE, NULL, "float*", "const float*" },
+    { INSTRUCTION_DIVIDE_ASSIGN, "divide_assign", KERNEL_UPDATE, NULL, "float*", "const float*" }
+};
+
+/**
+// Find the kernel that executes \e instruction or null if it is executed by
+// the virtual machine.
+*/
+static const Kernel* find_kernel( int instruction )
+{
+    for ( unsigned int i = 0; i < sizeof(KERNELS) / sizeof(KERNELS[0]); ++i )
+    {
+        if ( KERNELS[i].instruction == instruction )
+        {
+            return &KERNELS[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+// Get the suffix naming the kernel for one operand of a dispatch (e.g. "v3"
+// for DISPATCH_V3).
+*/
+static string dispatch_suffix( int dispatch )
+{
+    char buffer [16];
+    snprintf( buffer, sizeof(buffer), "%c%d", (dispatch & DISPATCH_VARYING) ? 'v' : 'u', (dispatch & 0x0f) + 1 );
+    return string( buffer );
+}
+
+NativeGenerator::NativeGenerator()
+: source_(),
+  identifiers_()
+{
+    write( "//\n" );
+    write( "// Generated by reyes::NativeGenerator, do not edit.\n" );
+    write( "//\n" );
+    write( "\n" );
+    write( "#include <reyes/NativeShader.hpp>\n" );
+    write( "#include <reyes/NativeVirtualMachine.hpp>\n" );
+    write( "#include <reyes/Renderer.hpp>\n" );
+    write( "#include <reyes/Value.hpp>\n" );
+    for ( unsigned int i = 0; i < sizeof(KERNELS) / sizeof(KERNELS[0]); ++i )
+    {
+        write( "#include <reyes/reyes_virtual_machine/%s.hpp>\n", KERNELS[i].name );
+    }
+    write( "#include <algorithm>\n" );
+}
+
+/**
+// Generate source for a shader.
+//
+// @param shader
+//  The shader to generate source for.
+//
+// @param filename
+//  The filename that \e shader was loaded from (assumed not null), the 
+//  filename without directories names the generated NativeShader and 
+//  identifies the shader it is used for at run time.
+*/
+void NativeGenerator::generate( const Shader& shader, const char* filename )
+{
+    REYES_ASSERT( filename );
+
+    const char* name = filename;
+    for ( const char* i = filename; *i; ++i )
+    {
+        if ( *i == '/' || *i == '\\' )
+        {
+            name = i + 1;
+        }
+    }
+
+    // The identifier is the name without its extension and with any 
+    // characters that can't be used in C++ identifiers replaced.
+    string identifier;
+    for ( const char* i = name; *i && *i != '.'; ++i )
+    {
+        identifier.push_back( isalnum(*i) ? *i : '_' );
+    }
+    if ( identifier.empty() || isdigit(identifier[0]) )
+    {
+        identifier.insert( identifier.begin(), '_' );
+    }
+    string unique_identifier = identifier;
+    for ( int suffix = 2; find(identifiers_.begin(), identifiers_.end(), unique_identifier) != identifiers_.end(); ++suffix )
+    {
+        char buffer [16];
+        snprintf( buffer, sizeof(buffer), "_%d", suffix );
+        unique_identifier = identifier + buffer;
+    }
+    identifier = unique_identifier;
+    identifiers_.push_back( identifier );
+
+    write( "\n" );
+    write( "// %s\n", name );
+    write( "namespace\n" );
+    write( "{\n" );
+    write( "\n" );
+    generate_fragment( shader, identifier, "initialize", shader.initialize_operation(), shader.shade_operation() );
+    generate_fragment( shader, identifier, "shade", shader.shade_operation(), shader.end_operation() );
+    write( "}\n" );
+    write( "\n" );
+    write( "extern const reyes::NativeShader %s_native_shader;\n", identifier.c_str() );
+    write( "const reyes::NativeShader %s_native_shader =\n", identifier.c_str() );
+    write( "{\n" );
+    write( "    \"%s\",\n", name );
+    write( "    0x%016llxull,\n", (unsigned long long) shader.fingerprint() );
+    write( "    &%s_initialize,\n", identifier.c_str() );
+    write( "    &%s_shade\n", identifier.c_str() );
+    write( "};\n" );
+}
+
+/**
+// Generate a function that adds every native shader generated so far to a
+// Renderer.
+//
+// @param function
+//  The name of the function to generate (assumed not null), the function
+//  is declared as `void function( reyes::Renderer& renderer )`.
+*/
+void NativeGenerator::generate_registration( const char* function )
+{
+    REYES_ASSERT( function );
+    write( "\n" );
+    write( "void %s( reyes::Renderer& renderer )\n", function );
+    write( "{\n" );
+    for ( vector<string>::const_iterator i = identifiers_.begin(); i != identifiers_.end(); ++i )
+    {
+        write( "    renderer.add_native_shader( &%s_native_shader );\n", i->c_str() );
+    }
+    if ( identifiers_.empty() )
+    {
+        write( "    (void) renderer;\n" );
+    }
+    write( "}\n" );
+}
+
+const std::string& NativeGenerator::source() const
+{
+    return source_;
+}
+
+void NativeGenerator::generate_fragment( const Shader& shader, const std::string& identifier, const char* fragment, int start, int finish )
+{
+    REYES_ASSERT( fragment );
+    REYES_ASSERT( start >= 0 && start <= finish );
+    REYES_ASSERT( finish <= shader.end_operation() );
+
+    // Labels are only generated for operations that are jumped to, unused 
+    // labels generate warnings.
+    const vector<Operation>& operations = shader.operations();
+    vector<bool> targets( finish - start + 1, false );
+    for ( int i = start; i < finish; ++i )
+    {
+        const int target = operations[i].target;
+        if ( target >= 0 )
+        {
+            REYES_ASSERT( target >= start && target <= finish );
+            targets[target - start] = true;
+        }
+    }
+
+    write( "void %s_%s( reyes::NativeVirtualMachine& %s )\n", identifier.c_str(), fragment, start < finish ? "virtual_machine" : "/*virtual_machine*/" );
+    write( "{\n" );
+    for ( int i = start; i < finish; ++i )
+    {
+        if ( targets[i - start] )
+        {
+            write( "operation_%d:\n", i );
+        }
+        generate_operation( operations[i], i );
+    }
+    if ( targets[finish - start] )
+    {
+        write( "operation_%d:\n", finish );
+        write( "    return;\n" );
+    }
+    write( "}\n" );
+    write( "\n" );
+}
+
+void NativeGenerator::generate_operation( const Operation& operation, int index )
+{
+    // Kernels are only called directly with interleaved values, operations 
+    // that read planes are executed by their handlers.
+    const Kernel* kernel = find_kernel( operation.instruction );
+    if ( kernel && !operation.planes )
+    {
+        generate_kernel( *kernel, operation );
+        return;
+    }
+
+    switch ( operation.instruction )
+    {
+        case INSTRUCTION_HALT:
+            write( "    return;\n" );
+            break;
+
+        case INSTRUCTION_JUMP_EMPTY:
+            write( "    if ( virtual_machine.mask_empty() )\n" );
+            write( "    {\n" );
+            write( "        virtual_machine.pop_mask();\n" );
+            write( "        goto operation_%d;\n", operation.target );
+            write( "    }\n" );
+            break;
+
+        case INSTRUCTION_JUMP_NOT_EMPTY:
+            write( "    if ( !virtual_machine.mask_empty() )\n" );
+            write( "    {\n" );
+            write( "        goto operation_%d;\n", operation.target );
+            write( "    }\n" );
+            break;
+
+        case INSTRUCTION_JUMP_ILLUMINANCE:
+            write( "    if ( !virtual_machine.next_light() )\n" );
+            write( "    {\n" );
+            write( "        goto operation_%d;\n", operation.target );
+            write( "    }\n" );
+            break;
+
+        case INSTRUCTION_JUMP:
+            write( "    goto operation_%d;\n", operation.target );
+            break;
+
+        default:
+            write( "    virtual_machine.execute( %d );\n", index );
+            break;
+    }
+}
+
+/**
+// Generate a direct call to the kernel that executes \e operation.
+//
+// The kernel is chosen from the dispatch encoded with the operation and 
+// the values in its registers are reset to the same types, storages, and 
+// sizes that the virtual machine resets them to before calling the same 
+// kernel.
+*/
+void NativeGenerator::generate_kernel( const Kernel& kernel, const Operation& operation )
+{
+    const int result_dispatch = (operation.dispatch >> 8) & 0xff;
+    const int dispatch = operation.dispatch & 0xff;
+    const string suffix = kernel.form == KERNEL_NEGATE ? dispatch_suffix( dispatch ) : dispatch_suffix( result_dispatch ) + dispatch_suffix( dispatch );
+    const char* name = kernel.name;
+    write( "    {\n" );
+    switch ( kernel.form )
+    {
+        case KERNEL_BINARY:
+            write( "        reyes::Value* lhs = virtual_machine.value( %d );\n", operation.arguments[0] );
+            write( "        reyes::Value* rhs = virtual_machine.value( %d );\n", operation.arguments[1] );
+            write( "        reyes::Value* result = virtual_machine.value( %d );\n", operation.result );
+            write( "        result->reset( %s, std::max(lhs->storage(), rhs->storage()), lhs->size() );\n", kernel.type );
+            write( "        reyes::%s_%s( reinterpret_cast<%s>(result->values()), reinterpret_cast<%s>(lhs->values()), reinterpret_cast<%s>(rhs->values()), lhs->size() );\n", name, suffix.c_str(), kernel.result, kernel.operand, kernel.operand );
+            break;
+
+        case KERNEL_DOT:
+            write( "        reyes::Value* lhs = virtual_machine.value( %d );\n", operation.arguments[0] );
+            write( "        reyes::Value* rhs = virtual_machine.value( %d );\n", operation.arguments[1] );
+            write( "        reyes::Value* result = virtual_machine.value( %d );\n", operation.result );
+            write( "        const unsigned int length = std::max( lhs->size(), rhs->size() );\n" );
+            write( "        result->reset( %s, std::max(lhs->storage(), rhs->storage()), length );\n", kernel.type );
+            write( "        reyes::%s_%s( reinterpret_cast<%s>(result->values()), reinterpret_cast<%s>(lhs->values()), reinterpret_cast<%s>(rhs->values())%s );\n", name, suffix.c_str(), kernel.result, kernel.operand, kernel.operand, operation.dispatch == DISPATCH_U3U3 ? "" : ", length" );
+            break;
+
+        case KERNEL_NEGATE:
+            write( "        reyes::Value* value = virtual_machine.value( %d );\n", operation.arguments[0] );
+            write( "        reyes::Value* result = virtual_machine.value( %d );\n", operation.result );
+            write( "        result->reset( value->type(), value->storage(), value->size() );\n" );
+            write( "        reyes::%s_%s( reinterpret_cast<%s>(result->values()), reinterpret_cast<%s>(value->values()), value->size() );\n", name, suffix.c_str(), kernel.result, kernel.operand );
+            break;
+
+        case KERNEL_ASSIGN:
+        case KERNEL_UPDATE:
+        {
+            // Kernels with uniform results take no mask, those with varying 
+            // results take the condition mask when their operand is varying.
+            const char* mask = "";
+            if ( result_dispatch & DISPATCH_VARYING )
+            {
+                mask = (dispatch & DISPATCH_VARYING) ? "virtual_machine.mask(), " : "NULL, ";
+            }
+            write( "        reyes::Value* result = virtual_machine.value( %d );\n", operation.arguments[0] );
+            write( "        reyes::Value* rhs = virtual_machine.value( %d );\n", operation.arguments[1] );
+            if ( kernel.form == KERNEL_ASSIGN )
+            {
+                write( "        result->reset( rhs->type(), rhs->storage(), rhs->size() );\n" );
+            }
+            write( "        reyes::%s_%s( reinterpret_cast<%s>(result->values()), reinterpret_cast<%s>(rhs->values()), %srhs->size() );\n", name, suffix.c_str(), kernel.result, kernel.operand, mask );
+            break;
+        }
+    }
+    write( "    }\n" );
+}
+
+void NativeGenerator::write( const char* format, ... )
+{
+    REYES_ASSERT( format );
+
+    char buffer [1024];
+    va_list args;
+    va_start( args, format );
+    int length = vsnprintf( buffer, sizeof(buffer), format, args );
+    va_end( args );
+    REYES_ASSERT( length >= 0 && length < int(sizeof(buffer)) );
+    (void) length;
+    source_.append( buffer );
+}
@@ -0,0 +1,50 @@
+#ifndef REYES_NATIVEGENERATOR_HPP_INCLUDED
+#define REYES_NATIVEGENERATOR_HPP_INCLUDED
+
+#include <vector>
+#include <string>
+
+namespace reyes
+{
+
+class Shader;
+struct Operation;
+struct Kernel;
+
+/**
+// Generate C++ source that executes shaders natively.
+//
+// Shaders are translated from the operations decoded from the byte code 
+// that the CodeGenerator generated from their analyzed syntax trees.  Each
+// code fragment becomes a function that calls the kernel for each 
+// operation, chosen from the operation's dispatch, directly and branches 
+// instead of jumping so that no operations are fetched or dispatched when
+// the generated code executes.  Operations without a single kernel 
+// (transforms, texture lookups, function calls, and light statements) are
+// executed by the virtual machine through NativeVirtualMachine.
+//
+// The generated source defines a NativeShader for each shader that can be
+// passed to Renderer::add_native_shader() and optionally a function that 
+// adds all of them.
+*/
+class NativeGenerator
+{
+    std::string source_; ///< The source generated so far.
+    std::vector<std::string> identifiers_; ///< The identifiers of the shaders that source has been generated for.
+
+public:
+    NativeGenerator();
+    void generate( const Shader& shader, const char* filename );
+    void generate_registration( const char* function );
+    const std::string& source() const;
+
+private:
+    void generate_fragment( const Shader& shader, const std::string& identifier, const char* fragment, int start, int finish );
+    void generate_operation( const Operation& operation, int index );
+    void generate_kernel( const Kernel& kernel, const Operation& operation );
+    void write( const char* format, ... );
+};
+
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef REYES_NATIVESHADER_HPP_INCLUDED
+#define REYES_NATIVESHADER_HPP_INCLUDED
+
+#include <stdint.h>
+
+namespace reyes
+{
+
+class NativeVirtualMachine;
+
+/**
+// A shader compiled ahead of time into C++ (see NativeGenerator).
+//
+// The functions execute the initialize and shade code fragments by calling
+// kernels directly, with the kernel for each operation chosen when the code
+// was generated, so nothing is fetched or dispatched while shading.  
+// Generated code refers to registers and operations by the 
+// indices assigned when the shader was compiled so it is only used for a 
+// Shader whose byte code has the same fingerprint, see
+// Renderer::add_native_shader().
+*/
+struct NativeShader
+{
+    typedef void (*Function)( NativeVirtualMachine& virtual_machine );
+
+    const char* name; ///< The filename, without directories, of the shader that this was generated from (e.g. "plastic.sl").
+    uint64_t fingerprint; ///< The fingerprint of the byte code that this was generated from (see Shader::fingerprint()).
+    Function initialize; ///< Execute the initialize code fragment.
+    Function shade; ///< Execute the shade code fragment.
+};
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+//
+// NativeVirtualMachine.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "stdafx.hpp"
+#include "NativeVirtualMachine.hpp"
+#include "VirtualMachine.hpp"
+#include <reyes/reyes_virtual_machine/Operation.hpp>
+#include "assert.hpp"
+
+using namespace reyes;
+
+NativeVirtualMachine::NativeVirtualMachine( VirtualMachine& virtual_machine )
+: virtual_machine_( virtual_machine )
+{
+}
+
+/**
+// Get the value in a register.
+//
+// @param index
+//  The index of the register as assigned when the shader was decoded.
+*/
+Value* NativeVirtualMachine::value( int index ) const
+{
+    REYES_ASSERT( index >= 0 && index < int(virtual_machine_.registers_.size()) );
+    return virtual_machine_.registers_[index];
+}
+
+/**
+// Get the bits of the current condition mask to pass to masked kernels or
+// null if every element is selected.
+*/
+const uint64_t* NativeVirtualMachine::mask() const
+{
+    return virtual_machine_.get_mask();
+}
+
+bool NativeVirtualMachine::mask_empty() const
+{
+    return virtual_machine_.mask_empty();
+}
+
+void NativeVirtualMachine::pop_mask()
+{
+    virtual_machine_.pop_mask();
+}
+
+bool NativeVirtualMachine::next_light()
+{
+    return virtual_machine_.next_light();
+}
+
+/**
+// Execute an operation of the shader that is being executed by calling its
+// handler.
+//
+// @param index
+//  The index of the operation in the shader's decoded operations, native 
+//  code is only used for shaders whose byte code, and so operations, 
+//  match those that it was generated from.
+*/
+void NativeVirtualMachine::execute( int index )
+{
+    REYES_ASSERT( virtual_machine_.operations_begin_ );
+    REYES_ASSERT( virtual_machine_.operations_begin_ + index < virtual_machine_.operations_end_ );
+    const Operation& operation = virtual_machine_.operations_begin_[index];
+    (virtual_machine_.*operation.handler)( operation );
+}
@@ -0,0 +1,38 @@
+#ifndef REYES_NATIVEVIRTUALMACHINE_HPP_INCLUDED
+#define REYES_NATIVEVIRTUALMACHINE_HPP_INCLUDED
+
+#include <stdint.h>
+
+namespace reyes
+{
+
+class Value;
+class VirtualMachine;
+
+/**
+// The part of a VirtualMachine that shaders compiled ahead of time use 
+// (see NativeGenerator).
+//
+// Generated code calls kernels directly on the values in registers and 
+// only asks the virtual machine to execute the operations that have no 
+// single kernel (transforms, texture lookups, function calls, and light
+// statements), to test and pop condition masks, and to step through 
+// lights in illuminance statements.
+*/
+class NativeVirtualMachine
+{
+    VirtualMachine& virtual_machine_; ///< The virtual machine executing the shader.
+
+public:
+    NativeVirtualMachine( VirtualMachine& virtual_machine );
+    Value* value( int index ) const;
+    const uint64_t* mask() const;
+    bool mask_empty() const;
+    void pop_mask();
+    bool next_light();
+    void execute( int index );
+};
+
+}
+
+#endif
@@ -0,0 +1,652 @@
+//
+// Optimizer.cpp
+// Copyright (c) Charles Baker.  All rights reserved.
+//
+
+#include "stdafx.hpp"
+#include "Optimizer.hpp"
+#include "SyntaxNode.hpp"
+#include "Symbol.hpp"
+#include "ErrorPolicy.hpp"
+#include "assert.hpp"
+#include <stdio.h>
+
+using std::map;
+using std::vector;
+using std::shared_ptr;
+using namespace reyes;
+
+Optimizer::SymbolUsage::SymbolUsage()
+: reads_( 0 ),
+  writes_( 0 ),
+  removable_( true ),
+  parameter_( false ),
+  definition_( NULL )
+{
+}
+
+Optimizer::Optimizer( ErrorPolicy* error_policy )
+: error_policy_( error_policy ),
+  usages_()
+{
+}
+
+/**
+// Optimize a syntax tree.
+//
+// Only literals are folded, conditions that depend on uniform values (e.g. 
+// shader parameters) are still evaluated at run time where the virtual 
+// machine skips the statements that they guard once per grid.
+//
+// @param node
+//  The root of the syntax tree to optimize (must have been analyzed by the
+//  SemanticAnalyzer without errors).
+*/
+void Optimizer::optimize( SyntaxNode* node )
+{
+    usages_.clear();
+
+    if ( node && (!error_policy_ || error_policy_->total_errors() == 0) )
+    {
+        SyntaxNode* shader_node = node->node( 0 );
+        find_usages( shader_node, false );
+        propagate_constants( shader_node );
+        fold_constants( shader_node );
+        prune_branches( shader_node );
+
+        usages_.clear();
+        find_usages( shader_node, false );
+        eliminate_dead_stores( shader_node );
+        usages_.clear();
+    }
+}
+
+void Optimizer::find_usages( const SyntaxNode* node, bool statement )
+{
+    REYES_ASSERT( node );
+
+    switch ( node->node_type() )
+    {
+        case SHADER_NODE_SURFACE_SHADER:
+        case SHADER_NODE_VOLUME_SHADER:
+        case SHADER_NODE_LIGHT_SHADER:
+        case SHADER_NODE_DISPLACEMENT_SHADER:
+        case SHADER_NODE_IMAGER_SHADER:
+        {
+            // Parameters are read by the renderer and written from outside 
+            // of the shader so only the variables declared in the shader's 
+            // statements are tracked as local variables.
+            find_usages( node->node(0), false );
+            const vector<shared_ptr<SyntaxNode>>& parameters = node->node( 0 )->nodes();
+            for ( vector<shared_ptr<SyntaxNode>>::const_iterator i = parameters.begin(); i != parameters.end(); ++i )
+            {
+                SymbolUsage& usage = usages_[(*i)->symbol().get()];
+                usage.definition_ = NULL;
+                usage.parameter_ = true;
+            }
+            find_usages( node->node(1), true );
+            break;
+        }
+
+        case SHADER_NODE_VARIABLE:
+        {
+            SymbolUsage& usage = usages_[node->symbol().get()];
+            usage.definition_ = node;
+            if ( node->node(0)->node_type() != SHADER_NODE_NULL )
+            {
+                ++usage.writes_;
+                usage.removable_ = usage.removable_ && !has_side_effects( node->node(0) );
+            }
+            find_usages( node->node(0), false );
+            break;
+        }
+
+        case SHADER_NODE_ASSIGN:
+        case SHADER_NODE_ADD_ASSIGN:
+        case SHADER_NODE_SUBTRACT_ASSIGN:
+        case SHADER_NODE_MULTIPLY_ASSIGN:
+        case SHADER_NODE_DIVIDE_ASSIGN:
+        {
+            SymbolUsage& usage = usages_[node->symbol().get()];
+            ++usage.writes_;
+            usage.removable_ = usage.removable_ && statement && !has_side_effects( node->node(0) );
+            find_usages( node->node(0), false );
+            break;
+        }
+
+        case SHADER_NODE_IDENTIFIER:
+            ++usages_[node->symbol().get()].reads_;
+            break;
+
+        case SHADER_NODE_CALL:
+        {
+            bool writes = writes_arguments( node );
+            const vector<shared_ptr<SyntaxNode>>& nodes = node->nodes();
+            for ( vector<shared_ptr<SyntaxNode>>::const_iterator i = nodes.begin(); i != nodes.end(); ++i )
+            {
+                const SyntaxNode* argument_node = i->get();
+                REYES_ASSERT( argument_node );
+                if ( writes && argument_node->node_type() == SHADER_NODE_IDENTIFIER )
+                {
+                    ++usages_[argument_node->symbol().get()].writes_;
+                }
+                find_usages( argument_node, false );
+            }
+            break;
+        }
+
+        default:
+        {
+            const vector<shared_ptr<SyntaxNode>>& nodes = node->nodes();
+            for ( unsigned int i = 0; i < nodes.size(); ++i )
+            {
+                const SyntaxNode* syntax_node = nodes[i].get();
+                REYES_ASSERT( syntax_node );
+                find_usages( syntax_node, child_statement(node, i) );
+            }
+            break;
+        }
+    }
+}
+
+/**
+// Replace reads of variables that are assigned a literal when they are 
+// declared, and never written again, with that literal and reads of 
+// variables that are assigned a copy of another variable when they are 
+// declared, and never written again, with reads of that other variable.
+//
+// Definitions are visited before the reads that they reach so chains of 
+// copies collapse onto the first variable in the chain in a single pass.
+// The copies themselves are left unread and are removed as dead stores.
+*/
+void Optimizer::propagate_constants( SyntaxNode* node ) const
+{
+    REYES_ASSERT( node );
+
+    if ( node->node_type() == SHADER_NODE_IDENTIFIER )
+    {
+        map<const Symbol*, SymbolUsage>::const_iterator i = usages_.find( node->symbol().get() );
+        if ( i != usages_.end() && constant_definition(i->second) )
+        {
+            const SyntaxNode* literal_node = i->second.definition_->node( 0 );
+            node->set_node_type( literal_node->node_type() );
+            node->set_lexeme( literal_node->lexeme() );
+            node->set_symbol( shared_ptr<Symbol>() );
+        }
+        else if ( i != usages_.end() )
+        {
+            const SyntaxNode* source_node = copy_definition( i->second );
+            if ( source_node )
+            {
+                node->set_lexeme( source_node->lexeme() );
+                node->set_symbol( source_node->symbol() );
+            }
+        }
+    }
+
+    const vector<shared_ptr<SyntaxNode>>& nodes = node->nodes();
+    for ( vector<shared_ptr<SyntaxNode>>::const_iterator i = nodes.begin(); i != nodes.end(); ++i )
+    {
+        SyntaxNode* syntax_node = i->get();
+        REYES_ASSERT( syntax_node );
+        propagate_constants( syntax_node );
+    }
+}
+
+/**
+// Replace arithmetic and negation on float literals with the literal that
+// they evaluate to.
+*/
+void Optimizer::fold_constants( SyntaxNode* node ) const
+{
+    REYES_ASSERT( node );
+
+    const vector<shared_ptr<SyntaxNode>>& nodes = node->nodes();
+    for ( vector<shared_ptr<SyntaxNode>>::const_iterator i = nodes.begin(); i != nodes.end(); ++i )
+    {
+        SyntaxNode* syntax_node = i->get();
+        REYES_ASSERT( syntax_node );
+        fold_constants( syntax_node );
+    }
+
+    switch ( node->node_type() )
+    {
+        case SHADER_NODE_MULTIPLY:
+        case SHADER_NODE_DIVIDE:
+        case SHADER_NODE_ADD:
+        case SHADER_NODE_SUBTRACT:
+            if ( node->original_type() == TYPE_FLOAT && numeric_literal(node->node(0)) && numeric_literal(node->node(1)) )
+            {
+                float lhs = node->node( 0 )->real();
+                float rhs = node->node( 1 )->real();
+                switch ( node->node_type() )
+                {
+                    case SHADER_NODE_MULTIPLY:
+                        replace_with_literal( node, lhs * rhs );
+                        break;
+
+                    case SHADER_NODE_DIVIDE:
+                        if ( rhs != 0.0f )
+                        {
+                            replace_with_literal( node, lhs / rhs );
+                        }
+                        break;
+
+                    case SHADER_NODE_ADD:
+                        replace_with_literal( node, lhs + rhs );
+                        break;
+
+                    case SHADER_NODE_SUBTRACT:
+                        replace_with_literal( node, lhs - rhs );
+                        break;
+
+                    default:
+                        REYES_ASSERT( false );
+                        break;
+                }
+            }
+            break;
+
+        case SHADER_NODE_NEGATE:
+            if ( node->original_type() == TYPE_FLOAT && numeric_literal(node->node(0)) )
+            {
+                replace_with_literal( node, -node->node(0)->real() );
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+// Replace if, while, and for statements whose conditions compare literals 
+// with the statements that they would always execute.
+*/
+void Optimizer::prune_branches( SyntaxNode* node ) const
+{
+    REYES_ASSERT( node );
+
+    bool value = false;
+    switch ( node->node_type() )
+    {
+        case SHADER_NODE_IF:
+        case SHADER_NODE_IF_ELSE:
+            if ( evaluate_condition(node->node(0), &value) )
+            {
+                shared_ptr<SyntaxNode> statement_node;
+                if ( value )
+                {
+                    statement_node = node->nodes()[1];
+                }
+                else if ( node->node_type() == SHADER_NODE_IF_ELSE )
+                {
+                    statement_node = node->nodes()[2];
+                }
+                replace_with_list( node );
+                if ( statement_node )
+                {
+                    node->add_node( statement_node );
+                }
+            }
+            break;
+
+        case SHADER_NODE_WHILE:
+            if ( evaluate_condition(node->node(0), &value) && !value )
+            {
+                replace_with_list( node );
+            }
+            break;
+
+        case SHADER_NODE_FOR:
+            if ( evaluate_condition(node->node(1), &value) && !value )
+            {
+                shared_ptr<SyntaxNode> initialize_statement_node = node->nodes()[0];
+                replace_with_list( node );
+                node->add_node( initialize_statement_node );
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    const vector<shared_ptr<SyntaxNode>>& nodes = node->nodes();
+    for ( vector<shared_ptr<SyntaxNode>>::const_iterator i = nodes.begin(); i != nodes.end(); ++i )
+    {
+        SyntaxNode* syntax_node = i->get();
+        REYES_ASSERT( syntax_node );
+        prune_branches( syntax_node );
+    }
+}
+
+/**
+// Remove the declarations of, and assignments to, local variables that are 
+// never read.
+*/
+void Optimizer::eliminate_dead_stores( SyntaxNode* node ) const
+{
+    REYES_ASSERT( node );
+
+    switch ( node->node_type() )
+    {
+        case SHADER_NODE_VARIABLE:
+        case SHADER_NODE_ASSIGN:
+        case SHADER_NODE_ADD_ASSIGN:
+        case SHADER_NODE_SUBTRACT_ASSIGN:
+        case SHADER_NODE_MULTIPLY_ASSIGN:
+        case SHADER_NODE_DIVIDE_ASSIGN:
+            if ( dead(node->symbol().get()) )
+            {
+                replace_with_list( node );
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    const vector<shared_ptr<SyntaxNode>>& nodes = node->nodes();
+    for ( vector<shared_ptr<SyntaxNode>>::const_iterator i = nodes.begin(); i != nodes.end(); ++i )
+    {
+        SyntaxNode* syntax_node = i->get();
+        REYES_ASSERT( syntax_node );
+        eliminate_dead_stores( syntax_node );
+    }
+}
+
+/**
+// Evaluate a condition that compares literals.
+//
+// @param node
+//  The condition to evaluate.
+//
+// @param value
+//  A variable to receive the value of the condition (assumed not null).
+//
+// @return
+//  True if the condition could be evaluated otherwise false.
+*/
+bool Optimizer::evaluate_condition( const SyntaxNode* node, bool* value ) const
+{
+    REYES_ASSERT( node );
+    REYES_ASSERT( value );
+
+    bool evaluated = false;
+    switch ( node->node_type() )
+    {
+        case SHADER_NODE_GREATER:
+        case SHADER_NODE_GREATER_EQUAL:
+        case SHADER_NODE_LESS:
+        case SHADER_NODE_LESS_EQUAL:
+        case SHADER_NODE_EQUAL:
+        case SHADER_NODE_NOT_EQUAL:
+            if ( numeric_literal(node->node(0)) && numeric_literal(node->node(1)) )
+            {
+                float lhs = node->node( 0 )->real();
+                float rhs = node->node( 1 )->real();
+                switch ( node->node_type() )
+                {
+                    case SHADER_NODE_GREATER:
+                        *value = lhs > rhs;
+                        break;
+
+                    case SHADER_NODE_GREATER_EQUAL:
+                        *value = lhs >= rhs;
+                        break;
+
+                    case SHADER_NODE_LESS:
+                        *value = lhs < rhs;
+                        break;
+
+                    case SHADER_NODE_LESS_EQUAL:
+                        *value = lhs <= rhs;
+                        break;
+
+                    case SHADER_NODE_EQUAL:
+                        *value = lhs == rhs;
+                        break;
+
+                    case SHADER_NODE_NOT_EQUAL:
+                        *value = lhs != rhs;
+                        break;
+
+                    default:
+                        REYES_ASSERT( false );
+                        break;
+                }
+                evaluated = true;
+            }
+            break;
+
+        case SHADER_NODE_AND:
+        case SHADER_NODE_OR:
+        {
+            bool lhs = false;
+            bool rhs = false;
+            if ( evaluate_condition(node->node(0), &lhs) && evaluate_condition(node->node(1), &rhs) )
+            {
+                *value = node->node_type() == SHADER_NODE_AND ? lhs && rhs : lhs || rhs;
+                evaluated = true;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+    return evaluated;
+}
+
+/**
+// Is a symbol a uniform float variable that is only assigned a literal when
+// it is declared?
+*/
+bool Optimizer::constant_definition( const SymbolUsage& usage ) const
+{
+    if ( usage.definition_ && usage.writes_ == 1 )
+    {
+        const Symbol* symbol = usage.definition_->symbol().get();
+        REYES_ASSERT( symbol );
+        return 
+            symbol->type() == TYPE_FLOAT && 
+            symbol->storage() == STORAGE_UNIFORM && 
+            numeric_literal( usage.definition_->node(0) )
+        ;
+    }
+    return false;
+}
+
+/**
+// Find the variable that a symbol is a copy of.
+//
+// A symbol is a copy if it is a local variable that is only assigned when 
+// it is declared and is assigned another parameter or local variable of 
+// the same type and storage that is never changed after it is declared.  
+// Reads of the copy can then be replaced by reads of the original.  Globals
+// aren't propagated as light and illuminance statements write them 
+// implicitly.
+//
+// @return
+//  The identifier node that the symbol is initialized from or null if the
+//  symbol isn't a copy.
+*/
+const SyntaxNode* Optimizer::copy_definition( const SymbolUsage& usage ) const
+{
+    if ( usage.definition_ && usage.writes_ == 1 )
+    {
+        const Symbol* symbol = usage.definition_->symbol().get();
+        const SyntaxNode* source_node = usage.definition_->node( 0 );
+        REYES_ASSERT( symbol );
+        REYES_ASSERT( source_node );
+        if ( source_node->node_type() == SHADER_NODE_IDENTIFIER && source_node->symbol() )
+        {
+            const Symbol* source_symbol = source_node->symbol().get();
+            return 
+                source_symbol != symbol &&
+                source_symbol->type() == symbol->type() &&
+                source_symbol->storage() == symbol->storage() &&
+                unchanging( source_symbol ) ? source_node : NULL
+            ;
+        }
+    }
+    return NULL;
+}
+
+/**
+// Is a symbol a parameter that is never written or a local variable that 
+// is only ever written when it is declared?
+*/
+bool Optimizer::unchanging( const Symbol* symbol ) const
+{
+    map<const Symbol*, SymbolUsage>::const_iterator i = usages_.find( symbol );
+    if ( i == usages_.end() )
+    {
+        return false;
+    }
+    const SymbolUsage& usage = i->second;
+    if ( usage.parameter_ )
+    {
+        return usage.writes_ == 0;
+    }
+    return 
+        usage.definition_ &&
+        (usage.writes_ == 0 || (usage.writes_ == 1 && usage.definition_->node(0)->node_type() != SHADER_NODE_NULL))
+    ;
+}
+
+/**
+// Is a symbol a local variable that is never read and whose assignments can
+// all be removed?
+*/
+bool Optimizer::dead( const Symbol* symbol ) const
+{
+    map<const Symbol*, SymbolUsage>::const_iterator i = usages_.find( symbol );
+    return 
+        symbol && 
+        i != usages_.end() && 
+        i->second.definition_ && 
+        i->second.reads_ == 0 && 
+        i->second.removable_
+    ;
+}
+
+/**
+// Is a node a float literal that isn't converted to another type?
+*/
+bool Optimizer::numeric_literal( const SyntaxNode* node ) const
+{
+    REYES_ASSERT( node );
+    return 
+        (node->node_type() == SHADER_NODE_INTEGER || node->node_type() == SHADER_NODE_REAL) &&
+        node->type() == TYPE_FLOAT &&
+        node->original_type() == TYPE_FLOAT
+    ;
+}
+
+/**
+// Does evaluating an expression change anything other than its result?
+*/
+bool Optimizer::has_side_effects( const SyntaxNode* node ) const
+{
+    REYES_ASSERT( node );
+
+    bool side_effects = false;
+    switch ( node->node_type() )
+    {
+        case SHADER_NODE_ASSIGN:
+        case SHADER_NODE_ADD_ASSIGN:
+        case SHADER_NODE_SUBTRACT_ASSIGN:
+        case SHADER_NODE_MULTIPLY_ASSIGN:
+        case SHADER_NODE_DIVIDE_ASSIGN:
+            side_effects = true;
+            break;
+
+        case SHADER_NODE_CALL:
+            side_effects = writes_arguments( node );
+            break;
+
+        default:
+            break;
+    }
+
+    const vector<shared_ptr<SyntaxNode>>& nodes = node->nodes();
+    for ( vector<shared_ptr<SyntaxNode>>::const_iterator i = nodes.begin(); i != nodes.end() && !side_effects; ++i )
+    {
+        const SyntaxNode* syntax_node = i->get();
+        REYES_ASSERT( syntax_node );
+        side_effects = has_side_effects( syntax_node );
+    }
+    return side_effects;
+}
+
+/**
+// May a call write to the variables passed to it?
+//
+// Only functions that don't return a value write to their arguments (e.g.
+// fresnel() and setxcomp()).
+*/
+bool Optimizer::writes_arguments( const SyntaxNode* call_node ) const
+{
+    REYES_ASSERT( call_node );
+    REYES_ASSERT( call_node->node_type() == SHADER_NODE_CALL );
+    const Symbol* symbol = call_node->symbol().get();
+    return !symbol || symbol->type() == TYPE_NULL;
+}
+
+/**
+// Is the child of a node at an index a statement rather than an expression?
+*/
+bool Optimizer::child_statement( const SyntaxNode* node, int index ) const
+{
+    REYES_ASSERT( node );
+
+    bool statement = false;
+    switch ( node->node_type() )
+    {
+        case SHADER_NODE_LIST:
+            statement = true;
+            break;
+
+        case SHADER_NODE_IF:
+        case SHADER_NODE_IF_ELSE:
+        case SHADER_NODE_WHILE:
+            statement = index > 0;
+            break;
+
+        case SHADER_NODE_FOR:
+            statement = index != 1;
+            break;
+
+        case SHADER_NODE_SOLAR:
+        case SHADER_NODE_ILLUMINATE:
+        case SHADER_NODE_ILLUMINANCE:
+            statement = index == 1;
+            break;
+
+        default:
+            statement = false;
+            break;
+    }
+    return statement;
+}
+
+void Optimizer::replace_with_literal( SyntaxNode* node, float value ) const
+{
+    REYES_ASSERT( node );
+
+    char lexeme [32];
+    snprintf( lexeme, sizeof(lexeme), "%.9g", value );
+    node->set_node_type( SHADER_NODE_REAL );
+    node->set_lexeme( lexeme );
+    node->set_instruction( INSTRUCTION_NULL );
+    node->clear_nodes();
+}
+
+void Optimizer::replace_with_list( SyntaxNode* node ) const
+{
+    REYES_ASSERT( node );
+    node->set_node_type( SHADER_NODE_LIST );
+    node->set_symbol( shared_ptr<Symbol>() );
+    node->clear_nodes();
+}
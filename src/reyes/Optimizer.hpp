@@ -0,0 +1,66 @@
+#ifndef REYES_OPTIMIZER_HPP_INCLUDED
+#define REYES_OPTIMIZER_HPP_INCLUDED
+
+#include <map>
+#include <stddef.h>
+
+namespace reyes
+{
+
+class Symbol;
+class SyntaxNode;
+class ErrorPolicy;
+
+/**
+// Simplify a syntax tree after semantic analysis and before code generation.
+//
+// Reads of variables that are only ever assigned a literal when they are 
+// declared are replaced by that literal, reads of variables that are only
+// ever assigned a copy of an unchanging parameter or variable when they are
+// declared are replaced by reads of that parameter or variable (copy 
+// propagation), arithmetic on literals is folded 
+// into a single literal, statements guarded by conditions that compare 
+// literals are removed or unwrapped, and variables that are never read are 
+// removed along with their assignments.
+*/
+class Optimizer
+{
+    struct SymbolUsage
+    {
+        int reads_; ///< The number of times the symbol is read.
+        int writes_; ///< The number of times the symbol is, or may be, written.
+        bool removable_; ///< True if every write to the symbol is a statement without other side effects.
+        bool parameter_; ///< True if the symbol is a parameter of the shader.
+        const SyntaxNode* definition_; ///< The variable node that declares the symbol (or null if the symbol isn't a local variable).
+        SymbolUsage();
+    };
+
+    ErrorPolicy* error_policy_; ///< ErrorPolicy to check for errors from earlier stages before optimizing.
+    std::map<const Symbol*, SymbolUsage> usages_; ///< The usage of each symbol in the most recently optimized syntax tree.
+
+public:
+    Optimizer( ErrorPolicy* error_policy = NULL );
+    void optimize( SyntaxNode* node );
+
+private:
+    void find_usages( const SyntaxNode* node, bool statement );
+    void propagate_constants( SyntaxNode* node ) const;
+    void fold_constants( SyntaxNode* node ) const;
+    void prune_branches( SyntaxNode* node ) const;
+    void eliminate_dead_stores( SyntaxNode* node ) const;
+    bool evaluate_condition( const SyntaxNode* node, bool* value ) const;
+    bool constant_definition( const SymbolUsage& usage ) const;
+    const SyntaxNode* copy_definition( const SymbolUsage& usage ) const;
+    bool unchanging( const Symbol* symbol ) const;
+    bool dead( const Symbol* symbol ) const;
+    bool numeric_literal( const SyntaxNode* node ) const;
+    bool has_side_effects( const SyntaxNode* node ) const;
+    bool writes_arguments( const SyntaxNode* call_node ) const;
+    bool child_statement( const SyntaxNode* node, int index ) const;
+    void replace_with_literal( SyntaxNode* node, float value ) const;
+    void replace_with_list( SyntaxNode* node ) const;
+};
+
+}
+
+#endif
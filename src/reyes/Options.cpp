@@ -36,7 +36,13 @@ Options::Options()
   maximum_( 255 ),
   filter_function_( &Options::box_filter ),
   filter_width_( 1.0f ),
-  filter_height_( 1.0f )
+  filter_height_( 1.0f ),
+  bucket_width_( 0 ),
+  bucket_height_( 0 ),
+  threads_( 1 ),
+  retained_( false ),
+  front_to_back_( false ),
+  shader_cache_directory_()
 {
 #ifdef BUILD_VARIANT_DEBUG
     horizontal_resolution_ = 32;
@@ -144,6 +150,41 @@ float Options::filter_height() const
     return filter_height_;
 }
 
+int Options::bucket_width() const
+{
+    return bucket_width_;
+}
+
+int Options::bucket_height() const
+{
+    return bucket_height_;
+}
+
+bool Options::bucketing() const
+{
+    return bucket_width_ > 0 && bucket_height_ > 0;
+}
+
+int Options::threads() const
+{
+    return threads_;
+}
+
+bool Options::retained() const
+{
+    return retained_;
+}
+
+bool Options::front_to_back() const
+{
+    return front_to_back_;
+}
+
+const std::string& Options::shader_cache_directory() const
+{
+    return shader_cache_directory_;
+}
+
 void Options::set_resolution( int horizontal_resolution, int vertical_resolution, float pixel_aspect_ratio )
 {
     REYES_ASSERT( horizontal_resolution > 1 );
@@ -252,6 +293,47 @@ void Options::set_filter( FilterFunction function, float width, float height )
     filter_height_ = max( 1.0f, height );
 }
 
+void Options::set_bucket_size( int bucket_width, int bucket_height )
+{
+    REYES_ASSERT( bucket_width >= 0 );
+    REYES_ASSERT( bucket_height >= 0 );
+    bucket_width_ = max( 0, bucket_width );
+    bucket_height_ = max( 0, bucket_height );
+}
+
+void Options::set_threads( int threads )
+{
+    REYES_ASSERT( threads >= 0 );
+    threads_ = max( 0, threads );
+}
+
+void Options::set_retained( bool retained )
+{
+    retained_ = retained;
+}
+
+void Options::set_front_to_back( bool front_to_back )
+{
+    front_to_back_ = front_to_back;
+}
+
+/**
+// Set the directory that compiled shaders are cached in.
+//
+// Shaders are loaded from the cache instead of being compiled when their 
+// source and the symbols that they're compiled against haven't changed
+// since they were cached (see ShaderCache).  The directory is assumed to
+// exist and may be shared between concurrent renders.
+//
+// @param shader_cache_directory
+//  The directory to cache compiled shaders in or null or empty to compile
+//  shaders every time they're loaded.
+*/
+void Options::set_shader_cache_directory( const char* shader_cache_directory )
+{
+    shader_cache_directory_ = shader_cache_directory ? shader_cache_directory : "";
+}
+
 float Options::box_filter( float /*x*/, float /*y*/, float /*width*/, float /*height*/ )
 {
     return 1.0f;
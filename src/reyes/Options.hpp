@@ -37,6 +37,12 @@ private:
     FilterFunction filter_function_; ///< The filter function to use.
     float filter_width_; ///< The width of the filter (in pixels).
     float filter_height_; ///< The height of the filter (in pixels).
+    int bucket_width_; ///< The width of each bucket (in pixels) or 0 to render without buckets.
+    int bucket_height_; ///< The height of each bucket (in pixels) or 0 to render without buckets.
+    int threads_; ///< The number of threads to render buckets on or 0 to use one thread per hardware thread.
+    bool retained_; ///< True to retain primitives and render them at the end of world space rather than immediately.
+    bool front_to_back_; ///< True to render retained primitives nearest first so that occluded geometry can be culled before it is shaded.
+    std::string shader_cache_directory_; ///< The directory that compiled shaders are cached in or empty to compile shaders every time they're loaded.
 
 public:
     Options();
@@ -61,6 +67,13 @@ public:
     FilterFunction filter_function() const;
     float filter_width() const;
     float filter_height() const;
+    int bucket_width() const;
+    int bucket_height() const;
+    bool bucketing() const;
+    int threads() const;
+    bool retained() const;
+    bool front_to_back() const;
+    const std::string& shader_cache_directory() const;
 
     void set_resolution( int horizontal_resolution, int vertical_resolution, float pixel_aspect_ratio );
     void set_crop_window( const math::vec4& crop_window );
@@ -79,6 +92,11 @@ public:
     void set_minimum( int minimum );
     void set_maximum( int maximum );
     void set_filter( FilterFunction function, float width, float height );
+    void set_bucket_size( int bucket_width, int bucket_height );
+    void set_threads( int threads );
+    void set_retained( bool retained );
+    void set_front_to_back( bool front_to_back );
+    void set_shader_cache_directory( const char* shader_cache_directory );
 
     static float box_filter( float x, float y, float width, float height );
     static float triangle_filter( float x, float y, float width, float height );
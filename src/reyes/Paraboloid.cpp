@@ -18,14 +18,12 @@
 
 using std::min;
 using std::max;
-using std::list;
 using std::vector;
-using std::shared_ptr;
 using namespace math;
 using namespace reyes;
 
 Paraboloid::Paraboloid( float rmax, float zmin, float zmax, float thetamax )
-: Geometry(vec2(0.0f, 1.0f), vec2(0.0f, 1.0f)),
+: Geometry(),
   rmax_( rmax ),
   zmin_( zmin ),
   zmax_( zmax ),
@@ -33,21 +31,12 @@ Paraboloid::Paraboloid( float rmax, float zmin, float zmax, float thetamax )
 {   
 }
 
-Paraboloid::Paraboloid( const Paraboloid& paraboloid, const math::vec2& u_range, const math::vec2& v_range )
-: Geometry(u_range, v_range),
-  rmax_( paraboloid.rmax_ ),
-  zmin_( paraboloid.zmin_ ),
-  zmax_( paraboloid.zmax_ ),
-  thetamax_( paraboloid.thetamax_ )
-{   
-}
-
 bool Paraboloid::boundable() const
 {
     return true;
 }
 
-void Paraboloid::bound( const math::mat4x4& transform, vec3* minimum, vec3* maximum ) const
+void Paraboloid::bound( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, vec3* minimum, vec3* maximum ) const
 {
     REYES_ASSERT( minimum );
     REYES_ASSERT( maximum );
@@ -55,19 +44,15 @@ void Paraboloid::bound( const math::mat4x4& transform, vec3* minimum, vec3* maxi
     *minimum = vec3( FLT_MAX, FLT_MAX, FLT_MAX );
     *maximum = vec3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
     
-    Grid grid;
-    dice( transform, 8, 8, &grid );
-    const vec3* positions = grid["P"].vec3_values();
-    const vec3* positions_end = positions + grid["P"].size();
-    for ( const vec3* i = positions; i != positions_end; ++i )
-    {
-        minimum->x = min( minimum->x, i->x );
-        minimum->y = min( minimum->y, i->y );
-        minimum->z = min( minimum->z, i->z );        
-        maximum->x = max( maximum->x, i->x );
-        maximum->y = max( maximum->y, i->y );
-        maximum->z = max( maximum->z, i->z );
-    }
+    const float theta0 = u_range.x * thetamax_;
+    const float theta1 = u_range.y * thetamax_;
+    const float z0 = v_range.x * (zmax_ - zmin_);
+    const float z1 = v_range.y * (zmax_ - zmin_);
+    bound_arc( rmax_ * sqrtf(z0 / zmax_), theta0, theta1, minimum, maximum );
+    bound_arc( rmax_ * sqrtf(z1 / zmax_), theta0, theta1, minimum, maximum );
+    minimum->z = min( z0, z1 );
+    maximum->z = max( z0, z1 );
+    transform_bound( transform, minimum, maximum );
 }
 
 bool Paraboloid::splittable() const
@@ -75,54 +60,26 @@ bool Paraboloid::splittable() const
     return true;
 }
 
-void Paraboloid::split( std::list<std::shared_ptr<Geometry>>* primitives ) const
-{
-    REYES_ASSERT( primitives );
-    REYES_ASSERT( u_range().y >= u_range().x );
-    REYES_ASSERT( v_range().y >= v_range().x );
-
-    const vec2& u_range = Geometry::u_range();
-    float u0 = u_range.x;
-    float u1 = (u_range.x + u_range.y) / 2.0f;
-    float u2 = u_range.y;
-
-    const vec2& v_range = Geometry::v_range();
-    float v0 = v_range.x;
-    float v1 = (v_range.x + v_range.y) / 2.0f;
-    float v2 = v_range.y;
-
-    shared_ptr<Geometry> paraboloid;
-    paraboloid.reset( new Paraboloid(*this, vec2(u0, u1), vec2(v0, v1)) );
-    primitives->push_back( paraboloid );
-    paraboloid.reset( new Paraboloid(*this, vec2(u0, u1), vec2(v1, v2)) );
-    primitives->push_back( paraboloid );
-    paraboloid.reset( new Paraboloid(*this, vec2(u1, u2), vec2(v0, v1)) );
-    primitives->push_back( paraboloid );
-    paraboloid.reset( new Paraboloid(*this, vec2(u1, u2), vec2(v1, v2)) );
-    primitives->push_back( paraboloid );
-}
-
 bool Paraboloid::diceable() const
 {
     return true;
 }
 
-void Paraboloid::dice( const math::mat4x4& transform, int width, int height, Grid* grid ) const
+void Paraboloid::dice( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, int width, int height, Grid* grid ) const
 {
     REYES_ASSERT( width > 0 );
     REYES_ASSERT( height > 0 );
     REYES_ASSERT( grid );
     
-    const vec2& u_range = Geometry::u_range();
-    const vec2& v_range = Geometry::v_range();
-
     grid->resize( width, height );
     grid->du_ = (u_range.y - u_range.x) / float(width - 1);
     grid->dv_ = (v_range.y - v_range.x) / float(height - 1);
     
-    vec3* positions = grid->value( "P", TYPE_POINT ).vec3_values();
-    float* s = grid->value( "s", TYPE_FLOAT ).float_values();
-    float* t = grid->value( "t", TYPE_FLOAT ).float_values();
+    vec3* positions = grid->value( GRID_SLOT_P, TYPE_POINT ).vec3_values();
+    vec3* u_derivatives = grid->value( GRID_SLOT_DPDU, TYPE_VECTOR ).vec3_values();
+    vec3* v_derivatives = grid->value( GRID_SLOT_DPDV, TYPE_VECTOR ).vec3_values();
+    float* s = grid->value( GRID_SLOT_S, TYPE_FLOAT ).float_values();
+    float* t = grid->value( GRID_SLOT_T, TYPE_FLOAT ).float_values();
     
     int vertex = 0;
     float v = v_range.x;
@@ -133,7 +90,13 @@ void Paraboloid::dice( const math::mat4x4& transform, int width, int height, Gri
         float du = (u_range.y - u_range.x) / float(width - 1);
         for ( int i = 0; i < width; ++i )
         {
-            positions[vertex] = vec3( transform * vec4(position(u, v), 1.0f) );
+            vec3 position;
+            vec3 dpdu;
+            vec3 dpdv;
+            evaluate( u, v, &position, &dpdu, &dpdv );
+            positions[vertex] = vec3( transform * vec4(position, 1.0f) );
+            u_derivatives[vertex] = vec3( transform * vec4(dpdu, 0.0f) );
+            v_derivatives[vertex] = vec3( transform * vec4(dpdv, 0.0f) );
             s[vertex] = u;
             t[vertex] = v;
             u = min( u + du, u_range.y );
@@ -143,10 +106,23 @@ void Paraboloid::dice( const math::mat4x4& transform, int width, int height, Gri
     }    
 }
 
-math::vec3 Paraboloid::position( float u, float v ) const
+void Paraboloid::evaluate( float u, float v, math::vec3* position, math::vec3* dpdu, math::vec3* dpdv ) const
 {
+    REYES_ASSERT( position );
+    REYES_ASSERT( dpdu );
+    REYES_ASSERT( dpdv );
     float theta = u * thetamax_;
+    float cos_theta = cosf( theta );
+    float sin_theta = sinf( theta );
     float z = v * (zmax_ - zmin_);
     float r = rmax_ * sqrtf( z / zmax_ );
-    return vec3( r * cosf(theta), r * sinf(theta), z );
+
+    // The radius changes infinitely quickly at the apex; leave the 
+    // derivative along the z axis there and let the degenerate derivatives 
+    // fall back to a finite difference normal.
+    float dzdv = zmax_ - zmin_;
+    float drdv = z > 0.0f ? 0.5f * rmax_ * dzdv / (zmax_ * sqrtf(z / zmax_)) : 0.0f;
+    *position = vec3( r * cos_theta, r * sin_theta, z );
+    *dpdu = thetamax_ * vec3( -r * sin_theta, r * cos_theta, 0.0f );
+    *dpdv = vec3( drdv * cos_theta, drdv * sin_theta, dzdv );
 }
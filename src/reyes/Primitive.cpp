@@ -0,0 +1,46 @@
+//
+// Primitive.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "stdafx.hpp"
+#include "Primitive.hpp"
+#include "Geometry.hpp"
+#include "Attributes.hpp"
+#include "assert.hpp"
+
+using std::shared_ptr;
+using namespace reyes;
+
+Primitive::Primitive( std::shared_ptr<Geometry> geometry, std::shared_ptr<Attributes> attributes )
+: geometry_( geometry ),
+  attributes_( attributes ),
+  depth_( 0.0f )
+{
+    REYES_ASSERT( geometry_ );
+    REYES_ASSERT( attributes_ );
+}
+
+Primitive::~Primitive()
+{
+}
+
+const std::shared_ptr<Geometry>& Primitive::geometry() const
+{
+    return geometry_;
+}
+
+const std::shared_ptr<Attributes>& Primitive::attributes() const
+{
+    return attributes_;
+}
+
+float Primitive::depth() const
+{
+    return depth_;
+}
+
+void Primitive::set_depth( float depth )
+{
+    depth_ = depth;
+}
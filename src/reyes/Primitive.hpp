@@ -0,0 +1,34 @@
+#ifndef REYES_PRIMITIVE_HPP_INCLUDED
+#define REYES_PRIMITIVE_HPP_INCLUDED
+
+#include <memory>
+
+namespace reyes
+{
+
+class Geometry;
+class Attributes;
+
+/**
+// A piece of geometry retained along with the attributes that were current 
+// when it was passed to the renderer.
+*/
+class Primitive
+{
+    std::shared_ptr<Geometry> geometry_; ///< The geometry to render.
+    std::shared_ptr<Attributes> attributes_; ///< The attributes (including the current transform) to render the geometry with.
+    float depth_; ///< The nearest camera space depth of the geometry's bound (or 0 if it hasn't been bounded).
+
+public:
+    Primitive( std::shared_ptr<Geometry> geometry, std::shared_ptr<Attributes> attributes );
+    ~Primitive();
+
+    const std::shared_ptr<Geometry>& geometry() const;
+    const std::shared_ptr<Attributes>& attributes() const;
+    float depth() const;
+    void set_depth( float depth );
+};
+
+}
+
+#endif
@@ -0,0 +1,159 @@
+//
+// Registry.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "stdafx.hpp"
+#include "Registry.hpp"
+#include "Shader.hpp"
+#include "Texture.hpp"
+#include "assert.hpp"
+
+using std::map;
+using std::make_pair;
+using std::string;
+using std::weak_ptr;
+using std::shared_ptr;
+using std::mutex;
+using std::lock_guard;
+using std::atomic_load;
+using std::atomic_store;
+using namespace reyes;
+
+template <class Resource>
+static shared_ptr<Resource> find_entry( const map<string, weak_ptr<Resource>>& entries, const string& key )
+{
+    typename map<string, weak_ptr<Resource>>::const_iterator i = entries.find( key );
+    return i != entries.end() ? i->second.lock() : shared_ptr<Resource>();
+}
+
+template <class Resource>
+static shared_ptr<Resource> add_entry( map<string, weak_ptr<Resource>>* entries, const string& key, const shared_ptr<Resource>& resource )
+{
+    REYES_ASSERT( entries );
+    
+    typename map<string, weak_ptr<Resource>>::iterator i = entries->begin(); 
+    while ( i != entries->end() )
+    {
+        if ( i->second.expired() )
+        {
+            entries->erase( i++ );
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    shared_ptr<Resource> existing_resource = find_entry( *entries, key );
+    if ( existing_resource )
+    {
+        return existing_resource;
+    }
+    entries->insert( make_pair(key, weak_ptr<Resource>(resource)) );
+    return resource;
+}
+
+Registry::Registry()
+: mutex_(),
+  entries_( new Entries() )
+{
+}
+
+Registry::~Registry()
+{
+}
+
+/**
+// Get the registry shared by all renderers in this process.
+*/
+Registry& Registry::instance()
+{
+    static Registry registry;
+    return registry;
+}
+
+/**
+// Find a shader that has been added to this registry.
+//
+// @param key
+//  The key that the shader was added with.
+//
+// @return
+//  The shader or null if no shader with \e key is still in use.
+*/
+std::shared_ptr<Shader> Registry::find_shader( const std::string& key ) const
+{
+    shared_ptr<const Entries> entries = atomic_load( &entries_ );
+    REYES_ASSERT( entries );
+    return find_entry( entries->shaders, key );
+}
+
+/**
+// Add a shader to this registry.
+//
+// If another thread added a shader with the same key since this thread 
+// last failed to find one then that shader is kept and returned instead so
+// that every renderer ends up sharing the same shader.
+//
+// @param key
+//  The key to add the shader with.
+//
+// @param shader
+//  The shader to add (assumed not null).
+//
+// @return
+//  The shader registered with \e key.
+*/
+std::shared_ptr<Shader> Registry::add_shader( const std::string& key, const std::shared_ptr<Shader>& shader )
+{
+    REYES_ASSERT( shader );
+
+    lock_guard<mutex> lock( mutex_ );
+    shared_ptr<Entries> entries( new Entries(*atomic_load(&entries_)) );
+    shared_ptr<Shader> registered_shader = add_entry( &entries->shaders, key, shader );
+    atomic_store( &entries_, shared_ptr<const Entries>(entries) );
+    return registered_shader;
+}
+
+/**
+// Find a texture that has been added to this registry.
+//
+// @param key
+//  The key that the texture was added with.
+//
+// @return
+//  The texture or null if no texture with \e key is still in use.
+*/
+std::shared_ptr<Texture> Registry::find_texture( const std::string& key ) const
+{
+    shared_ptr<const Entries> entries = atomic_load( &entries_ );
+    REYES_ASSERT( entries );
+    return find_entry( entries->textures, key );
+}
+
+/**
+// Add a texture to this registry.
+//
+// If another thread added a texture with the same key since this thread 
+// last failed to find one then that texture is kept and returned instead.
+//
+// @param key
+//  The key to add the texture with.
+//
+// @param texture
+//  The texture to add (assumed not null).
+//
+// @return
+//  The texture registered with \e key.
+*/
+std::shared_ptr<Texture> Registry::add_texture( const std::string& key, const std::shared_ptr<Texture>& texture )
+{
+    REYES_ASSERT( texture );
+
+    lock_guard<mutex> lock( mutex_ );
+    shared_ptr<Entries> entries( new Entries(*atomic_load(&entries_)) );
+    shared_ptr<Texture> registered_texture = add_entry( &entries->textures, key, texture );
+    atomic_store( &entries_, shared_ptr<const Entries>(entries) );
+    return registered_texture;
+}
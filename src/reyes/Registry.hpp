@@ -0,0 +1,52 @@
+#ifndef REYES_REGISTRY_HPP_INCLUDED
+#define REYES_REGISTRY_HPP_INCLUDED
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <map>
+
+namespace reyes
+{
+
+class Shader;
+class Texture;
+
+/**
+// The shaders and textures loaded by all renderers in a process.
+//
+// Renderers that load the same shader or texture share a single copy of it
+// rather than each compiling or decoding its own.  Lookups read an 
+// immutable snapshot of the registry that is published atomically so that
+// any number of renderers and worker threads can find resources without
+// locking.  Adding a resource copies the snapshot under a mutex, which is
+// cheap enough as resources are added rarely and found often.
+//
+// The registry only holds weak references.  Resources are owned by the 
+// renderers that use them and destroyed when the last of those renderers
+// releases them.
+*/
+class Registry
+{
+    struct Entries
+    {
+        std::map<std::string, std::weak_ptr<Shader>> shaders; ///< The shaders that have been added (by key).
+        std::map<std::string, std::weak_ptr<Texture>> textures; ///< The textures that have been added (by key).
+    };
+
+    std::mutex mutex_; ///< Serializes adding resources.
+    std::shared_ptr<const Entries> entries_; ///< The current snapshot of entries, only ever read and replaced atomically.
+
+public:
+    Registry();
+    ~Registry();
+    static Registry& instance();
+    std::shared_ptr<Shader> find_shader( const std::string& key ) const;
+    std::shared_ptr<Shader> add_shader( const std::string& key, const std::shared_ptr<Shader>& shader );
+    std::shared_ptr<Texture> find_texture( const std::string& key ) const;
+    std::shared_ptr<Texture> add_texture( const std::string& key, const std::shared_ptr<Texture>& texture );
+};
+
+}
+
+#endif
@@ -8,7 +8,6 @@
 #include "Options.hpp"
 #include "SampleBuffer.hpp"
 #include "ImageBuffer.hpp"
-#include "Sampler.hpp"
 #include "Grid.hpp"
 #include "Cone.hpp"
 #include "Sphere.hpp"
@@ -21,6 +20,9 @@
 #include "LinearPatch.hpp"
 #include "Geometry.hpp"
 #include "Shader.hpp"
+#include "NativeShader.hpp"
+#include "ShaderCache.hpp"
+#include "Registry.hpp"
 #include "Light.hpp"
 #include "Texture.hpp"
 #include "Value.hpp"
@@ -28,9 +30,15 @@
 #include "VirtualMachine.hpp"
 #include "SymbolTable.hpp"
 #include "Attributes.hpp"
+#include "Primitive.hpp"
+#include "Bucket.hpp"
+#include "Worker.hpp"
 #include "ErrorPolicy.hpp"
+#include "ErrorCode.hpp"
 #include "DisplayMode.hpp"
 #include "ImageBufferFormat.hpp"
+#include "hash.hpp"
+#include "file.hpp"
 #include <math/vec2.ipp>
 #include <math/vec3.ipp>
 #include <math/vec4.ipp>
@@ -43,9 +51,14 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <limits.h>
+#include <atomic>
+#include <thread>
+#include <random>
 
 using std::max;
 using std::swap;
@@ -60,7 +73,6 @@ using namespace math;
 using namespace reyes;
 
 static const int ATTRIBUTES_RESERVE = 32;
-static const int MAXIMUM_VERTICES_PER_GRID = 64 * 64;
 static const char* NULL_SURFACE_SHADER = "surface null() { Ci = Cs; Oi = Os; }";
 
 /**
@@ -71,13 +83,17 @@ Renderer::Renderer()
   symbol_table_( NULL ),
   virtual_machine_( NULL ),
   null_surface_shader_( NULL ),
-  sample_buffer_( NULL ),
   image_buffer_( NULL ),
-  sampler_( NULL ),
   screen_transform_( math::identity() ),
   camera_transform_( math::identity() ),
+  raster_width_( 0.0f ),
+  raster_height_( 0.0f ),
+  buckets_(),
+  workers_(),
   textures_(),
+  framebuffer_textures_(),
   shaders_(),
+  native_shaders_(),
   options_( NULL ),
   attributes_()
 {
@@ -96,30 +112,31 @@ Renderer::~Renderer()
 {
     attributes_.clear();
 
-    for ( map<string, Shader*>::const_iterator i = shaders_.begin(); i != shaders_.end(); ++i )
+    for ( vector<Bucket*>::const_iterator i = buckets_.begin(); i != buckets_.end(); ++i )
     {
-        Shader* shader = i->second;
-        REYES_ASSERT( shader );
-        delete shader;
+        delete *i;
     }
+    buckets_.clear();
+
+    for ( vector<Worker*>::const_iterator i = workers_.begin(); i != workers_.end(); ++i )
+    {
+        delete *i;
+    }
+    workers_.clear();
+
     shaders_.clear();
+    textures_.clear();
     
-    for ( map<string, Texture*>::const_iterator i = textures_.begin(); i != textures_.end(); ++i )
+    for ( map<string, Texture*>::const_iterator i = framebuffer_textures_.begin(); i != framebuffer_textures_.end(); ++i )
     {
         Texture* texture = i->second;
         REYES_ASSERT( texture );
         delete texture;
     }
-    textures_.clear();
-
-    delete sampler_;
-    sampler_ = NULL;
+    framebuffer_textures_.clear();
 
     delete image_buffer_;
     image_buffer_ = NULL;
-
-    delete sample_buffer_;
-    sample_buffer_ = NULL;
     
     delete null_surface_shader_;
     null_surface_shader_ = NULL;
@@ -209,13 +226,45 @@ void Renderer::pop_attributes()
 
 /**
 // Get the current render state attributes.
+//
+// While a primitive is being rendered the current render state is the copy 
+// of the primitive's attributes made by the worker rendering it on the 
+// calling thread.  This is how shaders find the named coordinate systems 
+// and other attributes of the primitive that they are shading.
 */
 Attributes& Renderer::attributes() const
 {
+    Attributes* shading_attributes = Worker::shading_attributes();
+    if ( shading_attributes )
+    {
+        return *shading_attributes;
+    }
     REYES_ASSERT( !attributes_.empty() );
     return *attributes_.back();
 }
 
+/**
+// Get the current render state attributes to modify them.
+//
+// Workers hold on to the attributes of the primitive that they last 
+// rendered.  The current attributes are copied here before they are 
+// modified if they're shared so that changes don't affect attributes that
+// are still in use elsewhere.
+//
+// @return
+//  The current attributes not shared with anything else.
+*/
+Attributes& Renderer::unshared_attributes()
+{
+    REYES_ASSERT( !attributes_.empty() );
+    shared_ptr<Attributes>& attributes = attributes_.back();
+    if ( attributes.use_count() > 1 )
+    {
+        attributes.reset( new Attributes(*attributes) );
+    }
+    return *attributes;
+}
+
 /**
 // Set the shading rate.
 //
@@ -229,7 +278,7 @@ Attributes& Renderer::attributes() const
 */
 void Renderer::shading_rate( float shading_rate )
 {
-    attributes().set_shading_rate( shading_rate );
+    unshared_attributes().set_shading_rate( shading_rate );
 }
 
 /**
@@ -246,7 +295,7 @@ void Renderer::shading_rate( float shading_rate )
 */
 void Renderer::matte( bool matte )
 {
-    attributes().set_matte( matte );
+    unshared_attributes().set_matte( matte );
 }
 
 /**
@@ -261,7 +310,7 @@ void Renderer::matte( bool matte )
 */
 void Renderer::two_sided( bool two_sided )
 {
-    attributes().set_two_sided( two_sided );
+    unshared_attributes().set_two_sided( two_sided );
 }
 
 /**
@@ -270,7 +319,7 @@ void Renderer::two_sided( bool two_sided )
 */
 void Renderer::orient_inside()
 {
-    Attributes& attributes = Renderer::attributes();
+    Attributes& attributes = unshared_attributes();
     attributes.set_geometry_left_handed( !attributes.transform_left_handed() );
 }
 
@@ -280,7 +329,7 @@ void Renderer::orient_inside()
 */
 void Renderer::orient_outside()
 {
-    Attributes& attributes = Renderer::attributes();
+    Attributes& attributes = unshared_attributes();
     attributes.set_geometry_left_handed( attributes.transform_left_handed() );
 }
 
@@ -289,7 +338,7 @@ void Renderer::orient_outside()
 */
 void Renderer::orient_left_handed()
 {
-    attributes().set_geometry_left_handed( true );
+    unshared_attributes().set_geometry_left_handed( true );
 }
 
 /**
@@ -297,7 +346,7 @@ void Renderer::orient_left_handed()
 */
 void Renderer::orient_right_handed()
 {
-    attributes().set_geometry_left_handed( false );
+    unshared_attributes().set_geometry_left_handed( false );
 }
 
 /**
@@ -308,7 +357,7 @@ void Renderer::orient_right_handed()
 */
 void Renderer::color( const math::vec3& color )
 {
-    attributes().set_color( color );
+    unshared_attributes().set_color( color );
 }
 
 /**
@@ -319,40 +368,21 @@ void Renderer::color( const math::vec3& color )
 */
 void Renderer::opacity( const math::vec3& opacity )
 {
-    attributes().set_opacity( opacity );
+    unshared_attributes().set_opacity( opacity );
 }
 
 /**
 // Mark the beginning of a frame.
 //
 // Allocates and initializes the sample and image buffers used during 
-// rendering according to the global options set in this renderer and 
-// initialize the attribute stack to have the default initial render
-// state.
+// rendering according to the global options set in this renderer, discards
+// any primitives retained from the previous frame, and initialize the 
+// attribute stack to have the default initial render state.
 */
 void Renderer::begin()
 {
-    if ( sample_buffer_ )
-    {
-        delete sample_buffer_;
-        sample_buffer_ = NULL;
-    }
-       
-    if ( image_buffer_ )
-    {
-        delete image_buffer_;
-        image_buffer_ = NULL;
-    }
-    
-    if ( sampler_ )
-    {
-        delete sampler_;
-        sampler_ = NULL;
-    }
-    
-    sample_buffer_ = new SampleBuffer( options_->horizontal_resolution(), options_->vertical_resolution(), options_->horizontal_sampling_rate(), options_->vertical_sampling_rate(), options_->filter_width(), options_->filter_height() );
-    image_buffer_ = new ImageBuffer( options_->horizontal_resolution(), options_->vertical_resolution(), 4, FORMAT_U8 );
-    sampler_ = new Sampler( float(sample_buffer_->width() - 1), float(sample_buffer_->height() - 1), MAXIMUM_VERTICES_PER_GRID, options_->crop_window() );
+    allocate_buffers();
+    primitives_.clear();
 
     screen_transform_ = math::identity();
     camera_transform_ = math::identity();
@@ -374,13 +404,114 @@ void Renderer::begin()
 void Renderer::end()
 {
     REYES_ASSERT( options_ );
-    
     attributes_.clear();
+    filter_samples();
+}
+
+/**
+// Render the primitives retained from the previous frame again.
+//
+// The sample and image buffers are reallocated according to the current 
+// global options, the retained primitives rendered, and the sample buffer 
+// filtered, exposed, and quantized into the image buffer.  This allows the
+// same scene to be rendered with different options (e.g. sampling rates, 
+// filters, exposure, or bucket sizes) without describing it again.  The 
+// screen and camera transforms set when the scene was described are reused
+// so options that affect the projection (e.g. aspect ratio and clipping 
+// distances) should be left unchanged.
+//
+// Primitives are only retained from one frame to the next when the 
+// retained option was set when the frame was described.
+*/
+void Renderer::render()
+{
+    REYES_ASSERT( options_ );
+    allocate_buffers();
+    render_primitives();
+    filter_samples();
+}
+
+/**
+// Allocate the sample and image buffers used during rendering.
+//
+// When the global options specify a bucket size each worker's sample buffer
+// covers only a single bucket and is reused for each bucket in turn as the 
+// buckets are rendered at the end of world space.  One worker is created for
+// each thread that renders buckets.
+*/
+void Renderer::allocate_buffers()
+{
+    if ( image_buffer_ )
+    {
+        delete image_buffer_;
+        image_buffer_ = NULL;
+    }
     
+    for ( vector<Worker*>::const_iterator i = workers_.begin(); i != workers_.end(); ++i )
+    {
+        delete *i;
+    }
+    workers_.clear();
+
+    for ( vector<Bucket*>::const_iterator i = buckets_.begin(); i != buckets_.end(); ++i )
+    {
+        delete *i;
+    }
+    buckets_.clear();
+
+    const int horizontal_resolution = options_->horizontal_resolution();
+    const int vertical_resolution = options_->vertical_resolution();
+    const int horizontal_sampling_rate = int(options_->horizontal_sampling_rate());
+    const int vertical_sampling_rate = int(options_->vertical_sampling_rate());
+    raster_width_ = float((horizontal_resolution + int(ceilf(options_->filter_width() - 0.5f))) * horizontal_sampling_rate - 1);
+    raster_height_ = float((vertical_resolution + int(ceilf(options_->filter_height() - 0.5f))) * vertical_sampling_rate - 1);
+
+    if ( options_->bucketing() )
+    {
+        const int bucket_width = options_->bucket_width();
+        const int bucket_height = options_->bucket_height();
+        for ( int y = 0; y < vertical_resolution; y += bucket_height )
+        {
+            for ( int x = 0; x < horizontal_resolution; x += bucket_width )
+            {
+                buckets_.push_back( new Bucket(x, std::min(x + bucket_width, horizontal_resolution), y, std::min(y + bucket_height, vertical_resolution)) );
+            }
+        }
+
+        int threads = options_->threads() > 0 ? options_->threads() : int(std::thread::hardware_concurrency());
+        threads = std::max( 1, std::min(threads, int(buckets_.size())) );
+        for ( int i = 0; i < threads; ++i )
+        {
+            workers_.push_back( new Worker(*this, std::min(bucket_width, horizontal_resolution), std::min(bucket_height, vertical_resolution), raster_width_, raster_height_) );
+        }
+    }
+    else
+    {
+        workers_.push_back( new Worker(*this, horizontal_resolution, vertical_resolution, raster_width_, raster_height_) );
+    }
+
+    image_buffer_ = new ImageBuffer( horizontal_resolution, vertical_resolution, 4, FORMAT_U8 );
+}
+
+/**
+// Filter, expose, and quantize the sample buffer into the image buffer.
+//
+// When rendering in buckets each bucket has already been filtered, exposed, 
+// and quantized into the image buffer as it was rendered.
+*/
+void Renderer::filter_samples()
+{
+    if ( !buckets_.empty() )
+    {
+        return;
+    }
+
+    REYES_ASSERT( !workers_.empty() );
     ImageBuffer image_buffer;
-    sample_buffer_->filter( options_->filter_function(), &image_buffer );
+    workers_.front()->sample_buffer()->filter( options_->filter_function(), &image_buffer );
     image_buffer.expose( options_->gain(), options_->gamma() );
-    image_buffer_->quantize( image_buffer, options_->one(), options_->minimum(), options_->maximum(), options_->dither() );
+    std::minstd_rand random;
+    image_buffer_->quantize( image_buffer, options_->one(), options_->minimum(), options_->maximum(), options_->dither(), &random );
 }
 
 /**
@@ -406,12 +537,14 @@ void Renderer::begin_world()
 /**
 // Mark the end of world space in a frame.
 //
-// Sets the current transform back to the identity.  Removes the coordinate
-// system transforms for the "screen", "camera", and "world" coordinate 
-// systems.  Pops the current render state.
+// Renders any retained primitives.  Sets the current transform 
+// back to the identity.  Removes the coordinate system transforms for the 
+// "screen", "camera", and "world" coordinate systems.  Pops the current 
+// render state.
 */
 void Renderer::end_world()
 {
+    render_primitives();
     identity();
     
     remove_coordinate_system( "world" );
@@ -467,7 +600,7 @@ const math::mat4x4& Renderer::camera_transform() const
 */
 void Renderer::add_coordinate_system( const char* name, const math::mat4x4& transform )
 {
-    attributes().add_coordinate_system( name, transform );
+    unshared_attributes().add_coordinate_system( name, transform );
 }
 
 /**
@@ -478,7 +611,7 @@ void Renderer::add_coordinate_system( const char* name, const math::mat4x4& tran
 */
 void Renderer::remove_coordinate_system( const char* name )
 {
-    attributes().remove_coordinate_system( name );    
+    unshared_attributes().remove_coordinate_system( name );    
 }
 
 /**
@@ -542,7 +675,7 @@ math::mat4x4 Renderer::transform_between( const std::string& from, const std::st
 */
 void Renderer::begin_transform()
 {
-    attributes().push_transform();
+    unshared_attributes().push_transform();
 }
 
 /**
@@ -551,7 +684,7 @@ void Renderer::begin_transform()
 void Renderer::end_transform()
 {
     REYES_ASSERT( !attributes_.empty() );
-    attributes().pop_transform();
+    unshared_attributes().pop_transform();
 }
 
 /**
@@ -560,7 +693,7 @@ void Renderer::end_transform()
 void Renderer::identity()
 {
     REYES_ASSERT( !attributes_.empty() );
-    attributes().identity();
+    unshared_attributes().identity();
 }
 
 /**
@@ -572,7 +705,7 @@ void Renderer::identity()
 void Renderer::transform( const math::mat4x4& transform )
 {
     REYES_ASSERT( !attributes_.empty() );
-    attributes().transform( transform );
+    unshared_attributes().transform( transform );
 }
 
 /**
@@ -589,7 +722,7 @@ void Renderer::transform( const math::mat4x4& transform )
 void Renderer::concat_transform( const math::mat4x4& transform )
 {
     REYES_ASSERT( !attributes_.empty() );
-    attributes().concat_transform( transform );
+    unshared_attributes().concat_transform( transform );
 }
 
 /**
@@ -735,7 +868,7 @@ const math::mat4x4& Renderer::current_transform() const
 Grid& Renderer::displacement_shader( Shader* displacement_shader )
 {
     REYES_ASSERT( !attributes_.empty() );
-    Attributes& attributes = Renderer::attributes();
+    Attributes& attributes = unshared_attributes();
     attributes.set_displacement_shader( displacement_shader, camera_transform_ );
     return attributes.displacement_parameters();
 }
@@ -754,7 +887,7 @@ Grid& Renderer::displacement_shader( Shader* displacement_shader )
 Grid& Renderer::surface_shader( Shader* surface_shader )
 {
     REYES_ASSERT( !attributes_.empty() );
-    Attributes& attributes = Renderer::attributes();
+    Attributes& attributes = unshared_attributes();
     attributes.set_surface_shader( surface_shader ? surface_shader : null_surface_shader_, camera_transform_ );
     return attributes.surface_parameters();
 }
@@ -772,7 +905,7 @@ Grid& Renderer::surface_shader( Shader* surface_shader )
 */
 Grid& Renderer::light_shader( Shader* light_shader )
 {
-    return attributes().add_light_shader( light_shader, camera_transform_ );
+    return unshared_attributes().add_light_shader( light_shader, camera_transform_ );
 }
 
 /**
@@ -833,7 +966,7 @@ Grid& Renderer::light_shader( const char* filename )
 */
 void Renderer::activate_light_shader( const Grid& grid )
 {
-    attributes().activate_light_shader( grid );
+    unshared_attributes().activate_light_shader( grid );
 }
 
 /**
@@ -845,7 +978,7 @@ void Renderer::activate_light_shader( const Grid& grid )
 */
 void Renderer::deactivate_light_shader( const Grid& grid )
 {
-    attributes().deactivate_light_shader( grid );
+    unshared_attributes().deactivate_light_shader( grid );
 }
 
 /**
@@ -862,7 +995,7 @@ void Renderer::deactivate_light_shader( const Grid& grid )
 */
 void Renderer::cone( float height, float radius, float thetamax )
 {
-    split( Cone(height, radius, thetamax) );
+    primitive( shared_ptr<Geometry>(new Cone(height, radius, thetamax)) );
 }
 
 /**
@@ -873,7 +1006,7 @@ void Renderer::cone( float height, float radius, float thetamax )
 */
 void Renderer::sphere( float radius )
 {   
-    split( Sphere(radius, -FLT_MAX, FLT_MAX, 2.0f * float(M_PI)) );
+    primitive( shared_ptr<Geometry>(new Sphere(radius, -FLT_MAX, FLT_MAX, 2.0f * float(M_PI))) );
 }
 
 /**
@@ -893,7 +1026,7 @@ void Renderer::sphere( float radius )
 */
 void Renderer::sphere( float radius, float zmin, float zmax, float thetamax )
 {   
-    split( Sphere(radius, zmin, zmax, thetamax) );
+    primitive( shared_ptr<Geometry>(new Sphere(radius, zmin, zmax, thetamax)) );
 }
 
 /**
@@ -913,7 +1046,7 @@ void Renderer::sphere( float radius, float zmin, float zmax, float thetamax )
 */
 void Renderer::cylinder( float radius, float zmin, float zmax, float thetamax )
 {   
-    split( Cylinder(radius, zmin, zmax, thetamax) );
+    primitive( shared_ptr<Geometry>(new Cylinder(radius, zmin, zmax, thetamax)) );
 }
 
 /**
@@ -930,7 +1063,7 @@ void Renderer::cylinder( float radius, float zmin, float zmax, float thetamax )
 */
 void Renderer::hyperboloid( const math::vec3& point1, const math::vec3& point2, float thetamax )
 {   
-    split( Hyperboloid(point1, point2, thetamax) );
+    primitive( shared_ptr<Geometry>(new Hyperboloid(point1, point2, thetamax)) );
 }
 
 /**
@@ -950,7 +1083,7 @@ void Renderer::hyperboloid( const math::vec3& point1, const math::vec3& point2,
 */
 void Renderer::paraboloid( float rmax, float zmin, float zmax, float thetamax )
 {   
-    split( Paraboloid(rmax, zmin, zmax, thetamax) );
+    primitive( shared_ptr<Geometry>(new Paraboloid(rmax, zmin, zmax, thetamax)) );
 }
 
 /**
@@ -967,7 +1100,7 @@ void Renderer::paraboloid( float rmax, float zmin, float zmax, float thetamax )
 */
 void Renderer::disk( float height, float radius, float thetamax )
 {
-    split( Disk(height, radius, thetamax) );
+    primitive( shared_ptr<Geometry>(new Disk(height, radius, thetamax)) );
 }
 
 /**
@@ -993,7 +1126,7 @@ void Renderer::disk( float height, float radius, float thetamax )
 */
 void Renderer::torus( float rmajor, float rminor, float phimin, float phimax, float thetamax )
 {
-    split( Torus(rmajor, rminor, phimin, phimax, thetamax) );
+    primitive( shared_ptr<Geometry>(new Torus(rmajor, rminor, phimin, phimax, thetamax)) );
 }
 
 /**
@@ -1109,7 +1242,7 @@ void Renderer::polygon( int vertices, const math::vec3* ppositions, const math::
 void Renderer::cubic_patch( const math::vec3* positions )
 {
     const Attributes& attributes = Renderer::attributes();
-    split( CubicPatch(positions, attributes.u_basis(), attributes.v_basis()) );
+    primitive( shared_ptr<Geometry>(new CubicPatch(positions, attributes.u_basis(), attributes.v_basis())) );
 }
 
 /**
@@ -1126,7 +1259,7 @@ void Renderer::cubic_patch( const math::vec3* positions )
 */
 void Renderer::linear_patch( const math::vec3* positions, const math::vec3* normals, const math::vec2* texture_coordinates )
 {
-    split( LinearPatch(positions, normals, texture_coordinates) );
+    primitive( shared_ptr<Geometry>(new LinearPatch(positions, normals, texture_coordinates)) );
 }
 
 /**
@@ -1252,117 +1385,272 @@ void Renderer::polygon_mesh( int polygons, const int* vertices, const int* indic
 }
 
 /**
-// Recursively split geometry until it is small enough to dice.
-//
-// Geometry is recursively split into smaller and smaller pieces until it can
-// be diced into a number of micropolygons that satisfies both the shading 
-// rate and the maximum number of micropolygons per grid.  Grids are also 
-// culled if their bounds project outside of the screen or on the outside of
-// the near or far clipping planes.
+// Render a primitive.
 //
-// The current transform is used to transform the grid from object space into
-// camera space where all shading and lighting calculations are performed.  
-// The current transform is also use to define the "object" coordinate system
-// that can be referred to in shaders at this point.
+// When rendering in buckets or when the retained option is set the 
+// primitive is retained along with a snapshot of the current attributes 
+// (including the current transform) and rendered at the end of world space.
+// Otherwise the primitive is split, diced, shaded, and sampled immediately.
 //
-// Once a grid has been split small enough it is shaded, sampled, and then
-// discarded.
+// The snapshot has its own copies of the shader parameters.  Callers keep 
+// writing parameters through the grids returned when shaders are set (e.g.
+// changing a surface shader's roughness between primitives) and those 
+// writes must only affect primitives passed afterwards.
 //
 // @param geometry
-//  The geometry to split.
+//  The geometry to render (assumed not null).
 */
-void Renderer::split( const Geometry& geometry )
+void Renderer::primitive( std::shared_ptr<Geometry> geometry )
 {
-    const mat4x4 transform = camera_transform_ * current_transform();
-    add_coordinate_system( "object", transform );
+    REYES_ASSERT( geometry );
+    REYES_ASSERT( !attributes_.empty() );
+    if ( options_->retained() || !buckets_.empty() )
+    {
+        shared_ptr<Attributes> attributes( new Attributes(*attributes_.back()) );
+        attributes->copy_shader_parameters();
+        primitives_.push_back( Primitive(geometry, attributes) );
+    }
+    else
+    {
+        REYES_ASSERT( !workers_.empty() );
+        workers_.front()->render( Primitive(geometry, attributes_.back()) );
+    }
+}
+
+/**
+// Render the retained primitives.
+//
+// When rendering in buckets the retained primitives are sorted into the 
+// buckets that they overlap and the buckets rendered.  Otherwise each 
+// retained primitive is rendered in the order that it was passed to the 
+// renderer.  If the front to back option is set the primitives are first
+// sorted nearest first so that geometry hidden behind primitives that have
+// already been sampled is culled before it is diced and shaded.  
+//
+// Primitives are released once they have been rendered unless the retained
+// option is set in which case they're kept so that the scene can be 
+// rendered again by Renderer::render().
+*/
+void Renderer::render_primitives()
+{
+    REYES_ASSERT( !workers_.empty() );
+
+    if ( options_->front_to_back() )
+    {
+        sort_primitives_front_to_back();
+    }
+
+    if ( !buckets_.empty() )
+    {
+        for ( vector<Primitive>::const_iterator i = primitives_.begin(); i != primitives_.end(); ++i )
+        {
+            bucket( *i );
+        }
+        render_buckets();
+    }
+    else
+    {
+        Worker* worker = workers_.front();
+        for ( vector<Primitive>::const_iterator i = primitives_.begin(); i != primitives_.end(); ++i )
+        {
+            worker->render( *i );
+        }
+    }
 
-    const float WIDTH = float(sample_buffer_->width() - 1);
-    const float HEIGHT = float(sample_buffer_->height() - 1);
-    const float SAMPLES_PER_PIXEL = float(options_->horizontal_sampling_rate() * options_->vertical_sampling_rate());
+    if ( !options_->retained() )
+    {
+        primitives_.clear();
+    }
+}
 
-    list<shared_ptr<Geometry>> geometries;
-    geometries.push_back( shared_ptr<Geometry>(const_cast<Geometry*>(&geometry), [](Geometry* /*geometry*/){}) );
-    while ( !geometries.empty() )
+/**
+// Sort the retained primitives by the nearest camera space depth of their
+// bounds.
+//
+// Primitives that can't be bounded are given a depth of zero so that they 
+// are rendered before any bounded primitives in front of the camera.  The
+// sort is stable so that primitives at the same depth are rendered in the 
+// order that they were passed to the renderer.  Primitives are bucketed in 
+// this order so the primitives in each bucket are also nearest first.
+*/
+void Renderer::sort_primitives_front_to_back()
+{
+    for ( vector<Primitive>::iterator i = primitives_.begin(); i != primitives_.end(); ++i )
     {
-        const shared_ptr<Geometry>& geometry = geometries.front();
+        Primitive& primitive = *i;
+        const shared_ptr<Geometry>& geometry = primitive.geometry();
         REYES_ASSERT( geometry );
+        float depth = 0.0f;
+        if ( geometry->boundable() )
+        {
+            const mat4x4 transform = camera_transform_ * primitive.attributes()->transform();
+            vec3 minimum = vec3( 0.0f, 0.0f, 0.0f );
+            vec3 maximum = vec3( 0.0f, 0.0f, 0.0f );
+            geometry->bound( transform, vec2(0.0f, 1.0f), vec2(0.0f, 1.0f), &minimum, &maximum );
+            depth = minimum.z;
+        }
+        primitive.set_depth( depth );
+    }
+
+    std::stable_sort( primitives_.begin(), primitives_.end(), [] (const Primitive& lhs, const Primitive& rhs) {
+        return lhs.depth() < rhs.depth();
+    } );
+}
 
+/**
+// Retain a primitive in each of the buckets that it overlaps.
+//
+// Primitives are bounded in raster space and added to the buckets whose 
+// samples (including the extra samples along the right and bottom edges 
+// needed to filter the pixels in the bucket) overlap that bound.  Primitives 
+// that can't be bounded or that span the epsilon plane are added to all 
+// buckets and split further as each bucket is rendered.
+//
+// @param primitive
+//  The primitive to retain.
+*/
+void Renderer::bucket( const Primitive& primitive )
+{
+    const shared_ptr<Geometry>& geometry = primitive.geometry();
+    REYES_ASSERT( geometry );
+    REYES_ASSERT( !buckets_.empty() );
+
+    const int horizontal_resolution = options_->horizontal_resolution();
+    const int vertical_resolution = options_->vertical_resolution();
+    const int bucket_width = options_->bucket_width();
+    const int bucket_height = options_->bucket_height();
+    const int columns = (horizontal_resolution + bucket_width - 1) / bucket_width;
+    const int rows = (vertical_resolution + bucket_height - 1) / bucket_height;
+
+    int column0 = 0;
+    int column1 = columns - 1;
+    int row0 = 0;
+    int row1 = rows - 1;
+
+    if ( geometry->boundable() )
+    {
+        const mat4x4 transform = camera_transform_ * primitive.attributes()->transform();
         vec3 minimum = vec3( 0.0f, 0.0f, 0.0f );
         vec3 maximum = vec3( 0.0f, 0.0f, 0.0f );
+        geometry->bound( transform, vec2(0.0f, 1.0f), vec2(0.0f, 1.0f), &minimum, &maximum );
+        if ( minimum.z > options_->far_clip_distance() || maximum.z < options_->near_clip_distance() )
+        {
+            return;
+        }
 
-        bool primitive_spans_epsilon_plane = false;
-        int width = 0;
-        int height = 0;
-        
-        if ( geometry->boundable() )
+        const float EPSILON = 0.01f;
+        if ( minimum.z >= EPSILON || !geometry->splittable() )
         {
-            geometry->bound( transform, &minimum, &maximum );        
-            if ( minimum.z > options_->far_clip_distance() || maximum.z < options_->near_clip_distance() )
+            vec2 raster_minimum;
+            vec2 raster_maximum;
+            raster_bound( minimum, maximum, &raster_minimum, &raster_maximum );
+            if ( raster_maximum.x < 0.0f || raster_minimum.x >= raster_width_ || raster_maximum.y < 0.0f || raster_minimum.y >= raster_height_ )
             {
-                geometries.pop_front();   
-                continue;
+                return;
             }
-            
-            const float EPSILON = 0.01f;
-            primitive_spans_epsilon_plane = minimum.z < EPSILON && geometry->splittable();
-            if ( !primitive_spans_epsilon_plane )
-            {
-                vec3 s[8];
-                s[0] = vec3( raster(vec3(minimum.x, minimum.y, minimum.z)) );
-                s[1] = vec3( raster(vec3(minimum.x, maximum.y, minimum.z)) );
-                s[2] = vec3( raster(vec3(maximum.x, minimum.y, minimum.z)) );
-                s[3] = vec3( raster(vec3(maximum.x, maximum.y, minimum.z)) );
-                s[4] = vec3( raster(vec3(minimum.x, minimum.y, maximum.z)) );
-                s[5] = vec3( raster(vec3(minimum.x, maximum.y, maximum.z)) );
-                s[6] = vec3( raster(vec3(maximum.x, minimum.y, maximum.z)) );
-                s[7] = vec3( raster(vec3(maximum.x, maximum.y, maximum.z)) );
-
-                vec2 screen_minimum( FLT_MAX, FLT_MAX );
-                vec2 screen_maximum( -FLT_MAX, -FLT_MAX );
-                for ( int i = 0; i < 8; ++i )
-                {
-                    screen_minimum.x = std::min( screen_minimum.x, s[i].x );
-                    screen_minimum.y = std::min( screen_minimum.y, s[i].y );
-                    screen_maximum.x = std::max( screen_maximum.x, s[i].x );
-                    screen_maximum.y = std::max( screen_maximum.y, s[i].y );
-                }
-                
-                float x0 = screen_minimum.x;
-                float x1 = screen_maximum.x;
-                float y0 = screen_minimum.y;
-                float y1 = screen_maximum.y;
-
-                if ( x1 < 0.0f || x0 >= WIDTH || y1 < 0.0f || y0 >= HEIGHT )
-                {
-                    geometries.pop_front();
-                    continue;
-                }
-
-                float pixels = (x1 - x0) * (y1 - y0) / SAMPLES_PER_PIXEL;
-                float micropolygons = pixels / attributes().shading_rate();
-                int power = std::max( 0, int(ceilf(lb(micropolygons) / 2.0f)) );
-                width = std::min( 1 << power, SHRT_MAX );
-                height = std::min( 1 << power, SHRT_MAX );
-            }
-        }
-        
-        if ( !primitive_spans_epsilon_plane && width * height <= MAXIMUM_VERTICES_PER_GRID && geometry->diceable() )
-        {
-            Grid grid;
-            geometry->dice( transform, width, height, &grid );
-            displacement_shade( grid );
-            surface_shade( grid );
-            sample( grid );
+
+            raster_minimum.x = std::max( raster_minimum.x, 0.0f );
+            raster_minimum.y = std::max( raster_minimum.y, 0.0f );
+            raster_maximum.x = std::min( raster_maximum.x, raster_width_ );
+            raster_maximum.y = std::min( raster_maximum.y, raster_height_ );
+
+            const float horizontal_sampling_rate = options_->horizontal_sampling_rate();
+            const float vertical_sampling_rate = options_->vertical_sampling_rate();
+            const float filter_width = ceilf( options_->filter_width() - 0.5f );
+            const float filter_height = ceilf( options_->filter_height() - 0.5f );
+            column0 = std::max( column0, int(floorf((raster_minimum.x / horizontal_sampling_rate - filter_width) / float(bucket_width))) );
+            column1 = std::min( column1, int(floorf(raster_maximum.x / horizontal_sampling_rate / float(bucket_width))) );
+            row0 = std::max( row0, int(floorf((raster_minimum.y / vertical_sampling_rate - filter_height) / float(bucket_height))) );
+            row1 = std::min( row1, int(floorf(raster_maximum.y / vertical_sampling_rate / float(bucket_height))) );
         }
-        else if ( geometry->splittable() )
+    }
+
+    for ( int row = row0; row <= row1; ++row )
+    {
+        for ( int column = column0; column <= column1; ++column )
         {
-            geometry->split( &geometries );
+            Bucket* bucket = buckets_[row * columns + column];
+            REYES_ASSERT( bucket );
+            bucket->add_primitive( primitive );
         }
-        
-        geometries.pop_front();
+    }
+}
+
+/**
+// Render the primitives retained in each bucket.
+//
+// Buckets are rendered concurrently by the workers created in 
+// Renderer::begin().  The first worker renders on the calling thread and each
+// other worker renders on a thread of its own.  Each worker repeatedly claims
+// the next unrendered bucket, splits, dices, shades, and samples its 
+// primitives into the worker's bucket sized sample buffer and then filters, 
+// exposes, and quantizes that sample buffer into the part of the image 
+// buffer covered by the bucket.  Workers that run out of work steal pieces
+// of split geometry from other workers so that large primitives are spread
+// across threads.  This returns once all of the buckets have been rendered.
+*/
+void Renderer::render_buckets()
+{
+    REYES_ASSERT( !workers_.empty() );
+    REYES_ASSERT( image_buffer_ );
+
+    if ( buckets_.empty() )
+    {
+        return;
     }
 
-    remove_coordinate_system( "object" );
+    std::atomic<int> next_bucket( 0 );
+    vector<std::thread> threads;
+    threads.reserve( workers_.size() - 1 );
+    for ( vector<Worker*>::const_iterator i = workers_.begin() + 1; i != workers_.end(); ++i )
+    {
+        Worker* worker = *i;
+        REYES_ASSERT( worker );
+        threads.push_back( std::thread(&Worker::render_buckets, worker, std::cref(workers_), std::cref(buckets_), &next_bucket, image_buffer_) );
+    }
+
+    workers_.front()->render_buckets( workers_, buckets_, &next_bucket, image_buffer_ );
+
+    for ( vector<std::thread>::iterator i = threads.begin(); i != threads.end(); ++i )
+    {
+        i->join();
+    }
+}
+
+/**
+// Get the number of grids diced and shaded since the frame was begun.
+//
+// @return
+//  The number of grids shaded by all workers.
+*/
+int Renderer::shaded_grids() const
+{
+    int shaded_grids = 0;
+    for ( vector<Worker*>::const_iterator i = workers_.begin(); i != workers_.end(); ++i )
+    {
+        shaded_grids += (*i)->shaded_grids();
+    }
+    return shaded_grids;
+}
+
+/**
+// Get the number of pieces of geometry culled as occluded, and so never 
+// diced and shaded, since the frame was begun.
+//
+// Rendering retained primitives front to back with the front to back option
+// increases this count by sampling likely occluders first.
+//
+// @return
+//  The number of pieces of geometry culled as occluded by all workers.
+*/
+int Renderer::occluded_grids() const
+{
+    int occluded_grids = 0;
+    for ( vector<Worker*>::const_iterator i = workers_.begin(); i != workers_.end(); ++i )
+    {
+        occluded_grids += (*i)->occluded_grids();
+    }
+    return occluded_grids;
 }
 
 /**
@@ -1398,22 +1686,6 @@ void Renderer::light_shade( Grid& grid )
     attributes().light_shade( grid );
 }
 
-/**
-// Sample \e grid.
-//
-// @param grid
-//  The grid to sample.
-*/
-void Renderer::sample( const Grid& grid )
-{
-    REYES_ASSERT( sampler_ );    
-    const Attributes& attributes = Renderer::attributes();
-    bool matte = attributes.matte();
-    bool two_sided = attributes.two_sided();
-    bool left_handed = attributes.geometry_left_handed();
-    sampler_->sample( screen_transform_, grid, matte, two_sided, left_handed, sample_buffer_ );
-}
-
 /**
 // Save the current contents of the image buffer to a file.
 //
@@ -1480,7 +1752,7 @@ void Renderer::save_image_as_png( const char* format, ... ) const
 */
 void Renderer::save_samples( int mode, const char* format, ... ) const
 {
-    REYES_ASSERT( sample_buffer_ );
+    REYES_ASSERT( !workers_.empty() );
     REYES_ASSERT( format );
 
     char filename [1024];
@@ -1490,7 +1762,7 @@ void Renderer::save_samples( int mode, const char* format, ... ) const
     va_end( args );
     filename [sizeof(filename) - 1] = 0;
 
-    sample_buffer_->save( mode, filename );
+    workers_.front()->sample_buffer()->save( mode, filename );
 }
 
 /**
@@ -1512,7 +1784,7 @@ void Renderer::save_samples( int mode, const char* format, ... ) const
 */
 void Renderer::save_samples_as_png( int mode, const char* format, ... ) const
 {
-    REYES_ASSERT( sample_buffer_ );
+    REYES_ASSERT( !workers_.empty() );
     REYES_ASSERT( format );
 
     char filename [1024];
@@ -1522,7 +1794,7 @@ void Renderer::save_samples_as_png( int mode, const char* format, ... ) const
     va_end( args );
     filename [sizeof(filename) - 1] = 0;
 
-    sample_buffer_->save_png( mode, filename, error_policy_ );
+    workers_.front()->sample_buffer()->save_png( mode, filename, error_policy_ );
 }
 
 /**
@@ -1539,11 +1811,9 @@ void Renderer::texture( const char* filename )
 {
     REYES_ASSERT( filename );
     
-    Texture* texture = find_texture( filename );
-    if ( !texture )
+    if ( !find_texture(filename) )
     {
-        texture = new Texture( filename, TEXTURE_COLOR, error_policy_ );
-        textures_.insert( make_pair(filename, texture) );
+        textures_.insert( make_pair(filename, load_texture(filename, TEXTURE_COLOR)) );
     }
 }
 
@@ -1559,11 +1829,9 @@ void Renderer::texture( const char* filename )
 */
 void Renderer::environment( const char* filename )
 {
-    Texture* texture = find_texture( filename );
-    if ( !texture )
+    if ( !find_texture(filename) )
     {
-        texture = new Texture( filename, TEXTURE_LATLONG_ENVIRONMENT, error_policy_ );
-        textures_.insert( make_pair(filename, texture) );
+        textures_.insert( make_pair(filename, load_texture(filename, TEXTURE_LATLONG_ENVIRONMENT)) );
     }
 }
 
@@ -1584,11 +1852,9 @@ void Renderer::environment( const char* filename )
 */
 void Renderer::cubic_environment( const char* filename )
 {
-    Texture* texture = find_texture( filename );
-    if ( !texture )
+    if ( !find_texture(filename) )
     {
-        texture = new Texture( filename, TEXTURE_CUBIC_ENVIRONMENT, error_policy_ );
-        textures_.insert( make_pair(filename, texture) );
+        textures_.insert( make_pair(filename, load_texture(filename, TEXTURE_CUBIC_ENVIRONMENT)) );
     }
 }
 
@@ -1598,6 +1864,9 @@ void Renderer::cubic_environment( const char* filename )
 // To refer to the shadow map each shader should use the same string value as 
 // passed to \e name to identify it in a shadow() call.
 //
+// Shadow maps can't be generated when rendering in buckets as there is no
+// sample buffer covering the whole frame to generate them from.
+//
 // @param name
 //  The name to identify the shadow map with (assumed not null).
 */
@@ -1605,15 +1874,22 @@ void Renderer::shadow_from_framebuffer( const char* name )
 {
     REYES_ASSERT( name );
 
-    Texture* texture = find_texture( name );
+    if ( !buckets_.empty() )
+    {
+        error_policy_->error( RENDER_ERROR_BUCKETS_NOT_SUPPORTED, "Unable to generate shadow map '%s' from the framebuffer when rendering in buckets", name );
+        return;
+    }
+
+    Texture* texture = find_framebuffer_texture( name );
     if ( !texture )
     {
         texture = new Texture( TEXTURE_SHADOW, camera_transform_, screen_transform_ );
-        textures_.insert( make_pair(name, texture) );
+        framebuffer_textures_.insert( make_pair(name, texture) );
     }
 
     REYES_ASSERT( texture->type() == TEXTURE_SHADOW );
-    sample_buffer_->pack( DISPLAY_MODE_Z, texture->image_buffers() );
+    REYES_ASSERT( !workers_.empty() );
+    workers_.front()->sample_buffer()->pack( DISPLAY_MODE_Z, texture->image_buffers() );
 }
 
 /**
@@ -1622,6 +1898,9 @@ void Renderer::shadow_from_framebuffer( const char* name )
 // To refer to the texture map each shader should use the same string value as 
 // passed to \e name to identify it in a texture() call.
 //
+// Textures can't be generated when rendering in buckets as there is no 
+// sample buffer covering the whole frame to generate them from.
+//
 // @param name
 //  The name to identify the texture with (assumed not null).
 */
@@ -1629,20 +1908,30 @@ void Renderer::texture_from_framebuffer( const char* name )
 {
     REYES_ASSERT( name );
 
-    Texture* texture = find_texture( name );
+    if ( !buckets_.empty() )
+    {
+        error_policy_->error( RENDER_ERROR_BUCKETS_NOT_SUPPORTED, "Unable to generate texture '%s' from the framebuffer when rendering in buckets", name );
+        return;
+    }
+
+    Texture* texture = find_framebuffer_texture( name );
     if ( !texture )
     {
         texture = new Texture( TEXTURE_COLOR, math::identity(), math::identity() );
-        textures_.insert( make_pair(name, texture) );
+        framebuffer_textures_.insert( make_pair(name, texture) );
     }    
 
     REYES_ASSERT( texture->type() == TEXTURE_COLOR );
-    sample_buffer_->pack( DISPLAY_MODE_RGB | DISPLAY_MODE_A, texture->image_buffers() );
+    REYES_ASSERT( !workers_.empty() );
+    workers_.front()->sample_buffer()->pack( DISPLAY_MODE_RGB | DISPLAY_MODE_A, texture->image_buffers() );
 }
 
 /**
 // Find a loaded texture.
 //
+// Textures generated from the framebuffer are found in preference to 
+// textures loaded from files with the same name.
+//
 // @param filename
 //  The string that identifies the texture (assumed not null).
 //
@@ -1653,8 +1942,76 @@ Texture* Renderer::find_texture( const char* filename ) const
 {
     REYES_ASSERT( filename );
     
-    map<string, Texture*>::const_iterator i = textures_.find( filename );
-    return i != textures_.end() ? i->second : NULL;
+    Texture* texture = find_framebuffer_texture( filename );
+    if ( !texture )
+    {
+        map<string, shared_ptr<Texture>>::const_iterator i = textures_.find( filename );
+        texture = i != textures_.end() ? i->second.get() : NULL;
+    }
+    return texture;
+}
+
+/**
+// Find a texture generated from the framebuffer.
+//
+// Textures generated from the framebuffer are private to this renderer as 
+// they are overwritten each time they're generated.
+//
+// @param name
+//  The string that identifies the texture (assumed not null).
+//
+// @return 
+//  The texture or null if no such texture has been generated.
+*/
+Texture* Renderer::find_framebuffer_texture( const char* name ) const
+{
+    REYES_ASSERT( name );
+    
+    map<string, Texture*>::const_iterator i = framebuffer_textures_.find( name );
+    return i != framebuffer_textures_.end() ? i->second : NULL;
+}
+
+/**
+// Load a texture or share the copy already loaded by another renderer.
+//
+// Textures are shared by filename, type, and the size and modification 
+// time of the file so that a texture written again between renders is 
+// loaded again rather than found.  Textures that fail to load aren't 
+// shared so that each renderer that tries to load them reports the failure
+// to its own error policy.
+//
+// @param filename
+//  The path to the texture map to load (assumed not null).
+//
+// @param type
+//  The type of texture to load \e filename as.
+//
+// @return
+//  The texture.
+*/
+std::shared_ptr<Texture> Renderer::load_texture( const char* filename, TextureType type )
+{
+    REYES_ASSERT( filename );
+    REYES_ASSERT( error_policy_ );
+
+    struct stat status;
+    memset( &status, 0, sizeof(status) );
+    stat( filename, &status );
+    char key [64];
+    snprintf( key, sizeof(key), "%d:%lld:%lld:", int(type), (long long) status.st_size, (long long) status.st_mtime );
+    const string registry_key = string( key ) + filename;
+
+    Registry& registry = Registry::instance();
+    shared_ptr<Texture> texture = registry.find_texture( registry_key );
+    if ( !texture )
+    {
+        texture.reset( new Texture(filename, type, error_policy_) );
+        if ( texture->valid() )
+        {
+            texture = registry.add_texture( registry_key, texture );
+        }
+    }
+    return texture;
 }
 
 /**
@@ -1662,7 +2019,16 @@ Texture* Renderer::find_texture( const char* filename ) const
 //
 // Looks for an existing loaded shader that was loaded using the same 
 // filename and returns that.  If there is no existing loaded shader with
-// that filename then a new shader is loaded and returned.
+// that filename then the shader is shared from another renderer that has
+// loaded the same source with an identical symbol table and native shader
+// or, failing that, a new shader is loaded, shared, and returned.
+//
+// Shaders are loaded from the shader cache directory set in the options 
+// when there is one and only compiled if they're missing from that cache.
+//
+// Newly loaded shaders are executed by native code added with 
+// Renderer::add_native_shader() if that code was generated from the same
+// byte code, otherwise they are interpreted.
 //
 // @param filename
 //  The filename of the shader to find or load.
@@ -1677,8 +2043,47 @@ Shader* Renderer::shader( const char* filename )
     Shader* shader = find_shader( filename );
     if ( !shader )
     {
-        shader = new Shader( filename, symbol_table(), error_policy() );
-        shaders_.insert( make_pair(filename, shader) );
+        // Shaders are shared by a hash of their source rather than only 
+        // their filename so that a shader edited between renders is 
+        // compiled again, unreadable sources are left for the compiler to 
+        // report and never shared.
+        const NativeShader* native_shader = find_native_shader( filename );
+        vector<unsigned char> source;
+        const bool readable = read_file( filename, &source );
+        const uint64_t source_hash = hash( source.empty() ? NULL : &source[0], source.size() );
+        char key [96];
+        snprintf( key, sizeof(key), "|%016llx|%016llx|%p", (unsigned long long) source_hash, (unsigned long long) symbol_table().fingerprint(), (const void*) native_shader );
+        const string registry_key = string( filename ) + key;
+
+        Registry& registry = Registry::instance();
+        shared_ptr<Shader> shared_shader;
+        if ( readable )
+        {
+            shared_shader = registry.find_shader( registry_key );
+        }
+        if ( !shared_shader )
+        {
+            const int errors = error_policy().total_errors();
+            if ( !options_->shader_cache_directory().empty() )
+            {
+                ShaderCache shader_cache( options_->shader_cache_directory().c_str() );
+                shared_shader.reset( shader_cache.shader(filename, symbol_table(), error_policy()) );
+            }
+            else
+            {
+                shared_shader.reset( new Shader(filename, symbol_table(), error_policy()) );
+            }
+            if ( native_shader && native_shader->fingerprint == shared_shader->fingerprint() )
+            {
+                shared_shader->set_native_shader( native_shader );
+            }
+            if ( readable && error_policy().total_errors() == errors )
+            {
+                shared_shader = registry.add_shader( registry_key, shared_shader );
+            }
+        }
+        shader = shared_shader.get();
+        shaders_.insert( make_pair(filename, shared_shader) );
     }
     return shader;
 }
@@ -1696,8 +2101,51 @@ Shader* Renderer::find_shader( const char* filename ) const
 {
     REYES_ASSERT( filename );
     
-    map<string, Shader*>::const_iterator i = shaders_.find( filename );
-    return i != shaders_.end() ? i->second : NULL;
+    map<string, shared_ptr<Shader>>::const_iterator i = shaders_.find( filename );
+    return i != shaders_.end() ? i->second.get() : NULL;
+}
+
+/**
+// Add a shader compiled ahead of time to be used in place of interpreting
+// the shader that it was generated from.
+//
+// Native shaders are only used for shaders loaded after they are added.
+//
+// @param native_shader
+//  The native shader to add (assumed not null and to remain valid for the
+//  lifetime of this renderer, usually a static generated by reyes_shaderc).
+*/
+void Renderer::add_native_shader( const NativeShader* native_shader )
+{
+    REYES_ASSERT( native_shader );
+    REYES_ASSERT( native_shader->name );
+    native_shaders_[native_shader->name] = native_shader;
+}
+
+/**
+// Find the native shader generated from a shader.
+//
+// @param filename
+//  The filename of the shader to find the native shader for, directories
+//  are ignored.
+//
+// @return
+//  The native shader or null if no matching native shader was found.
+*/
+const NativeShader* Renderer::find_native_shader( const char* filename ) const
+{
+    REYES_ASSERT( filename );
+
+    const char* name = filename;
+    for ( const char* i = filename; *i; ++i )
+    {
+        if ( *i == '/' || *i == '\\' )
+        {
+            name = i + 1;
+        }
+    }
+    map<string, const NativeShader*>::const_iterator i = native_shaders_.find( name );
+    return i != native_shaders_.end() ? i->second : NULL;
 }
 
 /**
@@ -1796,9 +2244,33 @@ math::vec4 Renderer::raster( const math::vec3& x ) const
     //  Make the Renderer::raster() function take into account the projection
     //  and view transforms to transform from view space into sample space 
     //  correctly.
-    const float width = float(sample_buffer_->width() - 1);
-    const float height = float(sample_buffer_->height() - 1);    
-    return renderman_project( screen_transform_, width, height, x );
+    return renderman_project( screen_transform_, raster_width_, raster_height_, x );
+}
+
+void Renderer::raster_bound( const math::vec3& minimum, const math::vec3& maximum, math::vec2* raster_minimum, math::vec2* raster_maximum ) const
+{
+    REYES_ASSERT( raster_minimum );
+    REYES_ASSERT( raster_maximum );
+
+    vec3 s[8];
+    s[0] = vec3( raster(vec3(minimum.x, minimum.y, minimum.z)) );
+    s[1] = vec3( raster(vec3(minimum.x, maximum.y, minimum.z)) );
+    s[2] = vec3( raster(vec3(maximum.x, minimum.y, minimum.z)) );
+    s[3] = vec3( raster(vec3(maximum.x, maximum.y, minimum.z)) );
+    s[4] = vec3( raster(vec3(minimum.x, minimum.y, maximum.z)) );
+    s[5] = vec3( raster(vec3(minimum.x, maximum.y, maximum.z)) );
+    s[6] = vec3( raster(vec3(maximum.x, minimum.y, maximum.z)) );
+    s[7] = vec3( raster(vec3(maximum.x, maximum.y, maximum.z)) );
+
+    *raster_minimum = vec2( FLT_MAX, FLT_MAX );
+    *raster_maximum = vec2( -FLT_MAX, -FLT_MAX );
+    for ( int i = 0; i < 8; ++i )
+    {
+        raster_minimum->x = std::min( raster_minimum->x, s[i].x );
+        raster_minimum->y = std::min( raster_minimum->y, s[i].y );
+        raster_maximum->x = std::max( raster_maximum->x, s[i].x );
+        raster_maximum->y = std::max( raster_maximum->y, s[i].y );
+    }
 }
 
 float Renderer::min( float a, float b, float c, float d ) const
@@ -1,6 +1,8 @@
 #ifndef REYES_RENDERER_HPP_INCLUDED
 #define REYES_RENDERER_HPP_INCLUDED
 
+#include "Primitive.hpp"
+#include "TextureType.hpp"
 #include <math/vec3.hpp>
 #include <math/vec4.hpp>
 #include <math/mat4x4.hpp>
@@ -14,18 +16,19 @@ namespace reyes
 {
 
 class ErrorPolicy;
-class SampleBuffer;
 class ImageBuffer;
 class Options;
 class Attributes;
 class SymbolTable;
 class VirtualMachine;
-class Sampler;
 class Value;
 class Grid;
 class Geometry;
 class Texture;
 class Shader;
+struct NativeShader;
+class Bucket;
+class Worker;
 
 /**
 // The main interface to the renderer.
@@ -36,13 +39,18 @@ class Renderer
     SymbolTable* symbol_table_; ///< The symbol table used to store symbols when compiling shaders.
     VirtualMachine* virtual_machine_; ///< The virtual machine used to execute shaders.
     Shader* null_surface_shader_; ///< The null surface shader used when no surface shader is set.
-    SampleBuffer* sample_buffer_; ///< The sample buffer that grids are sampled into.
     ImageBuffer* image_buffer_; ///< The image buffer that the final image is filtered, exposed, and quantized into.
-    Sampler* sampler_; ///< The sampler that samples grids into the sample buffer.
     math::mat4x4 screen_transform_; ///< Transform camera space to screen space.    
     math::mat4x4 camera_transform_; ///< Transform world space to camera space.
-    std::map<std::string, Texture*> textures_; ///< The textures that have been loaded (by filename).
-    std::map<std::string, Shader*> shaders_; ///< The shaders that have been loaded (by filename).
+    float raster_width_; ///< The width of raster space for the whole frame (in samples).
+    float raster_height_; ///< The height of raster space for the whole frame (in samples).
+    std::vector<Primitive> primitives_; ///< The primitives retained to be rendered at the end of world space.
+    std::vector<Bucket*> buckets_; ///< The buckets that primitives are sorted into when rendering in buckets.
+    std::vector<Worker*> workers_; ///< The workers that split, dice, shade, and sample primitives (the first renders on the calling thread).
+    std::map<std::string, std::shared_ptr<Texture>> textures_; ///< The textures that have been loaded (by filename), shared with other renderers.
+    std::map<std::string, Texture*> framebuffer_textures_; ///< The textures that have been generated from the framebuffer (by name).
+    std::map<std::string, std::shared_ptr<Shader>> shaders_; ///< The shaders that have been loaded (by filename), shared with other renderers.
+    std::map<std::string, const NativeShader*> native_shaders_; ///< The shaders compiled ahead of time (by filename without directories).
     Options* options_; /// The options used for this renderer.
     std::vector<std::shared_ptr<Attributes>> attributes_; ///< The attributes stack.
 
@@ -59,6 +67,7 @@ class Renderer
         void push_attributes();
         void pop_attributes();
         Attributes& attributes() const;
+        Attributes& unshared_attributes();
         
         void shading_rate( float shading_rate );
         void matte( bool matte );
@@ -72,6 +81,7 @@ class Renderer
         
         void begin();
         void end();        
+        void render();
         void begin_world();
         void end_world();
         void projection();
@@ -120,11 +130,18 @@ class Renderer
         void linear_patch( const math::vec3* positions, const math::vec3* normals, const math::vec2* texture_coordinates );
         void polygon_mesh( int polygons, const int* vertices, const int* indices, const math::vec3* positions, const math::vec3* normals, const math::vec2* texture_coordinates );
 
-        void split( const Geometry& geometry );        
+        void primitive( std::shared_ptr<Geometry> geometry );
+        void allocate_buffers();
+        void filter_samples();
+        void render_primitives();
+        void sort_primitives_front_to_back();
+        void bucket( const Primitive& primitive );
+        void render_buckets();
+        int shaded_grids() const;
+        int occluded_grids() const;
         void displacement_shade( Grid& grid );
         void surface_shade( Grid& grid );
         void light_shade( Grid& grid );
-        void sample( const Grid& grid );
         
         void save_image( const char* format, ... ) const;
         void save_image_as_png( const char* format, ... ) const;
@@ -137,9 +154,13 @@ class Renderer
         void shadow_from_framebuffer( const char* name );
         void texture_from_framebuffer( const char* name );
         Texture* find_texture( const char* filename ) const;
+        Texture* find_framebuffer_texture( const char* name ) const;
+        std::shared_ptr<Texture> load_texture( const char* filename, TextureType type );
 
         Shader* shader( const char* filename );
         Shader* find_shader( const char* filename ) const;
+        void add_native_shader( const NativeShader* native_shader );
+        const NativeShader* find_native_shader( const char* filename ) const;
 
         const math::vec4* bezier_basis() const;
         const math::vec4* bspline_basis() const;
@@ -148,6 +169,7 @@ class Renderer
         const math::vec4* power_basis() const;
 
         math::vec4 raster( const math::vec3& x ) const;
+        void raster_bound( const math::vec3& minimum, const math::vec3& maximum, math::vec2* raster_minimum, math::vec2* raster_maximum ) const;
         float min( float a, float b, float c, float d ) const;
         float max( float a, float b, float c, float d ) const;
         float lb( float x ) const;
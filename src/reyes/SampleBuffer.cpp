@@ -18,50 +18,63 @@
 #include <algorithm>
 
 using std::max;
+using std::min;
+using std::vector;
 using namespace math;
 using namespace reyes;
 
 SampleBuffer::SampleBuffer( int horizontal_resolution, int vertical_resolution, int horizontal_sampling_rate, int vertical_sampling_rate, float filter_width, float filter_height )
-: horizontal_resolution_( horizontal_resolution ),
-  vertical_resolution_( vertical_resolution ),
+: x_( 0 ),
+  y_( 0 ),
+  horizontal_resolution_( 0 ),
+  vertical_resolution_( 0 ),
   horizontal_sampling_rate_( horizontal_sampling_rate ),
   vertical_sampling_rate_( vertical_sampling_rate ),
   filter_width_( filter_width ),
   filter_height_( filter_height ),
-  width_( (horizontal_resolution + int(ceilf(filter_width - 0.5f))) * horizontal_sampling_rate ),
-  height_( (vertical_resolution + int(ceilf(filter_height - 0.5f))) * vertical_sampling_rate ),
+  width_( 0 ),
+  height_( 0 ),
   colors_( NULL ),
   depths_( NULL ),
-  positions_( NULL )
+  positions_( NULL ),
+  maximum_depths_()
 {
-    REYES_ASSERT( width_ > 0 );
-    REYES_ASSERT( height_ > 0 );
+    colors_ = new ImageBuffer;
+    depths_ = new ImageBuffer;
+    positions_ = new ImageBuffer;
+    reset( 0, 0, horizontal_resolution, vertical_resolution );
+}
 
-    colors_ = new ImageBuffer( width_, height_, 4, FORMAT_F32 );
-    depths_ = new ImageBuffer( width_, height_, 1, FORMAT_F32 );
-    positions_ = new ImageBuffer( width_, height_, 4, FORMAT_F32 );
-    
-    float* depths = depths_->f32_data();
-    for ( int i = 0; i < width_ * height_; ++i )
-    {
-        depths[i] = FLT_MAX;
-    }
-    
-    float* positions = positions_->f32_data();
-    for ( int y = 0; y < height_; ++y )
-    {
-        for ( int x = 0; x < width_; ++x )
-        {
-            positions[(y * width_ + x) * 4 + 0] = float(x);
-            positions[(y * width_ + x) * 4 + 1] = float(y);
-            positions[(y * width_ + x) * 4 + 2] = 0.0f;
-            positions[(y * width_ + x) * 4 + 3] = 0.0f;
-        }
-    }
+SampleBuffer::SampleBuffer( int x, int y, int horizontal_resolution, int vertical_resolution, int horizontal_sampling_rate, int vertical_sampling_rate, float filter_width, float filter_height )
+: x_( 0 ),
+  y_( 0 ),
+  horizontal_resolution_( 0 ),
+  vertical_resolution_( 0 ),
+  horizontal_sampling_rate_( horizontal_sampling_rate ),
+  vertical_sampling_rate_( vertical_sampling_rate ),
+  filter_width_( filter_width ),
+  filter_height_( filter_height ),
+  width_( 0 ),
+  height_( 0 ),
+  colors_( NULL ),
+  depths_( NULL ),
+  positions_( NULL ),
+  maximum_depths_()
+{
+    colors_ = new ImageBuffer;
+    depths_ = new ImageBuffer;
+    positions_ = new ImageBuffer;
+    reset( x, y, horizontal_resolution, vertical_resolution );
 }
 
 SampleBuffer::~SampleBuffer()
 {
+    for ( vector<ImageBuffer*>::const_iterator i = maximum_depths_.begin(); i != maximum_depths_.end(); ++i )
+    {
+        delete *i;
+    }
+    maximum_depths_.clear();
+
     delete positions_;
     positions_ = NULL;
 
@@ -72,6 +85,16 @@ SampleBuffer::~SampleBuffer()
     colors_ = NULL;    
 }
 
+int SampleBuffer::x() const
+{
+    return x_;
+}
+
+int SampleBuffer::y() const
+{
+    return y_;
+}
+
 int SampleBuffer::width() const
 {
     return width_;
@@ -84,26 +107,112 @@ int SampleBuffer::height() const
 
 float* SampleBuffer::color( int x, int y ) const
 {
-    REYES_ASSERT( x >= 0 && x < width_ );
-    REYES_ASSERT( y >= 0 && y < height_ );
+    REYES_ASSERT( x >= x_ && x < x_ + width_ );
+    REYES_ASSERT( y >= y_ && y < y_ + height_ );
     REYES_ASSERT( colors_ );
-    return colors_->f32_data( x, y );
+    return colors_->f32_data( x - x_, y - y_ );
 }
 
 float* SampleBuffer::depth( int x, int y ) const
 {
-    REYES_ASSERT( x >= 0 && x < width_ );
-    REYES_ASSERT( y >= 0 && y < height_ );
+    REYES_ASSERT( x >= x_ && x < x_ + width_ );
+    REYES_ASSERT( y >= y_ && y < y_ + height_ );
     REYES_ASSERT( depths_ );
-    return depths_->f32_data( x, y );
+    return depths_->f32_data( x - x_, y - y_ );
 }
 
 float* SampleBuffer::position( int x, int y ) const
 {
-    REYES_ASSERT( x >= 0 && x < width_ );
-    REYES_ASSERT( y >= 0 && y < height_ );
+    REYES_ASSERT( x >= x_ && x < x_ + width_ );
+    REYES_ASSERT( y >= y_ && y < y_ + height_ );
     REYES_ASSERT( positions_ );
-    return positions_->f32_data( x, y );
+    return positions_->f32_data( x - x_, y - y_ );
+}
+
+bool SampleBuffer::occluded( float x0, float x1, float y0, float y1, float z ) const
+{
+    // Test against the finest level of the hierarchical depth buffer at 
+    // which the bound covers no more than 2 x 2 blocks.  The bound is 
+    // expanded by a sample in each direction to conservatively include any 
+    // samples on its edges.
+    int sx0 = int(floorf( std::max(x0, float(x_)) )) - 1 - x_;
+    int sx1 = int(ceilf( std::min(x1, float(x_ + width_)) )) + 1 - x_;
+    int sy0 = int(floorf( std::max(y0, float(y_)) )) - 1 - y_;
+    int sy1 = int(ceilf( std::min(y1, float(y_ + height_)) )) + 1 - y_;
+    sx0 = max( sx0, 0 );
+    sx1 = min( sx1, width_ - 1 );
+    sy0 = max( sy0, 0 );
+    sy1 = min( sy1, height_ - 1 );
+    if ( sx0 > sx1 || sy0 > sy1 )
+    {
+        return false;
+    }
+
+    const ImageBuffer* depths = depths_;
+    vector<ImageBuffer*>::const_iterator level = maximum_depths_.begin();
+    while ( (sx1 - sx0 > 1 || sy1 - sy0 > 1) && level != maximum_depths_.end() )
+    {
+        sx0 >>= 1;
+        sx1 >>= 1;
+        sy0 >>= 1;
+        sy1 >>= 1;
+        depths = *level;
+        ++level;
+    }
+
+    for ( int y = sy0; y <= sy1; ++y )
+    {
+        for ( int x = sx0; x <= sx1; ++x )
+        {
+            if ( *depths->f32_data(x, y) >= z )
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void SampleBuffer::update_maximum_depths( int x0, int x1, int y0, int y1 )
+{
+    int sx0 = max( x0 - x_, 0 );
+    int sx1 = min( x1 - x_, width_ );
+    int sy0 = max( y0 - y_, 0 );
+    int sy1 = min( y1 - y_, height_ );
+    
+    const ImageBuffer* source = depths_;
+    for ( vector<ImageBuffer*>::const_iterator i = maximum_depths_.begin(); i != maximum_depths_.end() && sx0 < sx1 && sy0 < sy1; ++i )
+    {
+        ImageBuffer* destination = *i;
+        REYES_ASSERT( destination );
+        sx0 = sx0 >> 1;
+        sx1 = ((sx1 - 1) >> 1) + 1;
+        sy0 = sy0 >> 1;
+        sy1 = ((sy1 - 1) >> 1) + 1;
+        for ( int y = sy0; y < sy1; ++y )
+        {
+            for ( int x = sx0; x < sx1; ++x )
+            {
+                const int xx = x * 2;
+                const int yy = y * 2;
+                float depth = *source->f32_data( xx, yy );
+                if ( xx + 1 < source->width() )
+                {
+                    depth = std::max( depth, *source->f32_data(xx + 1, yy) );
+                }
+                if ( yy + 1 < source->height() )
+                {
+                    depth = std::max( depth, *source->f32_data(xx, yy + 1) );
+                    if ( xx + 1 < source->width() )
+                    {
+                        depth = std::max( depth, *source->f32_data(xx + 1, yy + 1) );
+                    }
+                }
+                *destination->f32_data( x, y ) = depth;
+            }
+        }
+        source = destination;
+    }
 }
 
 void SampleBuffer::save( int mode, const char* filename ) const
@@ -171,7 +280,7 @@ void SampleBuffer::filter( float (*filter_function)(float, float, float, float),
             {
                 for ( int xx = x0; xx < x1; ++xx )
                 {
-                    const float* color = SampleBuffer::color( xx, yy );
+                    const float* color = SampleBuffer::color( x_ + xx, y_ + yy );
                     float weight = (*filter_function)( float(xx) - px, float(yy) - py, filter_width_, filter_height_ );
                     area += weight;
                     pixel += weight * vec4( color[0], color[1], color[2], color[3] );
@@ -223,3 +332,69 @@ void SampleBuffer::pack( int mode, ImageBuffer* image_buffer ) const
         depths += 1;
     }
 }
+
+void SampleBuffer::reset( int x, int y, int horizontal_resolution, int vertical_resolution )
+{
+    REYES_ASSERT( x >= 0 );
+    REYES_ASSERT( y >= 0 );
+    REYES_ASSERT( colors_ );
+    REYES_ASSERT( depths_ );
+    REYES_ASSERT( positions_ );
+
+    x_ = x * horizontal_sampling_rate_;
+    y_ = y * vertical_sampling_rate_;
+    horizontal_resolution_ = horizontal_resolution;
+    vertical_resolution_ = vertical_resolution;
+    width_ = (horizontal_resolution + int(ceilf(filter_width_ - 0.5f))) * horizontal_sampling_rate_;
+    height_ = (vertical_resolution + int(ceilf(filter_height_ - 0.5f))) * vertical_sampling_rate_;
+    REYES_ASSERT( width_ > 0 );
+    REYES_ASSERT( height_ > 0 );
+
+    colors_->reset( width_, height_, 4, FORMAT_F32 );
+    depths_->reset( width_, height_, 1, FORMAT_F32 );
+    positions_->reset( width_, height_, 4, FORMAT_F32 );
+    
+    float* depths = depths_->f32_data();
+    for ( int i = 0; i < width_ * height_; ++i )
+    {
+        depths[i] = FLT_MAX;
+    }
+    
+    int level_width = width_;
+    int level_height = height_;
+    unsigned int levels = 0;
+    while ( level_width > 1 || level_height > 1 )
+    {
+        level_width = (level_width + 1) / 2;
+        level_height = (level_height + 1) / 2;
+        if ( levels >= maximum_depths_.size() )
+        {
+            maximum_depths_.push_back( new ImageBuffer );
+        }
+        ImageBuffer* maximum_depths = maximum_depths_[levels];
+        maximum_depths->reset( level_width, level_height, 1, FORMAT_F32 );
+        float* maximum_depths_data = maximum_depths->f32_data();
+        for ( int i = 0; i < level_width * level_height; ++i )
+        {
+            maximum_depths_data[i] = FLT_MAX;
+        }
+        ++levels;
+    }
+    while ( maximum_depths_.size() > levels )
+    {
+        delete maximum_depths_.back();
+        maximum_depths_.pop_back();
+    }
+    
+    float* positions = positions_->f32_data();
+    for ( int y = 0; y < height_; ++y )
+    {
+        for ( int x = 0; x < width_; ++x )
+        {
+            positions[(y * width_ + x) * 4 + 0] = float(x_ + x);
+            positions[(y * width_ + x) * 4 + 1] = float(y_ + y);
+            positions[(y * width_ + x) * 4 + 2] = 0.0f;
+            positions[(y * width_ + x) * 4 + 3] = 0.0f;
+        }
+    }
+}
@@ -3,6 +3,7 @@
 
 #include <math/vec4.hpp>
 #include <math/mat4x4.hpp>
+#include <vector>
 
 namespace reyes
 {
@@ -15,6 +16,8 @@ class ImageBuffer;
 */
 class SampleBuffer
 {
+    int x_; ///< The x coordinate of the first sample in this buffer in the sample space of the whole frame.
+    int y_; ///< The y coordinate of the first sample in this buffer in the sample space of the whole frame.
     int horizontal_resolution_; ///< The number of pixels across.
     int vertical_resolution_; ///< The number of pixels down.
     int horizontal_sampling_rate_; ///< The number of samples across a pixel.
@@ -26,21 +29,28 @@ class SampleBuffer
     ImageBuffer* colors_; ///< The color of the nearest element.
     ImageBuffer* depths_; ///< The distance of the nearest element from the near plane.
     ImageBuffer* positions_; ///< The sample position on the near plane in sample space.
+    std::vector<ImageBuffer*> maximum_depths_; ///< The hierarchical depth buffer; level n holds the farthest depth in each 2^(n+1) by 2^(n+1) block of samples.
     
     public:
         SampleBuffer( int horizontal_resolution, int vertical_resolution, int horizontal_sampling_rate, int vertical_sampling_rate, float filter_width, float filter_height );
+        SampleBuffer( int x, int y, int horizontal_resolution, int vertical_resolution, int horizontal_sampling_rate, int vertical_sampling_rate, float filter_width, float filter_height );
         ~SampleBuffer();
         
+        int x() const;
+        int y() const;
         int width() const;
         int height() const;        
         float* color( int x, int y ) const;
         float* depth( int x, int y ) const;
         float* position( int x, int y ) const;
+        bool occluded( float x0, float x1, float y0, float y1, float z ) const;
+        void update_maximum_depths( int x0, int x1, int y0, int y1 );
         
         void save( int mode, const char* filename ) const;
         void save_png( int mode, const char* filename, ErrorPolicy* error_policy ) const;
         void filter( float (*filter_function)(float, float, float, float), ImageBuffer* image_buffer ) const;
         void pack( int mode, ImageBuffer* image_buffer ) const;        
+        void reset( int x, int y, int horizontal_resolution, int vertical_resolution );
 };
 
 }
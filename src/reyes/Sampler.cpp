@@ -18,6 +18,7 @@
 #include <list>
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <limits.h>
 
 using namespace math;
 using namespace reyes;
@@ -71,15 +72,34 @@ void Sampler::sample( const math::mat4x4& screen_transform, const Grid& grid, bo
 
     polygons_ = 0;
 
-    const vec3* colors = !matte ? grid["Ci"].vec3_values() : NULL;
-    const vec3* opacities = !matte ? grid["Oi"].vec3_values() : NULL;
-    const vec3* positions = grid["P"].vec3_values();
+    const vec3* colors = !matte ? grid[GRID_SLOT_CI].vec3_values() : NULL;
+    const vec3* opacities = !matte ? grid[GRID_SLOT_OI].vec3_values() : NULL;
+    const vec3* positions = grid[GRID_SLOT_P].vec3_values();
     const int vertices = grid.size();
     
     calculate_raster_positions( screen_transform, positions, vertices );
     calculate_indices_origins_and_edges( grid, two_sided, left_handed );
-    calculate_bounds( sample_buffer->width(), sample_buffer->height(), polygons_ );
+    calculate_bounds( std::max(x0_, sample_buffer->x()), std::min(x1_, sample_buffer->x() + sample_buffer->width()), std::max(y0_, sample_buffer->y()), std::min(y1_, sample_buffer->y() + sample_buffer->height()), polygons_ );
     calculate_samples( colors, opacities, matte, polygons_, sample_buffer );
+
+    int x0 = INT_MAX;
+    int x1 = INT_MIN;
+    int y0 = INT_MAX;
+    int y1 = INT_MIN;
+    for ( int i = 0; i < polygons_; ++i )
+    {
+        if ( bounds_[i * 4 + 0] < bounds_[i * 4 + 1] && bounds_[i * 4 + 2] < bounds_[i * 4 + 3] )
+        {
+            x0 = std::min( x0, bounds_[i * 4 + 0] );
+            x1 = std::max( x1, bounds_[i * 4 + 1] );
+            y0 = std::min( y0, bounds_[i * 4 + 2] );
+            y1 = std::max( y1, bounds_[i * 4 + 3] );
+        }
+    }
+    if ( x0 < x1 && y0 < y1 )
+    {
+        sample_buffer->update_maximum_depths( x0, x1, y0, y1 );
+    }
 }
 
 void Sampler::calculate_raster_positions( const math::mat4x4& screen_transform, const vec3* positions, int vertices )
@@ -280,10 +300,8 @@ void Sampler::calculate_indices_origins_and_edges_right_handed( const Grid& grid
     polygons_ = index;
 }
 
-void Sampler::calculate_bounds( int width, int height, int polygons )
+void Sampler::calculate_bounds( int x0, int x1, int y0, int y1, int polygons )
 {
-    REYES_ASSERT( width >= 0 );
-    REYES_ASSERT( height >= 0 );
     REYES_ASSERT( polygons >= 0 );
     
     for ( int i = 0; i < polygons; ++i )
@@ -301,10 +319,10 @@ void Sampler::calculate_bounds( int width, int height, int polygons )
         int sy0 = int(floorf( min(p0.y, p1.y, p2.y) ));
         int sy1 = int(ceilf( max(p0.y, p1.y, p2.y) )) + 1;
 
-        bounds_[i * 4 + 0] = std::max( x0_, sx0 );
-        bounds_[i * 4 + 1] = std::min( sx1, x1_ );
-        bounds_[i * 4 + 2] = std::max( y0_, sy0 );
-        bounds_[i * 4 + 3] = std::min( sy1, y1_ );
+        bounds_[i * 4 + 0] = std::max( x0, sx0 );
+        bounds_[i * 4 + 1] = std::min( sx1, x1 );
+        bounds_[i * 4 + 2] = std::max( y0, sy0 );
+        bounds_[i * 4 + 3] = std::min( sy1, y1 );
     }
 }
 
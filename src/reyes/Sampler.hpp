@@ -49,7 +49,7 @@ private:
     void calculate_indices_origins_and_edges_two_sided( const Grid& grid );
     void calculate_indices_origins_and_edges_left_handed( const Grid& grid );
     void calculate_indices_origins_and_edges_right_handed( const Grid& grid );
-    void calculate_bounds( int width, int height, int polygons );
+    void calculate_bounds( int x0, int x1, int y0, int y1, int polygons );
     void calculate_samples( const math::vec3* colors, const math::vec3* opacities, bool matte, int polygons, SampleBuffer* sample_buffer );
     void calculate_colors_in_sample_buffer( const math::vec3* colors, const math::vec3* opacities, bool matte, int samples, SampleBuffer* sample_buffer );
 
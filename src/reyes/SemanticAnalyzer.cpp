@@ -17,6 +17,7 @@
 #include <stdio.h>
 
 using std::max;
+using std::find;
 using std::string;
 using std::vector;
 using std::shared_ptr;
@@ -65,6 +66,7 @@ void SemanticAnalyzer::analyze( SyntaxNode* node, const char* name )
     if ( node && error_policy_->errors() == 0 )
     {
         analyze_ambient_lighting( node->node(0) );
+        analyze_storage_inference( node->node(0) );
         analyze_node( node->node(0) );
 
         if ( errors_ > 0 && error_policy_ )
@@ -121,6 +123,299 @@ void SemanticAnalyzer::analyze_ambient_lighting( SyntaxNode* node )
     }
 }
 
+/**
+// Infer the storage of variables that are declared without uniform or 
+// varying.
+//
+// Inferred variables start out uniform and are made varying whenever they 
+// are assigned a varying value or are assigned under control flow that can
+// differ between vertices.  The syntax tree is analyzed repeatedly until no 
+// more variables are made varying.  Errors are suppressed while inferring 
+// storage as they are reported again by the final analysis if they remain.
+//
+// Inferring uniform storage keeps computations that only depend on uniform
+// values (shader parameters especially, which make up most of the work in
+// light shaders) running once per grid instead of once per vertex and 
+// avoids promoting their results to varying.
+//
+// @param node
+//  The shader node at the root of the syntax tree to infer storage for.
+*/
+void SemanticAnalyzer::analyze_storage_inference( SyntaxNode* node )
+{
+    REYES_ASSERT( node );
+
+    vector<shared_ptr<Symbol>> symbols;
+    find_inferred_symbols( node, &symbols );
+    for ( vector<shared_ptr<Symbol>>::const_iterator i = symbols.begin(); i != symbols.end(); ++i )
+    {
+        Symbol* symbol = i->get();
+        REYES_ASSERT( symbol );
+        symbol->set_storage( STORAGE_UNIFORM );
+    }
+
+    if ( !symbols.empty() )
+    {
+        ErrorPolicy* error_policy = error_policy_;
+        const int errors = errors_;
+        error_policy_ = NULL;
+        bool changed = true;
+        while ( changed )
+        {
+            clear_analysis( node );
+            analyze_node( node );
+            changed = analyze_varying_assignments( node, symbols, false );
+        }
+        clear_analysis( node );
+        error_policy_ = error_policy;
+        errors_ = errors;
+    }
+}
+
+void SemanticAnalyzer::find_inferred_symbols( const SyntaxNode* node, std::vector<std::shared_ptr<Symbol>>* symbols ) const
+{
+    REYES_ASSERT( node );
+    REYES_ASSERT( symbols );
+
+    if ( node->node_type() == SHADER_NODE_VARIABLE && node->symbol() && node->symbol()->storage() == STORAGE_NULL )
+    {
+        symbols->push_back( node->symbol() );
+    }
+
+    const vector<shared_ptr<SyntaxNode>>& nodes = node->nodes();
+    for ( vector<shared_ptr<SyntaxNode>>::const_iterator i = nodes.begin(); i != nodes.end(); ++i )
+    {
+        const SyntaxNode* syntax_node = i->get();
+        REYES_ASSERT( syntax_node );
+        find_inferred_symbols( syntax_node, symbols );
+    }
+}
+
+void SemanticAnalyzer::clear_analysis( SyntaxNode* node ) const
+{
+    REYES_ASSERT( node );
+
+    node->clear_analysis();
+    const vector<shared_ptr<SyntaxNode>>& nodes = node->nodes();
+    for ( vector<shared_ptr<SyntaxNode>>::const_iterator i = nodes.begin(); i != nodes.end(); ++i )
+    {
+        SyntaxNode* syntax_node = i->get();
+        REYES_ASSERT( syntax_node );
+        clear_analysis( syntax_node );
+    }
+}
+
+/**
+// Make inferred uniform variables varying if they are assigned a varying 
+// value or are assigned in a varying context.
+//
+// @param node
+//  The analyzed SyntaxNode to look for assignments in.
+//
+// @param symbols
+//  The variables whose storage is being inferred.
+//
+// @param varying
+//  True if \e node is executed under control flow that can differ between 
+//  vertices (a varying if, while, or for statement, a loop that is exited 
+//  by a varying break or continue, or the body of an illuminance, 
+//  illuminate, or solar statement).
+//
+// @return
+//  True if any variables were made varying otherwise false.
+*/
+bool SemanticAnalyzer::analyze_varying_assignments( const SyntaxNode* node, const std::vector<std::shared_ptr<Symbol>>& symbols, bool varying ) const
+{
+    REYES_ASSERT( node );
+
+    bool changed = false;
+    switch ( node->node_type() )
+    {
+        case SHADER_NODE_VARIABLE:
+        case SHADER_NODE_ASSIGN:
+        case SHADER_NODE_ADD_ASSIGN:
+        case SHADER_NODE_SUBTRACT_ASSIGN:
+        case SHADER_NODE_MULTIPLY_ASSIGN:
+        case SHADER_NODE_DIVIDE_ASSIGN:
+        {
+            Symbol* symbol = node->symbol().get();
+            const SyntaxNode* expression_node = node->node( 0 );
+            if ( 
+                symbol && 
+                symbol->storage() == STORAGE_UNIFORM && 
+                expression_node->node_type() != SHADER_NODE_NULL &&
+                (varying || varying_before_promotion(expression_node)) &&
+                find( symbols.begin(), symbols.end(), node->symbol() ) != symbols.end()
+            )
+            {
+                symbol->set_storage( STORAGE_VARYING );
+                changed = true;
+            }
+            changed |= analyze_varying_assignments( expression_node, symbols, varying );
+            break;
+        }
+
+        case SHADER_NODE_CALL:
+        {
+            // Variables passed to varying parameters may be written by the
+            // call (e.g. the Kr and Kt parameters of fresnel()) and so must 
+            // be varying themselves.
+            const Symbol* function = node->symbol().get();
+            const vector<shared_ptr<SyntaxNode>>& nodes = node->nodes();
+            for ( unsigned int i = 0; i < nodes.size(); ++i )
+            {
+                const SyntaxNode* argument_node = nodes[i].get();
+                REYES_ASSERT( argument_node );
+                Symbol* symbol = argument_node->node_type() == SHADER_NODE_IDENTIFIER ? argument_node->symbol().get() : NULL;
+                if ( 
+                    function && 
+                    i < function->parameters().size() && 
+                    function->parameters()[i].storage() == STORAGE_VARYING &&
+                    symbol && 
+                    symbol->storage() == STORAGE_UNIFORM &&
+                    find( symbols.begin(), symbols.end(), argument_node->symbol() ) != symbols.end()
+                )
+                {
+                    symbol->set_storage( STORAGE_VARYING );
+                    changed = true;
+                }
+                changed |= analyze_varying_assignments( argument_node, symbols, varying );
+            }
+            break;
+        }
+
+        case SHADER_NODE_IF:
+        case SHADER_NODE_IF_ELSE:
+        {
+            bool varying_statement = varying || varying_before_promotion( node->node(0) );
+            changed |= analyze_varying_assignments( node->node(0), symbols, varying );
+            for ( unsigned int i = 1; i < node->nodes().size(); ++i )
+            {
+                changed |= analyze_varying_assignments( node->node(i), symbols, varying_statement );
+            }
+            break;
+        }
+
+        case SHADER_NODE_WHILE:
+        {
+            bool varying_loop = varying || varying_before_promotion( node->node(0) ) || analyze_varying_exits( node->node(1), false );
+            changed |= analyze_varying_assignments( node->node(0), symbols, varying_loop );
+            changed |= analyze_varying_assignments( node->node(1), symbols, varying_loop );
+            break;
+        }
+
+        case SHADER_NODE_FOR:
+        {
+            bool varying_loop = varying || varying_before_promotion( node->node(1) ) || analyze_varying_exits( node->node(3), false );
+            changed |= analyze_varying_assignments( node->node(0), symbols, varying );
+            for ( unsigned int i = 1; i < node->nodes().size(); ++i )
+            {
+                changed |= analyze_varying_assignments( node->node(i), symbols, varying_loop );
+            }
+            break;
+        }
+
+        case SHADER_NODE_SOLAR:
+        case SHADER_NODE_ILLUMINATE:
+        case SHADER_NODE_ILLUMINANCE:
+        {
+            const vector<shared_ptr<SyntaxNode>>& nodes = node->nodes();
+            for ( unsigned int i = 0; i < nodes.size(); ++i )
+            {
+                changed |= analyze_varying_assignments( nodes[i].get(), symbols, varying || i == 1 );
+            }
+            break;
+        }
+
+        default:
+        {
+            const vector<shared_ptr<SyntaxNode>>& nodes = node->nodes();
+            for ( vector<shared_ptr<SyntaxNode>>::const_iterator i = nodes.begin(); i != nodes.end(); ++i )
+            {
+                const SyntaxNode* syntax_node = i->get();
+                REYES_ASSERT( syntax_node );
+                changed |= analyze_varying_assignments( syntax_node, symbols, varying );
+            }
+            break;
+        }
+    }
+    return changed;
+}
+
+/**
+// Does a loop body contain a break or continue statement that is executed
+// in a varying context?
+//
+// A loop exited by a varying break or continue runs a different number of 
+// iterations for different vertices and so any assignment in it is 
+// varying even if the loop's condition is uniform.
+*/
+bool SemanticAnalyzer::analyze_varying_exits( const SyntaxNode* node, bool varying ) const
+{
+    REYES_ASSERT( node );
+
+    bool varying_exits = false;
+    switch ( node->node_type() )
+    {
+        case SHADER_NODE_BREAK:
+        case SHADER_NODE_CONTINUE:
+            varying_exits = varying;
+            break;
+
+        case SHADER_NODE_IF:
+        case SHADER_NODE_IF_ELSE:
+        {
+            bool varying_statement = varying || varying_before_promotion( node->node(0) );
+            for ( unsigned int i = 1; i < node->nodes().size() && !varying_exits; ++i )
+            {
+                varying_exits = analyze_varying_exits( node->node(i), varying_statement );
+            }
+            break;
+        }
+
+        case SHADER_NODE_WHILE:
+            varying_exits = analyze_varying_exits( node->node(1), varying || varying_before_promotion(node->node(0)) );
+            break;
+
+        case SHADER_NODE_FOR:
+            varying_exits = analyze_varying_exits( node->node(3), varying || varying_before_promotion(node->node(1)) );
+            break;
+
+        case SHADER_NODE_SOLAR:
+        case SHADER_NODE_ILLUMINATE:
+        case SHADER_NODE_ILLUMINANCE:
+            varying_exits = analyze_varying_exits( node->node(1), true );
+            break;
+
+        default:
+        {
+            const vector<shared_ptr<SyntaxNode>>& nodes = node->nodes();
+            for ( vector<shared_ptr<SyntaxNode>>::const_iterator i = nodes.begin(); i != nodes.end() && !varying_exits; ++i )
+            {
+                const SyntaxNode* syntax_node = i->get();
+                REYES_ASSERT( syntax_node );
+                varying_exits = analyze_varying_exits( syntax_node, varying );
+            }
+            break;
+        }
+    }
+    return varying_exits;
+}
+
+/**
+// Is the expression at an analyzed SyntaxNode varying before any promotion?
+//
+// Expressions that failed analysis (for example calls that couldn't be 
+// matched while a variable was assumed to be uniform) have null storage and
+// are treated as varying.
+*/
+bool SemanticAnalyzer::varying_before_promotion( const SyntaxNode* node ) const
+{
+    REYES_ASSERT( node );
+    ValueStorage storage = node->original_storage() != STORAGE_NULL ? node->original_storage() : node->storage();
+    return storage == STORAGE_VARYING || storage == STORAGE_NULL;
+}
+
 void SemanticAnalyzer::analyze_node( SyntaxNode* node ) const
 {
     REYES_ASSERT( node );
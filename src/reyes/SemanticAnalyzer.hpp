@@ -5,10 +5,13 @@
 #include "ValueType.hpp"
 #include "ValueStorage.hpp"
 #include <string>
+#include <vector>
+#include <memory>
 
 namespace reyes
 {
 
+class Symbol;
 class SyntaxNode;
 class SymbolTable;
 class ErrorPolicy;
@@ -33,6 +36,12 @@ private:
     void error( bool condition, int line, const char* format, ... ) const;
 
     void analyze_ambient_lighting( SyntaxNode* node );
+    void analyze_storage_inference( SyntaxNode* node );
+    void find_inferred_symbols( const SyntaxNode* node, std::vector<std::shared_ptr<Symbol>>* symbols ) const;
+    void clear_analysis( SyntaxNode* node ) const;
+    bool analyze_varying_assignments( const SyntaxNode* node, const std::vector<std::shared_ptr<Symbol>>& symbols, bool varying ) const;
+    bool analyze_varying_exits( const SyntaxNode* node, bool varying ) const;
+    bool varying_before_promotion( const SyntaxNode* node ) const;
     void analyze_node( SyntaxNode* node ) const;
     
     void analyze_assign_expectations( SyntaxNode* node ) const;
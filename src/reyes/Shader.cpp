@@ -8,42 +8,100 @@
 #include "SyntaxNode.hpp"
 #include "ShaderParser.hpp"
 #include "SemanticAnalyzer.hpp"
+#include "Optimizer.hpp"
 #include "CodeGenerator.hpp"
 #include "Symbol.hpp"
+#include "Value.hpp"
 #include "SymbolTable.hpp"
+#include "Grid.hpp"
+#include "VirtualMachine.hpp"
+#include "NativeShader.hpp"
+#include "hash.hpp"
 #include "assert.hpp"
+#include <string.h>
 
 using std::map;
+using std::pair;
+using std::make_pair;
 using std::string;
 using std::vector;
 using std::shared_ptr;
 using namespace reyes;
 
+static void write_int( std::vector<unsigned char>* data, int value )
+{
+    const int32_t word = value;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>( &word );
+    data->insert( data->end(), bytes, bytes + sizeof(word) );
+}
+
+static void write_bytes( std::vector<unsigned char>* data, const void* bytes, size_t length )
+{
+    write_int( data, int(length) );
+    const unsigned char* begin = static_cast<const unsigned char*>( bytes );
+    data->insert( data->end(), begin, begin + length );
+}
+
+static bool read_int( const unsigned char** data, const unsigned char* end, int* value )
+{
+    int32_t word = 0;
+    if ( end - *data < int(sizeof(word)) )
+    {
+        return false;
+    }
+    memcpy( &word, *data, sizeof(word) );
+    *data += sizeof(word);
+    *value = word;
+    return true;
+}
+
+static bool read_bytes( const unsigned char** data, const unsigned char* end, const unsigned char** bytes, int* length )
+{
+    if ( !read_int(data, end, length) || *length < 0 || end - *data < *length )
+    {
+        return false;
+    }
+    *bytes = *data;
+    *data += *length;
+    return true;
+}
+
 Shader::Shader()
 : symbols_(),
   values_(),
   code_(),
+  operations_(),
   initialize_address_( 0 ),
   shade_address_( 0 ),
+  initialize_operation_( 0 ),
+  shade_operation_( 0 ),
   parameters_( 0 ),
   variables_( 0 ),
   constants_( 0 ),
   permanent_registers_( 0 ),
-  registers_( 0 )
+  registers_( 0 ),
+  global_bindings_(),
+  native_shader_( NULL )
 {
+    bind_globals();
 }
 
 Shader::Shader( const char* filename, SymbolTable& symbol_table, ErrorPolicy& error_policy )
 : symbols_(),
   values_(),
   code_(),
+  operations_(),
   initialize_address_( 0 ),
   shade_address_( 0 ),
+  initialize_operation_( 0 ),
+  shade_operation_( 0 ),
   parameters_( 0 ),
   variables_( 0 ),
   constants_( 0 ),
   permanent_registers_( 0 ),
-  registers_( 0 )
+  registers_( 0 ),
+  global_bindings_(),
+  native_shader_( NULL )
 {
     REYES_ASSERT( filename );
     
@@ -53,6 +111,9 @@ Shader::Shader( const char* filename, SymbolTable& symbol_table, ErrorPolicy& er
     SemanticAnalyzer semantic_analyzer( symbol_table, &error_policy );
     semantic_analyzer.analyze( syntax_node.get(), filename );
 
+    Optimizer optimizer( &error_policy );
+    optimizer.optimize( syntax_node.get() );
+
     CodeGenerator code_generator( symbol_table, &error_policy );
     code_generator.generate( syntax_node.get(), filename );
     
@@ -67,19 +128,27 @@ Shader::Shader( const char* filename, SymbolTable& symbol_table, ErrorPolicy& er
     constants_ = code_generator.constants();
     permanent_registers_ = code_generator.permanent_registers();
     registers_ = code_generator.registers();
+
+    bind_globals();
+    decode();
 }
 
 Shader::Shader( const char* start, const char* finish, SymbolTable& symbol_table, ErrorPolicy& error_policy )
 : symbols_(),
   values_(),
   code_(),
+  operations_(),
   initialize_address_( 0 ),
   shade_address_( 0 ),
+  initialize_operation_( 0 ),
+  shade_operation_( 0 ),
   parameters_( 0 ),
   variables_( 0 ),
   constants_( 0 ),
   permanent_registers_( 0 ),
-  registers_( 0 )
+  registers_( 0 ),
+  global_bindings_(),
+  native_shader_( NULL )
 {
     REYES_ASSERT( start );
     REYES_ASSERT( finish );
@@ -91,6 +160,9 @@ Shader::Shader( const char* start, const char* finish, SymbolTable& symbol_table
     SemanticAnalyzer semantic_analyzer( symbol_table, &error_policy );
     semantic_analyzer.analyze( syntax_node.get(), "from memory" );
 
+    Optimizer optimizer( &error_policy );
+    optimizer.optimize( syntax_node.get() );
+
     CodeGenerator code_generator( symbol_table, &error_policy );
     code_generator.generate( syntax_node.get(), "from memory" );
     
@@ -105,6 +177,9 @@ Shader::Shader( const char* start, const char* finish, SymbolTable& symbol_table
     constants_ = code_generator.constants();
     permanent_registers_ = code_generator.permanent_registers();
     registers_ = code_generator.registers();
+
+    bind_globals();
+    decode();
 }
 
 const std::vector<std::shared_ptr<Symbol> >& Shader::symbols() const
@@ -137,6 +212,26 @@ int Shader::end_address() const
     return int(code_.size());
 }
 
+const std::vector<Operation>& Shader::operations() const
+{
+    return operations_;
+}
+
+int Shader::initialize_operation() const
+{
+    return initialize_operation_;
+}
+
+int Shader::shade_operation() const
+{
+    return shade_operation_;
+}
+
+int Shader::end_operation() const
+{
+    return int(operations_.size());
+}
+
 int Shader::parameters() const
 {
     return parameters_;
@@ -162,6 +257,52 @@ int Shader::registers() const
     return registers_;
 }
 
+int Shader::global_register( int slot ) const
+{
+    REYES_ASSERT( slot >= 0 && slot < GRID_SLOT_COUNT );
+    return global_registers_[slot];
+}
+
+const std::vector<std::pair<int, int>>& Shader::global_bindings() const
+{
+    return global_bindings_;
+}
+
+/**
+// Calculate a fingerprint of this shader's byte code.
+//
+// Byte code encodes the register and constant indices that native code 
+// generated from a shader also depends on so shaders with the same 
+// fingerprint can share native code.
+//
+// @return
+//  The hash of this shader's byte code.
+*/
+uint64_t Shader::fingerprint() const
+{
+    return hash( code_.empty() ? NULL : &code_[0], code_.size() );
+}
+
+const NativeShader* Shader::native_shader() const
+{
+    return native_shader_;
+}
+
+/**
+// Execute this shader with native code instead of interpreting it.
+//
+// @param native_shader
+//  The native code generated from this shader or null to go back to 
+//  interpreting this shader (its fingerprint is assumed to match this
+//  shader's fingerprint).
+*/
+void Shader::set_native_shader( const NativeShader* native_shader )
+{
+    REYES_ASSERT( !native_shader || native_shader->fingerprint == fingerprint() );
+    REYES_ASSERT( !native_shader || (native_shader->initialize && native_shader->shade) );
+    native_shader_ = native_shader;
+}
+
 std::shared_ptr<Symbol> Shader::find_symbol( const std::string& identifier ) const
 {
     vector<shared_ptr<Symbol>>::const_iterator i = symbols_.begin();
@@ -171,3 +312,287 @@ std::shared_ptr<Symbol> Shader::find_symbol( const std::string& identifier ) con
     }
     return i != symbols_.end() ? *i : shared_ptr<Symbol>();
 }
+
+/**
+// Save this shader to be loaded again later without being compiled.
+//
+// Symbols from \e symbol_table, e.g. globals and functions, are saved as
+// references to be looked up again when this shader is loaded so they 
+// must be saved and loaded with symbol tables that have the same 
+// fingerprint (see SymbolTable::fingerprint()).
+//
+// @param symbol_table
+//  The symbol table that this shader was compiled with.
+//
+// @param data
+//  The buffer to append the saved shader to (assumed not null).
+*/
+void Shader::save( const SymbolTable& symbol_table, std::vector<unsigned char>* data ) const
+{
+    REYES_ASSERT( data );
+
+    write_int( data, initialize_address_ );
+    write_int( data, shade_address_ );
+    write_int( data, parameters_ );
+    write_int( data, variables_ );
+    write_int( data, constants_ );
+    write_int( data, permanent_registers_ );
+    write_int( data, registers_ );
+
+    write_int( data, int(symbols_.size()) );
+    for ( vector<shared_ptr<Symbol>>::const_iterator i = symbols_.begin(); i != symbols_.end(); ++i )
+    {
+        const Symbol* symbol = i->get();
+        REYES_ASSERT( symbol );
+        const float value = symbol->value();
+        write_bytes( data, symbol->identifier().c_str(), symbol->identifier().size() );
+        write_int( data, symbol_table.overload(*i) );
+        write_int( data, symbol->type() );
+        write_int( data, symbol->storage() );
+        write_int( data, symbol->elements() );
+        write_bytes( data, &value, sizeof(value) );
+        write_int( data, symbol->index() );
+        write_int( data, symbol->register_index() );
+    }
+
+    write_int( data, int(values_.size()) );
+    for ( vector<shared_ptr<Value>>::const_iterator i = values_.begin(); i != values_.end(); ++i )
+    {
+        const Value* value = i->get();
+        REYES_ASSERT( value );
+        write_int( data, value->type() );
+        write_int( data, value->storage() );
+        if ( value->type() == TYPE_STRING )
+        {
+            write_bytes( data, value->string_value().c_str(), value->string_value().size() );
+        }
+        else
+        {
+            write_int( data, int(value->size()) );
+            write_bytes( data, value->values(), value->size() * value->element_size() );
+        }
+    }
+
+    write_bytes( data, code_.empty() ? NULL : &code_[0], code_.size() );
+}
+
+/**
+// Load a shader saved by Shader::save().
+//
+// @param begin, end
+//  The range of data to load this shader from.
+//
+// @param symbol_table
+//  The symbol table to look up references to symbols in, assumed to have
+//  the same fingerprint as the symbol table passed to Shader::save().
+//
+// @return
+//  True if this shader was loaded otherwise false, in which case this 
+//  shader is left unchanged.
+*/
+bool Shader::load( const unsigned char* begin, const unsigned char* end, const SymbolTable& symbol_table )
+{
+    REYES_ASSERT( begin );
+    REYES_ASSERT( end );
+    REYES_ASSERT( begin <= end );
+
+    const unsigned char* data = begin;
+    int initialize_address = 0;
+    int shade_address = 0;
+    int parameters = 0;
+    int variables = 0;
+    int constants = 0;
+    int permanent_registers = 0;
+    int registers = 0;
+    int symbols_size = 0;
+    bool loaded = 
+        read_int( &data, end, &initialize_address ) &&
+        read_int( &data, end, &shade_address ) &&
+        read_int( &data, end, &parameters ) &&
+        read_int( &data, end, &variables ) &&
+        read_int( &data, end, &constants ) &&
+        read_int( &data, end, &permanent_registers ) &&
+        read_int( &data, end, &registers ) &&
+        read_int( &data, end, &symbols_size ) &&
+        symbols_size >= 0
+    ;
+
+    // Symbols in the symbol table are shared with every shader that uses
+    // them so their indices are only set once everything has been read.
+    vector<shared_ptr<Symbol>> symbols;
+    vector<pair<int, int>> indices;
+    for ( int i = 0; loaded && i < symbols_size; ++i )
+    {
+        const unsigned char* identifier = NULL;
+        const unsigned char* value = NULL;
+        int identifier_length = 0;
+        int value_length = 0;
+        int overload = 0;
+        int type = 0;
+        int storage = 0;
+        int elements = 0;
+        int index = 0;
+        int register_index = 0;
+        loaded = 
+            read_bytes( &data, end, &identifier, &identifier_length ) &&
+            read_int( &data, end, &overload ) &&
+            read_int( &data, end, &type ) &&
+            read_int( &data, end, &storage ) &&
+            read_int( &data, end, &elements ) &&
+            read_bytes( &data, end, &value, &value_length ) &&
+            value_length == int(sizeof(float)) &&
+            read_int( &data, end, &index ) &&
+            read_int( &data, end, &register_index )
+        ;
+        if ( loaded )
+        {
+            const string symbol_identifier( reinterpret_cast<const char*>(identifier), identifier_length );
+            shared_ptr<Symbol> symbol;
+            if ( overload >= 0 )
+            {
+                symbol = symbol_table.find_overload( symbol_identifier, overload );
+                loaded = symbol && symbol->type() == ValueType(type) && symbol->storage() == ValueStorage(storage);
+            }
+            else
+            {
+                float symbol_value = 0.0f;
+                memcpy( &symbol_value, value, sizeof(symbol_value) );
+                symbol.reset( new Symbol(symbol_identifier) );
+                symbol->set_type( ValueType(type) );
+                symbol->set_storage( ValueStorage(storage) );
+                symbol->set_elements( elements );
+                symbol->set_value( symbol_value );
+            }
+            symbols.push_back( symbol );
+            indices.push_back( make_pair(index, register_index) );
+        }
+    }
+
+    int values_size = 0;
+    loaded = loaded && read_int( &data, end, &values_size ) && values_size >= 0;
+    vector<shared_ptr<Value>> values;
+    for ( int i = 0; loaded && i < values_size; ++i )
+    {
+        int type = 0;
+        int storage = 0;
+        loaded = read_int( &data, end, &type ) && read_int( &data, end, &storage );
+        if ( loaded && type == TYPE_STRING )
+        {
+            const unsigned char* string_value = NULL;
+            int length = 0;
+            loaded = read_bytes( &data, end, &string_value, &length );
+            if ( loaded )
+            {
+                shared_ptr<Value> value( new Value() );
+                value->set_string( string(reinterpret_cast<const char*>(string_value), length) );
+                values.push_back( value );
+            }
+        }
+        else if ( loaded )
+        {
+            const unsigned char* bytes = NULL;
+            int size = 0;
+            int length = 0;
+            loaded = read_int( &data, end, &size ) && size >= 0 && read_bytes( &data, end, &bytes, &length );
+            if ( loaded )
+            {
+                shared_ptr<Value> value( new Value(ValueType(type), ValueStorage(storage), size) );
+                loaded = length == int(size * value->element_size());
+                if ( loaded && length > 0 )
+                {
+                    memcpy( value->values(), bytes, length );
+                }
+                values.push_back( value );
+            }
+        }
+    }
+
+    const unsigned char* code = NULL;
+    int code_length = 0;
+    loaded = loaded && read_bytes( &data, end, &code, &code_length ) && data == end;
+    if ( !loaded )
+    {
+        return false;
+    }
+
+    for ( int i = 0; i < int(symbols.size()); ++i )
+    {
+        symbols[i]->set_index( indices[i].first );
+        symbols[i]->set_register_index( indices[i].second );
+    }
+
+    symbols_.swap( symbols );
+    values_.swap( values );
+    code_.assign( code, code + code_length );
+    initialize_address_ = initialize_address;
+    shade_address_ = shade_address;
+    parameters_ = parameters;
+    variables_ = variables;
+    constants_ = constants;
+    permanent_registers_ = permanent_registers;
+    registers_ = registers;
+    native_shader_ = NULL;
+    bind_globals();
+    decode();
+    return true;
+}
+
+void Shader::bind_globals()
+{
+    for ( int slot = 0; slot < GRID_SLOT_COUNT; ++slot )
+    {
+        global_registers_[slot] = -1;
+    }
+
+    // Iterate in reverse so that the first symbol matching a global's 
+    // identifier wins just as it does in Shader::find_symbol().
+    for ( vector<shared_ptr<Symbol>>::const_reverse_iterator i = symbols_.rbegin(); i != symbols_.rend(); ++i )
+    {
+        const Symbol* symbol = i->get();
+        REYES_ASSERT( symbol );
+        int slot = Grid::global_slot( symbol->identifier() );
+        if ( slot >= 0 )
+        {
+            global_registers_[slot] = symbol->register_index();
+        }
+    }
+
+    // The globals are always stored in the same slots in every Grid so the 
+    // bindings from slots to registers only need to be built once per 
+    // shader and can then be reused for every grid that it shades.
+    global_bindings_.clear();
+    for ( int slot = 0; slot < GRID_SLOT_COUNT; ++slot )
+    {
+        if ( global_registers_[slot] >= 0 )
+        {
+            global_bindings_.push_back( std::make_pair(slot, global_registers_[slot]) );
+        }
+    }
+}
+
+void Shader::decode()
+{
+    VirtualMachine::decode( *this, &operations_ );
+    initialize_operation_ = operation_index( initialize_address_ );
+    shade_operation_ = operation_index( shade_address_ );
+}
+
+/**
+// Find the operation decoded from the instruction at or after an address.
+//
+// @param address
+//  The address in the byte code to find the operation for.
+//
+// @return
+//  The index of the first operation decoded from an instruction at or after
+//  \e address or the number of operations if there is no such operation.
+*/
+int Shader::operation_index( int address ) const
+{
+    int index = 0;
+    while ( index < int(operations_.size()) && operations_[index].address < address )
+    {
+        ++index;
+    }
+    return index;
+}
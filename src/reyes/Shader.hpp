@@ -1,10 +1,14 @@
 #ifndef REYES_SHADER_HPP_INCLUDED
 #define REYES_SHADER_HPP_INCLUDED
 
+#include "GridSlot.hpp"
+#include <reyes/reyes_virtual_machine/Operation.hpp>
 #include <memory>
 #include <string>
 #include <vector>
 #include <map>
+#include <utility>
+#include <stdint.h>
 
 namespace reyes
 {
@@ -16,6 +20,7 @@ class Grid;
 class SymbolTable;
 class Renderer;
 class ErrorPolicy;
+struct NativeShader;
 
 /**
 // A displacement, surface, or light shader.
@@ -25,13 +30,19 @@ class Shader
     std::vector<std::shared_ptr<Symbol>> symbols_; ///< The symbols that are used in the shader.
     std::vector<std::shared_ptr<Value>> values_; ///< The values of any constants used in the shader (including default parameter values).
     std::vector<unsigned char> code_; ///< The byte code generated for the shader.
+    std::vector<Operation> operations_; ///< The operations decoded from the byte code for execution.
     int initialize_address_; ///< The index of the start of the initialize code fragment.
     int shade_address_; ///< The index of the start of the shade code fragment.
+    int initialize_operation_; ///< The index of the first operation of the initialize code fragment.
+    int shade_operation_; ///< The index of the first operation of the shade code fragment.
     int parameters_; ///< The number of parameters to the shader.
     int variables_; ///< The number of variables in the shader.
     int constants_; ///< The number of constants in the shader.
     int permanent_registers_; ///< The number of registers used by constant and uniform values in this shader.
     int registers_; ///< The maximum number of registers that are used by this shader (variables and temporaries).
+    int global_registers_ [GRID_SLOT_COUNT]; ///< The register index of each standard global used by this shader or -1 if it isn't used (indexed by GridSlot).
+    std::vector<std::pair<int, int>> global_bindings_; ///< The slot and register index of each standard global used by this shader.
+    const NativeShader* native_shader_; ///< The native code that executes this shader or null to interpret its operations.
 
 public:
     Shader();
@@ -44,13 +55,30 @@ public:
     int initialize_address() const;
     int shade_address() const;
     int end_address() const;
+    const std::vector<Operation>& operations() const;
+    int initialize_operation() const;
+    int shade_operation() const;
+    int end_operation() const;
     int parameters() const;
     int variables() const;
     int constants() const;
     int permanent_registers() const;
     int registers() const;
+    int global_register( int slot ) const;
+    const std::vector<std::pair<int, int>>& global_bindings() const;
+    uint64_t fingerprint() const;
+    const NativeShader* native_shader() const;
+    void set_native_shader( const NativeShader* native_shader );
 
     std::shared_ptr<Symbol> find_symbol( const std::string& identitifer ) const;
+
+    void save( const SymbolTable& symbol_table, std::vector<unsigned char>* data ) const;
+    bool load( const unsigned char* begin, const unsigned char* end, const SymbolTable& symbol_table );
+
+private:
+    void bind_globals();
+    void decode();
+    int operation_index( int address ) const;
 };
 
 }
@@ -0,0 +1,216 @@
+//
+// ShaderCache.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "stdafx.hpp"
+#include "ShaderCache.hpp"
+#include "Shader.hpp"
+#include "SymbolTable.hpp"
+#include "ErrorPolicy.hpp"
+#include "hash.hpp"
+#include "file.hpp"
+#include "assert.hpp"
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <stdio.h>
+#include <string.h>
+
+using std::string;
+using std::vector;
+using namespace reyes;
+
+/**
+// Constructor.
+//
+// @param directory
+//  The directory to cache compiled shaders in (assumed not null and to 
+//  exist).
+*/
+ShaderCache::ShaderCache( const char* directory )
+: directory_( directory ? directory : "" )
+{
+    REYES_ASSERT( directory );
+}
+
+/**
+// Load a shader from this cache or compile and cache it.
+//
+// @param filename
+//  The filename of the shader's source (assumed not null).
+//
+// @param symbol_table
+//  The symbol table to compile the shader with.
+//
+// @param error_policy
+//  The error policy to report errors compiling the shader to, shaders that
+//  fail to compile aren't cached.
+//
+// @return
+//  The shader, always a new shader to be owned by the caller.
+*/
+Shader* ShaderCache::shader( const char* filename, SymbolTable& symbol_table, ErrorPolicy& error_policy ) const
+{
+    REYES_ASSERT( filename );
+
+    // A missing or unreadable source is left for the compiler to report.
+    uint64_t key = 0;
+    if ( !this->key(filename, symbol_table, &key) )
+    {
+        return new Shader( filename, symbol_table, error_policy );
+    }
+
+    const uint64_t symbols = symbol_table.fingerprint();
+    const string path = this->path( key );
+    Shader* shader = load( path, key, symbols, symbol_table );
+    if ( !shader )
+    {
+        const int errors = error_policy.total_errors();
+        shader = new Shader( filename, symbol_table, error_policy );
+        if ( error_policy.total_errors() == errors )
+        {
+            save( path, key, symbols, symbol_table, *shader );
+        }
+    }
+    return shader;
+}
+
+/**
+// Get the path of the file that a shader is cached in.
+//
+// @param filename
+//  The filename of the shader's source (assumed not null).
+//
+// @param symbol_table
+//  The symbol table that the shader is compiled with.
+//
+// @return
+//  The path of the cached file or an empty string if the shader's source 
+//  can't be read.
+*/
+std::string ShaderCache::path( const char* filename, const SymbolTable& symbol_table ) const
+{
+    uint64_t key = 0;
+    return this->key( filename, symbol_table, &key ) ? path( key ) : string();
+}
+
+/**
+// Calculate the key that a shader is cached with from the cache version, 
+// the fingerprint of the symbol table, and the shader's source.
+*/
+bool ShaderCache::key( const char* filename, const SymbolTable& symbol_table, uint64_t* key ) const
+{
+    REYES_ASSERT( filename );
+    REYES_ASSERT( key );
+
+    vector<unsigned char> source;
+    if ( directory_.empty() || !read_file(filename, &source) )
+    {
+        return false;
+    }
+
+    const uint64_t symbols = symbol_table.fingerprint();
+    *key = hash( &SHADER_CACHE_VERSION, sizeof(SHADER_CACHE_VERSION) );
+    *key = hash( &symbols, sizeof(symbols), *key );
+    *key = hash( source.empty() ? NULL : &source[0], source.size(), *key );
+    return true;
+}
+
+/**
+// Get the path of the file that a shader with \e key is cached in.
+*/
+std::string ShaderCache::path( uint64_t key ) const
+{
+    REYES_ASSERT( !directory_.empty() );
+    char name [32];
+    snprintf( name, sizeof(name), "%08x%08x.rslc", (unsigned int) (key >> 32), (unsigned int) (key & 0xffffffff) );
+    const char last = directory_[directory_.size() - 1];
+    return last == '/' || last == '\\' ? directory_ + name : directory_ + "/" + name;
+}
+
+Shader* ShaderCache::load( const std::string& path, uint64_t key, uint64_t symbols, const SymbolTable& symbol_table ) const
+{
+    vector<unsigned char> data;
+    if ( !read_file(path.c_str(), &data) || data.size() < sizeof(ShaderCacheHeader) )
+    {
+        return NULL;
+    }
+
+    ShaderCacheHeader header;
+    memcpy( &header, &data[0], sizeof(header) );
+    const unsigned char* begin = &data[0] + sizeof(header);
+    const unsigned char* end = &data[0] + data.size();
+    bool matches = 
+        header.magic == SHADER_CACHE_MAGIC &&
+        header.version == SHADER_CACHE_VERSION &&
+        header.key == key &&
+        header.symbols == symbols &&
+        header.length == uint64_t(end - begin) &&
+        header.checksum == hash( begin, end - begin )
+    ;
+    if ( !matches )
+    {
+        return NULL;
+    }
+
+    Shader* shader = new Shader();
+    if ( !shader->load(begin, end, symbol_table) )
+    {
+        delete shader;
+        shader = NULL;
+    }
+    return shader;
+}
+
+void ShaderCache::save( const std::string& path, uint64_t key, uint64_t symbols, const SymbolTable& symbol_table, const Shader& shader ) const
+{
+    vector<unsigned char> data( sizeof(ShaderCacheHeader) );
+    shader.save( symbol_table, &data );
+
+    ShaderCacheHeader header;
+    memset( &header, 0, sizeof(header) );
+    header.magic = SHADER_CACHE_MAGIC;
+    header.version = SHADER_CACHE_VERSION;
+    header.key = key;
+    header.symbols = symbols;
+    header.length = data.size() - sizeof(header);
+    header.checksum = hash( &data[0] + sizeof(header), data.size() - sizeof(header) );
+    memcpy( &data[0], &header, sizeof(header) );
+
+    // Write to a file unique to this thread and moment and rename it into 
+    // place, replacing a rejected file where renaming doesn't (on Windows).
+    // A failure only means the shader is compiled again next time.
+    const size_t unique = std::hash<std::thread::id>()( std::this_thread::get_id() ) ^ size_t( std::chrono::steady_clock::now().time_since_epoch().count() );
+    char suffix [32];
+    snprintf( suffix, sizeof(suffix), ".%08x.tmp", (unsigned int) unique );
+    const string temporary_path = path + suffix;
+    if ( write_file(temporary_path, data) )
+    {
+        if ( rename(temporary_path.c_str(), path.c_str()) != 0 )
+        {
+            remove( path.c_str() );
+            if ( rename(temporary_path.c_str(), path.c_str()) != 0 )
+            {
+                remove( temporary_path.c_str() );
+            }
+        }
+    }
+}
+
+bool ShaderCache::write_file( const std::string& filename, const std::vector<unsigned char>& data )
+{
+    FILE* file = fopen( filename.c_str(), "wb" );
+    if ( !file )
+    {
+        return false;
+    }
+
+    bool written = data.empty() || fwrite( &data[0], 1, data.size(), file ) == data.size();
+    written = fclose( file ) == 0 && written;
+    if ( !written )
+    {
+        remove( filename.c_str() );
+    }
+    return written;
+}
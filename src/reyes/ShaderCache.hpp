@@ -0,0 +1,70 @@
+#ifndef REYES_SHADERCACHE_HPP_INCLUDED
+#define REYES_SHADERCACHE_HPP_INCLUDED
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+namespace reyes
+{
+
+class Shader;
+class SymbolTable;
+class ErrorPolicy;
+
+/**
+// The version of the cached file format and of the byte code that it 
+// contains, increment whenever either changes so that files cached by 
+// older builds are ignored.
+*/
+static const uint32_t SHADER_CACHE_VERSION = 1;
+
+/**
+// Identifies cached shaders ("RSLC" when read as bytes on little endian 
+// machines, files from machines of the other endianness don't match).
+*/
+static const uint32_t SHADER_CACHE_MAGIC = 0x434c5352;
+
+/**
+// The header written at the start of each cached shader.
+*/
+struct ShaderCacheHeader
+{
+    uint32_t magic; ///< Always SHADER_CACHE_MAGIC.
+    uint32_t version; ///< Always SHADER_CACHE_VERSION.
+    uint64_t key; ///< The hash of the source and symbol table fingerprint that the shader was compiled from.
+    uint64_t symbols; ///< The fingerprint of the symbol table that the shader was compiled with.
+    uint64_t length; ///< The length of the saved shader that follows this header (in bytes).
+    uint64_t checksum; ///< The hash of the saved shader that follows this header.
+};
+
+/**
+// A directory of compiled shaders that persists between renders.
+//
+// Each shader is cached in a file named for a hash of its source and the 
+// fingerprint of the symbol table that it is compiled with so editing a 
+// shader or changing the symbols available to shaders misses the cache
+// rather than loading stale code.  Cached files are written to a temporary
+// file that is then renamed so that renders sharing a directory never see
+// partially written files.
+*/
+class ShaderCache
+{
+    std::string directory_; ///< The directory that compiled shaders are cached in.
+
+public:
+    ShaderCache( const char* directory );
+    Shader* shader( const char* filename, SymbolTable& symbol_table, ErrorPolicy& error_policy ) const;
+    std::string path( const char* filename, const SymbolTable& symbol_table ) const;
+
+private:
+    bool key( const char* filename, const SymbolTable& symbol_table, uint64_t* key ) const;
+    std::string path( uint64_t key ) const;
+    Shader* load( const std::string& path, uint64_t key, uint64_t symbols, const SymbolTable& symbol_table ) const;
+    void save( const std::string& path, uint64_t key, uint64_t symbols, const SymbolTable& symbol_table, const Shader& shader ) const;
+    static bool write_file( const std::string& filename, const std::vector<unsigned char>& data );
+};
+
+}
+
+#endif
@@ -12,9 +12,8 @@
 #include "ErrorPolicy.hpp"
 #include <lalr/Parser.hpp>
 #include <lalr/PositionIterator.hpp>
+#include "file.hpp"
 #include "assert.hpp"
-#include <fstream>
-#include <iterator>
 #include <functional>
 #include <map>
 #include <string>
@@ -23,7 +22,6 @@ using std::map;
 using std::find;
 using std::string;
 using std::vector;
-using std::istream_iterator;
 using std::bind;
 using std::shared_ptr;
 using namespace std::placeholders;
@@ -405,7 +403,10 @@ public:
 
     shared_ptr<SyntaxNode> variable_definition_( const shared_ptr<SyntaxNode>* start, const lalr::ParserNode<>* /*nodes*/, size_t length )
     {
-        ValueStorage storage = storage_from_syntax_node( start[1], STORAGE_VARYING );
+        // Variables declared without uniform or varying are left with null
+        // storage so that the SemanticAnalyzer can infer their storage from
+        // the way that they are assigned.
+        ValueStorage storage = storage_from_syntax_node( start[1], STORAGE_NULL );
         ValueType type = type_from_syntax_node( start[2] );
         
         const vector<shared_ptr<SyntaxNode> >& nodes = start[3]->nodes();
@@ -1260,13 +1261,12 @@ shared_ptr<SyntaxNode> ShaderParser::parse( const char* filename )
     REYES_ASSERT( filename );
 
     shared_ptr<SyntaxNode> syntax_node;    
-    std::ifstream stream( filename, std::ios::binary );
-    if ( stream.is_open() )
+    vector<unsigned char> source;
+    if ( read_file(filename, &source) )
     {
-        stream.unsetf( std::iostream::skipws );
-        stream.exceptions( std::iostream::badbit );        
-        ShaderParserContext<istream_iterator<char>> shader_parser_context( symbol_table_, error_policy_ );
-        syntax_node = shader_parser_context.parse( istream_iterator<char>(stream), istream_iterator<char>(), filename );
+        const char* start = source.empty() ? "" : reinterpret_cast<const char*>( &source[0] );
+        ShaderParserContext<const char*> shader_parser_context( symbol_table_, error_policy_ );
+        syntax_node = shader_parser_context.parse( start, start + source.size(), filename );
     }
     else if ( error_policy_ )
     {
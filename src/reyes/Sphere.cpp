@@ -18,14 +18,12 @@
 
 using std::min;
 using std::max;
-using std::list;
 using std::vector;
-using std::shared_ptr;
 using namespace math;
 using namespace reyes;
 
 Sphere::Sphere( float radius )
-: Geometry(vec2(0.0f, 1.0f), vec2(0.0f, 1.0f)),
+: Geometry(),
   radius_( radius ),
   zmin_( -FLT_MAX ),
   zmax_( FLT_MAX ),
@@ -34,7 +32,7 @@ Sphere::Sphere( float radius )
 }
 
 Sphere::Sphere( float radius, float zmin, float zmax, float thetamax )
-: Geometry(vec2(0.0f, 1.0f), vec2(0.0f, 1.0f)),
+: Geometry(),
   radius_( radius ),
   zmin_( zmin ),
   zmax_( zmax ),
@@ -42,21 +40,12 @@ Sphere::Sphere( float radius, float zmin, float zmax, float thetamax )
 {   
 }
 
-Sphere::Sphere( const Sphere& sphere, const math::vec2& u_range, const math::vec2& v_range )
-: Geometry(u_range, v_range),
-  radius_( sphere.radius_ ),
-  zmin_( sphere.zmin_ ),
-  zmax_( sphere.zmax_ ),
-  thetamax_( sphere.thetamax_ )
-{   
-}
-
 bool Sphere::boundable() const
 {
     return true;
 }
 
-void Sphere::bound( const math::mat4x4& transform, vec3* minimum, vec3* maximum ) const
+void Sphere::bound( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, vec3* minimum, vec3* maximum ) const
 {
     REYES_ASSERT( minimum );
     REYES_ASSERT( maximum );
@@ -64,19 +53,23 @@ void Sphere::bound( const math::mat4x4& transform, vec3* minimum, vec3* maximum
     *minimum = vec3( FLT_MAX, FLT_MAX, FLT_MAX );
     *maximum = vec3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
     
-    Grid grid;
-    dice( transform, 8, 8, &grid );
-    const vec3* positions = grid["P"].vec3_values();
-    const vec3* positions_end = positions + grid["P"].size();
-    for ( const vec3* i = positions; i != positions_end; ++i )
-    {
-        minimum->x = min( minimum->x, i->x );
-        minimum->y = min( minimum->y, i->y );
-        minimum->z = min( minimum->z, i->z );        
-        maximum->x = max( maximum->x, i->x );
-        maximum->y = max( maximum->y, i->y );
-        maximum->z = max( maximum->z, i->z );
-    }
+    // The extents of cos(phi) and sin(phi) over the range in v give the 
+    // range of distances from the z axis and heights covered which are then
+    // swept around the z axis.
+    const float PI = float(M_PI);    
+    const float phimin = zmin_ > -radius_ ? asinf( zmin_ / radius_ ) : -PI / 2.0f;
+    const float phimax = zmax_ < radius_ ? asinf( zmax_ / radius_ ) : PI / 2.0f;
+    vec3 phi_minimum = vec3( FLT_MAX, FLT_MAX, 0.0f );
+    vec3 phi_maximum = vec3( -FLT_MAX, -FLT_MAX, 0.0f );
+    bound_arc( radius_, phimin + v_range.x * (phimax - phimin), phimin + v_range.y * (phimax - phimin), &phi_minimum, &phi_maximum );
+
+    const float theta0 = u_range.x * thetamax_;
+    const float theta1 = u_range.y * thetamax_;
+    bound_arc( phi_minimum.x, theta0, theta1, minimum, maximum );
+    bound_arc( phi_maximum.x, theta0, theta1, minimum, maximum );
+    minimum->z = phi_minimum.y;
+    maximum->z = phi_maximum.y;
+    transform_bound( transform, minimum, maximum );
 }
 
 bool Sphere::splittable() const
@@ -84,54 +77,26 @@ bool Sphere::splittable() const
     return true;
 }
 
-void Sphere::split( std::list<std::shared_ptr<Geometry>>* primitives ) const
-{
-    REYES_ASSERT( primitives );
-    REYES_ASSERT( u_range().y >= u_range().x );
-    REYES_ASSERT( v_range().y >= v_range().x );
-
-    const vec2& u_range = Geometry::u_range();
-    float u0 = u_range.x;
-    float u1 = (u_range.x + u_range.y) / 2.0f;
-    float u2 = u_range.y;
-
-    const vec2& v_range = Geometry::v_range();
-    float v0 = v_range.x;
-    float v1 = (v_range.x + v_range.y) / 2.0f;
-    float v2 = v_range.y;
-
-    shared_ptr<Geometry> sphere;
-    sphere.reset( new Sphere(*this, vec2(u0, u1), vec2(v0, v1)) );
-    primitives->push_back( sphere );
-    sphere.reset( new Sphere(*this, vec2(u0, u1), vec2(v1, v2)) );
-    primitives->push_back( sphere );
-    sphere.reset( new Sphere(*this, vec2(u1, u2), vec2(v0, v1)) );
-    primitives->push_back( sphere );
-    sphere.reset( new Sphere(*this, vec2(u1, u2), vec2(v1, v2)) );
-    primitives->push_back( sphere );
-}
-
 bool Sphere::diceable() const
 {
     return true;
 }
 
-void Sphere::dice( const math::mat4x4& transform, int width, int height, Grid* grid ) const
+void Sphere::dice( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, int width, int height, Grid* grid ) const
 {
     REYES_ASSERT( width > 0 );
     REYES_ASSERT( height > 0 );
     REYES_ASSERT( grid );
     
-    const vec2& u_range = Geometry::u_range();
-    const vec2& v_range = Geometry::v_range();
-
     grid->resize( width, height );
     grid->du_ = (u_range.y - u_range.x) / float(width - 1);
     grid->dv_ = (v_range.y - v_range.x) / float(height - 1);
     
-    vec3* positions = grid->value( "P", TYPE_POINT ).vec3_values();
-    float* s = grid->value( "s", TYPE_FLOAT ).float_values();
-    float* t = grid->value( "t", TYPE_FLOAT ).float_values();
+    vec3* positions = grid->value( GRID_SLOT_P, TYPE_POINT ).vec3_values();
+    vec3* u_derivatives = grid->value( GRID_SLOT_DPDU, TYPE_VECTOR ).vec3_values();
+    vec3* v_derivatives = grid->value( GRID_SLOT_DPDV, TYPE_VECTOR ).vec3_values();
+    float* s = grid->value( GRID_SLOT_S, TYPE_FLOAT ).float_values();
+    float* t = grid->value( GRID_SLOT_T, TYPE_FLOAT ).float_values();
     
     int vertex = 0;
     float v = v_range.x;
@@ -142,7 +107,13 @@ void Sphere::dice( const math::mat4x4& transform, int width, int height, Grid* g
         float du = (u_range.y - u_range.x) / float(width - 1);
         for ( int i = 0; i < width; ++i )
         {
-            positions[vertex] = vec3( transform * vec4(position(u, v), 1.0f) );
+            vec3 position;
+            vec3 dpdu;
+            vec3 dpdv;
+            evaluate( u, v, &position, &dpdu, &dpdv );
+            positions[vertex] = vec3( transform * vec4(position, 1.0f) );
+            u_derivatives[vertex] = vec3( transform * vec4(dpdu, 0.0f) );
+            v_derivatives[vertex] = vec3( transform * vec4(dpdv, 0.0f) );
             s[vertex] = u;
             t[vertex] = v;
             u = min( u + du, u_range.y );
@@ -152,17 +123,21 @@ void Sphere::dice( const math::mat4x4& transform, int width, int height, Grid* g
     }    
 }
 
-math::vec3 Sphere::position( float u, float v ) const
-{
-    return radius_ * normal( u, v );
-}
-
-math::vec3 Sphere::normal( float u, float v ) const
+void Sphere::evaluate( float u, float v, math::vec3* position, math::vec3* dpdu, math::vec3* dpdv ) const
 {
+    REYES_ASSERT( position );
+    REYES_ASSERT( dpdu );
+    REYES_ASSERT( dpdv );
     const float PI = float(M_PI);    
     float phimin = zmin_ > -radius_ ? asinf( zmin_ / radius_ ) : -PI / 2.0f;
     float phimax = zmax_ < radius_ ? asinf( zmax_ / radius_ ) : PI / 2.0f;
     float phi = phimin + v * (phimax - phimin);
+    float cos_phi = cosf( phi );
+    float sin_phi = sinf( phi );
     float theta = u * thetamax_;
-    return vec3( cosf(theta) * cosf(phi), sinf(theta) * cosf(phi), sinf(phi) );
+    float cos_theta = cosf( theta );
+    float sin_theta = sinf( theta );
+    *position = radius_ * vec3( cos_theta * cos_phi, sin_theta * cos_phi, sin_phi );
+    *dpdu = (radius_ * thetamax_) * vec3( -sin_theta * cos_phi, cos_theta * cos_phi, 0.0f );
+    *dpdv = (radius_ * (phimax - phimin)) * vec3( -cos_theta * sin_phi, -sin_theta * sin_phi, cos_phi );
 }
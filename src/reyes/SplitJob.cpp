@@ -0,0 +1,55 @@
+//
+// SplitJob.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "stdafx.hpp"
+#include "SplitJob.hpp"
+#include "Primitive.hpp"
+#include <math/vec2.ipp>
+#include "assert.hpp"
+
+using namespace math;
+using namespace reyes;
+
+SplitJob::SplitJob()
+: primitive_( NULL ),
+  u_range_( 0.0f, 0.0f ),
+  v_range_( 0.0f, 0.0f ),
+  worker_( NULL )
+{
+}
+
+SplitJob::SplitJob( const Primitive* primitive, const math::vec2& u_range, const math::vec2& v_range, Worker* worker )
+: primitive_( primitive ),
+  u_range_( u_range ),
+  v_range_( v_range ),
+  worker_( worker )
+{
+    REYES_ASSERT( primitive_ );
+    REYES_ASSERT( worker_ );
+}
+
+SplitJob::~SplitJob()
+{
+}
+
+const Primitive* SplitJob::primitive() const
+{
+    return primitive_;
+}
+
+const math::vec2& SplitJob::u_range() const
+{
+    return u_range_;
+}
+
+const math::vec2& SplitJob::v_range() const
+{
+    return v_range_;
+}
+
+Worker* SplitJob::worker() const
+{
+    return worker_;
+}
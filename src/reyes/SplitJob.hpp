@@ -0,0 +1,43 @@
+#ifndef REYES_SPLITJOB_HPP_INCLUDED
+#define REYES_SPLITJOB_HPP_INCLUDED
+
+#include <math/vec2.hpp>
+
+namespace reyes
+{
+
+class Primitive;
+class Worker;
+
+/**
+// A piece of a primitive waiting to be split or diced, shaded, and sampled
+// into the sample buffer of the worker rendering the bucket that it belongs
+// to.
+//
+// Split jobs refer to the primitive that they are a piece of and the range 
+// in u and v that they cover so that they can be copied and pushed onto 
+// work-stealing deques without allocating or touching reference counts.  
+// The primitive is retained by the bucket, or by the caller when rendering
+// immediately, until all of its split jobs have completed.
+*/
+class SplitJob
+{
+    const Primitive* primitive_; ///< The primitive that the geometry to split or dice is a piece of.
+    math::vec2 u_range_; ///< The range in u covered by the piece of geometry.
+    math::vec2 v_range_; ///< The range in v covered by the piece of geometry.
+    Worker* worker_; ///< The worker whose sample buffer the geometry is sampled into.
+
+public:
+    SplitJob();
+    SplitJob( const Primitive* primitive, const math::vec2& u_range, const math::vec2& v_range, Worker* worker );
+    ~SplitJob();
+
+    const Primitive* primitive() const;
+    const math::vec2& u_range() const;
+    const math::vec2& v_range() const;
+    Worker* worker() const;
+};
+
+}
+
+#endif
@@ -7,6 +7,8 @@
 #include "SymbolTable.hpp"
 #include "Symbol.hpp"
 #include "SyntaxNode.hpp"
+#include "SymbolParameter.hpp"
+#include "hash.hpp"
 #include <reyes/reyes_virtual_machine/mathematical_functions.hpp>
 #include <reyes/reyes_virtual_machine/geometric_functions.hpp>
 #include <reyes/reyes_virtual_machine/color_functions.hpp>
@@ -390,6 +392,108 @@ std::shared_ptr<Symbol> SymbolTable::find_symbol( const SyntaxNode* node ) const
     return i != symbols_.rend() && j != i->end() && j->first == node->lexeme() ? j->second : shared_ptr<Symbol>();
 }
 
+/**
+// Find a symbol by its identifier and overload.
+//
+// @param identifier
+//  The identifier of the symbol to find.
+//
+// @param overload
+//  The index of the symbol among the symbols with the same identifier, as
+//  returned by SymbolTable::overload().
+//
+// @return
+//  The symbol or null if there is no such symbol.
+*/
+std::shared_ptr<Symbol> SymbolTable::find_overload( const std::string& identifier, int overload ) const
+{
+    for ( list<multimap<string, shared_ptr<Symbol>>>::const_iterator i = symbols_.begin(); i != symbols_.end(); ++i )
+    {
+        multimap<string, shared_ptr<Symbol>>::const_iterator j = i->lower_bound( identifier );
+        while ( j != i->end() && j->first == identifier )
+        {
+            if ( overload == 0 )
+            {
+                return j->second;
+            }
+            --overload;
+            ++j;
+        }
+    }
+    return shared_ptr<Symbol>();
+}
+
+/**
+// Get the index of a symbol among the symbols in this table that share its
+// identifier.
+//
+// @param symbol
+//  The symbol to get the overload of (assumed not null).
+//
+// @return
+//  The overload of \e symbol or -1 if \e symbol isn't in this table.
+*/
+int SymbolTable::overload( const std::shared_ptr<Symbol>& symbol ) const
+{
+    REYES_ASSERT( symbol );
+
+    int overload = 0;
+    for ( list<multimap<string, shared_ptr<Symbol>>>::const_iterator i = symbols_.begin(); i != symbols_.end(); ++i )
+    {
+        multimap<string, shared_ptr<Symbol>>::const_iterator j = i->lower_bound( symbol->identifier() );
+        while ( j != i->end() && j->first == symbol->identifier() )
+        {
+            if ( j->second == symbol )
+            {
+                return overload;
+            }
+            ++overload;
+            ++j;
+        }
+    }
+    return -1;
+}
+
+/**
+// Calculate a fingerprint of the symbols in this table.
+//
+// The fingerprint covers everything that affects the code generated for a
+// shader (identifiers, types, storage, values, and parameters) and so acts
+// as a version of this table.  Function addresses change between runs and 
+// aren't included.
+//
+// @return
+//  The 64 bit FNV-1a hash of the symbols in this table.
+*/
+uint64_t SymbolTable::fingerprint() const
+{
+    uint64_t value = HASH_SEED;
+    for ( list<multimap<string, shared_ptr<Symbol>>>::const_iterator i = symbols_.begin(); i != symbols_.end(); ++i )
+    {
+        for ( multimap<string, shared_ptr<Symbol>>::const_iterator j = i->begin(); j != i->end(); ++j )
+        {
+            const Symbol* symbol = j->second.get();
+            REYES_ASSERT( symbol );
+            const float symbol_value = symbol->value();
+            value = hash( symbol->identifier().c_str(), symbol->identifier().size() + 1, value );
+            value = hash( symbol->type(), value );
+            value = hash( symbol->storage(), value );
+            value = hash( symbol->elements(), value );
+            value = hash( &symbol_value, sizeof(symbol_value), value );
+            value = hash( symbol->function() != NULL, value );
+            const vector<SymbolParameter>& parameters = symbol->parameters();
+            value = hash( int(parameters.size()), value );
+            for ( vector<SymbolParameter>::const_iterator k = parameters.begin(); k != parameters.end(); ++k )
+            {
+                value = hash( k->type(), value );
+                value = hash( k->storage(), value );
+            }
+        }
+        value = hash( -1, value );
+    }
+    return value;
+}
+
 bool SymbolTable::matches( const std::shared_ptr<Symbol>& symbol, const SyntaxNode* node, const std::vector<std::shared_ptr<SyntaxNode>>& node_parameters )
 {
     REYES_ASSERT( symbol );
@@ -6,6 +6,7 @@
 #include <map>
 #include <string>
 #include <memory>
+#include <stdint.h>
 
 namespace reyes
 {
@@ -30,6 +31,9 @@ public:
     std::shared_ptr<Symbol> add_symbol( const std::string& identifier );
     std::shared_ptr<Symbol> find_symbol( const std::string& identifier ) const;
     std::shared_ptr<Symbol> find_symbol( const SyntaxNode* node ) const;
+    std::shared_ptr<Symbol> find_overload( const std::string& identifier, int overload ) const;
+    int overload( const std::shared_ptr<Symbol>& symbol ) const;
+    uint64_t fingerprint() const;
     static bool matches( const std::shared_ptr<Symbol>& symbol, const SyntaxNode* node, const std::vector<std::shared_ptr<SyntaxNode>>& node_parameters );
 };
 
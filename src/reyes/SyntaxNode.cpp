@@ -255,6 +255,11 @@ void SyntaxNode::add_nodes_at_end( const std::vector<std::shared_ptr<SyntaxNode>
     nodes_.insert( nodes_.end(), begin, end );
 }
 
+void SyntaxNode::clear_nodes()
+{
+    nodes_.clear();
+}
+
 void SyntaxNode::set_symbol( std::shared_ptr<Symbol> symbol )
 {
     symbol_ = symbol;
@@ -308,3 +313,18 @@ void SyntaxNode::set_instruction( Instruction instruction )
 {
     instruction_ = instruction;
 }
+
+/**
+// Clear the types, storages, and instruction set on this SyntaxNode during 
+// semantic analysis so that it can be analyzed again.
+*/
+void SyntaxNode::clear_analysis()
+{
+    expected_type_ = TYPE_NULL;
+    original_type_ = TYPE_NULL;
+    type_ = TYPE_NULL;
+    expected_storage_ = STORAGE_NULL;
+    original_storage_ = STORAGE_NULL;
+    storage_ = STORAGE_NULL;
+    instruction_ = INSTRUCTION_NULL;
+}
@@ -71,6 +71,7 @@ public:
     void add_node( std::shared_ptr<SyntaxNode> node );
     void add_node_at_front( std::shared_ptr<SyntaxNode> node );
     void add_nodes_at_end( const std::vector<std::shared_ptr<SyntaxNode>>::const_iterator begin, const std::vector<std::shared_ptr<SyntaxNode>>::const_iterator end );   
+    void clear_nodes();
     void set_symbol( std::shared_ptr<Symbol> symbol );    
     void set_constant_index( int index );    
     void set_expected_type( ValueType type );    
@@ -80,6 +81,7 @@ public:
     void set_storage( ValueStorage storage );    
     void set_storage_for_promotion( ValueStorage storage );    
     void set_instruction( Instruction instruction );    
+    void clear_analysis();
 };
 
 }
@@ -16,10 +16,13 @@
 #include <string>
 #include <stdio.h>
 #include <memory.h>
+#include <algorithm>
 #define _USE_MATH_DEFINES
 #include <math.h>
 
 using std::string;
+using std::min;
+using std::max;
 using namespace math;
 using namespace reyes;
 
@@ -46,7 +49,9 @@ Texture::Texture()
 : type_( TEXTURE_NULL ),
   camera_transform_( identity() ),
   screen_transform_( identity() ),
-  image_buffers_( NULL )
+  image_buffers_( NULL ),
+  mipmaps_( NULL ),
+  levels_( 1 )
 {
 }
 
@@ -54,7 +59,9 @@ Texture::Texture( TextureType type, const math::mat4x4& camera_transform, const
 : type_( type ),
   camera_transform_( camera_transform ),
   screen_transform_( screen_transform ),
-  image_buffers_( NULL )
+  image_buffers_( NULL ),
+  mipmaps_( NULL ),
+  levels_( 1 )
 {
     REYES_ASSERT( type_ >= TEXTURE_NULL && type_ < TEXTURE_COUNT );
     image_buffers_ = new ImageBuffer [1];
@@ -64,13 +71,17 @@ Texture::Texture( const std::string& filename, TextureType type, ErrorPolicy* er
 : type_( TEXTURE_NULL ),
   camera_transform_( identity() ),
   screen_transform_( identity() ),
-  image_buffers_( NULL )
+  image_buffers_( NULL ),
+  mipmaps_( NULL ),
+  levels_( 1 )
 {
     load( filename, type, error_policy );
 }
 
 Texture::~Texture()
 {
+    delete[] mipmaps_;
+    mipmaps_ = NULL;
     delete[] image_buffers_;
     image_buffers_ = NULL;
 }
@@ -90,17 +101,125 @@ bool Texture::valid() const
     return image_buffers_ && image_buffers_->width() > 0 && image_buffers_->height() > 0;
 }
 
+int Texture::levels() const
+{
+    return levels_;
+}
+
+const ImageBuffer& Texture::level( int level ) const
+{
+    REYES_ASSERT( image_buffers_ );
+    REYES_ASSERT( level >= 0 && level < levels_ );
+    return level == 0 ? *image_buffers_ : mipmaps_[level - 1];
+}
+
+/**
+// Generate the mip pyramid for this texture from its full resolution image.
+//
+// Each level is half the size of the level above it, rounding down and 
+// stopping at a single texel, with each texel the average of the 2x2 
+// texels that it covers in the level above.  Texels past the edge of odd
+// sized levels are clamped to the edge.  Only 8 bit images are filtered,
+// other textures are left with a single level.  Only color textures are
+// given pyramids when loaded, environment and shadow lookups have no 
+// footprint to pick a level with and always use the full resolution.
+*/
+void Texture::generate_mipmaps()
+{
+    delete[] mipmaps_;
+    mipmaps_ = NULL;
+    levels_ = 1;
+
+    if ( !valid() || image_buffers_->format() != FORMAT_U8 )
+    {
+        return;
+    }
+
+    int width = image_buffers_->width();
+    int height = image_buffers_->height();
+    while ( width > 1 || height > 1 )
+    {
+        width = max( width / 2, 1 );
+        height = max( height / 2, 1 );
+        ++levels_;
+    }
+
+    if ( levels_ > 1 )
+    {
+        const int elements = image_buffers_->elements();
+        mipmaps_ = new ImageBuffer [levels_ - 1];
+        for ( int i = 1; i < levels_; ++i )
+        {
+            const ImageBuffer& source = level( i - 1 );
+            ImageBuffer& destination = mipmaps_[i - 1];
+            destination.reset( max(source.width() / 2, 1), max(source.height() / 2, 1), elements, FORMAT_U8 );
+            for ( int y = 0; y < destination.height(); ++y )
+            {
+                const int y0 = min( y * 2, source.height() - 1 );
+                const int y1 = min( y * 2 + 1, source.height() - 1 );
+                for ( int x = 0; x < destination.width(); ++x )
+                {
+                    const int x0 = min( x * 2, source.width() - 1 );
+                    const int x1 = min( x * 2 + 1, source.width() - 1 );
+                    const unsigned char* texel00 = source.u8_data( x0, y0 );
+                    const unsigned char* texel10 = source.u8_data( x1, y0 );
+                    const unsigned char* texel01 = source.u8_data( x0, y1 );
+                    const unsigned char* texel11 = source.u8_data( x1, y1 );
+                    unsigned char* texel = destination.u8_data( x, y );
+                    for ( int element = 0; element < elements; ++element )
+                    {
+                        texel[element] = (unsigned char) ((texel00[element] + texel10[element] + texel01[element] + texel11[element] + 2) / 4);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+// Look up the color of this texture at a point.
+//
+// Equivalent to a lookup with a footprint covering less than a texel, i.e.
+// a bilinear lookup in the full resolution level.
+*/
 math::vec4 Texture::color( float s, float t ) const
+{
+    return color( s, t, 0.0f, 0.0f );
+}
+
+/**
+// Look up the color of this texture over an area.
+//
+// The level of the mip pyramid whose texels are closest in size to the 
+// footprint of the lookup is chosen and the result is blended between 
+// bilinear lookups in the two nearest levels (trilinear filtering).
+//
+// @param s, t
+//  The texture coordinates to look up the color at (clamped to [0, 1]).
+//
+// @param ds, dt
+//  The width of the area covered by the lookup in s and t (usually the 
+//  change in s and t across a micropolygon).
+//
+// @return
+//  The filtered color.
+*/
+math::vec4 Texture::color( float s, float t, float ds, float dt ) const
 {
     s = clamp( s, 0.0f, 1.0f );
     t = clamp( t, 0.0f, 1.0f );
-    const unsigned char* pixel = image_buffers_->u8_data( s, t );
-    return vec4(
-        float(*(pixel + 0)) / 255.0f,
-        float(*(pixel + 1)) / 255.0f,
-        float(*(pixel + 2)) / 255.0f,
-        1.0f
-    );
+
+    const float texels = max( fabsf(ds) * float(image_buffers_->width()), fabsf(dt) * float(image_buffers_->height()) );
+    const float lod = texels > 1.0f ? min( log2f(texels), float(levels_ - 1) ) : 0.0f;
+    const int lower = int( lod );
+    const float blend = lod - float( lower );
+    if ( lower + 1 >= levels_ || blend <= 0.0f )
+    {
+        return bilinear( level(lower), s, t );
+    }
+    const vec4 lower_color = bilinear( level(lower), s, t );
+    const vec4 upper_color = bilinear( level(lower + 1), s, t );
+    return lower_color + (upper_color - lower_color) * blend;
 }
 
 math::vec4 Texture::environment( const math::vec3& direction ) const
@@ -136,13 +255,7 @@ math::vec4 Texture::environment( const math::vec3& direction ) const
 
         s = clamp( (s + 1.0f) / 2.0f, 0.0f, 1.0f );
         t = clamp( (t + 1.0f) / 2.0f, 0.0f, 1.0f );
-        const unsigned char* pixel = image_buffers_[image].u8_data( s, t );
-        return vec4(
-            float(*(pixel + 0)) / 255.0f,
-            float(*(pixel + 1)) / 255.0f,
-            float(*(pixel + 2)) / 255.0f,
-            1.0f
-        );
+        return bilinear( image_buffers_[image], s, t );
     }
     else    
     {
@@ -217,6 +330,52 @@ void Texture::load( const std::string& filename, TextureType type, ErrorPolicy*
                 }
                 return;
             }
+            if ( type_ == TEXTURE_COLOR )
+            {
+                generate_mipmaps();
+            }
         }
     }
 }
+
+/**
+// Look up the color of an 8 bit image by interpolating between the four 
+// texels nearest to a point.
+//
+// @param image_buffer
+//  The image to look up (assumed to have at least three 8 bit elements).
+//
+// @param s, t
+//  The texture coordinates to look up the color at (assumed in [0, 1]).
+//
+// @return
+//  The interpolated color (alpha is always one).
+*/
+math::vec4 Texture::bilinear( const ImageBuffer& image_buffer, float s, float t )
+{
+    REYES_ASSERT( image_buffer.format() == FORMAT_U8 );
+    REYES_ASSERT( s >= 0.0f && s <= 1.0f );
+    REYES_ASSERT( t >= 0.0f && t <= 1.0f );
+
+    const float x = s * float(image_buffer.width() - 1);
+    const float y = t * float(image_buffer.height() - 1);
+    const int x0 = int( x );
+    const int y0 = int( y );
+    const int x1 = min( x0 + 1, image_buffer.width() - 1 );
+    const int y1 = min( y0 + 1, image_buffer.height() - 1 );
+    const float fx = x - float( x0 );
+    const float fy = y - float( y0 );
+
+    const unsigned char* texel00 = image_buffer.u8_data( x0, y0 );
+    const unsigned char* texel10 = image_buffer.u8_data( x1, y0 );
+    const unsigned char* texel01 = image_buffer.u8_data( x0, y1 );
+    const unsigned char* texel11 = image_buffer.u8_data( x1, y1 );
+    float color [3];
+    for ( int element = 0; element < 3; ++element )
+    {
+        const float top = float(texel00[element]) + (float(texel10[element]) - float(texel00[element])) * fx;
+        const float bottom = float(texel01[element]) + (float(texel11[element]) - float(texel01[element])) * fx;
+        color[element] = (top + (bottom - top) * fy) / 255.0f;
+    }
+    return vec4( color[0], color[1], color[2], 1.0f );
+}
@@ -14,6 +14,11 @@ class ImageBuffer;
 
 /**
 // A color map, shadow map, or environment map texture.
+//
+// Only color maps keep a mip pyramid of successively half sized copies of
+// their image so that lookups covering many texels read a few texels from
+// a small level rather than aliasing against the full resolution image.
+// Shadow and environment maps are always looked up at full resolution.
 */
 class Texture
 {
@@ -21,6 +26,8 @@ class Texture
     math::mat4x4 camera_transform_; ///< The camera transform in effect when a shadow map was created.
     math::mat4x4 screen_transform_; ///< The screen transform in effect when a shadow map was created.
     ImageBuffer* image_buffers_; ///< The image buffers that store texture data for this texture.
+    ImageBuffer* mipmaps_; ///< The levels of the mip pyramid below the full resolution level in image_buffers_ or null if there is no mip pyramid.
+    int levels_; ///< The number of levels in the mip pyramid including the full resolution level.
 
 public:
     Texture();
@@ -32,12 +39,18 @@ public:
     ImageBuffer* image_buffers() const;
     bool valid() const;
     
+    int levels() const;
+    const ImageBuffer& level( int level ) const;
+    void generate_mipmaps();
+
     math::vec4 color( float s, float t ) const;
+    math::vec4 color( float s, float t, float ds, float dt ) const;
     math::vec4 environment( const math::vec3& direction ) const;
     float shadow( const math::vec4& P, float bias ) const;
     
 private:
     void load( const std::string& filename, TextureType type, ErrorPolicy* error_policy );
+    static math::vec4 bilinear( const ImageBuffer& image_buffer, float s, float t );
 };
 
 }
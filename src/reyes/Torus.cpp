@@ -18,14 +18,12 @@
 
 using std::min;
 using std::max;
-using std::list;
 using std::vector;
-using std::shared_ptr;
 using namespace math;
 using namespace reyes;
 
 Torus::Torus( float rmajor, float rminor, float phimin, float phimax, float thetamax )
-: Geometry(vec2(0.0f, 1.0f), vec2(0.0f, 1.0f)),
+: Geometry(),
   rmajor_( rmajor ),
   rminor_( rminor ),
   phimin_( phimin ),
@@ -34,22 +32,12 @@ Torus::Torus( float rmajor, float rminor, float phimin, float phimax, float thet
 {   
 }
 
-Torus::Torus( const Torus& torus, const math::vec2& u_range, const math::vec2& v_range )
-: Geometry(u_range, v_range),
-  rmajor_( torus.rmajor_ ),
-  rminor_( torus.rminor_ ),
-  phimin_( torus.phimin_ ),
-  phimax_( torus.phimax_ ),
-  thetamax_( torus.thetamax_ )
-{   
-}
-
 bool Torus::boundable() const
 {
     return true;
 }
 
-void Torus::bound( const math::mat4x4& transform, vec3* minimum, vec3* maximum ) const
+void Torus::bound( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, vec3* minimum, vec3* maximum ) const
 {
     REYES_ASSERT( minimum );
     REYES_ASSERT( maximum );
@@ -57,19 +45,22 @@ void Torus::bound( const math::mat4x4& transform, vec3* minimum, vec3* maximum )
     *minimum = vec3( FLT_MAX, FLT_MAX, FLT_MAX );
     *maximum = vec3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
     
-    Grid grid;
-    dice( transform, 8, 8, &grid );
-    const vec3* positions = grid["P"].vec3_values();
-    const vec3* positions_end = positions + grid["P"].size();
-    for ( const vec3* i = positions; i != positions_end; ++i )
-    {
-        minimum->x = min( minimum->x, i->x );
-        minimum->y = min( minimum->y, i->y );
-        minimum->z = min( minimum->z, i->z );        
-        maximum->x = max( maximum->x, i->x );
-        maximum->y = max( maximum->y, i->y );
-        maximum->z = max( maximum->z, i->z );
-    }
+    // The extents of cos(phi) and sin(phi) over the range in v give the 
+    // range of distances from the z axis and heights covered by the minor
+    // circle which is then swept around the z axis.
+    vec3 phi_minimum = vec3( FLT_MAX, FLT_MAX, 0.0f );
+    vec3 phi_maximum = vec3( -FLT_MAX, -FLT_MAX, 0.0f );
+    const float phi0 = phimin_ + (phimax_ - phimin_) * v_range.x;
+    const float phi1 = phimin_ + (phimax_ - phimin_) * v_range.y;
+    bound_arc( rminor_, phi0, phi1, &phi_minimum, &phi_maximum );
+
+    const float theta0 = u_range.x * thetamax_;
+    const float theta1 = u_range.y * thetamax_;
+    bound_arc( rmajor_ + phi_minimum.x, theta0, theta1, minimum, maximum );
+    bound_arc( rmajor_ + phi_maximum.x, theta0, theta1, minimum, maximum );
+    minimum->z = phi_minimum.y;
+    maximum->z = phi_maximum.y;
+    transform_bound( transform, minimum, maximum );
 }
 
 bool Torus::splittable() const
@@ -77,54 +68,26 @@ bool Torus::splittable() const
     return true;
 }
 
-void Torus::split( std::list<std::shared_ptr<Geometry>>* primitives ) const
-{
-    REYES_ASSERT( primitives );
-    REYES_ASSERT( u_range().y >= u_range().x );
-    REYES_ASSERT( v_range().y >= v_range().x );
-
-    const vec2& u_range = Geometry::u_range();
-    float u0 = u_range.x;
-    float u1 = (u_range.x + u_range.y) / 2.0f;
-    float u2 = u_range.y;
-
-    const vec2& v_range = Geometry::v_range();
-    float v0 = v_range.x;
-    float v1 = (v_range.x + v_range.y) / 2.0f;
-    float v2 = v_range.y;
-
-    shared_ptr<Geometry> torus;
-    torus.reset( new Torus(*this, vec2(u0, u1), vec2(v0, v1)) );
-    primitives->push_back( torus );
-    torus.reset( new Torus(*this, vec2(u0, u1), vec2(v1, v2)) );
-    primitives->push_back( torus );
-    torus.reset( new Torus(*this, vec2(u1, u2), vec2(v0, v1)) );
-    primitives->push_back( torus );
-    torus.reset( new Torus(*this, vec2(u1, u2), vec2(v1, v2)) );
-    primitives->push_back( torus );
-}
-
 bool Torus::diceable() const
 {
     return true;
 }
 
-void Torus::dice( const math::mat4x4& transform, int width, int height, Grid* grid ) const
+void Torus::dice( const math::mat4x4& transform, const math::vec2& u_range, const math::vec2& v_range, int width, int height, Grid* grid ) const
 {
     REYES_ASSERT( width > 0 );
     REYES_ASSERT( height > 0 );
     REYES_ASSERT( grid );
     
-    const vec2& u_range = Geometry::u_range();
-    const vec2& v_range = Geometry::v_range();
-
     grid->resize( width, height );
     grid->du_ = (u_range.y - u_range.x) / float(width - 1);
     grid->dv_ = (v_range.y - v_range.x) / float(height - 1);
     
-    vec3* positions = grid->value( "P", TYPE_POINT ).vec3_values();
-    float* s = grid->value( "s", TYPE_FLOAT ).float_values();
-    float* t = grid->value( "t", TYPE_FLOAT ).float_values();
+    vec3* positions = grid->value( GRID_SLOT_P, TYPE_POINT ).vec3_values();
+    vec3* u_derivatives = grid->value( GRID_SLOT_DPDU, TYPE_VECTOR ).vec3_values();
+    vec3* v_derivatives = grid->value( GRID_SLOT_DPDV, TYPE_VECTOR ).vec3_values();
+    float* s = grid->value( GRID_SLOT_S, TYPE_FLOAT ).float_values();
+    float* t = grid->value( GRID_SLOT_T, TYPE_FLOAT ).float_values();
     
     int vertex = 0;
     float v = v_range.x;
@@ -135,7 +98,13 @@ void Torus::dice( const math::mat4x4& transform, int width, int height, Grid* gr
         float du = (u_range.y - u_range.x) / float(width - 1);
         for ( int i = 0; i < width; ++i )
         {
-            positions[vertex] = vec3( transform * vec4(position(u, v), 1.0f) );
+            vec3 position;
+            vec3 dpdu;
+            vec3 dpdv;
+            evaluate( u, v, &position, &dpdu, &dpdv );
+            positions[vertex] = vec3( transform * vec4(position, 1.0f) );
+            u_derivatives[vertex] = vec3( transform * vec4(dpdu, 0.0f) );
+            v_derivatives[vertex] = vec3( transform * vec4(dpdv, 0.0f) );
             s[vertex] = u;
             t[vertex] = v;
             u = min( u + du, u_range.y );
@@ -145,10 +114,19 @@ void Torus::dice( const math::mat4x4& transform, int width, int height, Grid* gr
     }    
 }
 
-math::vec3 Torus::position( float u, float v ) const
+void Torus::evaluate( float u, float v, math::vec3* position, math::vec3* dpdu, math::vec3* dpdv ) const
 {
+    REYES_ASSERT( position );
+    REYES_ASSERT( dpdu );
+    REYES_ASSERT( dpdv );
     float theta = u * thetamax_;
+    float cos_theta = cosf( theta );
+    float sin_theta = sinf( theta );
     float phi = phimin_ + (phimax_ - phimin_) * v;
-    float r = rminor_ * cosf( phi );
-    return vec3( (rmajor_ + r) * cosf(theta), (rmajor_ + r) * sinf(theta), rminor_ * sinf(phi) );
+    float cos_phi = cosf( phi );
+    float sin_phi = sinf( phi );
+    float r = rmajor_ + rminor_ * cos_phi;
+    *position = vec3( r * cos_theta, r * sin_theta, rminor_ * sin_phi );
+    *dpdu = thetamax_ * vec3( -r * sin_theta, r * cos_theta, 0.0f );
+    *dpdv = (phimax_ - phimin_) * vec3( -rminor_ * sin_phi * cos_theta, -rminor_ * sin_phi * sin_theta, rminor_ * cos_phi );
 }
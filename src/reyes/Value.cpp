@@ -9,6 +9,7 @@
 #include "Texture.hpp"
 #include "Grid.hpp"
 #include "Light.hpp"
+#include "ValuePool.hpp"
 #include <math/vec2.ipp>
 #include <math/vec3.ipp>
 #include <math/vec4.ipp>
@@ -18,6 +19,7 @@
 #include "assert.hpp"
 #include <math.h>
 #include <memory.h>
+#include <stdlib.h>
 
 using std::min;
 using std::max;
@@ -25,35 +27,44 @@ using std::vector;
 using namespace math;
 using namespace reyes;
 
-// @todo
-//  Make sure that MAXIMUM_VERTICES_PER_GRID in Value.cpp is unified with the
-//  same variable in Renderer.
-static const int MAXIMUM_VERTICES_PER_GRID = 64 * 64;
+/// The number of floats that each plane of a planar value is padded to a multiple of (the width of an AVX2 vector).
+static const unsigned int PLANE_ALIGNMENT = 8;
 
 Value::Value()
 : type_( TYPE_NULL ),
   storage_( STORAGE_NULL ),
   string_value_(),
+  value_pool_( NULL ),
   values_( NULL ),
+  allocated_( 0 ),
   size_( 0 ),
-  capacity_( 0 )
+  capacity_( 0 ),
+  planar_( false )
 {
-    allocate();
 }
 
 Value::Value( const Value& value )
 : type_( value.type_ ),
   storage_( value.storage_ ),
   string_value_( value.string_value_ ),
+  value_pool_( NULL ),
   values_( NULL ),
+  allocated_( 0 ),
   size_( 0 ),
-  capacity_( 0 )
+  capacity_( 0 ),
+  planar_( false )
 {
-    allocate();
     if ( value.capacity_ > 0 )
     {
-        reserve( value.capacity_ );
-        memcpy( values_, value.values_, capacity_ * element_size() );
+        if ( value.planar_ )
+        {
+            reset_planes( value.type_, value.storage_, value.capacity_ );
+        }
+        else
+        {
+            reserve( value.capacity_ );
+        }
+        memcpy( values_, value.values_, bytes() );
         size_ = capacity_;
     }
 }
@@ -65,9 +76,11 @@ Value& Value::operator=( const Value& value )
         type_ = value.type_;
         storage_ = value.storage_;
         string_value_ = value.string_value_;
+        planar_ = value.planar_;
+        allocate( value.bytes() );
         size_ = value.size_;
         capacity_ = value.capacity_;
-        memcpy( values_, value.values_, size_ * element_size() );
+        memcpy( values_, value.values_, planar_ ? bytes() : size_ * element_size() );
     }
     return *this;
 }
@@ -76,41 +89,60 @@ Value::Value( ValueType type, ValueStorage storage )
 : type_( type ),
   storage_( storage ),
   string_value_(),
+  value_pool_( NULL ),
   values_( NULL ),
+  allocated_( 0 ),
   size_( 0 ),
-  capacity_( 0 )
+  capacity_( 0 ),
+  planar_( false )
 {
-    allocate();
 }
 
 Value::Value( ValueType type, ValueStorage storage, unsigned int capacity )
 : type_( type ),
   storage_( storage ),
   string_value_(),
+  value_pool_( NULL ),
   values_( NULL ),
+  allocated_( 0 ),
   size_( 0 ),
-  capacity_( 0 )
+  capacity_( 0 ),
+  planar_( false )
+{
+    reserve( capacity );
+}
+
+Value::Value( ValueType type, ValueStorage storage, unsigned int capacity, ValuePool* value_pool )
+: type_( type ),
+  storage_( storage ),
+  string_value_(),
+  value_pool_( value_pool ),
+  values_( NULL ),
+  allocated_( 0 ),
+  size_( 0 ),
+  capacity_( 0 ),
+  planar_( false )
 {
-    allocate();
     reserve( capacity );
-    size_ = capacity;
 }
 
 Value::~Value()
 {
-    if ( values_ )
+    if ( values_ && !value_pool_ )
     {
         free( values_ );
-        values_ = NULL;
     }
+    values_ = NULL;
 }
 
 Value& Value::operator=( float value )
 {
+    planar_ = false;
     switch ( type_ )
     {
         case TYPE_FLOAT:
         {
+            allocate( sizeof(float) );
             float* values = float_values();
             values[0] = value;
             storage_ = STORAGE_UNIFORM;
@@ -123,6 +155,7 @@ Value& Value::operator=( float value )
         case TYPE_VECTOR:
         case TYPE_NORMAL:
         {
+            allocate( sizeof(vec3) );
             vec3* values = vec3_values();
             values[0] = vec3( value, value, value );
             storage_ = STORAGE_UNIFORM;
@@ -140,6 +173,8 @@ Value& Value::operator=( float value )
 
 Value& Value::operator=( const math::vec3& value )
 {
+    planar_ = false;
+    allocate( sizeof(vec3) );
     vec3* values = vec3_values();
     values[0] = value;        
     storage_ = STORAGE_UNIFORM;
@@ -149,6 +184,8 @@ Value& Value::operator=( const math::vec3& value )
 
 Value& Value::operator=( const math::mat4x4& value )
 {
+    planar_ = false;
+    allocate( sizeof(mat4x4) );
     mat4x4* values = mat4x4_values();
     values[0] = value;    
     storage_ = STORAGE_UNIFORM;
@@ -184,6 +221,10 @@ unsigned int Value::element_size() const
     unsigned int size = 0;
     switch ( type_ )
     {
+        case TYPE_NULL:
+            size = 0;
+            break;
+
         case TYPE_INTEGER:  
             size = sizeof(int);
             break;
@@ -229,7 +270,7 @@ void Value::zero()
 {
     REYES_ASSERT( values_ );
     REYES_ASSERT( capacity_ > 0 );
-    memset( values_, 0, capacity_ * element_size() );
+    memset( values_, 0, bytes() );
     size_ = capacity_;
 }
 
@@ -241,6 +282,8 @@ void Value::clear()
 
 void Value::reserve( unsigned int capacity )
 {
+    planar_ = false;
+    allocate( capacity * element_size() );
     capacity_ = capacity;
     size_ = capacity;
 }
@@ -249,8 +292,35 @@ void Value::reset( ValueType type, ValueStorage storage, unsigned int capacity )
 {
     type_ = type;
     storage_ = storage;    
+    planar_ = false;
+    allocate( capacity * element_size() );
+    capacity_ = capacity;
+    size_ = capacity;
+}
+
+/**
+// Reset this value to store \e capacity vec3 values in planes.
+//
+// The x, y, and z components are each stored contiguously, starting at 
+// plane( 0 ), plane( 1 ), and plane( 2 ), rather than interleaved.  Each 
+// plane is padded to a multiple of PLANE_ALIGNMENT floats so that kernels 
+// can process whole planes a vector at a time without gathering 
+// components.
+//
+// Only the virtual machine's temporaries are stored in planes (see 
+// VirtualMachine::decode_planes()).  Everything else reads values 
+// through float_values() and vec3_values() which mustn't be used for 
+// planar values.
+*/
+void Value::reset_planes( ValueType type, ValueStorage storage, unsigned int capacity )
+{
+    REYES_ASSERT( type == TYPE_COLOR || type == TYPE_POINT || type == TYPE_VECTOR || type == TYPE_NORMAL );
+    type_ = type;
+    storage_ = storage;
+    planar_ = true;
     capacity_ = capacity;
     size_ = capacity;
+    allocate( bytes() );
 }
 
 bool Value::empty() const
@@ -283,11 +353,13 @@ int* Value::int_values() const
 
 float* Value::float_values() const
 {
+    REYES_ASSERT( !planar_ );
     return reinterpret_cast<float*>( values_ );
 }
 
 math::vec3* Value::vec3_values() const
 {
+    REYES_ASSERT( !planar_ );
     return reinterpret_cast<math::vec3*>( values_ );
 }
 
@@ -312,6 +384,32 @@ math::vec3 Value::vec3_value() const
     return *(const vec3*) values_;
 }
 
+bool Value::planar() const
+{
+    return planar_;
+}
+
+/**
+// Get the distance between the starts of consecutive planes of a planar 
+// value (in floats).
+*/
+unsigned int Value::plane_stride() const
+{
+    REYES_ASSERT( planar_ );
+    return (capacity_ + PLANE_ALIGNMENT - 1) / PLANE_ALIGNMENT * PLANE_ALIGNMENT;
+}
+
+/**
+// Get the plane storing the x (0), y (1), or z (2) components of a planar
+// value.
+*/
+float* Value::plane( int component ) const
+{
+    REYES_ASSERT( planar_ );
+    REYES_ASSERT( component >= 0 && component < 3 );
+    return reinterpret_cast<float*>( values_ ) + component * plane_stride();
+}
+
 /**
 // Calculate the light direction from the light at \e light_position (the
 // explicit position expression of an illuminate statement) to the surface 
@@ -319,7 +417,7 @@ math::vec3 Value::vec3_value() const
 //
 // This is used to calculate "L" in a light shader's illuminate statement.
 */
-void Value::light_to_surface_vector( std::shared_ptr<Value> position, const math::vec3& light_position )
+void Value::light_to_surface_vector( const Value* position, const math::vec3& light_position )
 {
     REYES_ASSERT( position );
     REYES_ASSERT( position->storage() == STORAGE_VARYING );
@@ -329,7 +427,7 @@ void Value::light_to_surface_vector( std::shared_ptr<Value> position, const math
     
     const int size = size_;
     vec3* values = vec3_values();
-    vec3* positions = position->vec3_values();
+    const vec3* positions = position->vec3_values();
     for ( int i = 0; i < size; ++i )
     {
         values[i] = positions[i] - light_position;
@@ -343,7 +441,7 @@ void Value::light_to_surface_vector( std::shared_ptr<Value> position, const math
 // This is used to calculate "L" in a surface shader's illuminance statement 
 // from the surface position and the currently active light.
 */
-void Value::surface_to_light_vector( std::shared_ptr<Value> position, const Light* light )
+void Value::surface_to_light_vector( const Value* position, const Light* light )
 {
     REYES_ASSERT( position );
     REYES_ASSERT( position->storage() == STORAGE_VARYING );
@@ -366,7 +464,7 @@ void Value::surface_to_light_vector( std::shared_ptr<Value> position, const Ligh
 // Calculate a mask based on the axis and angle passed to an illuminance 
 // statement and the light from \e light.
 */
-void Value::illuminance_axis_angle( std::shared_ptr<Value> position, std::shared_ptr<Value> axis, std::shared_ptr<Value> angle, const Light* light )
+void Value::illuminance_axis_angle( const Value* position, const Value* axis, const Value* angle, const Light* light )
 {
     REYES_ASSERT( position );
     REYES_ASSERT( position->storage() == STORAGE_VARYING );
@@ -411,7 +509,7 @@ void Value::illuminance_axis_angle( std::shared_ptr<Value> position, std::shared
     }        
 }
 
-void Value::assign_string( std::shared_ptr<Value> value, const unsigned char* mask )
+void Value::assign_string( const Value* value, const uint64_t* /*mask*/ )
 {
     REYES_ASSERT( value );
     REYES_ASSERT( value->storage() != STORAGE_VARYING );
@@ -421,8 +519,32 @@ void Value::assign_string( std::shared_ptr<Value> value, const unsigned char* ma
     string_value_ = value->string_value_;
 }
 
-void Value::allocate()
+void Value::allocate( unsigned int size )
+{
+    // Values only grow, keeping their contents in case a value is reset 
+    // while it is also being read from.  Memory drawn from a pool isn't 
+    // freed here but reclaimed when the whole pool is reset.
+    if ( size > allocated_ )
+    {
+        void* values = value_pool_ ? value_pool_->allocate( size ) : malloc( size );
+        REYES_ASSERT( values );
+        if ( values_ )
+        {
+            memcpy( values, values_, allocated_ );
+            if ( !value_pool_ )
+            {
+                free( values_ );
+            }
+        }
+        values_ = values;
+        allocated_ = size;
+    }
+}
+
+/**
+// Get the number of bytes needed to store this value's capacity.
+*/
+unsigned int Value::bytes() const
 {
-    REYES_ASSERT( !values_ );
-    values_ = malloc( sizeof(vec3) * MAXIMUM_VERTICES_PER_GRID );
+    return planar_ ? 3 * plane_stride() * sizeof(float) : capacity_ * element_size();
 }
@@ -10,6 +10,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <stdint.h>
 
 namespace reyes
 {
@@ -18,6 +19,7 @@ class Grid;
 class Light;
 class Texture;
 class Renderer;
+class ValuePool;
 
 /**
 // A value stored by the renderer for a shader parameter or a varying variable
@@ -28,9 +30,12 @@ class Value
     ValueType type_; ///< The type stored in this value.
     ValueStorage storage_; ///< The storage of this value.
     std::string string_value_; ///< The string value of this value.
+    ValuePool* value_pool_; ///< The pool that values are allocated from or null to allocate them from the heap.
     void* values_; ///< A pointer to the buffer of floating point values that this value can use.
+    unsigned int allocated_; ///< The size of the buffer pointed to by values_ (in bytes).
     unsigned int size_; ///< The number of values stored in this value.
     unsigned int capacity_; ///< The capacity of this value.
+    bool planar_; ///< True if the x, y, and z components of this value are stored in separate planes rather than interleaved.
 
 public:
     Value();
@@ -38,6 +43,7 @@ public:
     Value& operator=( const Value& value );
     Value( ValueType type, ValueStorage storage );
     Value( ValueType type, ValueStorage storage, unsigned int capacity );
+    Value( ValueType type, ValueStorage storage, unsigned int capacity, ValuePool* value_pool );
     ~Value();
     
     Value& operator=( float value );
@@ -57,6 +63,7 @@ public:
     void clear();
     void reserve( unsigned int capacity );
     void reset( ValueType type, ValueStorage storage, unsigned int capacity );
+    void reset_planes( ValueType type, ValueStorage storage, unsigned int capacity );
 
     bool empty() const;
     void set_string( const std::string& value );
@@ -68,14 +75,18 @@ public:
     math::mat4x4* mat4x4_values() const;
     float float_value() const;
     math::vec3 vec3_value() const;
+    bool planar() const;
+    unsigned int plane_stride() const;
+    float* plane( int component ) const;
     
-    void light_to_surface_vector( std::shared_ptr<Value> position, const math::vec3& light_position );
-    void surface_to_light_vector( std::shared_ptr<Value> position, const Light* light );
-    void illuminance_axis_angle( std::shared_ptr<Value> position, std::shared_ptr<Value> axis, std::shared_ptr<Value> angle, const Light* light );
-    void assign_string( std::shared_ptr<Value> value, const unsigned char* mask );
+    void light_to_surface_vector( const Value* position, const math::vec3& light_position );
+    void surface_to_light_vector( const Value* position, const Light* light );
+    void illuminance_axis_angle( const Value* position, const Value* axis, const Value* angle, const Light* light );
+    void assign_string( const Value* value, const uint64_t* mask );
     
 private:
-    void allocate();
+    void allocate( unsigned int size );
+    unsigned int bytes() const;
 };
 
 }
@@ -0,0 +1,92 @@
+//
+// ValuePool.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "stdafx.hpp"
+#include "ValuePool.hpp"
+#include "assert.hpp"
+#include <stdlib.h>
+
+using std::vector;
+using namespace reyes;
+
+/// The alignment of each allocation made from a pool (in bytes).
+static const unsigned int ALIGNMENT = 16;
+
+ValuePool::ValuePool( unsigned int block_size )
+: blocks_(),
+  large_blocks_(),
+  block_size_( block_size ),
+  block_( 0 ),
+  offset_( 0 )
+{
+    REYES_ASSERT( block_size_ > 0 );
+}
+
+ValuePool::~ValuePool()
+{
+    reset();
+    for ( vector<unsigned char*>::const_iterator i = blocks_.begin(); i != blocks_.end(); ++i )
+    {
+        free( *i );
+    }
+}
+
+/**
+// Allocate memory from this pool.
+//
+// The memory remains valid until this pool is reset or destroyed.  Requests
+// larger than a block are allocated from the heap and freed when this pool 
+// is reset.
+//
+// @param size
+//  The number of bytes to allocate.
+//
+// @return
+//  The allocated memory.
+*/
+void* ValuePool::allocate( unsigned int size )
+{
+    size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    if ( size > block_size_ )
+    {
+        unsigned char* block = reinterpret_cast<unsigned char*>( malloc(size) );
+        REYES_ASSERT( block );
+        large_blocks_.push_back( block );
+        return block;
+    }
+
+    if ( block_ < blocks_.size() && offset_ + size > block_size_ )
+    {
+        ++block_;
+        offset_ = 0;
+    }
+
+    if ( block_ == blocks_.size() )
+    {
+        unsigned char* block = reinterpret_cast<unsigned char*>( malloc(block_size_) );
+        REYES_ASSERT( block );
+        blocks_.push_back( block );
+    }
+
+    void* values = blocks_[block_] + offset_;
+    offset_ += size;
+    return values;
+}
+
+/**
+// Reset this pool so that its blocks are reused by later allocations.
+//
+// All memory previously allocated from this pool is invalidated.
+*/
+void ValuePool::reset()
+{
+    for ( vector<unsigned char*>::const_iterator i = large_blocks_.begin(); i != large_blocks_.end(); ++i )
+    {
+        free( *i );
+    }
+    large_blocks_.clear();
+    block_ = 0;
+    offset_ = 0;
+}
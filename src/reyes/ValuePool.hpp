@@ -0,0 +1,34 @@
+#ifndef REYES_VALUEPOOL_HPP_INCLUDED
+#define REYES_VALUEPOOL_HPP_INCLUDED
+
+#include <vector>
+
+namespace reyes
+{
+
+/**
+// A pool of memory that the values of a single grid are allocated from.
+//
+// Memory is handed out by bumping an offset through large blocks and is 
+// never freed individually.  The whole pool is reset once the grid that its
+// values belong to has been sampled so that the same blocks are reused for
+// the next grid without going back to the heap.
+*/
+class ValuePool
+{
+    std::vector<unsigned char*> blocks_; ///< The blocks of memory retained by this pool.
+    std::vector<unsigned char*> large_blocks_; ///< The blocks allocated for requests larger than a block and freed on reset.
+    unsigned int block_size_; ///< The size of each block (in bytes).
+    unsigned int block_; ///< The index of the block that memory is currently allocated from.
+    unsigned int offset_; ///< The offset of the first free byte in the current block.
+
+public:
+    ValuePool( unsigned int block_size );
+    ~ValuePool();
+    void* allocate( unsigned int size );
+    void reset();
+};
+
+}
+
+#endif
@@ -8,17 +8,22 @@
 #include "Renderer.hpp"
 #include "Value.hpp"
 #include "Shader.hpp"
+#include "NativeShader.hpp"
+#include "NativeVirtualMachine.hpp"
 #include "Symbol.hpp"
 #include "Texture.hpp"
 #include "Grid.hpp"
 #include "Light.hpp"
 #include <reyes/reyes_virtual_machine/Instruction.hpp>
+#include <reyes/reyes_virtual_machine/Operation.hpp>
 #include <reyes/reyes_virtual_machine/color_functions.hpp>
 #include <reyes/reyes_virtual_machine/add.hpp>
 #include <reyes/reyes_virtual_machine/subtract.hpp>
 #include <reyes/reyes_virtual_machine/multiply.hpp>
 #include <reyes/reyes_virtual_machine/divide.hpp>
 #include <reyes/reyes_virtual_machine/dot.hpp>
+#include <reyes/reyes_virtual_machine/normalize.hpp>
+#include <reyes/reyes_virtual_machine/geometric_functions.hpp>
 #include <reyes/reyes_virtual_machine/negate.hpp>
 #include <reyes/reyes_virtual_machine/equal.hpp>
 #include <reyes/reyes_virtual_machine/not_equal.hpp>
@@ -48,11 +53,13 @@
 #include "assert.hpp"
 #include <algorithm>
 #include <limits.h>
+#include <math.h>
 
 using std::max;
+using std::min;
 using std::swap;
 using std::make_pair;
-using std::map;
+using std::pair;
 using std::string;
 using std::vector;
 using std::shared_ptr;
@@ -65,12 +72,11 @@ VirtualMachine::VirtualMachine()
   shader_( NULL ),
   values_(),
   registers_(),
-  register_index_( 0 ),
   light_index_( INT_MAX ),
-  code_begin_( NULL ),
-  code_end_( NULL ),
-  masks_(),
-  code_( NULL )
+  operations_begin_( NULL ),
+  operations_end_( NULL ),
+  operation_( NULL ),
+  masks_()
 {
 }
 
@@ -80,12 +86,11 @@ VirtualMachine::VirtualMachine( const Renderer& renderer )
   shader_( NULL ),
   values_(),
   registers_(),
-  register_index_( 0 ),
   light_index_( INT_MAX ),
-  code_begin_( NULL ),
-  code_end_( NULL ),
-  masks_(),
-  code_( NULL )
+  operations_begin_( NULL ),
+  operations_end_( NULL ),
+  operation_( NULL ),
+  masks_()
 {
 }
 
@@ -104,12 +109,21 @@ void VirtualMachine::initialize( Grid& parameters, Shader& shader )
     {
         const shared_ptr<Symbol>& symbol = symbols[i];
         REYES_ASSERT( symbol );
-        parameters.add_value( symbol->identifier(), symbol->type() );
+        parameters.add_parameter( symbol->identifier(), symbol->type() );
     }
 
-    construct( shader.initialize_address(), shader.shade_address() );
+    construct( shader.initialize_operation(), shader.shade_operation() );
     initialize_registers( parameters );
-    execute();
+    const NativeShader* native_shader = shader.native_shader();
+    if ( native_shader )
+    {
+        NativeVirtualMachine native_virtual_machine( *this );
+        (*native_shader->initialize)( native_virtual_machine );
+    }
+    else
+    {
+        execute();
+    }
     
     shader_ = NULL;
     grid_ = NULL;
@@ -120,26 +134,337 @@ void VirtualMachine::shade( Grid& globals, Grid& parameters, Shader& shader )
     grid_ = &globals;
     shader_ = &shader;
     
-    construct( shader.shade_address(), shader.end_address() );
-    initialize_registers( parameters );
+    construct( shader.shade_operation(), shader.end_operation() );
+    initialize_parameter_registers( parameters );
     initialize_registers( globals );
-    execute();
+    const NativeShader* native_shader = shader.native_shader();
+    if ( native_shader )
+    {
+        NativeVirtualMachine native_virtual_machine( *this );
+        (*native_shader->shade)( native_virtual_machine );
+    }
+    else
+    {
+        execute();
+    }
     
     shader_ = NULL;
     grid_ = NULL;
 }
 
+/**
+// Decode the byte code generated for a shader into operations.
+//
+// Decoding is done once when a shader is created and the resulting 
+// operations are shared by every virtual machine that executes that 
+// shader.  The registers that instructions implicitly allocate for their
+// results are assigned here by replaying the allocation that the code 
+// generator did, reset instructions only redirect that allocation and are 
+// dropped.  Jump distances are converted into the indices of the 
+// operations that they land on.  Finally the calls to normalize() whose
+// results are stored in planes are chosen (see 
+// VirtualMachine::decode_planes()).
+//
+// @param shader
+//  The shader to decode the byte code of.
+//
+// @param operations
+//  The vector to decode operations into (assumed not null).
+*/
+void VirtualMachine::decode( const Shader& shader, std::vector<Operation>* operations )
+{
+    REYES_ASSERT( operations );
+
+    struct InstructionFormat
+    {
+        int instruction;
+        Operation::Handler handler;
+        int arguments;
+        bool result;
+        bool jump;
+    };
+
+    static const InstructionFormat INSTRUCTION_FORMATS [INSTRUCTION_COUNT] =
+    {
+        { INSTRUCTION_NULL, NULL, 0, false, false },
+        { INSTRUCTION_HALT, &VirtualMachine::execute_halt, 0, false, false },
+        { INSTRUCTION_RESET, NULL, 1, false, false },
+        { INSTRUCTION_CLEAR_MASK, &VirtualMachine::execute_clear_mask, 0, false, false },
+        { INSTRUCTION_GENERATE_MASK, &VirtualMachine::execute_generate_mask, 1, false, false },
+        { INSTRUCTION_INVERT_MASK, &VirtualMachine::execute_invert_mask, 0, false, false },
+        { INSTRUCTION_JUMP_EMPTY, &VirtualMachine::execute_jump_empty, 1, false, true },
+        { INSTRUCTION_JUMP_NOT_EMPTY, &VirtualMachine::execute_jump_not_empty, 1, false, true },
+        { INSTRUCTION_JUMP_ILLUMINANCE, &VirtualMachine::execute_jump_illuminance, 1, false, true },
+        { INSTRUCTION_JUMP, &VirtualMachine::execute_jump, 1, false, true },
+        { INSTRUCTION_TRANSFORM_POINT, &VirtualMachine::execute_transform_point, 2, true, false },
+        { INSTRUCTION_TRANSFORM_VECTOR, &VirtualMachine::execute_transform_vector, 2, true, false },
+        { INSTRUCTION_TRANSFORM_NORMAL, &VirtualMachine::execute_transform_normal, 2, true, false },
+        { INSTRUCTION_TRANSFORM_COLOR, &VirtualMachine::execute_transform_color, 2, true, false },
+        { INSTRUCTION_TRANSFORM_MATRIX, &VirtualMachine::execute_transform_matrix, 2, true, false },
+        { INSTRUCTION_DOT, &VirtualMachine::execute_dot, 2, true, false },
+        { INSTRUCTION_MULTIPLY, &VirtualMachine::execute_multiply, 2, true, false },
+        { INSTRUCTION_DIVIDE, &VirtualMachine::execute_divide, 2, true, false },
+        { INSTRUCTION_ADD, &VirtualMachine::execute_add, 2, true, false },
+        { INSTRUCTION_SUBTRACT, &VirtualMachine::execute_subtract, 2, true, false },
+        { INSTRUCTION_GREATER, &VirtualMachine::execute_greater, 2, true, false },
+        { INSTRUCTION_GREATER_EQUAL, &VirtualMachine::execute_greater_equal, 2, true, false },
+        { INSTRUCTION_LESS, &VirtualMachine::execute_less, 2, true, false },
+        { INSTRUCTION_LESS_EQUAL, &VirtualMachine::execute_less_equal, 2, true, false },
+        { INSTRUCTION_AND, &VirtualMachine::execute_and, 2, true, false },
+        { INSTRUCTION_OR, &VirtualMachine::execute_or, 2, true, false },
+        { INSTRUCTION_EQUAL, &VirtualMachine::execute_equal, 2, true, false },
+        { INSTRUCTION_NOT_EQUAL, &VirtualMachine::execute_not_equal, 2, true, false },
+        { INSTRUCTION_NEGATE, &VirtualMachine::execute_negate, 1, true, false },
+        { INSTRUCTION_CONVERT, &VirtualMachine::execute_convert, 1, true, false },
+        { INSTRUCTION_PROMOTE, &VirtualMachine::execute_promote, 1, true, false },
+        { INSTRUCTION_ASSIGN, &VirtualMachine::execute_assign, 2, false, false },
+        { INSTRUCTION_ASSIGN_STRING, &VirtualMachine::execute_assign_string, 2, false, false },
+        { INSTRUCTION_ADD_ASSIGN, &VirtualMachine::execute_add_assign, 2, false, false },
+        { INSTRUCTION_SUBTRACT_ASSIGN, &VirtualMachine::execute_subtract_assign, 2, false, false },
+        { INSTRUCTION_MULTIPLY_ASSIGN, &VirtualMachine::execute_multiply_assign, 2, false, false },
+        { INSTRUCTION_DIVIDE_ASSIGN, &VirtualMachine::execute_divide_assign, 2, false, false },
+        { INSTRUCTION_FLOAT_TEXTURE, &VirtualMachine::execute_float_texture, 3, true, false },
+        { INSTRUCTION_VEC3_TEXTURE, &VirtualMachine::execute_vec3_texture, 3, true, false },
+        { INSTRUCTION_FLOAT_ENVIRONMENT, &VirtualMachine::execute_float_environment, 2, true, false },
+        { INSTRUCTION_VEC3_ENVIRONMENT, &VirtualMachine::execute_vec3_environment, 2, true, false },
+        { INSTRUCTION_SHADOW, &VirtualMachine::execute_shadow, 3, true, false },
+        { INSTRUCTION_CALL_0, &VirtualMachine::execute_call_0, 1, true, false },
+        { INSTRUCTION_CALL_1, &VirtualMachine::execute_call_1, 2, true, false },
+        { INSTRUCTION_CALL_2, &VirtualMachine::execute_call_2, 3, true, false },
+        { INSTRUCTION_CALL_3, &VirtualMachine::execute_call_3, 4, true, false },
+        { INSTRUCTION_CALL_4, &VirtualMachine::execute_call_4, 5, true, false },
+        { INSTRUCTION_CALL_5, &VirtualMachine::execute_call_5, 6, true, false },
+        { INSTRUCTION_AMBIENT, &VirtualMachine::execute_ambient, 2, false, false },
+        { INSTRUCTION_SOLAR, &VirtualMachine::execute_solar_axis_angle, 0, false, false },
+        { INSTRUCTION_SOLAR_AXIS_ANGLE, &VirtualMachine::execute_solar_axis_angle, 4, false, false },
+        { INSTRUCTION_ILLUMINATE, &VirtualMachine::execute_illuminate, 5, false, false },
+        { INSTRUCTION_ILLUMINATE_AXIS_ANGLE, &VirtualMachine::execute_illuminate_axis_angle, 7, false, false },
+        { INSTRUCTION_ILLUMINANCE_AXIS_ANGLE, &VirtualMachine::execute_illuminance_axis_angle, 6, true, false }
+    };
+
+    const vector<unsigned char>& code = shader.code();
+    const int size = int(code.size());
+    vector<int> operation_indices( size + 1, -1 );
+    vector<pair<int, int>> jumps;
+    vector<pair<int, int>> resets;
+    operations->clear();
+
+    int register_index = shader.permanent_registers();
+    int address = 0;
+    while ( address < size )
+    {
+        // The initialize and shade fragments are each executed from a fresh 
+        // register allocation.
+        if ( address == shader.initialize_address() || address == shader.shade_address() )
+        {
+            register_index = shader.permanent_registers();
+            resets.push_back( make_pair(int(operations->size()), register_index) );
+        }
+
+        operation_indices[address] = int(operations->size());
+        REYES_ASSERT( address + 2 * int(sizeof(short)) <= size );
+        const int instruction = *reinterpret_cast<const short*>( &code[address] );
+        const int dispatch = *reinterpret_cast<const short*>( &code[address + sizeof(short)] );
+        REYES_ASSERT( instruction > INSTRUCTION_NULL && instruction < INSTRUCTION_COUNT );
+        const InstructionFormat& format = INSTRUCTION_FORMATS[instruction];
+        REYES_ASSERT( format.instruction == instruction );
+
+        Operation operation;
+        operation.handler = format.handler;
+        operation.instruction = instruction;
+        operation.dispatch = dispatch;
+        operation.address = address;
+        operation.result = -1;
+        operation.target = -1;
+        operation.planes = false;
+        address += 2 * sizeof(short);
+        for ( int i = 0; i < OPERATION_ARGUMENTS; ++i )
+        {
+            operation.arguments[i] = 0;
+        }
+        for ( int i = 0; i < format.arguments; ++i )
+        {
+            REYES_ASSERT( address + int(sizeof(int)) <= size );
+            operation.arguments[i] = *reinterpret_cast<const int*>( &code[address] );
+            address += sizeof(int);
+        }
+
+        if ( instruction == INSTRUCTION_RESET )
+        {
+            register_index = operation.arguments[0];
+            resets.push_back( make_pair(int(operations->size()), register_index) );
+            continue;
+        }
+
+        if ( format.result )
+        {
+            operation.result = register_index;
+            ++register_index;
+        }
+
+        // Jump distances are relative to the end of the jump instruction.
+        if ( format.jump )
+        {
+            jumps.push_back( make_pair(int(operations->size()), address + operation.arguments[0]) );
+        }
+        operations->push_back( operation );
+    }
+    operation_indices[size] = int(operations->size());
+
+    for ( vector<pair<int, int>>::const_iterator i = jumps.begin(); i != jumps.end(); ++i )
+    {
+        REYES_ASSERT( i->second >= 0 && i->second <= size );
+        REYES_ASSERT( operation_indices[i->second] >= 0 );
+        (*operations)[i->first].target = operation_indices[i->second];
+    }
+
+    decode_planes( shader, resets, operations );
+}
+
+/**
+// Check that the result of the operation at \e index is only read by dot 
+// products and planar normalize() calls, the operations that read planes.
+//
+// Reads are searched for until the result's register is reset or written 
+// again.  A jump before then could lead to reads anywhere so the search 
+// fails at jumps.
+//
+// @param operations
+//  The operations of the shader.
+//
+// @param freed
+//  The lowest register reset before each operation or INT_MAX if no reset
+//  precedes that operation.
+//
+// @param planar
+//  Whether or not each operation is still considered to leave its result 
+//  in planes.
+//
+// @param index
+//  The index of the operation whose result is checked.
+//
+// @param mark
+//  True to mark the operations that read the result as reading planes.
+//
+// @return
+//  True if the result is only read by operations that read planes.
+*/
+static bool read_as_planes( vector<Operation>& operations, const vector<int>& freed, const vector<bool>& planar, int index, bool mark )
+{
+    const int count = int(operations.size());
+    const int result = operations[index].result;
+    for ( int i = index + 1; i < count && freed[i] > result; ++i )
+    {
+        // The first argument of a call is the symbol of the function called
+        // rather than a register.
+        Operation& operation = operations[i];
+        const int first = operation.instruction >= INSTRUCTION_CALL_0 && operation.instruction <= INSTRUCTION_CALL_5 ? 1 : 0;
+        for ( int j = first; j < OPERATION_ARGUMENTS; ++j )
+        {
+            if ( operation.arguments[j] == result )
+            {
+                if ( operation.instruction != INSTRUCTION_DOT && !(planar[i] && j == 1) )
+                {
+                    return false;
+                }
+                operation.planes = operation.planes || mark;
+            }
+        }
+        if ( operation.target >= 0 )
+        {
+            return false;
+        }
+        if ( operation.result == result )
+        {
+            break;
+        }
+    }
+    return true;
+}
+
+/**
+// Choose the calls to normalize() that leave their results in planes (see
+// Value::reset_planes()).
+//
+// A call's result is stored in planes when it is a temporary that is only 
+// read by dot products and other planar calls to normalize().  Calls whose
+// results are read by anything else are removed until no more are removed 
+// so that planar values never reach operations that expect interleaved 
+// values.  The remaining calls are executed by 
+// VirtualMachine::execute_normalize_planes().
+//
+// @param shader
+//  The shader that \e operations were decoded from.
+//
+// @param resets
+//  The index of each operation preceded by a reset and the register that 
+//  allocation was reset to.
+//
+// @param operations
+//  The decoded operations (assumed not null).
+*/
+void VirtualMachine::decode_planes( const Shader& shader, const std::vector<std::pair<int, int>>& resets, std::vector<Operation>* operations )
+{
+    REYES_ASSERT( operations );
+
+    const int count = int(operations->size());
+    vector<int> freed( count + 1, INT_MAX );
+    for ( vector<pair<int, int>>::const_iterator i = resets.begin(); i != resets.end(); ++i )
+    {
+        freed[i->first] = min( freed[i->first], i->second );
+    }
+
+    typedef void (*FunctionType)( const Renderer&, const Grid&, Value*, Value* );
+    const FunctionType normalize_function = &reyes::normalize;
+    const vector<shared_ptr<Symbol>>& symbols = shader.symbols();
+    vector<bool> planar( count, false );
+    for ( int i = 0; i < count; ++i )
+    {
+        const Operation& operation = (*operations)[i];
+        if ( operation.instruction == INSTRUCTION_CALL_1 && operation.result >= shader.permanent_registers() )
+        {
+            const Symbol* symbol = symbols[operation.arguments[0]].get();
+            planar[i] = symbol->function() == reinterpret_cast<void*>( normalize_function );
+        }
+    }
+
+    bool removed = true;
+    while ( removed )
+    {
+        removed = false;
+        for ( int i = 0; i < count; ++i )
+        {
+            if ( planar[i] && !read_as_planes(*operations, freed, planar, i, false) )
+            {
+                planar[i] = false;
+                removed = true;
+            }
+        }
+    }
+
+    for ( int i = 0; i < count; ++i )
+    {
+        if ( planar[i] )
+        {
+            Operation& operation = (*operations)[i];
+            operation.handler = &VirtualMachine::execute_normalize_planes;
+            operation.planes = true;
+            read_as_planes( *operations, freed, planar, i, true );
+        }
+    }
+}
+
 void VirtualMachine::construct( int start, int finish )
 {
     REYES_ASSERT( shader_ );
-    REYES_ASSERT( !shader_->code().empty() );
-    REYES_ASSERT( start >= 0 && start <= int(shader_->code().size()) );
-    REYES_ASSERT( finish >= 0 && finish <= int(shader_->code().size()) );
+    REYES_ASSERT( !shader_->operations().empty() );
+    REYES_ASSERT( start >= 0 && start <= int(shader_->operations().size()) );
+    REYES_ASSERT( finish >= 0 && finish <= int(shader_->operations().size()) );
     REYES_ASSERT( start <= finish );
 
-    code_begin_ = &shader_->code().front() + start;
-    code_end_ = &shader_->code().front() + finish;
-    register_index_ = shader_->permanent_registers();
+    operations_begin_ = &shader_->operations().front();
+    operations_end_ = operations_begin_ + finish;
+    operation_ = operations_begin_ + start;
     
     values_.reserve( shader_->registers() );
     while ( values_.size() < shader_->registers() )
@@ -150,22 +475,21 @@ void VirtualMachine::construct( int start, int finish )
     
     registers_.clear();
     registers_.reserve( shader_->registers() );
-    registers_.insert( registers_.end(), max(shader_->registers() - int(registers_.size()), 0), shared_ptr<Value>() );
+    registers_.insert( registers_.end(), max(shader_->registers() - int(registers_.size()), 0), (Value*) NULL );
 
     // Initialize registers for constants.
     REYES_ASSERT( shader_->constants() == int(shader_->values().size()) );
     unsigned int register_index = 0;
     while ( register_index < shader_->values().size() )
     {
-        shared_ptr<Value>& value = values_[register_index];
-        registers_[register_index] = shader_->values()[register_index];
+        registers_[register_index] = shader_->values()[register_index].get();
         ++register_index;
     }
        
     // Initialize registers for global, local, and temporary values.
     while ( register_index < shader_->registers() )
     {
-        registers_[register_index] = values_[register_index];
+        registers_[register_index] = values_[register_index].get();
         ++register_index;
     }
 
@@ -178,375 +502,135 @@ void VirtualMachine::construct( int start, int finish )
     masks_.reserve( MASKS_RESERVE );
 }
 
-void VirtualMachine::initialize_registers( Grid& grid )
+void VirtualMachine::initialize_parameter_registers( Grid& parameters )
 {
-    const map<string, shared_ptr<Value>>& values = grid.values_by_identifier();
-    for ( map<string, shared_ptr<Value>>::const_iterator i = values.begin(); i != values.end(); ++i )
+    // Parameters are added to their grid in symbol order by 
+    // VirtualMachine::initialize() so the slot of the parameter with symbol 
+    // index i is the i-th parameter slot recorded in that grid.
+    const vector<shared_ptr<Symbol>>& symbols = shader_->symbols();
+    const vector<int>& parameter_slots = parameters.parameter_slots();
+    int parameters_count = std::min( shader_->parameters(), int(parameter_slots.size()) );
+    for ( int i = 0; i < parameters_count; ++i )
     {
-        Symbol* symbol = shader_->find_symbol( i->first ).get();
-        if ( symbol )
+        const shared_ptr<Value>& value = parameters.values()[parameter_slots[i]];
+        if ( value )
         {
-            registers_[symbol->register_index()] = i->second;
+            registers_[symbols[i]->register_index()] = value.get();
         }
     }
 }
 
-void VirtualMachine::execute()
+void VirtualMachine::initialize_registers( Grid& grid )
 {
-    REYES_ASSERT( code_begin_ );
-    REYES_ASSERT( code_end_ );
-    REYES_ASSERT( code_begin_ <= code_end_ );
-    
-    code_ = code_begin_;
-    while ( code_ < code_end_ )
+    const vector<shared_ptr<Value>>& values = grid.values();
+    const vector<pair<int, int>>& global_bindings = shader_->global_bindings();
+    for ( vector<pair<int, int>>::const_iterator i = global_bindings.begin(); i != global_bindings.end(); ++i )
     {
-        switch ( instruction() )
+        const shared_ptr<Value>& value = values[i->first];
+        if ( value )
         {
-            case INSTRUCTION_HALT:    
-                execute_halt();
-                break;                
-
-            case INSTRUCTION_RESET:
-                execute_reset();
-                break;
-                
-            case INSTRUCTION_CLEAR_MASK:
-                execute_clear_mask();
-                break;
-            
-            case INSTRUCTION_GENERATE_MASK:
-                execute_generate_mask();
-                break;
-                
-            case INSTRUCTION_INVERT_MASK:
-                execute_invert_mask();
-                break;
-                
-            case INSTRUCTION_JUMP_EMPTY:
-                execute_jump_empty();
-                break;
-            
-            case INSTRUCTION_JUMP_NOT_EMPTY:
-                execute_jump_not_empty();
-                break;
-            
-            case INSTRUCTION_JUMP_ILLUMINANCE:
-                execute_jump_illuminance();
-                break;
-            
-            case INSTRUCTION_JUMP:
-                execute_jump();
-                break;
-            
-            case INSTRUCTION_TRANSFORM_POINT:
-                execute_transform_point();
-                break;
-                
-            case INSTRUCTION_TRANSFORM_VECTOR:
-                execute_transform_vector();
-                break;
-                
-            case INSTRUCTION_TRANSFORM_NORMAL:
-                execute_transform_normal();
-                break;
-                
-            case INSTRUCTION_TRANSFORM_COLOR:
-                execute_transform_color();
-                break;
-                
-            case INSTRUCTION_TRANSFORM_MATRIX:
-                execute_transform_matrix();
-                break;
-                
-            case INSTRUCTION_DOT:
-                execute_dot();
-                break;
-                
-            case INSTRUCTION_MULTIPLY:
-                execute_multiply();
-                break;
-                
-            case INSTRUCTION_DIVIDE:
-                execute_divide();
-                break;
-                
-            case INSTRUCTION_ADD:
-                execute_add();
-                break;
-            
-            case INSTRUCTION_SUBTRACT:
-                execute_subtract();
-                break;
-            
-            case INSTRUCTION_GREATER:
-                execute_greater();
-                break;
-            
-            case INSTRUCTION_GREATER_EQUAL:
-                execute_greater_equal();
-                break;
-            
-            case INSTRUCTION_LESS:
-                execute_less();
-                break;
-            
-            case INSTRUCTION_LESS_EQUAL:
-                execute_less_equal();
-                break;
-            
-            case INSTRUCTION_AND:
-                execute_and();
-                break;
-            
-            case INSTRUCTION_OR:
-                execute_or();
-                break;
-            
-            case INSTRUCTION_EQUAL:
-                execute_equal();
-                break;
-            
-            case INSTRUCTION_NOT_EQUAL:
-                execute_not_equal();
-                break;
-                        
-            case INSTRUCTION_NEGATE:
-                execute_negate();
-                break;
-                
-            case INSTRUCTION_CONVERT:
-                execute_convert();
-                break;
-
-            case INSTRUCTION_PROMOTE:
-                execute_promote();
-                break;
-            
-            case INSTRUCTION_ASSIGN:
-                execute_assign();
-                break;
-                        
-            case INSTRUCTION_ASSIGN_STRING:
-                execute_assign_string();
-                break;
-            
-            case INSTRUCTION_ADD_ASSIGN:
-                execute_add_assign();
-                break;
-            
-            case INSTRUCTION_MULTIPLY_ASSIGN:
-                execute_multiply_assign();
-                break;
-            
-            case INSTRUCTION_DIVIDE_ASSIGN:
-                execute_divide_assign();
-                break;
-            
-            case INSTRUCTION_FLOAT_TEXTURE:
-                execute_float_texture();
-                break;
-            
-            case INSTRUCTION_VEC3_TEXTURE:
-                execute_vec3_texture();
-                break;
-            
-            case INSTRUCTION_FLOAT_ENVIRONMENT:
-                execute_float_environment();
-                break;
-            
-            case INSTRUCTION_VEC3_ENVIRONMENT:
-                execute_vec3_environment();
-                break;
-            
-            case INSTRUCTION_SHADOW:
-                execute_shadow();
-                break;
-                
-            case INSTRUCTION_CALL_0:
-                execute_call_0();
-                break;
-                
-            case INSTRUCTION_CALL_1:
-                execute_call_1();
-                break;
-                
-            case INSTRUCTION_CALL_2:
-                execute_call_2();
-                break;
-            
-            case INSTRUCTION_CALL_3:
-                execute_call_3();
-                break;
-
-            case INSTRUCTION_CALL_4:
-                execute_call_4();
-                break;
-
-            case INSTRUCTION_CALL_5:
-                execute_call_5();                
-                break;
-
-            case INSTRUCTION_AMBIENT:
-                execute_ambient();
-                break;
-            
-            case INSTRUCTION_SOLAR:
-            case INSTRUCTION_SOLAR_AXIS_ANGLE:
-                execute_solar_axis_angle();
-                break;
-            
-            case INSTRUCTION_ILLUMINATE:
-                execute_illuminate();
-                break;
-
-            case INSTRUCTION_ILLUMINATE_AXIS_ANGLE:
-                execute_illuminate_axis_angle();
-                break;
-            
-            case INSTRUCTION_ILLUMINANCE_AXIS_ANGLE:
-                execute_illuminance_axis_angle();
-                break;
-
-            default:    
-                REYES_ASSERT( false );
-                execute_halt();
-                break;                
+            registers_[i->second] = value.get();
         }
     }
-}
 
-void VirtualMachine::jump_illuminance( int distance )
-{
-    const int lights = int(grid_->lights().size());
-    if ( light_index_ < lights )    
-    {
-        ++light_index_;        
-    }
-    else
-    {
-        light_index_ = 0;
-    }
-    
-    while ( light_index_ < lights && grid_->get_light(light_index_)->type() == LIGHT_AMBIENT )
+    // Values other than the standard globals are rare outside of tests and 
+    // are still bound by looking up their identifiers.
+    for ( int slot = GRID_SLOT_COUNT; slot < grid.slots(); ++slot )
     {
-        ++light_index_;
-    }
-    
-    if ( light_index_ >= lights )
-    {
-        light_index_ = INT_MAX;
-        jump( distance );
+        Symbol* symbol = values[slot] ? shader_->find_symbol( grid.identifier(slot) ).get() : NULL;
+        if ( symbol )
+        {
+            registers_[symbol->register_index()] = values[slot].get();
+        }
     }
 }
 
-void VirtualMachine::jump( int distance )
-{
-    REYES_ASSERT( code_ + distance >= code_begin_ && code_ + distance < code_end_ );
-    code_ += distance;
-}
-
-int VirtualMachine::instruction()
-{
-    return word();
-}
-
-int VirtualMachine::argument()
+void VirtualMachine::execute()
 {
-    return quad();
-}
+    REYES_ASSERT( operations_begin_ );
+    REYES_ASSERT( operations_end_ );
+    REYES_ASSERT( operation_ && operation_ <= operations_end_ );
 
-int VirtualMachine::word()
-{
-    REYES_ASSERT( code_ );
-    REYES_ASSERT( code_end_ );
-    REYES_ASSERT( code_ < code_end_ );
-    int value = *(const short*) code_;
-    code_ += sizeof(short);
-    return value;
+    // Operations are executed by calling their handlers directly, operands
+    // and jump targets were resolved when the shader was decoded.  The 
+    // operation pointer is advanced before the handler is called so that 
+    // jumps and halts can simply overwrite it.
+    while ( operation_ < operations_end_ )
+    {
+        const Operation* operation = operation_;
+        ++operation_;
+        (this->*operation->handler)( *operation );
+    }
 }
 
-int VirtualMachine::quad()
+void VirtualMachine::jump_illuminance( int target )
 {
-    REYES_ASSERT( code_ );
-    REYES_ASSERT( code_end_ );
-    REYES_ASSERT( code_ < code_end_ );
-    int value = *(const int*) code_;
-    code_ += sizeof(int);
-    return value;
+    if ( !next_light() )
+    {
+        jump( target );
+    }
 }
 
-void VirtualMachine::execute_halt()
+void VirtualMachine::jump( int target )
 {
-    code_ = code_end_;
+    REYES_ASSERT( operations_begin_ + target >= operations_begin_ && operations_begin_ + target < operations_end_ );
+    operation_ = operations_begin_ + target;
 }
 
-void VirtualMachine::execute_reset()
+void VirtualMachine::execute_halt( const Operation& /*operation*/ )
 {
-    word();
-    int index = argument();
-    reset_register( index );
+    operation_ = operations_end_;
 }
 
-void VirtualMachine::execute_clear_mask()
+void VirtualMachine::execute_clear_mask( const Operation& /*operation*/ )
 {
-    word();
     pop_mask();
 }
 
-void VirtualMachine::execute_generate_mask()
+void VirtualMachine::execute_generate_mask( const Operation& operation )
 {
-    word();
-    int mask = argument();
+    int mask = operation.arguments[0];
     push_mask( registers_[mask] );
 }
 
-void VirtualMachine::execute_invert_mask()
+void VirtualMachine::execute_invert_mask( const Operation& /*operation*/ )
 {
-    word();
     invert_mask();
 }
 
-void VirtualMachine::execute_jump_empty()
+void VirtualMachine::execute_jump_empty( const Operation& operation )
 {
-    word();
-    int distance = argument();
     if ( mask_empty() )
     {
-        jump( distance );
+        jump( operation.target );
         pop_mask();
     }
 }
 
-void VirtualMachine::execute_jump_not_empty()
+void VirtualMachine::execute_jump_not_empty( const Operation& operation )
 {
-    word();
-    int distance = argument();
     if ( !mask_empty() )
     {
-        jump( distance );
+        jump( operation.target );
     }
 }
 
-void VirtualMachine::execute_jump_illuminance()
+void VirtualMachine::execute_jump_illuminance( const Operation& operation )
 {
-    word();
-    int distance = argument();
-    jump_illuminance( distance );
+    jump_illuminance( operation.target );
 }
 
-void VirtualMachine::execute_jump()
+void VirtualMachine::execute_jump( const Operation& operation )
 {
-    word();
-    int distance = argument();
-    jump( distance );
+    jump( operation.target );
 }
 
-void VirtualMachine::execute_transform_point()
+void VirtualMachine::execute_transform_point( const Operation& operation )
 {
-    int dispatch = word();
-    const shared_ptr<Value>& result = registers_[allocate_register()];
-    const shared_ptr<Value>& fromspace = registers_[argument()];
-    const shared_ptr<Value>& point = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* fromspace = registers_[operation.arguments[0]];
+    Value* point = registers_[operation.arguments[1]];
     REYES_ASSERT( renderer_ );
     result->reset( point->type(), point->storage(), point->size() );
     transform( 
@@ -558,12 +642,12 @@ void VirtualMachine::execute_transform_point()
     );
 }
 
-void VirtualMachine::execute_transform_vector()
+void VirtualMachine::execute_transform_vector( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& fromspace = registers_[argument()];
-    const shared_ptr<Value>& vector = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* fromspace = registers_[operation.arguments[0]];
+    Value* vector = registers_[operation.arguments[1]];
     REYES_ASSERT( renderer_ );
     result->reset( vector->type(), vector->storage(), vector->size() );
     vtransform( 
@@ -575,12 +659,12 @@ void VirtualMachine::execute_transform_vector()
     );
 }
 
-void VirtualMachine::execute_transform_normal()
+void VirtualMachine::execute_transform_normal( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& fromspace = registers_[argument()];
-    const shared_ptr<Value>& normal = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* fromspace = registers_[operation.arguments[0]];
+    Value* normal = registers_[operation.arguments[1]];
     REYES_ASSERT( renderer_ );
     result->reset( normal->type(), normal->storage(), normal->size() );
     ntransform( 
@@ -592,12 +676,12 @@ void VirtualMachine::execute_transform_normal()
     );
 }
 
-void VirtualMachine::execute_transform_color()
+void VirtualMachine::execute_transform_color( const Operation& operation )
 {
-    int dispatch = word();
-    const shared_ptr<Value>& result = registers_[allocate_register()];
-    const shared_ptr<Value>& fromspace = registers_[argument()];
-    const shared_ptr<Value>& color = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* fromspace = registers_[operation.arguments[0]];
+    Value* color = registers_[operation.arguments[1]];
     result->reset( TYPE_COLOR, color->storage(), color->size() );
     ctransform( 
         color->size() == 1 ? DISPATCH_U3 : DISPATCH_V3,
@@ -608,12 +692,12 @@ void VirtualMachine::execute_transform_color()
     );
 }
 
-void VirtualMachine::execute_transform_matrix()
+void VirtualMachine::execute_transform_matrix( const Operation& operation )
 {
-    int dispatch = word();
-    const shared_ptr<Value>& result = registers_[allocate_register()];
-    const shared_ptr<Value>& tospace = registers_[argument()];
-    const shared_ptr<Value>& matrix = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* tospace = registers_[operation.arguments[0]];
+    Value* matrix = registers_[operation.arguments[1]];
     REYES_ASSERT( renderer_ );
     result->reset( TYPE_MATRIX, matrix->storage(), matrix->size() );
     mtransform( 
@@ -625,14 +709,38 @@ void VirtualMachine::execute_transform_matrix()
     );
 }
 
-void VirtualMachine::execute_dot()
+void VirtualMachine::execute_dot( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& lhs = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* lhs = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
     const unsigned int length = max( lhs->size(), rhs->size() );
     result->reset( TYPE_FLOAT, max(lhs->storage(), rhs->storage()), length );
+
+    // Dot products are symmetric so operands are swapped to leave a planar
+    // operand on the left hand side.
+    if ( lhs->planar() || rhs->planar() )
+    {
+        if ( !lhs->planar() )
+        {
+            swap( lhs, rhs );
+        }
+        if ( rhs->planar() )
+        {
+            dot_p3p3( result->float_values(), lhs->plane(0), lhs->plane_stride(), rhs->plane(0), rhs->plane_stride(), length );
+        }
+        else if ( rhs->storage() == STORAGE_VARYING )
+        {
+            dot_p3v3( result->float_values(), lhs->plane(0), lhs->plane_stride(), reinterpret_cast<const float*>(rhs->values()), length );
+        }
+        else
+        {
+            dot_p3u3( result->float_values(), lhs->plane(0), lhs->plane_stride(), reinterpret_cast<const float*>(rhs->values()), length );
+        }
+        return;
+    }
+
     dot( 
         dispatch, 
         reinterpret_cast<float*>(result->values()),
@@ -642,12 +750,41 @@ void VirtualMachine::execute_dot()
     );
 }
 
-void VirtualMachine::execute_multiply()
+/**
+// Execute a call to normalize() whose result is only read by operations 
+// that read planes (see VirtualMachine::decode_planes()).
+//
+// Varying results are stored in planes, uniform results are left to the 
+// normalize() built-in function.
+*/
+void VirtualMachine::execute_normalize_planes( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& lhs = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
+    Value* result = registers_[operation.result];
+    Value* n = registers_[operation.arguments[1]];
+    if ( n->storage() != STORAGE_VARYING )
+    {
+        execute_call_1( operation );
+        return;
+    }
+
+    const unsigned int length = n->size();
+    result->reset_planes( n->type(), n->storage(), length );
+    if ( n->planar() )
+    {
+        normalize_p3p3( result->plane(0), result->plane_stride(), n->plane(0), n->plane_stride(), length );
+    }
+    else
+    {
+        normalize_p3v3( result->plane(0), result->plane_stride(), reinterpret_cast<const float*>(n->values()), length );
+    }
+}
+
+void VirtualMachine::execute_multiply( const Operation& operation )
+{
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* lhs = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
     result->reset( lhs->type(), max(lhs->storage(), rhs->storage()), lhs->size() );
     multiply( 
         dispatch, 
@@ -658,12 +795,12 @@ void VirtualMachine::execute_multiply()
     );
 }
 
-void VirtualMachine::execute_divide()
+void VirtualMachine::execute_divide( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& lhs = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* lhs = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
     result->reset( lhs->type(), max(lhs->storage(), rhs->storage()), lhs->size() );
     divide( 
         dispatch, 
@@ -674,12 +811,12 @@ void VirtualMachine::execute_divide()
     );
 }
 
-void VirtualMachine::execute_add()
+void VirtualMachine::execute_add( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& lhs = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* lhs = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
     result->reset( lhs->type(), max(lhs->storage(), rhs->storage()), lhs->size() );
     add( 
         dispatch, 
@@ -690,12 +827,12 @@ void VirtualMachine::execute_add()
     );
 }
 
-void VirtualMachine::execute_subtract()
+void VirtualMachine::execute_subtract( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& lhs = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* lhs = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
     result->reset( lhs->type(), max(lhs->storage(), rhs->storage()), lhs->size() );
     subtract( 
         dispatch,
@@ -706,12 +843,12 @@ void VirtualMachine::execute_subtract()
     );
 }
 
-void VirtualMachine::execute_greater()
+void VirtualMachine::execute_greater( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& lhs = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* lhs = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
     result->reset( TYPE_INTEGER, max(lhs->storage(), rhs->storage()), lhs->size() );
     greater(
         dispatch,
@@ -722,12 +859,12 @@ void VirtualMachine::execute_greater()
     );
 }
 
-void VirtualMachine::execute_greater_equal()
+void VirtualMachine::execute_greater_equal( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& lhs = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* lhs = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
     result->reset( TYPE_INTEGER, max(lhs->storage(), rhs->storage()), lhs->size() );
     greater_equal(
         dispatch,
@@ -738,12 +875,12 @@ void VirtualMachine::execute_greater_equal()
     );
 }
 
-void VirtualMachine::execute_less()
+void VirtualMachine::execute_less( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& lhs = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* lhs = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
     result->reset( TYPE_INTEGER, max(lhs->storage(), rhs->storage()), lhs->size() );
     less(
         dispatch,
@@ -754,12 +891,12 @@ void VirtualMachine::execute_less()
     );
 }
 
-void VirtualMachine::execute_less_equal()
+void VirtualMachine::execute_less_equal( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& lhs = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* lhs = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
     result->reset( TYPE_INTEGER, max(lhs->storage(), rhs->storage()), lhs->size() );
     less_equal(
         dispatch,
@@ -770,12 +907,12 @@ void VirtualMachine::execute_less_equal()
     );
 }
 
-void VirtualMachine::execute_and()
+void VirtualMachine::execute_and( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& lhs = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* lhs = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
     result->reset( TYPE_INTEGER, max(lhs->storage(), rhs->storage()), lhs->size() );
     logical_and( 
         dispatch,
@@ -786,12 +923,12 @@ void VirtualMachine::execute_and()
     );
 }
 
-void VirtualMachine::execute_or()
+void VirtualMachine::execute_or( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& lhs = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* lhs = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
     result->reset( TYPE_INTEGER, max(lhs->storage(), rhs->storage()), lhs->size() );
     logical_or( 
         dispatch,
@@ -802,12 +939,12 @@ void VirtualMachine::execute_or()
     );
 }
 
-void VirtualMachine::execute_equal()
+void VirtualMachine::execute_equal( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& lhs = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* lhs = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
     result->reset( lhs->type(), max(lhs->storage(), rhs->storage()), lhs->size() );
     equal(
         dispatch,
@@ -818,12 +955,12 @@ void VirtualMachine::execute_equal()
     );
 }
 
-void VirtualMachine::execute_not_equal()
+void VirtualMachine::execute_not_equal( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& lhs = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* lhs = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
     result->reset( TYPE_INTEGER, max(lhs->storage(), rhs->storage()), lhs->size() );
     not_equal( 
         dispatch,
@@ -834,18 +971,18 @@ void VirtualMachine::execute_not_equal()
     );
 }
 
-void VirtualMachine::execute_negate()
+void VirtualMachine::execute_negate( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& value = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* value = registers_[operation.arguments[0]];
     result->reset( value->type(), value->storage(), value->size() );
     negate( dispatch, reinterpret_cast<float*>(result->values()), reinterpret_cast<const float*>(value->values()), value->size() );
 }
 
-void VirtualMachine::execute_convert()
+void VirtualMachine::execute_convert( const Operation& operation )
 {
-    int dispatch = word();
+    int dispatch = operation.dispatch;
     ValueType type = TYPE_NULL;
     switch ( dispatch >> 8 )
     {
@@ -868,8 +1005,8 @@ void VirtualMachine::execute_convert()
             break;
     }    
 
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
+    Value* result = registers_[operation.result];
+    Value* rhs = registers_[operation.arguments[0]];
     result->reset( type, rhs->storage(), rhs->size() );
     convert( 
         dispatch,
@@ -879,11 +1016,11 @@ void VirtualMachine::execute_convert()
     );
 }
 
-void VirtualMachine::execute_promote()
+void VirtualMachine::execute_promote( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.result];
+    Value* rhs = registers_[operation.arguments[0]];
     result->reset( rhs->type(), STORAGE_VARYING, grid_->size() );
     promote( 
         dispatch,
@@ -893,12 +1030,12 @@ void VirtualMachine::execute_promote()
     );
 }
 
-void VirtualMachine::execute_assign()
+void VirtualMachine::execute_assign( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
-    const unsigned char* mask = rhs->storage() == STORAGE_VARYING ? get_mask() : NULL;
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
+    const uint64_t* mask = rhs->storage() == STORAGE_VARYING ? get_mask() : NULL;
     result->reset( rhs->type(), rhs->storage(), rhs->size() );
     assign(
         dispatch,
@@ -909,21 +1046,20 @@ void VirtualMachine::execute_assign()
     );
 }
 
-void VirtualMachine::execute_assign_string()
+void VirtualMachine::execute_assign_string( const Operation& operation )
 {
-    word();
-    shared_ptr<Value> result = registers_[argument()];
-    shared_ptr<Value> value = registers_[argument()];
-    const unsigned char* mask = value->storage() == STORAGE_VARYING ? get_mask() : NULL;
+    Value* result = registers_[operation.arguments[0]];
+    Value* value = registers_[operation.arguments[1]];
+    const uint64_t* mask = value->storage() == STORAGE_VARYING ? get_mask() : NULL;
     result->assign_string( value, mask );
 }
 
-void VirtualMachine::execute_add_assign()
+void VirtualMachine::execute_add_assign( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
-    const unsigned char* mask = rhs->storage() == STORAGE_VARYING ? get_mask() : NULL;
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
+    const uint64_t* mask = rhs->storage() == STORAGE_VARYING ? get_mask() : NULL;
     add_assign( 
         dispatch, 
         reinterpret_cast<float*>(result->values()),
@@ -933,12 +1069,12 @@ void VirtualMachine::execute_add_assign()
     );
 }
 
-void VirtualMachine::execute_subtract_assign()
+void VirtualMachine::execute_subtract_assign( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
-    const unsigned char* mask = rhs->storage() == STORAGE_VARYING ? get_mask() : NULL;
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
+    const uint64_t* mask = rhs->storage() == STORAGE_VARYING ? get_mask() : NULL;
     subtract_assign( 
         dispatch, 
         reinterpret_cast<float*>(result->values()),
@@ -948,12 +1084,12 @@ void VirtualMachine::execute_subtract_assign()
     );
 }
 
-void VirtualMachine::execute_multiply_assign()
+void VirtualMachine::execute_multiply_assign( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
-    const unsigned char* mask = rhs->storage() == STORAGE_VARYING ? get_mask() : NULL;
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
+    const uint64_t* mask = rhs->storage() == STORAGE_VARYING ? get_mask() : NULL;
     multiply_assign( 
         dispatch, 
         reinterpret_cast<float*>(result->values()),
@@ -963,12 +1099,12 @@ void VirtualMachine::execute_multiply_assign()
     );
 }
 
-void VirtualMachine::execute_divide_assign()
+void VirtualMachine::execute_divide_assign( const Operation& operation )
 {
-    int dispatch = word();
-    shared_ptr<Value> result = registers_[argument()];
-    const shared_ptr<Value>& rhs = registers_[argument()];
-    const unsigned char* mask = rhs->storage() == STORAGE_VARYING ? get_mask() : NULL;
+    int dispatch = operation.dispatch;
+    Value* result = registers_[operation.arguments[0]];
+    Value* rhs = registers_[operation.arguments[1]];
+    const uint64_t* mask = rhs->storage() == STORAGE_VARYING ? get_mask() : NULL;
     divide_assign( 
         dispatch, 
         reinterpret_cast<float*>(result->values()),
@@ -978,233 +1114,217 @@ void VirtualMachine::execute_divide_assign()
     );
 }
 
-void VirtualMachine::execute_float_texture()
+void VirtualMachine::execute_float_texture( const Operation& operation )
 {
-    word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    int texturename = argument();
-    int s = argument();
-    int t = argument();
+    Value* result = registers_[operation.result];
+    int texturename = operation.arguments[0];
+    int s = operation.arguments[1];
+    int t = operation.arguments[2];
     REYES_ASSERT( renderer_ );
-    float_texture( *renderer_, result, registers_[texturename], registers_[s], registers_[t] );
+    REYES_ASSERT( grid_ );
+    float_texture( *renderer_, *grid_, result, registers_[texturename], registers_[s], registers_[t] );
 }
 
-void VirtualMachine::execute_vec3_texture()
+void VirtualMachine::execute_vec3_texture( const Operation& operation )
 {
-    word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    int texturename = argument();
-    int s = argument();
-    int t = argument();
+    Value* result = registers_[operation.result];
+    int texturename = operation.arguments[0];
+    int s = operation.arguments[1];
+    int t = operation.arguments[2];
     REYES_ASSERT( renderer_ );
-    vec3_texture( *renderer_, result, registers_[texturename], registers_[s], registers_[t] );
+    REYES_ASSERT( grid_ );
+    vec3_texture( *renderer_, *grid_, result, registers_[texturename], registers_[s], registers_[t] );
 }
 
-void VirtualMachine::execute_float_environment()
+void VirtualMachine::execute_float_environment( const Operation& operation )
 {
-    word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    int texturename = argument();
-    int direction = argument();
+    Value* result = registers_[operation.result];
+    int texturename = operation.arguments[0];
+    int direction = operation.arguments[1];
     REYES_ASSERT( renderer_ );
     float_environment( *renderer_, result, registers_[texturename], registers_[direction] );
 }
 
-void VirtualMachine::execute_vec3_environment()
+void VirtualMachine::execute_vec3_environment( const Operation& operation )
 {
-    word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    int texturename = argument();
-    int direction = argument();
+    Value* result = registers_[operation.result];
+    int texturename = operation.arguments[0];
+    int direction = operation.arguments[1];
     REYES_ASSERT( renderer_ );
     vec3_environment( *renderer_, result, registers_[texturename], registers_[direction] );
 }
 
-void VirtualMachine::execute_shadow()
+void VirtualMachine::execute_shadow( const Operation& operation )
 {
-    word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    int texturename = argument();
-    int position = argument();
-    int bias = argument();
+    Value* result = registers_[operation.result];
+    int texturename = operation.arguments[0];
+    int position = operation.arguments[1];
+    int bias = operation.arguments[2];
     REYES_ASSERT( renderer_ );
     shadow( *renderer_, result, registers_[texturename], registers_[position], registers_[bias] );
 }
 
-void VirtualMachine::execute_call_0()
+void VirtualMachine::execute_call_0( const Operation& operation )
 {
-    word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    shared_ptr<Symbol> symbol = shader_->symbols()[argument()];
+    Value* result = registers_[operation.result];
+    const Symbol* symbol = shader_->symbols()[operation.arguments[0]].get();
     REYES_ASSERT( symbol->function() );
-    typedef void (*FunctionType)( const Renderer&, const Grid&, shared_ptr<Value> );
+    typedef void (*FunctionType)( const Renderer&, const Grid&, Value* );
     FunctionType function = reinterpret_cast<FunctionType>( symbol->function() );
     REYES_ASSERT( renderer_ );
     (*function)( *renderer_, *grid_, result );
 }
 
-void VirtualMachine::execute_call_1()
+void VirtualMachine::execute_call_1( const Operation& operation )
 {
-    word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    shared_ptr<Symbol> symbol = shader_->symbols()[argument()];
-    shared_ptr<Value> arg0 = registers_[argument()];
-    typedef void (*FunctionType)( const Renderer&, const Grid&, shared_ptr<Value>, shared_ptr<Value> );
+    Value* result = registers_[operation.result];
+    const Symbol* symbol = shader_->symbols()[operation.arguments[0]].get();
+    Value* arg0 = registers_[operation.arguments[1]];
+    typedef void (*FunctionType)( const Renderer&, const Grid&, Value*, Value* );
     FunctionType function = reinterpret_cast<FunctionType>( symbol->function() );
     REYES_ASSERT( renderer_ );
     (*function)( *renderer_, *grid_, result, arg0 );
 }
 
-void VirtualMachine::execute_call_2()
+void VirtualMachine::execute_call_2( const Operation& operation )
 {
-    word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    shared_ptr<Symbol> symbol = shader_->symbols()[argument()];
-    shared_ptr<Value> arg0 = registers_[argument()];
-    shared_ptr<Value> arg1 = registers_[argument()];
-    typedef void (*FunctionType)( const Renderer&, const Grid&, shared_ptr<Value>, shared_ptr<Value>, shared_ptr<Value> );
+    Value* result = registers_[operation.result];
+    const Symbol* symbol = shader_->symbols()[operation.arguments[0]].get();
+    Value* arg0 = registers_[operation.arguments[1]];
+    Value* arg1 = registers_[operation.arguments[2]];
+    typedef void (*FunctionType)( const Renderer&, const Grid&, Value*, Value*, Value* );
     FunctionType function = reinterpret_cast<FunctionType>( symbol->function() );
     REYES_ASSERT( renderer_ );
     (*function)( *renderer_, *grid_, result, arg0, arg1 );
 }
 
-void VirtualMachine::execute_call_3()
+void VirtualMachine::execute_call_3( const Operation& operation )
 {
-    word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    shared_ptr<Symbol> symbol = shader_->symbols()[argument()];
-    shared_ptr<Value> arg0 = registers_[argument()];
-    shared_ptr<Value> arg1 = registers_[argument()];
-    shared_ptr<Value> arg2 = registers_[argument()];
-    typedef void (*FunctionType)( const Renderer&, const Grid&, shared_ptr<Value>, shared_ptr<Value>, shared_ptr<Value>, shared_ptr<Value> );
+    Value* result = registers_[operation.result];
+    const Symbol* symbol = shader_->symbols()[operation.arguments[0]].get();
+    Value* arg0 = registers_[operation.arguments[1]];
+    Value* arg1 = registers_[operation.arguments[2]];
+    Value* arg2 = registers_[operation.arguments[3]];
+    typedef void (*FunctionType)( const Renderer&, const Grid&, Value*, Value*, Value*, Value* );
     FunctionType function = reinterpret_cast<FunctionType>( symbol->function() );
     REYES_ASSERT( renderer_ );
     (*function)( *renderer_, *grid_, result, arg0, arg1, arg2 );
 }
 
-void VirtualMachine::execute_call_4()
+void VirtualMachine::execute_call_4( const Operation& operation )
 {
-    word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    shared_ptr<Symbol> symbol = shader_->symbols()[argument()];
-    shared_ptr<Value> arg0 = registers_[argument()];
-    shared_ptr<Value> arg1 = registers_[argument()];
-    shared_ptr<Value> arg2 = registers_[argument()];
-    shared_ptr<Value> arg3 = registers_[argument()];
-    typedef void (*FunctionType)( const Renderer&, const Grid&, shared_ptr<Value>, shared_ptr<Value>, shared_ptr<Value>, shared_ptr<Value>, shared_ptr<Value> );
+    Value* result = registers_[operation.result];
+    const Symbol* symbol = shader_->symbols()[operation.arguments[0]].get();
+    Value* arg0 = registers_[operation.arguments[1]];
+    Value* arg1 = registers_[operation.arguments[2]];
+    Value* arg2 = registers_[operation.arguments[3]];
+    Value* arg3 = registers_[operation.arguments[4]];
+    typedef void (*FunctionType)( const Renderer&, const Grid&, Value*, Value*, Value*, Value*, Value* );
     FunctionType function = reinterpret_cast<FunctionType>( symbol->function() );
     REYES_ASSERT( renderer_ );
     (*function)( *renderer_, *grid_, result, arg0, arg1, arg2, arg3 );
 }
 
-void VirtualMachine::execute_call_5()
+void VirtualMachine::execute_call_5( const Operation& operation )
 {
-    word();
-    shared_ptr<Value> result = registers_[allocate_register()];
-    shared_ptr<Symbol> symbol = shader_->symbols()[argument()];
-    shared_ptr<Value> arg0 = registers_[argument()];
-    shared_ptr<Value> arg1 = registers_[argument()];
-    shared_ptr<Value> arg2 = registers_[argument()];
-    shared_ptr<Value> arg3 = registers_[argument()];
-    shared_ptr<Value> arg4 = registers_[argument()];
-    typedef void (*FunctionType)( const Renderer&, const Grid&, shared_ptr<Value>, shared_ptr<Value>, shared_ptr<Value>, shared_ptr<Value>, shared_ptr<Value>, shared_ptr<Value> );
+    Value* result = registers_[operation.result];
+    const Symbol* symbol = shader_->symbols()[operation.arguments[0]].get();
+    Value* arg0 = registers_[operation.arguments[1]];
+    Value* arg1 = registers_[operation.arguments[2]];
+    Value* arg2 = registers_[operation.arguments[3]];
+    Value* arg3 = registers_[operation.arguments[4]];
+    Value* arg4 = registers_[operation.arguments[5]];
+    typedef void (*FunctionType)( const Renderer&, const Grid&, Value*, Value*, Value*, Value*, Value*, Value* );
     FunctionType function = reinterpret_cast<FunctionType>( symbol->function() );
     REYES_ASSERT( renderer_ );
     (*function)( *renderer_, *grid_, result, arg0, arg1, arg2, arg3, arg4 );
 }
 
-void VirtualMachine::execute_ambient()
+void VirtualMachine::execute_ambient( const Operation& operation )
 {
-    int dispatch = word();
-    (void) dispatch;
+    int light_color_index = operation.arguments[0];
+    int light_opacity_index = operation.arguments[1];
 
-    shared_ptr<Value>& light_color = registers_[argument()];
-    shared_ptr<Value>& light_opacity = registers_[argument()];
-
-    light_color.reset( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size()) );
-    light_color->zero();    
-    light_opacity.reset( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size()) );
+    shared_ptr<Value> light_color( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size(), grid_->value_pool()) );
+    light_color->zero();
+    registers_[light_color_index] = light_color.get();
+    shared_ptr<Value> light_opacity( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size(), grid_->value_pool()) );
     light_opacity->zero();
+    registers_[light_opacity_index] = light_opacity.get();
     
     shared_ptr<Light> light( new Light(LIGHT_AMBIENT, light_color, light_opacity, vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 0.0f), 0.0f) );
     grid_->add_light( light );                
 }
 
-void VirtualMachine::execute_solar_axis_angle()
+void VirtualMachine::execute_solar_axis_angle( const Operation& operation )
 {
-    int dispatch = word();
-    (void) dispatch;
+    Value* axis = registers_[operation.arguments[0]];
+    Value* angle = registers_[operation.arguments[1]];    
+    int light_color_index = operation.arguments[2];
+    int light_opacity_index = operation.arguments[3];
 
-    const shared_ptr<Value>& axis = registers_[argument()];
-    const shared_ptr<Value>& angle = registers_[argument()];    
-    shared_ptr<Value>& light_color = registers_[argument()];
-    shared_ptr<Value>& light_opacity = registers_[argument()];
-
-    light_color.reset( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size()) );
+    shared_ptr<Value> light_color( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size(), grid_->value_pool()) );
     light_color->zero();
-    light_opacity.reset( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size()) );
+    registers_[light_color_index] = light_color.get();
+    shared_ptr<Value> light_opacity( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size(), grid_->value_pool()) );
     light_opacity->zero();
+    registers_[light_opacity_index] = light_opacity.get();
 
     shared_ptr<Light> light( new Light(LIGHT_SOLAR_AXIS_ANGLE, light_color, light_opacity, axis->vec3_value(), axis->vec3_value(), angle->float_value()) );
     grid_->add_light( light );             
 }
 
-void VirtualMachine::execute_illuminate()
+void VirtualMachine::execute_illuminate( const Operation& operation )
 {
-    int dispatch = word();
-    (void) dispatch;
-
-    const shared_ptr<Value>& P = registers_[argument()];
-    const shared_ptr<Value>& Ps = registers_[argument()];
-    const shared_ptr<Value>& L = registers_[argument()];
-    shared_ptr<Value>& light_color = registers_[argument()];
-    shared_ptr<Value>& light_opacity = registers_[argument()];
+    Value* P = registers_[operation.arguments[0]];
+    Value* Ps = registers_[operation.arguments[1]];
+    Value* L = registers_[operation.arguments[2]];
+    int light_color_index = operation.arguments[3];
+    int light_opacity_index = operation.arguments[4];
 
     L->light_to_surface_vector( Ps, P->vec3_value() );
-    light_color.reset( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size()) );
+    shared_ptr<Value> light_color( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size(), grid_->value_pool()) );
     light_color->zero();
-    light_opacity.reset( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size()) );
+    registers_[light_color_index] = light_color.get();
+    shared_ptr<Value> light_opacity( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size(), grid_->value_pool()) );
     light_opacity->zero();
+    registers_[light_opacity_index] = light_opacity.get();
 
     shared_ptr<Light> light( new Light(LIGHT_ILLUMINATE, light_color, light_opacity, P->vec3_value(), vec3(0.0f, 0.0f, 0.0f), 0.0f) );
     grid_->add_light( light );
 }
 
-void VirtualMachine::execute_illuminate_axis_angle()
+void VirtualMachine::execute_illuminate_axis_angle( const Operation& operation )
 {
-    int dispatch = word();
-    (void) dispatch;
-
-    const shared_ptr<Value>& P = registers_[argument()];
-    const shared_ptr<Value>& axis = registers_[argument()];
-    const shared_ptr<Value>& angle = registers_[argument()];                
-    const shared_ptr<Value>& Ps = registers_[argument()];
-    const shared_ptr<Value>& L = registers_[argument()];
-    shared_ptr<Value>& light_color = registers_[argument()];
-    shared_ptr<Value>& light_opacity = registers_[argument()];
+    Value* P = registers_[operation.arguments[0]];
+    Value* axis = registers_[operation.arguments[1]];
+    Value* angle = registers_[operation.arguments[2]];                
+    Value* Ps = registers_[operation.arguments[3]];
+    Value* L = registers_[operation.arguments[4]];
+    int light_color_index = operation.arguments[5];
+    int light_opacity_index = operation.arguments[6];
 
     L->light_to_surface_vector( Ps, P->vec3_value() );
-    light_color.reset( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size()) );
+    shared_ptr<Value> light_color( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size(), grid_->value_pool()) );
     light_color->zero();
-    light_opacity.reset( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size()) );
+    registers_[light_color_index] = light_color.get();
+    shared_ptr<Value> light_opacity( new Value(TYPE_COLOR, STORAGE_VARYING, grid_->size(), grid_->value_pool()) );
     light_opacity->zero();
+    registers_[light_opacity_index] = light_opacity.get();
 
     shared_ptr<Light> light( new Light(LIGHT_ILLUMINATE_AXIS_ANGLE, light_color, light_opacity, P->vec3_value(), axis->vec3_value(), angle->float_value()) );
     grid_->add_light( light );
 }
 
-void VirtualMachine::execute_illuminance_axis_angle()
+void VirtualMachine::execute_illuminance_axis_angle( const Operation& operation )
 {
-    int dispatch = word();
-    (void) dispatch;
-
-    const shared_ptr<Value>& P = registers_[argument()];
-    const shared_ptr<Value>& axis = registers_[argument()];
-    const shared_ptr<Value>& angle = registers_[argument()];
-    const shared_ptr<Value>& L = registers_[argument()];
-    const shared_ptr<Value>& light_color = registers_[argument()];
-    const shared_ptr<Value>& light_opacity = registers_[argument()];                
-    const shared_ptr<Value>& result = registers_[allocate_register()];
+    Value* P = registers_[operation.arguments[0]];
+    Value* axis = registers_[operation.arguments[1]];
+    Value* angle = registers_[operation.arguments[2]];
+    Value* L = registers_[operation.arguments[3]];
+    Value* light_color = registers_[operation.arguments[4]];
+    Value* light_opacity = registers_[operation.arguments[5]];                
+    Value* result = registers_[operation.result];
 
     const Light* light = grid_->get_light( light_index_ );                
     result->illuminance_axis_angle( P, axis, angle, light );
@@ -1216,7 +1336,40 @@ void VirtualMachine::execute_illuminance_axis_angle()
 }
 
 
-void VirtualMachine::float_texture( const Renderer& renderer, std::shared_ptr<Value> result, std::shared_ptr<Value> texturename, std::shared_ptr<Value> s, std::shared_ptr<Value> t ) const
+/**
+// Calculate the footprint of a texture lookup at a vertex of a grid.
+//
+// The footprint is the largest change in each texture coordinate between 
+// the vertex and its neighbours in u and v, i.e. the texture coordinate 
+// derivatives scaled by du and dv, and so covers roughly the area of one 
+// micropolygon.  Values that don't match the size of the grid (uniform 
+// texture coordinates) have no footprint.
+*/
+static void texture_footprint( const Grid& grid, const float* s_values, const float* t_values, unsigned int size, int i, float* ds, float* dt )
+{
+    REYES_ASSERT( s_values );
+    REYES_ASSERT( t_values );
+    REYES_ASSERT( ds );
+    REYES_ASSERT( dt );
+
+    const int width = grid.width();
+    const int height = grid.height();
+    if ( int(size) != width * height )
+    {
+        *ds = 0.0f;
+        *dt = 0.0f;
+        return;
+    }
+
+    const int x = i % width;
+    const int y = i / width;
+    const int u = x + 1 < width ? i + 1 : (x > 0 ? i - 1 : i);
+    const int v = y + 1 < height ? i + width : (y > 0 ? i - width : i);
+    *ds = max( fabsf(s_values[u] - s_values[i]), fabsf(s_values[v] - s_values[i]) );
+    *dt = max( fabsf(t_values[u] - t_values[i]), fabsf(t_values[v] - t_values[i]) );
+}
+
+void VirtualMachine::float_texture( const Renderer& renderer, const Grid& grid, Value* result, Value* texturename, Value* s, Value* t ) const
 {
     REYES_ASSERT( result );
     REYES_ASSERT( texturename );
@@ -1239,7 +1392,10 @@ void VirtualMachine::float_texture( const Renderer& renderer, std::shared_ptr<Va
         float* values = result->float_values();
         for ( unsigned int i = 0; i < s->size(); ++i )
         {
-            values[i] = texture->color( s_values[i], t_values[i] ).x;
+            float ds = 0.0f;
+            float dt = 0.0f;
+            texture_footprint( grid, s_values, t_values, s->size(), i, &ds, &dt );
+            values[i] = texture->color( s_values[i], t_values[i], ds, dt ).x;
         }
     }
     else
@@ -1248,7 +1404,7 @@ void VirtualMachine::float_texture( const Renderer& renderer, std::shared_ptr<Va
     }
 }
 
-void VirtualMachine::vec3_texture( const Renderer& renderer, std::shared_ptr<Value> result, std::shared_ptr<Value> texturename, std::shared_ptr<Value> s, std::shared_ptr<Value> t ) const
+void VirtualMachine::vec3_texture( const Renderer& renderer, const Grid& grid, Value* result, Value* texturename, Value* s, Value* t ) const
 {
     REYES_ASSERT( result );
     REYES_ASSERT( texturename );
@@ -1271,7 +1427,10 @@ void VirtualMachine::vec3_texture( const Renderer& renderer, std::shared_ptr<Val
         vec3* values = result->vec3_values();
         for ( unsigned int i = 0; i < s->size(); ++i )
         {
-            values[i] = vec3( texture->color(s_values[i], t_values[i]) );
+            float ds = 0.0f;
+            float dt = 0.0f;
+            texture_footprint( grid, s_values, t_values, s->size(), i, &ds, &dt );
+            values[i] = vec3( texture->color(s_values[i], t_values[i], ds, dt) );
         }    
     }
     else
@@ -1280,7 +1439,7 @@ void VirtualMachine::vec3_texture( const Renderer& renderer, std::shared_ptr<Val
     }
 }
 
-void VirtualMachine::float_environment( const Renderer& renderer, std::shared_ptr<Value> result, std::shared_ptr<Value> texturename, std::shared_ptr<Value> direction ) const
+void VirtualMachine::float_environment( const Renderer& renderer, Value* result, Value* texturename, Value* direction ) const
 {
     REYES_ASSERT( result );
     REYES_ASSERT( texturename );
@@ -1306,7 +1465,7 @@ void VirtualMachine::float_environment( const Renderer& renderer, std::shared_pt
     }
 }
 
-void VirtualMachine::vec3_environment( const Renderer& renderer, std::shared_ptr<Value> result, std::shared_ptr<Value> texturename, std::shared_ptr<Value> direction ) const
+void VirtualMachine::vec3_environment( const Renderer& renderer, Value* result, Value* texturename, Value* direction ) const
 {
     REYES_ASSERT( result );
     REYES_ASSERT( texturename );
@@ -1332,7 +1491,7 @@ void VirtualMachine::vec3_environment( const Renderer& renderer, std::shared_ptr
     }
 }
 
-void VirtualMachine::shadow( const Renderer& renderer, std::shared_ptr<Value> result, std::shared_ptr<Value> texturename, std::shared_ptr<Value> position, std::shared_ptr<Value> bias ) const
+void VirtualMachine::shadow( const Renderer& renderer, Value* result, Value* texturename, Value* position, Value* bias ) const
 {
     REYES_ASSERT( result );
     REYES_ASSERT( texturename );
@@ -1363,7 +1522,7 @@ void VirtualMachine::shadow( const Renderer& renderer, std::shared_ptr<Value> re
     }
 }
 
-void VirtualMachine::push_mask( std::shared_ptr<Value> value )
+void VirtualMachine::push_mask( Value* value )
 {
     REYES_ASSERT( value );
     REYES_ASSERT( value->type() == TYPE_INTEGER );
@@ -1408,19 +1567,54 @@ bool VirtualMachine::mask_empty() const
     return masks_.back().empty();
 }
 
-const unsigned char* VirtualMachine::get_mask() const
-{
-    return !masks_.empty() ? &masks_.back().mask()[0] : NULL;
-}
-
-void VirtualMachine::reset_register( int index )
+/**
+// Advance to the next non-ambient light for an illuminance statement.
+//
+// The first call after an illuminance statement has finished starts again
+// from the first light.
+//
+// @return
+//  True if there is another light to illuminate from otherwise false, in 
+//  which case the illuminance statement is finished.
+*/
+bool VirtualMachine::next_light()
 {
-    REYES_ASSERT( shader_ );
-    REYES_ASSERT( index >= shader_->permanent_registers() );
-    register_index_ = index;
+    const int lights = int(grid_->lights().size());
+    if ( light_index_ < lights )    
+    {
+        ++light_index_;        
+    }
+    else
+    {
+        light_index_ = 0;
+    }
+    
+    while ( light_index_ < lights && grid_->get_light(light_index_)->type() == LIGHT_AMBIENT )
+    {
+        ++light_index_;
+    }
+    
+    if ( light_index_ >= lights )
+    {
+        light_index_ = INT_MAX;
+        return false;
+    }
+    return true;
 }
 
-int VirtualMachine::allocate_register()
+/**
+// Get the bits of the current condition mask to pass to masked kernels.
+//
+// @return
+//  The bits of the current condition mask or null if there is no condition
+//  mask or the current condition mask selects every element, in which case
+//  kernels run their unmasked paths.
+*/
+const uint64_t* VirtualMachine::get_mask() const
 {
-    return register_index_++;
+    if ( masks_.empty() || masks_.back().full() )
+    {
+        return NULL;
+    }
+    return &masks_.back().mask()[0];
 }
@@ -15,6 +15,8 @@ class Grid;
 class Value;
 class Shader;
 class Renderer;
+class NativeVirtualMachine;
+struct Operation;
 
 /**
 // A virtual machine that interprets the code generated for shaders to execute
@@ -26,99 +28,97 @@ class VirtualMachine
     Grid* grid_; ///< The grid of micropolygon vertices that is currently being shaded (null if no shader is being executed).
     Shader* shader_; ///< The shader that is currently being executed (null if no shader is being executed).
     std::vector<std::shared_ptr<Value> > values_; ///< The values allocated for use as temporary registers by this virtual machine.
-    std::vector<std::shared_ptr<Value> > registers_; ///< The values loaded into registers by this virtual machine (some from grid, some temporary).
-    int register_index_; ///< The index of the next available register.
+    std::vector<Value*> registers_; ///< The values loaded into registers by this virtual machine (some from grid, some temporary), not owned by this virtual machine.
     int light_index_; ///< The index of the current light (or INT_MAX if there is no current light).
-    const unsigned char* code_begin_; ///< The address of the beginning of loaded code.
-    const unsigned char* code_end_; ///< The address one past the end of loaded code.
-    const unsigned char* code_; ///< The currently executed instruction.
+    const Operation* operations_begin_; ///< The first operation of the shader that is currently being executed.
+    const Operation* operations_end_; ///< One past the last operation of the currently executed code fragment.
+    const Operation* operation_; ///< The next operation to execute.
     std::vector<ConditionMask> masks_; ///< The stack of condition masks that specify which elements to use during assignment.
+
+    friend class NativeVirtualMachine;
     
 public:
     VirtualMachine();
     VirtualMachine( const Renderer& renderer );
     void initialize( Grid& parameters, Shader& shader );
     void shade( Grid& globals, Grid& parameters, Shader& shader );
+    static void decode( const Shader& shader, std::vector<Operation>* operations );
     
 private:
+    static void decode_planes( const Shader& shader, const std::vector<std::pair<int, int>>& resets, std::vector<Operation>* operations );
     void construct( int start, int finish );
+    void initialize_parameter_registers( Grid& parameters );
     void initialize_registers( Grid& grid );
     void execute();
-    void jump_illuminance( int distance );
-    void jump( int distance );
-    int instruction();
-    int argument();
-    int word();
-    int quad();
+    void jump_illuminance( int target );
+    void jump( int target );
     
-    void execute_halt();
-    void execute_reset();
-    void execute_clear_mask();
-    void execute_generate_mask();
-    void execute_invert_mask();
-    void execute_jump_empty();
-    void execute_jump_not_empty();
-    void execute_jump_illuminance();
-    void execute_jump();
-    void execute_transform_point();
-    void execute_transform_vector();
-    void execute_transform_normal();
-    void execute_transform_color();
-    void execute_transform_matrix();
-    void execute_dot();
-    void execute_multiply();
-    void execute_divide();
-    void execute_add();
-    void execute_subtract();
-    void execute_greater();
-    void execute_greater_equal();
-    void execute_less();
-    void execute_less_equal();
-    void execute_and();
-    void execute_or();
-    void execute_equal();
-    void execute_not_equal();
-    void execute_negate();
-    void execute_convert();
-    void execute_promote();
-    void execute_assign();
-    void execute_assign_string();
-    void execute_add_assign();
-    void execute_subtract_assign();
-    void execute_multiply_assign();
-    void execute_divide_assign();
-    void execute_float_texture();
-    void execute_vec3_texture();
-    void execute_float_environment();
-    void execute_vec3_environment();
-    void execute_shadow();
-    void execute_call_0();
-    void execute_call_1();
-    void execute_call_2();
-    void execute_call_3();
-    void execute_call_4();
-    void execute_call_5();
-    void execute_ambient();
-    void execute_solar();
-    void execute_solar_axis_angle();
-    void execute_illuminate();
-    void execute_illuminate_axis_angle();
-    void execute_illuminance_axis_angle();
+    void execute_halt( const Operation& operation );
+    void execute_clear_mask( const Operation& operation );
+    void execute_generate_mask( const Operation& operation );
+    void execute_invert_mask( const Operation& operation );
+    void execute_jump_empty( const Operation& operation );
+    void execute_jump_not_empty( const Operation& operation );
+    void execute_jump_illuminance( const Operation& operation );
+    void execute_jump( const Operation& operation );
+    void execute_transform_point( const Operation& operation );
+    void execute_transform_vector( const Operation& operation );
+    void execute_transform_normal( const Operation& operation );
+    void execute_transform_color( const Operation& operation );
+    void execute_transform_matrix( const Operation& operation );
+    void execute_dot( const Operation& operation );
+    void execute_normalize_planes( const Operation& operation );
+    void execute_multiply( const Operation& operation );
+    void execute_divide( const Operation& operation );
+    void execute_add( const Operation& operation );
+    void execute_subtract( const Operation& operation );
+    void execute_greater( const Operation& operation );
+    void execute_greater_equal( const Operation& operation );
+    void execute_less( const Operation& operation );
+    void execute_less_equal( const Operation& operation );
+    void execute_and( const Operation& operation );
+    void execute_or( const Operation& operation );
+    void execute_equal( const Operation& operation );
+    void execute_not_equal( const Operation& operation );
+    void execute_negate( const Operation& operation );
+    void execute_convert( const Operation& operation );
+    void execute_promote( const Operation& operation );
+    void execute_assign( const Operation& operation );
+    void execute_assign_string( const Operation& operation );
+    void execute_add_assign( const Operation& operation );
+    void execute_subtract_assign( const Operation& operation );
+    void execute_multiply_assign( const Operation& operation );
+    void execute_divide_assign( const Operation& operation );
+    void execute_float_texture( const Operation& operation );
+    void execute_vec3_texture( const Operation& operation );
+    void execute_float_environment( const Operation& operation );
+    void execute_vec3_environment( const Operation& operation );
+    void execute_shadow( const Operation& operation );
+    void execute_call_0( const Operation& operation );
+    void execute_call_1( const Operation& operation );
+    void execute_call_2( const Operation& operation );
+    void execute_call_3( const Operation& operation );
+    void execute_call_4( const Operation& operation );
+    void execute_call_5( const Operation& operation );
+    void execute_ambient( const Operation& operation );
+    void execute_solar( const Operation& operation );
+    void execute_solar_axis_angle( const Operation& operation );
+    void execute_illuminate( const Operation& operation );
+    void execute_illuminate_axis_angle( const Operation& operation );
+    void execute_illuminance_axis_angle( const Operation& operation );
 
-    void float_texture( const Renderer& renderer, std::shared_ptr<Value> result, std::shared_ptr<Value> texturename, std::shared_ptr<Value> s, std::shared_ptr<Value> t ) const;
-    void vec3_texture( const Renderer& renderer, std::shared_ptr<Value> result, std::shared_ptr<Value> texturename, std::shared_ptr<Value> s, std::shared_ptr<Value> t ) const;
-    void float_environment( const Renderer& renderer, std::shared_ptr<Value> result, std::shared_ptr<Value> texturename, std::shared_ptr<Value> direction ) const;
-    void vec3_environment( const Renderer& renderer, std::shared_ptr<Value> result, std::shared_ptr<Value> texturename, std::shared_ptr<Value> direction ) const;
-    void shadow( const Renderer& renderer, std::shared_ptr<Value> result, std::shared_ptr<Value> texturename, std::shared_ptr<Value> position, std::shared_ptr<Value> bias ) const;
+    void float_texture( const Renderer& renderer, const Grid& grid, Value* result, Value* texturename, Value* s, Value* t ) const;
+    void vec3_texture( const Renderer& renderer, const Grid& grid, Value* result, Value* texturename, Value* s, Value* t ) const;
+    void float_environment( const Renderer& renderer, Value* result, Value* texturename, Value* direction ) const;
+    void vec3_environment( const Renderer& renderer, Value* result, Value* texturename, Value* direction ) const;
+    void shadow( const Renderer& renderer, Value* result, Value* texturename, Value* position, Value* bias ) const;
     
-    void push_mask( std::shared_ptr<Value> value );
+    void push_mask( Value* value );
     void pop_mask();
     void invert_mask();
     bool mask_empty() const;
-    const unsigned char* get_mask() const;
-        
-    void reset_register( int index );
-    int allocate_register();
+    bool next_light();
+    const uint64_t* get_mask() const;
 };
 
 }
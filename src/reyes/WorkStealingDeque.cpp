@@ -0,0 +1,82 @@
+//
+// WorkStealingDeque.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "stdafx.hpp"
+#include "WorkStealingDeque.hpp"
+#include "assert.hpp"
+
+using std::mutex;
+using std::lock_guard;
+using namespace reyes;
+
+WorkStealingDeque::WorkStealingDeque()
+: mutex_(),
+  jobs_()
+{
+}
+
+WorkStealingDeque::~WorkStealingDeque()
+{
+}
+
+/**
+// Push a job onto the back of this deque.
+//
+// Only the worker that owns this deque pushes jobs onto it.
+//
+// @param job
+//  The job to push.
+*/
+void WorkStealingDeque::push( const SplitJob& job )
+{
+    lock_guard<mutex> lock( mutex_ );
+    jobs_.push_back( job );
+}
+
+/**
+// Pop the most recently pushed job from the back of this deque.
+//
+// Only the worker that owns this deque pops jobs from it.
+//
+// @param job
+//  The job to set to the popped job (assumed not null).
+//
+// @return
+//  True if a job was popped otherwise false if this deque was empty.
+*/
+bool WorkStealingDeque::pop( SplitJob* job )
+{
+    REYES_ASSERT( job );
+    lock_guard<mutex> lock( mutex_ );
+    if ( jobs_.empty() )
+    {
+        return false;
+    }
+    *job = jobs_.back();
+    jobs_.pop_back();
+    return true;
+}
+
+/**
+// Steal the least recently pushed job from the front of this deque.
+//
+// @param job
+//  The job to set to the stolen job (assumed not null).
+//
+// @return
+//  True if a job was stolen otherwise false if this deque was empty.
+*/
+bool WorkStealingDeque::steal( SplitJob* job )
+{
+    REYES_ASSERT( job );
+    lock_guard<mutex> lock( mutex_ );
+    if ( jobs_.empty() )
+    {
+        return false;
+    }
+    *job = jobs_.front();
+    jobs_.pop_front();
+    return true;
+}
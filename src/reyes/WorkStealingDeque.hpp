@@ -0,0 +1,35 @@
+#ifndef REYES_WORKSTEALINGDEQUE_HPP_INCLUDED
+#define REYES_WORKSTEALINGDEQUE_HPP_INCLUDED
+
+#include "SplitJob.hpp"
+#include <deque>
+#include <mutex>
+
+namespace reyes
+{
+
+/**
+// A double ended queue of split jobs owned by a single worker.
+//
+// The owning worker pushes and pops jobs at the back so that it works 
+// depth first on the most recently split, and smallest, pieces of geometry.
+// Other workers steal jobs from the front so that they take the least 
+// recently split, and largest, pieces of geometry and so steal as rarely as
+// possible.
+*/
+class WorkStealingDeque
+{
+    std::mutex mutex_; ///< Guards access to the jobs in this deque.
+    std::deque<SplitJob> jobs_; ///< The jobs in this deque.
+
+public:
+    WorkStealingDeque();
+    ~WorkStealingDeque();
+    void push( const SplitJob& job );
+    bool pop( SplitJob* job );
+    bool steal( SplitJob* job );
+};
+
+}
+
+#endif
@@ -0,0 +1,523 @@
+//
+// Worker.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "stdafx.hpp"
+#include "Worker.hpp"
+#include "Renderer.hpp"
+#include "Options.hpp"
+#include "Attributes.hpp"
+#include "VirtualMachine.hpp"
+#include "SampleBuffer.hpp"
+#include "ImageBuffer.hpp"
+#include "Sampler.hpp"
+#include "Geometry.hpp"
+#include "Primitive.hpp"
+#include "Grid.hpp"
+#include "Bucket.hpp"
+#include "SplitJob.hpp"
+#include "WorkStealingDeque.hpp"
+#include "ValuePool.hpp"
+#include <math/vec2.ipp>
+#include <math/vec3.ipp>
+#include <math/mat4x4.ipp>
+#include "assert.hpp"
+#include <algorithm>
+#include <math.h>
+#include <limits.h>
+#include <thread>
+
+using std::vector;
+using std::shared_ptr;
+using namespace math;
+using namespace reyes;
+
+static const int MAXIMUM_VERTICES_PER_GRID = 64 * 64;
+
+/// The size of the blocks that grid values are allocated from; enough for a
+/// handful of varying colors or points on a grid of maximum size.
+static const unsigned int VALUE_POOL_BLOCK_SIZE = 16 * sizeof(vec3) * MAXIMUM_VERTICES_PER_GRID;
+
+/// The attributes of the primitive being rendered on this thread or null if
+/// no primitive is being rendered on this thread.
+static thread_local Attributes* shading_attributes_on_thread = NULL;
+
+/**
+// Constructor.
+//
+// @param renderer
+//  The Renderer to render primitives for.
+//
+// @param width
+//  The width of the region of the image that this worker renders at one
+//  time (in pixels).
+//
+// @param height
+//  The height of the region of the image that this worker renders at one
+//  time (in pixels).
+//
+// @param raster_width
+//  The width of raster space for the whole frame (in samples).
+//
+// @param raster_height
+//  The height of raster space for the whole frame (in samples).
+*/
+Worker::Worker( const Renderer& renderer, int width, int height, float raster_width, float raster_height )
+: renderer_( &renderer ),
+  virtual_machine_( NULL ),
+  sample_buffer_( NULL ),
+  sample_buffer_mutex_(),
+  sampler_( NULL ),
+  value_pool_( NULL ),
+  image_buffer_( NULL ),
+  shared_attributes_(),
+  attributes_( NULL ),
+  split_jobs_( NULL ),
+  outstanding_split_jobs_( 0 ),
+  shaded_grids_( 0 ),
+  occluded_grids_( 0 ),
+  random_()
+{
+    const Options& options = renderer.options();
+    virtual_machine_ = new VirtualMachine( renderer );
+    sample_buffer_ = new SampleBuffer( 0, 0, width, height, int(options.horizontal_sampling_rate()), int(options.vertical_sampling_rate()), options.filter_width(), options.filter_height() );
+    sampler_ = new Sampler( raster_width, raster_height, MAXIMUM_VERTICES_PER_GRID, options.crop_window() );
+    value_pool_ = new ValuePool( VALUE_POOL_BLOCK_SIZE );
+    image_buffer_ = new ImageBuffer();
+    split_jobs_ = new WorkStealingDeque();
+}
+
+/**
+// Destructor.
+*/
+Worker::~Worker()
+{
+    delete split_jobs_;
+    split_jobs_ = NULL;
+
+    delete attributes_;
+    attributes_ = NULL;
+
+    delete image_buffer_;
+    image_buffer_ = NULL;
+
+    delete sampler_;
+    sampler_ = NULL;
+
+    delete value_pool_;
+    value_pool_ = NULL;
+
+    delete sample_buffer_;
+    sample_buffer_ = NULL;
+
+    delete virtual_machine_;
+    virtual_machine_ = NULL;
+}
+
+/**
+// Get the sample buffer that this worker samples grids into.
+//
+// @return
+//  The SampleBuffer.
+*/
+SampleBuffer* Worker::sample_buffer() const
+{
+    return sample_buffer_;
+}
+
+/**
+// Get the number of grids diced and shaded by this worker.
+//
+// @return
+//  The number of grids shaded.
+*/
+int Worker::shaded_grids() const
+{
+    return shaded_grids_;
+}
+
+/**
+// Get the number of pieces of geometry that this worker culled because they
+// were hidden behind samples already in the sample buffer.
+//
+// Each culled piece of geometry would otherwise have been diced and shaded 
+// as at least one grid.
+//
+// @return
+//  The number of pieces of geometry culled as occluded.
+*/
+int Worker::occluded_grids() const
+{
+    return occluded_grids_;
+}
+
+/**
+// Render buckets until there are no more buckets left to render.
+//
+// Buckets are claimed by atomically incrementing \e next_bucket so that any
+// number of workers can render the same list of buckets concurrently with
+// each bucket being rendered exactly once.  Once there are no more buckets
+// to claim this worker steals split jobs from the other workers until they
+// have all finished their buckets.
+//
+// @param workers
+//  All of the workers rendering buckets (including this worker).
+//
+// @param buckets
+//  The buckets to render.
+//
+// @param next_bucket
+//  The index of the next bucket to be rendered by any worker (assumed not
+//  null).
+//
+// @param image_buffer
+//  The image buffer to quantize each rendered bucket into (assumed not null).
+*/
+void Worker::render_buckets( const std::vector<Worker*>& workers, const std::vector<Bucket*>& buckets, std::atomic<int>* next_bucket, ImageBuffer* image_buffer )
+{
+    REYES_ASSERT( next_bucket );
+    REYES_ASSERT( image_buffer );
+
+    int index = next_bucket->fetch_add( 1 );
+    while ( index < int(buckets.size()) )
+    {
+        Bucket* bucket = buckets[index];
+        REYES_ASSERT( bucket );
+        render_bucket( workers, *bucket, image_buffer );
+        index = next_bucket->fetch_add( 1 );
+    }
+
+    SplitJob job;
+    while ( busy(workers) )
+    {
+        if ( split_jobs_->pop(&job) || steal(workers, &job) )
+        {
+            split( job );
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/**
+// Render a bucket.
+//
+// The primitives in the bucket are pushed as split jobs onto this worker's
+// deque and then split, diced, shaded, and sampled into this worker's 
+// sample buffer by this worker and any other workers that steal them.  While
+// it waits for stolen jobs to complete this worker steals jobs from other
+// workers in turn.
+//
+// Once all of the jobs for the bucket have completed the sample buffer is 
+// filtered, exposed, and quantized into the part of \e image_buffer covered
+// by the bucket.  Buckets don't overlap in the image buffer so any number of
+// workers can quantize into the same image buffer concurrently.  The 
+// primitives retained in the bucket are released once it has been rendered.
+//
+// @param workers
+//  All of the workers rendering buckets (including this worker).
+//
+// @param bucket
+//  The bucket to render.
+//
+// @param image_buffer
+//  The image buffer to quantize the rendered bucket into (assumed not null).
+*/
+void Worker::render_bucket( const std::vector<Worker*>& workers, Bucket& bucket, ImageBuffer* image_buffer )
+{
+    REYES_ASSERT( image_buffer );
+    REYES_ASSERT( outstanding_split_jobs_ == 0 );
+
+    sample_buffer_->reset( bucket.x0(), bucket.y0(), bucket.width(), bucket.height() );
+
+    // Push primitives in reverse order so that they're popped, and rendered
+    // by this worker, in the order that they were passed to the renderer.
+    const vector<Primitive>& primitives = bucket.primitives();
+    outstanding_split_jobs_ += int(primitives.size());
+    for ( vector<Primitive>::const_reverse_iterator i = primitives.rbegin(); i != primitives.rend(); ++i )
+    {
+        split_jobs_->push( SplitJob(&(*i), vec2(0.0f, 1.0f), vec2(0.0f, 1.0f), this) );
+    }
+
+    SplitJob job;
+    while ( outstanding_split_jobs_ > 0 )
+    {
+        if ( split_jobs_->pop(&job) || steal(workers, &job) )
+        {
+            split( job );
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    bucket.clear();
+
+    const Options& options = renderer_->options();
+    sample_buffer_->filter( options.filter_function(), image_buffer_ );
+    image_buffer_->expose( options.gain(), options.gamma() );
+    image_buffer->quantize( *image_buffer_, bucket.x0(), bucket.y0(), options.one(), options.minimum(), options.maximum(), options.dither(), &random_ );
+}
+
+/**
+// Render a primitive into this worker's sample buffer on the calling thread.
+//
+// @param primitive
+//  The primitive to render.
+*/
+void Worker::render( const Primitive& primitive )
+{
+    REYES_ASSERT( outstanding_split_jobs_ == 0 );
+
+    // Primitives rendered immediately share the renderer's current 
+    // attributes and their shader parameters may have been written since 
+    // the last primitive so always take a fresh copy.
+    shared_attributes_.reset();
+    ++outstanding_split_jobs_;
+    split_jobs_->push( SplitJob(&primitive, vec2(0.0f, 1.0f), vec2(0.0f, 1.0f), this) );
+
+    SplitJob job;
+    while ( split_jobs_->pop(&job) )
+    {
+        split( job );
+    }
+    REYES_ASSERT( outstanding_split_jobs_ == 0 );
+}
+
+/**
+// Get the attributes of the primitive being rendered on the calling thread.
+//
+// @return
+//  The attributes of the primitive being rendered on the calling thread or
+//  null if no primitive is being rendered on the calling thread.
+*/
+Attributes* Worker::shading_attributes()
+{
+    return shading_attributes_on_thread;
+}
+
+/**
+// Is any worker still waiting for split jobs to complete?
+//
+// @param workers
+//  All of the workers rendering buckets (including this worker).
+//
+// @return
+//  True if any worker has split jobs that haven't completed otherwise false.
+*/
+bool Worker::busy( const std::vector<Worker*>& workers ) const
+{
+    for ( vector<Worker*>::const_iterator i = workers.begin(); i != workers.end(); ++i )
+    {
+        const Worker* worker = *i;
+        REYES_ASSERT( worker );
+        if ( worker->outstanding_split_jobs_ > 0 )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+// Steal a split job from another worker.
+//
+// The other workers are tried in turn starting from the worker after this
+// one so that workers looking for jobs spread out over the other workers.
+//
+// @param workers
+//  All of the workers rendering buckets (including this worker).
+//
+// @param job
+//  The job to set to the stolen job (assumed not null).
+//
+// @return
+//  True if a job was stolen otherwise false.
+*/
+bool Worker::steal( const std::vector<Worker*>& workers, SplitJob* job )
+{
+    REYES_ASSERT( job );
+
+    const int count = int(workers.size());
+    const int index = int(std::find(workers.begin(), workers.end(), this) - workers.begin());
+    for ( int i = 1; i < count; ++i )
+    {
+        Worker* worker = workers[(index + i) % count];
+        REYES_ASSERT( worker );
+        if ( worker->split_jobs_->steal(job) )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+// Split or dice a piece of geometry.
+//
+// Geometry that is small enough is diced into a grid of micropolygons that 
+// satisfies both the shading rate and the maximum number of micropolygons
+// per grid, shaded, sampled into the sample buffer of the worker that the 
+// job belongs to, and then discarded.  Larger geometry is split into smaller
+// ranges of the same primitive that are pushed back onto this worker's deque
+// as jobs belonging to the same worker.  Geometry is culled if its bound projects outside of the
+// sample buffer, on the outside of the near or far clipping planes, or 
+// behind the farthest depth already sampled in the area that it covers.
+//
+// The current transform is used to transform the grid from object space into
+// camera space where all shading and lighting calculations are performed.  
+//
+// @param job
+//  The split job to process.
+*/
+void Worker::split( const SplitJob& job )
+{
+    const Primitive* primitive = job.primitive();
+    REYES_ASSERT( primitive );
+    const Geometry* geometry = primitive->geometry().get();
+    const vec2& u_range = job.u_range();
+    const vec2& v_range = job.v_range();
+    Worker* worker = job.worker();
+    REYES_ASSERT( geometry );
+    REYES_ASSERT( worker );
+
+    use_attributes( primitive->attributes() );
+    shading_attributes_on_thread = attributes_;
+
+    const Options& options = renderer_->options();
+    const mat4x4 transform = renderer_->camera_transform() * attributes_->transform();
+    const SampleBuffer* sample_buffer = worker->sample_buffer_;
+    const float X0 = float(sample_buffer->x());
+    const float X1 = float(sample_buffer->x() + sample_buffer->width() - 1);
+    const float Y0 = float(sample_buffer->y());
+    const float Y1 = float(sample_buffer->y() + sample_buffer->height() - 1);
+    const float SAMPLES_PER_PIXEL = float(options.horizontal_sampling_rate() * options.vertical_sampling_rate());
+
+    vec3 minimum = vec3( 0.0f, 0.0f, 0.0f );
+    vec3 maximum = vec3( 0.0f, 0.0f, 0.0f );
+
+    bool culled = false;
+    bool primitive_spans_epsilon_plane = false;
+    int width = 0;
+    int height = 0;
+    
+    if ( geometry->boundable() )
+    {
+        geometry->bound( transform, u_range, v_range, &minimum, &maximum );
+        culled = minimum.z > options.far_clip_distance() || maximum.z < options.near_clip_distance();
+        
+        const float EPSILON = 0.01f;
+        primitive_spans_epsilon_plane = minimum.z < EPSILON && geometry->splittable();
+        if ( !culled && !primitive_spans_epsilon_plane )
+        {
+            vec2 screen_minimum;
+            vec2 screen_maximum;
+            renderer_->raster_bound( minimum, maximum, &screen_minimum, &screen_maximum );
+            
+            float x0 = screen_minimum.x;
+            float x1 = screen_maximum.x;
+            float y0 = screen_minimum.y;
+            float y1 = screen_maximum.y;
+
+            culled = x1 < X0 || x0 >= X1 || y1 < Y0 || y0 >= Y1;
+            if ( !culled )
+            {
+                std::lock_guard<std::mutex> lock( worker->sample_buffer_mutex_ );
+                culled = sample_buffer->occluded( x0, x1, y0, y1, minimum.z );
+                occluded_grids_ += culled ? 1 : 0;
+            }
+
+            float pixels = (x1 - x0) * (y1 - y0) / SAMPLES_PER_PIXEL;
+            float micropolygons = pixels / attributes_->shading_rate();
+            int power = std::max( 0, int(ceilf(renderer_->lb(micropolygons) / 2.0f)) );
+            width = std::min( 1 << power, SHRT_MAX );
+            height = std::min( 1 << power, SHRT_MAX );
+        }
+    }
+    
+    if ( !culled )
+    {
+        if ( !primitive_spans_epsilon_plane && width * height <= MAXIMUM_VERTICES_PER_GRID && geometry->diceable() )
+        {
+            {
+                Grid grid;
+                grid.set_value_pool( value_pool_ );
+                geometry->dice( transform, u_range, v_range, width, height, &grid );
+                attributes_->displacement_shade( grid );
+                attributes_->surface_shade( grid );
+                sample( grid, worker );
+                ++shaded_grids_;
+            }
+            value_pool_->reset();
+        }
+        else if ( geometry->splittable() )
+        {
+            vec2 u_ranges[Geometry::SPLIT_PIECES];
+            vec2 v_ranges[Geometry::SPLIT_PIECES];
+            geometry->split( u_range, v_range, u_ranges, v_ranges );
+            worker->outstanding_split_jobs_ += Geometry::SPLIT_PIECES;
+            for ( int i = Geometry::SPLIT_PIECES - 1; i >= 0; --i )
+            {
+                split_jobs_->push( SplitJob(primitive, u_ranges[i], v_ranges[i], worker) );
+            }
+        }
+    }
+
+    shading_attributes_on_thread = NULL;
+    --worker->outstanding_split_jobs_;
+}
+
+/**
+// Use \e attributes to render the geometry in subsequent split jobs.
+//
+// Shading adds and removes named coordinate systems to and from the
+// attributes that a primitive is rendered with and the same attributes are
+// shared by primitives in different buckets and by split jobs processed by
+// different workers.  Geometry is rendered with a copy of its attributes 
+// private to this worker that is reused for consecutive jobs that share the 
+// same attributes.  Retained primitives each have their own immutable 
+// snapshot so this only reuses the copy between jobs split from the same 
+// primitive, and Worker::render() discards it before each primitive that's
+// rendered immediately.  The current transform is also used to define the 
+// "object" coordinate system in that copy so that shaders can refer to it.
+//
+// @param attributes
+//  The attributes to use (assumed not null).
+*/
+void Worker::use_attributes( const std::shared_ptr<Attributes>& attributes )
+{
+    REYES_ASSERT( attributes );
+    if ( attributes != shared_attributes_ )
+    {
+        delete attributes_;
+        attributes_ = new Attributes( *attributes );
+        attributes_->set_virtual_machine( virtual_machine_ );
+        attributes_->copy_shader_parameters();
+        attributes_->add_coordinate_system( "object", renderer_->camera_transform() * attributes_->transform() );
+        shared_attributes_ = attributes;
+    }
+}
+
+/**
+// Sample \e grid into the sample buffer of \e worker.
+//
+// @param grid
+//  The grid to sample.
+//
+// @param worker
+//  The worker whose sample buffer \e grid is sampled into (assumed not null).
+*/
+void Worker::sample( const Grid& grid, Worker* worker )
+{
+    REYES_ASSERT( sampler_ );
+    REYES_ASSERT( attributes_ );
+    REYES_ASSERT( worker );
+    bool matte = attributes_->matte();
+    bool two_sided = attributes_->two_sided();
+    bool left_handed = attributes_->geometry_left_handed();
+    std::lock_guard<std::mutex> lock( worker->sample_buffer_mutex_ );
+    sampler_->sample( renderer_->screen_transform(), grid, matte, two_sided, left_handed, worker->sample_buffer_ );
+}
@@ -0,0 +1,68 @@
+#ifndef REYES_WORKER_HPP_INCLUDED
+#define REYES_WORKER_HPP_INCLUDED
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <random>
+
+namespace reyes
+{
+
+class Renderer;
+class Attributes;
+class VirtualMachine;
+class SampleBuffer;
+class ImageBuffer;
+class Sampler;
+class Primitive;
+class Grid;
+class Bucket;
+class SplitJob;
+class WorkStealingDeque;
+class ValuePool;
+
+/**
+// The state needed to split, dice, shade, and sample primitives on a single
+// thread.
+*/
+class Worker
+{
+    const Renderer* renderer_; ///< The Renderer that this worker renders primitives for.
+    VirtualMachine* virtual_machine_; ///< The virtual machine used to execute shaders on this worker.
+    SampleBuffer* sample_buffer_; ///< The sample buffer that grids are sampled into.
+    std::mutex sample_buffer_mutex_; ///< Serializes sampling into the sample buffer by this and other workers.
+    Sampler* sampler_; ///< The sampler that samples grids into the sample buffer.
+    ValuePool* value_pool_; ///< The pool that the values of grids diced by this worker are allocated from.
+    ImageBuffer* image_buffer_; ///< The image buffer that each bucket is filtered and exposed into.
+    std::shared_ptr<Attributes> shared_attributes_; ///< The attributes that this worker's attributes were last copied from.
+    Attributes* attributes_; ///< This worker's copy of the attributes of the primitive being rendered.
+    WorkStealingDeque* split_jobs_; ///< The split jobs waiting to be processed by this worker or stolen by other workers.
+    std::atomic<int> outstanding_split_jobs_; ///< The number of split jobs sampling into this worker's sample buffer that haven't yet completed.
+    int shaded_grids_; ///< The number of grids diced and shaded by this worker.
+    int occluded_grids_; ///< The number of pieces of geometry culled as occluded by this worker before being diced and shaded.
+    std::minstd_rand random_; ///< The random number generator used to dither buckets quantized by this worker.
+
+public:
+    Worker( const Renderer& renderer, int width, int height, float raster_width, float raster_height );
+    ~Worker();
+    SampleBuffer* sample_buffer() const;
+    int shaded_grids() const;
+    int occluded_grids() const;
+    void render_buckets( const std::vector<Worker*>& workers, const std::vector<Bucket*>& buckets, std::atomic<int>* next_bucket, ImageBuffer* image_buffer );
+    void render_bucket( const std::vector<Worker*>& workers, Bucket& bucket, ImageBuffer* image_buffer );
+    void render( const Primitive& primitive );
+    static Attributes* shading_attributes();
+
+private:
+    bool busy( const std::vector<Worker*>& workers ) const;
+    bool steal( const std::vector<Worker*>& workers, SplitJob* job );
+    void split( const SplitJob& job );
+    void use_attributes( const std::shared_ptr<Attributes>& attributes );
+    void sample( const Grid& grid, Worker* worker );
+};
+
+}
+
+#endif
@@ -0,0 +1,55 @@
+//
+// file.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "stdafx.hpp"
+#include "file.hpp"
+#include "assert.hpp"
+#include <stdio.h>
+
+namespace reyes
+{
+
+/**
+// Read a whole file into memory with a single read.
+//
+// Used to read shader sources and cached shaders, reading a file this way
+// rather than iterating over a stream a character at a time costs less 
+// than parsing or loading what has been read.
+//
+// @param filename
+//  The name of the file to read (assumed not null).
+//
+// @param data
+//  The vector to read the file's contents into (assumed not null).
+//
+// @return
+//  True if the whole file was read otherwise false.
+*/
+bool read_file( const char* filename, std::vector<unsigned char>* data )
+{
+    REYES_ASSERT( filename );
+    REYES_ASSERT( data );
+
+    FILE* file = fopen( filename, "rb" );
+    if ( !file )
+    {
+        return false;
+    }
+
+    bool read = false;
+    if ( fseek(file, 0, SEEK_END) == 0 )
+    {
+        long size = ftell( file );
+        if ( size >= 0 && fseek(file, 0, SEEK_SET) == 0 )
+        {
+            data->resize( size );
+            read = size == 0 || fread( &(*data)[0], 1, size, file ) == size_t(size);
+        }
+    }
+    fclose( file );
+    return read;
+}
+
+}
@@ -0,0 +1,13 @@
+#ifndef REYES_FILE_HPP_INCLUDED
+#define REYES_FILE_HPP_INCLUDED
+
+#include <vector>
+
+namespace reyes
+{
+
+bool read_file( const char* filename, std::vector<unsigned char>* data );
+
+}
+
+#endif
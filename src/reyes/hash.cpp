@@ -0,0 +1,52 @@
+//
+// hash.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "stdafx.hpp"
+#include "hash.hpp"
+
+namespace reyes
+{
+
+/**
+// Continue a 64 bit FNV-1a hash over bytes.
+//
+// Used for fingerprints of symbol tables and byte code and for keys and
+// checksums of cached shaders.  Hashes aren't stable across machines of
+// different endianness.
+//
+// @param data
+//  The bytes to hash (may be null if \e length is zero).
+//
+// @param length
+//  The number of bytes to hash.
+//
+// @param seed
+//  The hash to continue, HASH_SEED to start a new hash.
+//
+// @return
+//  The hash of \e seed continued over \e data.
+*/
+uint64_t hash( const void* data, size_t length, uint64_t seed )
+{
+    uint64_t value = seed;
+    const unsigned char* bytes = static_cast<const unsigned char*>( data );
+    for ( size_t i = 0; i < length; ++i )
+    {
+        value ^= bytes[i];
+        value *= UINT64_C(1099511628211);
+    }
+    return value;
+}
+
+/**
+// Continue a 64 bit FNV-1a hash over an integer stored as 32 bits.
+*/
+uint64_t hash( int value, uint64_t seed )
+{
+    const int32_t word = value;
+    return hash( &word, sizeof(word), seed );
+}
+
+}
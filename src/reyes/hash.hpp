@@ -0,0 +1,20 @@
+#ifndef REYES_HASH_HPP_INCLUDED
+#define REYES_HASH_HPP_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace reyes
+{
+
+/**
+// The value to start hashes with (the 64 bit FNV-1a offset basis).
+*/
+static const uint64_t HASH_SEED = UINT64_C(14695981039346656037);
+
+uint64_t hash( const void* data, size_t length, uint64_t seed = HASH_SEED );
+uint64_t hash( int value, uint64_t seed );
+
+}
+
+#endif
@@ -0,0 +1,120 @@
+//
+// main.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include <reyes/ShaderParser.hpp>
+#include <reyes/SymbolTable.hpp>
+#include <reyes/ErrorPolicy.hpp>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using std::string;
+using std::vector;
+using std::shared_ptr;
+using std::istream_iterator;
+using std::chrono::steady_clock;
+using std::chrono::duration;
+using namespace reyes;
+
+/**
+// Parse a shader by extracting its characters one at a time through an 
+// istream_iterator, as ShaderParser::parse() did before reading files with
+// a single read, and then parsing them from memory.
+*/
+static shared_ptr<SyntaxNode> parse_from_stream( ShaderParser& shader_parser, const char* filename )
+{
+    std::ifstream stream( filename, std::ios::binary );
+    if ( !stream.is_open() )
+    {
+        return shared_ptr<SyntaxNode>();
+    }
+    stream.unsetf( std::iostream::skipws );
+    string source( (istream_iterator<char>(stream)), istream_iterator<char>() );
+    return shader_parser.parse( source.c_str(), source.c_str() + source.size() );
+}
+
+/**
+// Time parsing shaders from files.
+//
+// Usage: reyes_benchmark [-n iterations] [shader.sl...]
+//
+// Parses each shader, the shaders in the shaders directory if none are 
+// given, the given number of times (100 by default) with 
+// ShaderParser::parse() and through an istream_iterator and prints the 
+// time taken by each.
+*/
+int main( int argc, char** argv )
+{
+    int iterations = 100;
+    int argument = 1;
+    if ( argument + 1 < argc && strcmp(argv[argument], "-n") == 0 )
+    {
+        iterations = atoi( argv[argument + 1] );
+        argument += 2;
+    }
+
+    if ( iterations <= 0 )
+    {
+        fprintf( stderr, "Usage: reyes_benchmark [-n iterations] [shader.sl...]\n" );
+        return EXIT_FAILURE;
+    }
+
+    vector<string> filenames( argv + argument, argv + argc );
+    if ( filenames.empty() )
+    {
+        const char* SHADERS [] =
+        {
+            "ambientlight.sl", "bumpy.sl", "constant.sl", "depthcue.sl", 
+            "distantlight.sl", "fog.sl", "matte.sl", "metal.sl", "painted.sl", 
+            "paintedplastic.sl", "plastic.sl", "pointlight.sl", 
+            "shadowpointlight.sl", "shinymetal.sl", "spotlight.sl", "wavy.sl"
+        };
+        for ( size_t i = 0; i < sizeof(SHADERS) / sizeof(SHADERS[0]); ++i )
+        {
+            filenames.push_back( string(SHADERS_PATH) + SHADERS[i] );
+        }
+    }
+
+    ErrorPolicy error_policy;
+    SymbolTable symbol_table;
+    ShaderParser shader_parser( symbol_table, &error_policy );
+    double file_total = 0.0;
+    double stream_total = 0.0;
+    for ( vector<string>::const_iterator filename = filenames.begin(); filename != filenames.end(); ++filename )
+    {
+        steady_clock::time_point start = steady_clock::now();
+        for ( int i = 0; i < iterations; ++i )
+        {
+            if ( !shader_parser.parse(filename->c_str()) )
+            {
+                fprintf( stderr, "reyes_benchmark: Parsing '%s' failed\n", filename->c_str() );
+                return EXIT_FAILURE;
+            }
+        }
+        steady_clock::time_point middle = steady_clock::now();
+        for ( int i = 0; i < iterations; ++i )
+        {
+            if ( !parse_from_stream(shader_parser, filename->c_str()) )
+            {
+                fprintf( stderr, "reyes_benchmark: Parsing '%s' failed\n", filename->c_str() );
+                return EXIT_FAILURE;
+            }
+        }
+        steady_clock::time_point finish = steady_clock::now();
+
+        const double file_time = duration<double, std::milli>( middle - start ).count() / iterations;
+        const double stream_time = duration<double, std::milli>( finish - middle ).count() / iterations;
+        file_total += file_time;
+        stream_total += stream_time;
+        printf( "%s: %.3fms read, %.3fms istream_iterator\n", filename->c_str(), file_time, stream_time );
+    }
+    printf( "total: %.3fms read, %.3fms istream_iterator\n", file_total, stream_total );
+    return EXIT_SUCCESS;
+}
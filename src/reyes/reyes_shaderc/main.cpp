@@ -0,0 +1,76 @@
+//
+// main.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include <reyes/Shader.hpp>
+#include <reyes/SymbolTable.hpp>
+#include <reyes/ErrorPolicy.hpp>
+#include <reyes/NativeGenerator.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace reyes;
+
+/**
+// Compile shaders ahead of time into C++ source.
+//
+// Usage: reyes_shaderc [-f function] output.cpp shader.sl...
+//
+// The generated source defines a NativeShader for each shader and a 
+// function, named add_native_shaders unless overridden with -f, that adds 
+// all of them to a Renderer.  Call that function before loading shaders to
+// have matching shaders executed natively instead of being interpreted.
+*/
+int main( int argc, char** argv )
+{
+    const char* function = "add_native_shaders";
+    int argument = 1;
+    if ( argument + 1 < argc && strcmp(argv[argument], "-f") == 0 )
+    {
+        function = argv[argument + 1];
+        argument += 2;
+    }
+
+    if ( argc - argument < 2 )
+    {
+        fprintf( stderr, "Usage: reyes_shaderc [-f function] output.cpp shader.sl...\n" );
+        return EXIT_FAILURE;
+    }
+
+    const char* output = argv[argument];
+    ++argument;
+
+    ErrorPolicy error_policy;
+    SymbolTable symbol_table;
+    NativeGenerator native_generator;
+    for ( ; argument < argc; ++argument )
+    {
+        const char* filename = argv[argument];
+        Shader shader( filename, symbol_table, error_policy );
+        if ( error_policy.total_errors() > 0 )
+        {
+            fprintf( stderr, "reyes_shaderc: Compiling '%s' failed\n", filename );
+            return EXIT_FAILURE;
+        }
+        native_generator.generate( shader, filename );
+    }
+    native_generator.generate_registration( function );
+
+    FILE* file = fopen( output, "wb" );
+    if ( !file )
+    {
+        fprintf( stderr, "reyes_shaderc: Opening '%s' to write failed\n", output );
+        return EXIT_FAILURE;
+    }
+    const std::string& source = native_generator.source();
+    size_t written = fwrite( source.c_str(), 1, source.size(), file );
+    fclose( file );
+    if ( written != source.size() )
+    {
+        fprintf( stderr, "reyes_shaderc: Writing '%s' failed\n", output );
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
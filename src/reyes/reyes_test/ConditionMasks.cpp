@@ -0,0 +1,111 @@
+
+#include <UnitTest++/UnitTest++.h>
+#include <reyes/reyes_virtual_machine/ConditionMask.hpp>
+#include <reyes/Value.hpp>
+
+using namespace reyes;
+
+SUITE( ConditionMasks )
+{
+    // Spans two whole mask words and a partial third word.
+    static const unsigned int LENGTH = 150;
+
+    struct ConditionMaskTest
+    {
+        Value condition;
+        Value other_condition;
+        int* values;
+        int* other_values;
+
+        ConditionMaskTest()
+        : condition( TYPE_INTEGER, STORAGE_VARYING, LENGTH ),
+          other_condition( TYPE_INTEGER, STORAGE_VARYING, LENGTH ),
+          values( NULL ),
+          other_values( NULL )
+        {
+            condition.zero();
+            values = condition.int_values();
+            other_condition.zero();
+            other_values = other_condition.int_values();
+        }
+    };
+
+    TEST_FIXTURE( ConditionMaskTest, empty_mask )
+    {
+        ConditionMask mask;
+        mask.generate( &condition );
+        CHECK( mask.empty() );
+        CHECK( !mask.full() );
+        CHECK_EQUAL( 0, mask.processed() );
+        CHECK_EQUAL( 3u, (unsigned int) mask.mask().size() );
+    }
+
+    TEST_FIXTURE( ConditionMaskTest, full_mask )
+    {
+        for ( unsigned int i = 0; i < LENGTH; ++i )
+        {
+            values[i] = 1;
+        }
+        ConditionMask mask;
+        mask.generate( &condition );
+        CHECK( mask.full() );
+        CHECK_EQUAL( int(LENGTH), mask.processed() );
+    }
+
+    TEST_FIXTURE( ConditionMaskTest, invert_keeps_bits_past_last_element_clear )
+    {
+        values[3] = 1;
+        values[70] = 1;
+        ConditionMask mask;
+        mask.generate( &condition );
+        CHECK_EQUAL( 2, mask.processed() );
+        mask.invert();
+        CHECK_EQUAL( int(LENGTH) - 2, mask.processed() );
+        CHECK_EQUAL( 0u, (unsigned int) (mask.mask()[2] >> (LENGTH % MASK_WORD_BITS)) );
+        mask.invert();
+        CHECK_EQUAL( 2, mask.processed() );
+    }
+
+    TEST_FIXTURE( ConditionMaskTest, nested_mask_intersects_existing_mask )
+    {
+        for ( unsigned int i = 0; i < LENGTH; ++i )
+        {
+            values[i] = i % 2;
+            other_values[i] = i < 100;
+        }
+        ConditionMask mask;
+        mask.generate( &condition );
+        ConditionMask nested_mask;
+        nested_mask.generate( mask, &other_condition );
+        CHECK_EQUAL( 50, nested_mask.processed() );
+    }
+
+    TEST_FIXTURE( ConditionMaskTest, active_ranges )
+    {
+        for ( unsigned int i = 0; i < 130; ++i )
+        {
+            values[i] = 1;
+        }
+        values[5] = 0;
+        values[140] = 1;
+        values[149] = 1;
+        ConditionMask mask;
+        mask.generate( &condition );
+
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        CHECK( next_active_range(&mask.mask()[0], LENGTH, &begin, &end) );
+        CHECK_EQUAL( 0u, begin );
+        CHECK_EQUAL( 5u, end );
+        CHECK( next_active_range(&mask.mask()[0], LENGTH, &begin, &end) );
+        CHECK_EQUAL( 6u, begin );
+        CHECK_EQUAL( 130u, end );
+        CHECK( next_active_range(&mask.mask()[0], LENGTH, &begin, &end) );
+        CHECK_EQUAL( 140u, begin );
+        CHECK_EQUAL( 141u, end );
+        CHECK( next_active_range(&mask.mask()[0], LENGTH, &begin, &end) );
+        CHECK_EQUAL( 149u, begin );
+        CHECK_EQUAL( 150u, end );
+        CHECK( !next_active_range(&mask.mask()[0], LENGTH, &begin, &end) );
+    }
+}
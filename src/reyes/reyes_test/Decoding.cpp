@@ -0,0 +1,392 @@
+
+#include <UnitTest++/UnitTest++.h>
+#include <reyes/Renderer.hpp>
+#include <reyes/SymbolTable.hpp>
+#include <reyes/ErrorPolicy.hpp>
+#include <reyes/Shader.hpp>
+#include <reyes/reyes_virtual_machine/Instruction.hpp>
+#include <reyes/reyes_virtual_machine/Operation.hpp>
+#include <reyes/assert.hpp>
+#include <vector>
+#include <memory>
+#include <string.h>
+
+using std::vector;
+using std::shared_ptr;
+using namespace reyes;
+
+SUITE( Decoding )
+{
+    struct DecodingTest
+    {
+        Renderer renderer;
+        shared_ptr<Shader> shader;
+        int forward_jumps;
+        int backward_jumps;
+        int illuminance_jumps;
+
+        DecodingTest()
+        : renderer(),
+          shader(),
+          forward_jumps( 0 ),
+          backward_jumps( 0 ),
+          illuminance_jumps( 0 )
+        {
+        }
+
+        // The number of arguments encoded after each instruction in the 
+        // byte code.
+        static int arguments( int instruction )
+        {
+            switch ( instruction )
+            {
+                case INSTRUCTION_HALT:
+                case INSTRUCTION_CLEAR_MASK:
+                case INSTRUCTION_INVERT_MASK:
+                case INSTRUCTION_SOLAR:
+                    return 0;
+                case INSTRUCTION_RESET:
+                case INSTRUCTION_GENERATE_MASK:
+                case INSTRUCTION_JUMP_EMPTY:
+                case INSTRUCTION_JUMP_NOT_EMPTY:
+                case INSTRUCTION_JUMP_ILLUMINANCE:
+                case INSTRUCTION_JUMP:
+                case INSTRUCTION_NEGATE:
+                case INSTRUCTION_CONVERT:
+                case INSTRUCTION_PROMOTE:
+                case INSTRUCTION_CALL_0:
+                    return 1;
+                case INSTRUCTION_FLOAT_TEXTURE:
+                case INSTRUCTION_VEC3_TEXTURE:
+                case INSTRUCTION_SHADOW:
+                case INSTRUCTION_CALL_2:
+                    return 3;
+                case INSTRUCTION_CALL_3:
+                case INSTRUCTION_SOLAR_AXIS_ANGLE:
+                    return 4;
+                case INSTRUCTION_CALL_4:
+                case INSTRUCTION_ILLUMINATE:
+                    return 5;
+                case INSTRUCTION_CALL_5:
+                case INSTRUCTION_ILLUMINANCE_AXIS_ANGLE:
+                    return 6;
+                case INSTRUCTION_ILLUMINATE_AXIS_ANGLE:
+                    return 7;
+                default:
+                    return 2;
+            }
+        }
+
+        // True if \e instruction implicitly allocates the next register for
+        // its result.
+        static bool result( int instruction )
+        {
+            return 
+                (instruction >= INSTRUCTION_TRANSFORM_POINT && instruction <= INSTRUCTION_PROMOTE) ||
+                (instruction >= INSTRUCTION_FLOAT_TEXTURE && instruction <= INSTRUCTION_CALL_5) ||
+                instruction == INSTRUCTION_ILLUMINANCE_AXIS_ANGLE
+            ;
+        }
+
+        static bool jump( int instruction )
+        {
+            return instruction >= INSTRUCTION_JUMP_EMPTY && instruction <= INSTRUCTION_JUMP;
+        }
+
+        // The arguments of \e instruction that read registers written by 
+        // earlier instructions as opposed to symbols, constants, or jump 
+        // distances.
+        static void register_arguments( int instruction, int* first, int* last )
+        {
+            REYES_ASSERT( first );
+            REYES_ASSERT( last );
+            *first = 0;
+            *last = -1;
+            if ( instruction >= INSTRUCTION_DOT && instruction <= INSTRUCTION_NOT_EQUAL )
+            {
+                *last = 1;
+            }
+            else if ( instruction >= INSTRUCTION_NEGATE && instruction <= INSTRUCTION_PROMOTE )
+            {
+                *last = 0;
+            }
+            else if ( instruction == INSTRUCTION_GENERATE_MASK )
+            {
+                *last = 0;
+            }
+            else if ( instruction == INSTRUCTION_ASSIGN || (instruction >= INSTRUCTION_ADD_ASSIGN && instruction <= INSTRUCTION_DIVIDE_ASSIGN) )
+            {
+                *first = 1;
+                *last = 1;
+            }
+        }
+
+        static int read_short( const vector<unsigned char>& code, int address )
+        {
+            REYES_ASSERT( address + int(sizeof(short)) <= int(code.size()) );
+            short value = 0;
+            memcpy( &value, &code[address], sizeof(value) );
+            return value;
+        }
+
+        static int read_int( const vector<unsigned char>& code, int address )
+        {
+            REYES_ASSERT( address + int(sizeof(int)) <= int(code.size()) );
+            int value = 0;
+            memcpy( &value, &code[address], sizeof(value) );
+            return value;
+        }
+
+        void compile( const char* source )
+        {
+            shader.reset( new Shader(source, source + strlen(source), renderer.symbol_table(), renderer.error_policy()) );
+            CHECK_EQUAL( 0, renderer.error_policy().total_errors() );
+        }
+
+        // Walk the shader's byte code independently of its decoded 
+        // operations and check that each operation matches the instruction
+        // it was decoded from, that result registers follow the code 
+        // generator's implicit allocation and resets, that operands only 
+        // read registers written earlier in the same fragment, and that 
+        // jumps land on the operation decoded from their target address.
+        void check_decoding()
+        {
+            REYES_ASSERT( shader );
+            const vector<unsigned char>& code = shader->code();
+            const vector<Operation>& operations = shader->operations();
+            const int permanent_registers = shader->permanent_registers();
+            const int size = int(code.size());
+
+            vector<int> operation_addresses;
+            vector<int> jump_addresses;
+            vector<int> jump_operations;
+            vector<bool> written( shader->registers(), false );
+            int register_index = permanent_registers;
+            int address = 0;
+            while ( address < size )
+            {
+                if ( address == shader->initialize_address() || address == shader->shade_address() )
+                {
+                    register_index = permanent_registers;
+                    written.assign( shader->registers(), false );
+                }
+
+                const int instruction = read_short( code, address );
+                const int dispatch = read_short( code, address + sizeof(short) );
+                const int arguments_address = address + 2 * sizeof(short);
+                const int end_address = arguments_address + arguments( instruction ) * sizeof(int);
+                if ( instruction == INSTRUCTION_RESET )
+                {
+                    register_index = read_int( code, arguments_address );
+                    address = end_address;
+                    continue;
+                }
+
+                const int index = int(operation_addresses.size());
+                CHECK( index < int(operations.size()) );
+                if ( index >= int(operations.size()) )
+                {
+                    return;
+                }
+                const Operation& operation = operations[index];
+                CHECK_EQUAL( address, operation.address );
+                CHECK_EQUAL( instruction, operation.instruction );
+                CHECK_EQUAL( dispatch, operation.dispatch );
+                for ( int i = 0; i < arguments(instruction); ++i )
+                {
+                    CHECK_EQUAL( read_int(code, arguments_address + i * sizeof(int)), operation.arguments[i] );
+                }
+
+                int first = 0;
+                int last = -1;
+                register_arguments( instruction, &first, &last );
+                for ( int i = first; i <= last; ++i )
+                {
+                    const int argument = operation.arguments[i];
+                    CHECK( argument >= 0 && argument < shader->registers() );
+                    CHECK( argument < permanent_registers || (argument < int(written.size()) && written[argument]) );
+                }
+
+                if ( result(instruction) )
+                {
+                    CHECK_EQUAL( register_index, operation.result );
+                    CHECK( operation.result < shader->registers() );
+                    if ( register_index >= 0 && register_index < int(written.size()) )
+                    {
+                        written[register_index] = true;
+                    }
+                    ++register_index;
+                }
+                else
+                {
+                    CHECK_EQUAL( -1, operation.result );
+                }
+
+                if ( jump(instruction) )
+                {
+                    jump_addresses.push_back( end_address + read_int(code, arguments_address) );
+                    jump_operations.push_back( index );
+                }
+                else
+                {
+                    CHECK_EQUAL( -1, operation.target );
+                }
+
+                operation_addresses.push_back( address );
+                address = end_address;
+            }
+            CHECK_EQUAL( size, address );
+            CHECK_EQUAL( operations.size(), operation_addresses.size() );
+
+            for ( unsigned int i = 0; i < jump_operations.size(); ++i )
+            {
+                const Operation& operation = operations[jump_operations[i]];
+                const int target_address = jump_addresses[i];
+                if ( target_address == size )
+                {
+                    CHECK_EQUAL( int(operations.size()), operation.target );
+                }
+                else
+                {
+                    CHECK( operation.target >= 0 && operation.target < int(operations.size()) );
+                    if ( operation.target >= 0 && operation.target < int(operations.size()) )
+                    {
+                        CHECK_EQUAL( target_address, operations[operation.target].address );
+                    }
+                }
+                forward_jumps += operation.target > jump_operations[i] ? 1 : 0;
+                backward_jumps += operation.target <= jump_operations[i] ? 1 : 0;
+                illuminance_jumps += operation.instruction == INSTRUCTION_JUMP_ILLUMINANCE ? 1 : 0;
+            }
+        }
+    };
+
+    TEST_FIXTURE( DecodingTest, if_else_statements_jump_forward )
+    {
+        compile(
+            "surface if_else_statements_jump_forward() { \n"
+            "   float y = 0; \n"
+            "   if ( s > 0.5 ) { \n"
+            "       y = s * 2; \n"
+            "   } else { \n"
+            "       y = t + 1; \n"
+            "   } \n"
+            "   Ci = color(y, y, y); \n"
+            "}"
+        );
+        check_decoding();
+        CHECK( forward_jumps >= 2 );
+        CHECK_EQUAL( 0, backward_jumps );
+    }
+
+    TEST_FIXTURE( DecodingTest, while_loops_with_break_and_continue_jump_both_ways )
+    {
+        compile(
+            "surface while_loops_with_break_and_continue_jump_both_ways() { \n"
+            "   float i = 0; \n"
+            "   float y = 0; \n"
+            "   while ( i < 8 ) { \n"
+            "       i += 1; \n"
+            "       if ( i == 2 ) { \n"
+            "           continue; \n"
+            "       } \n"
+            "       if ( i > s * 8 ) { \n"
+            "           break; \n"
+            "       } \n"
+            "       y += i * t; \n"
+            "   } \n"
+            "   Ci = color(y, y, y); \n"
+            "}"
+        );
+        check_decoding();
+        CHECK( forward_jumps > 0 );
+        CHECK( backward_jumps > 0 );
+    }
+
+    TEST_FIXTURE( DecodingTest, for_loops_with_break_and_continue_jump_both_ways )
+    {
+        compile(
+            "surface for_loops_with_break_and_continue_jump_both_ways() { \n"
+            "   float i; \n"
+            "   float y = 0; \n"
+            "   for ( i = 0; i < 8; i += 1 ) { \n"
+            "       if ( i == 2 ) { \n"
+            "           continue; \n"
+            "       } \n"
+            "       if ( i > s * 8 ) { \n"
+            "           break; \n"
+            "       } \n"
+            "       y += -i / (t + 1); \n"
+            "   } \n"
+            "   Ci = color(y, y, y); \n"
+            "}"
+        );
+        check_decoding();
+        CHECK( forward_jumps > 0 );
+        CHECK( backward_jumps > 0 );
+    }
+
+    TEST_FIXTURE( DecodingTest, illuminance_statements_jump_to_the_next_light )
+    {
+        compile(
+            "surface illuminance_statements_jump_to_the_next_light() { \n"
+            "   Ci = 0; \n"
+            "   illuminance( P, N, 1.5708 ) { \n"
+            "       if ( s > 0.5 ) { \n"
+            "           Ci += Cl * (N . normalize(L)); \n"
+            "       } \n"
+            "   } \n"
+            "}"
+        );
+        check_decoding();
+        CHECK( illuminance_jumps > 0 );
+        CHECK( forward_jumps > 0 );
+    }
+
+    TEST_FIXTURE( DecodingTest, normalized_temporaries_read_only_by_dot_products_are_planar )
+    {
+        compile(
+            "surface normalized_temporaries_read_only_by_dot_products_are_planar() { \n"
+            "   vector n = normalize( N ); \n"
+            "   float d = normalize(N) . normalize(normalize(I)); \n"
+            "   Ci = color(d, d, d); \n"
+            "   illuminance( P, N, 1.5708 ) { \n"
+            "       Ci += Cl * (n . normalize(L)); \n"
+            "   } \n"
+            "}"
+        );
+        check_decoding();
+
+        int planar_calls = 0;
+        int interleaved_calls = 0;
+        int planar_dots = 0;
+        const vector<Operation>& operations = shader->operations();
+        for ( vector<Operation>::const_iterator i = operations.begin(); i != operations.end(); ++i )
+        {
+            planar_calls += i->instruction == INSTRUCTION_CALL_1 && i->planes ? 1 : 0;
+            interleaved_calls += i->instruction == INSTRUCTION_CALL_1 && !i->planes ? 1 : 0;
+            planar_dots += i->instruction == INSTRUCTION_DOT && i->planes ? 1 : 0;
+            CHECK( !i->planes || i->instruction == INSTRUCTION_CALL_1 || i->instruction == INSTRUCTION_DOT );
+        }
+        CHECK_EQUAL( 4, planar_calls );
+        CHECK_EQUAL( 1, interleaved_calls );
+        CHECK_EQUAL( 2, planar_dots );
+    }
+
+    TEST_FIXTURE( DecodingTest, stock_shaders_decode_consistently )
+    {
+        const char* FILENAMES [] =
+        {
+            SHADERS_PATH "constant.sl",
+            SHADERS_PATH "matte.sl",
+            SHADERS_PATH "metal.sl",
+            SHADERS_PATH "plastic.sl"
+        };
+        for ( unsigned int i = 0; i < sizeof(FILENAMES) / sizeof(FILENAMES[0]); ++i )
+        {
+            shader.reset( new Shader(FILENAMES[i], renderer.symbol_table(), renderer.error_policy()) );
+            CHECK_EQUAL( 0, renderer.error_policy().total_errors() );
+            check_decoding();
+        }
+    }
+}
@@ -0,0 +1,228 @@
+
+#include <UnitTest++/UnitTest++.h>
+#include <reyes/Geometry.hpp>
+#include <reyes/Sphere.hpp>
+#include <reyes/Cone.hpp>
+#include <reyes/Cylinder.hpp>
+#include <reyes/Disk.hpp>
+#include <reyes/Hyperboloid.hpp>
+#include <reyes/Paraboloid.hpp>
+#include <reyes/Torus.hpp>
+#include <reyes/CubicPatch.hpp>
+#include <reyes/LinearPatch.hpp>
+#include <reyes/Grid.hpp>
+#include <reyes/GridSlot.hpp>
+#include <reyes/Value.hpp>
+#include <reyes/assert.hpp>
+#include <math/vec2.ipp>
+#include <math/vec3.ipp>
+#include <math/vec4.ipp>
+#include <math/mat4x4.ipp>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+using std::vector;
+using std::shared_ptr;
+using namespace math;
+using namespace reyes;
+
+static const float TOLERANCE = 0.01f;
+
+static const float BEZIER_BASIS [16] =
+{
+    -1.0f,  3.0f, -3.0f,  1.0f,
+     3.0f, -6.0f,  3.0f,  0.0f,
+    -3.0f,  3.0f,  0.0f,  0.0f,
+     1.0f,  0.0f,  0.0f,  0.0f
+};
+
+SUITE( Dicing )
+{
+    struct DicingTest
+    {
+        vec3 cubic_positions [16];
+        vector<shared_ptr<Geometry> > quadrics;
+        vector<shared_ptr<Geometry> > patches;
+        mat4x4 transform;
+
+        DicingTest()
+        : quadrics(),
+          patches(),
+          transform()
+        {
+            const float THETAMAX = 1.5f * float(M_PI);
+            quadrics.push_back( shared_ptr<Geometry>(new Sphere(1.0f, -0.5f, 0.8f, THETAMAX)) );
+            quadrics.push_back( shared_ptr<Geometry>(new Cone(2.0f, 1.0f, THETAMAX)) );
+            quadrics.push_back( shared_ptr<Geometry>(new Cylinder(1.0f, -1.0f, 1.0f, THETAMAX)) );
+            quadrics.push_back( shared_ptr<Geometry>(new Disk(0.5f, 1.0f, THETAMAX)) );
+            quadrics.push_back( shared_ptr<Geometry>(new Hyperboloid(vec3(1.0f, 0.0f, -1.0f), vec3(0.5f, 1.0f, 1.0f), THETAMAX)) );
+            quadrics.push_back( shared_ptr<Geometry>(new Paraboloid(1.0f, 0.2f, 2.0f, THETAMAX)) );
+            quadrics.push_back( shared_ptr<Geometry>(new Torus(2.0f, 0.5f, 0.0f, THETAMAX, THETAMAX)) );
+
+            for ( int j = 0; j < 4; ++j )
+            {
+                for ( int i = 0; i < 4; ++i )
+                {
+                    cubic_positions[j * 4 + i] = vec3( float(i), float(j), float((i * 3 + j * 5) % 4) - 1.5f );
+                }
+            }
+            const vec4* basis = reinterpret_cast<const vec4*>( BEZIER_BASIS );
+            patches.push_back( shared_ptr<Geometry>(new CubicPatch(cubic_positions, basis, basis)) );
+
+            const vec3 positions [4] = { vec3(-1.0f, -1.0f, 0.0f), vec3(1.0f, -1.0f, 0.5f), vec3(-1.0f, 1.0f, -0.5f), vec3(1.0f, 1.0f, 1.0f) };
+            const vec3 normals [4] = { vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, 0.0f, -1.0f) };
+            const vec2 texture_coordinates [4] = { vec2(0.0f, 0.0f), vec2(1.0f, 0.0f), vec2(0.0f, 1.0f), vec2(1.0f, 1.0f) };
+            patches.push_back( shared_ptr<Geometry>(new LinearPatch(positions, normals, texture_coordinates)) );
+
+            transform = math::translate( 1.0f, 2.0f, 10.0f ) * math::rotate( vec3(1.0f, 0.0f, 0.0f), 0.5f );
+        }
+
+        // Evaluate the cubic Bezier patch directly from its control points 
+        // using the Bernstein polynomials.
+        vec3 evaluate_cubic( float u, float v ) const
+        {
+            const float bu [4] = { (1.0f - u) * (1.0f - u) * (1.0f - u), 3.0f * u * (1.0f - u) * (1.0f - u), 3.0f * u * u * (1.0f - u), u * u * u };
+            const float bv [4] = { (1.0f - v) * (1.0f - v) * (1.0f - v), 3.0f * v * (1.0f - v) * (1.0f - v), 3.0f * v * v * (1.0f - v), v * v * v };
+            vec3 position( 0.0f, 0.0f, 0.0f );
+            for ( int j = 0; j < 4; ++j )
+            {
+                for ( int i = 0; i < 4; ++i )
+                {
+                    position += (bu[i] * bv[j]) * cubic_positions[j * 4 + i];
+                }
+            }
+            return position;
+        }
+
+        static void check_bound_contains_dicing( const Geometry& geometry, const mat4x4& transform, const vec2& u_range, const vec2& v_range )
+        {
+            vec3 minimum;
+            vec3 maximum;
+            geometry.bound( transform, u_range, v_range, &minimum, &maximum );
+
+            Grid grid;
+            geometry.dice( transform, u_range, v_range, 17, 17, &grid );
+            const vec3* positions = grid.value( GRID_SLOT_P, TYPE_POINT ).vec3_values();
+            const float EPSILON = 0.0001f;
+            for ( int i = 0; i < grid.size(); ++i )
+            {
+                const vec3& position = positions[i];
+                CHECK( position.x >= minimum.x - EPSILON && position.x <= maximum.x + EPSILON );
+                CHECK( position.y >= minimum.y - EPSILON && position.y <= maximum.y + EPSILON );
+                CHECK( position.z >= minimum.z - EPSILON && position.z <= maximum.z + EPSILON );
+            }
+        }
+
+        // Dice a 3x3 grid straddling (u, v) and check the derivatives output
+        // at its center against central differences of its positions.
+        static void check_derivatives( const Geometry& geometry, const mat4x4& transform, float u, float v )
+        {
+            const float H = 0.001f;
+            Grid grid;
+            geometry.dice( transform, vec2(u - H, u + H), vec2(v - H, v + H), 3, 3, &grid );
+            const vec3* positions = grid.value( GRID_SLOT_P, TYPE_POINT ).vec3_values();
+            const vec3* dpdu = grid.value( GRID_SLOT_DPDU, TYPE_VECTOR ).vec3_values();
+            const vec3* dpdv = grid.value( GRID_SLOT_DPDV, TYPE_VECTOR ).vec3_values();
+            const vec3 expected_dpdu = (positions[5] - positions[3]) / (2.0f * H);
+            const vec3 expected_dpdv = (positions[7] - positions[1]) / (2.0f * H);
+            const float scale = std::max( 1.0f, std::max(length(expected_dpdu), length(expected_dpdv)) );
+            CHECK_CLOSE( expected_dpdu.x, dpdu[4].x, TOLERANCE * scale );
+            CHECK_CLOSE( expected_dpdu.y, dpdu[4].y, TOLERANCE * scale );
+            CHECK_CLOSE( expected_dpdu.z, dpdu[4].z, TOLERANCE * scale );
+            CHECK_CLOSE( expected_dpdv.x, dpdv[4].x, TOLERANCE * scale );
+            CHECK_CLOSE( expected_dpdv.y, dpdv[4].y, TOLERANCE * scale );
+            CHECK_CLOSE( expected_dpdv.z, dpdv[4].z, TOLERANCE * scale );
+        }
+
+        // Check the normals generated from the derivatives output by dicing 
+        // against the normals generated from the diced positions alone.
+        static void check_normals( const Geometry& geometry, const mat4x4& transform )
+        {
+            const vec2 range( 0.25f, 0.75f );
+            Grid analytic;
+            geometry.dice( transform, range, range, 33, 33, &analytic );
+            analytic.generate_normals( false );
+            Grid differenced;
+            geometry.dice( transform, range, range, 33, 33, &differenced );
+            differenced.generate_normals( false, true );
+
+            const vec3* analytic_normals = analytic.value( GRID_SLOT_N, TYPE_NORMAL ).vec3_values();
+            const vec3* differenced_normals = differenced.value( GRID_SLOT_N, TYPE_NORMAL ).vec3_values();
+            for ( int i = 0; i < analytic.size(); ++i )
+            {
+                CHECK( dot(normalize(analytic_normals[i]), normalize(differenced_normals[i])) > 0.99f );
+            }
+        }
+    };
+
+    TEST_FIXTURE( DicingTest, quadric_bounds_contain_diced_positions )
+    {
+        for ( vector<shared_ptr<Geometry> >::const_iterator i = quadrics.begin(); i != quadrics.end(); ++i )
+        {
+            check_bound_contains_dicing( **i, transform, vec2(0.0f, 1.0f), vec2(0.0f, 1.0f) );
+            check_bound_contains_dicing( **i, transform, vec2(0.25f, 0.5f), vec2(0.5f, 0.75f) );
+            check_bound_contains_dicing( **i, transform, vec2(0.6f, 0.9f), vec2(0.0f, 0.3f) );
+        }
+    }
+
+    TEST_FIXTURE( DicingTest, patch_bounds_contain_diced_positions )
+    {
+        for ( vector<shared_ptr<Geometry> >::const_iterator i = patches.begin(); i != patches.end(); ++i )
+        {
+            check_bound_contains_dicing( **i, transform, vec2(0.0f, 1.0f), vec2(0.0f, 1.0f) );
+            check_bound_contains_dicing( **i, transform, vec2(0.25f, 0.5f), vec2(0.5f, 0.75f) );
+            check_bound_contains_dicing( **i, transform, vec2(0.6f, 0.9f), vec2(0.0f, 0.3f) );
+        }
+    }
+
+    TEST_FIXTURE( DicingTest, forward_differenced_cubic_patch_matches_direct_evaluation )
+    {
+        const vec2 u_range( 0.1f, 0.9f );
+        const vec2 v_range( 0.2f, 0.7f );
+        const int SIZE = 32;
+        Grid grid;
+        patches.front()->dice( math::identity(), u_range, v_range, SIZE, SIZE, &grid );
+        const vec3* positions = grid.value( GRID_SLOT_P, TYPE_POINT ).vec3_values();
+        for ( int y = 0; y < SIZE; ++y )
+        {
+            for ( int x = 0; x < SIZE; ++x )
+            {
+                const float u = u_range.x + (u_range.y - u_range.x) * float(x) / float(SIZE - 1);
+                const float v = v_range.x + (v_range.y - v_range.x) * float(y) / float(SIZE - 1);
+                const vec3 expected = evaluate_cubic( u, v );
+                const vec3& position = positions[y * SIZE + x];
+                CHECK_CLOSE( expected.x, position.x, TOLERANCE );
+                CHECK_CLOSE( expected.y, position.y, TOLERANCE );
+                CHECK_CLOSE( expected.z, position.z, TOLERANCE );
+            }
+        }
+    }
+
+    TEST_FIXTURE( DicingTest, quadric_derivatives_match_finite_differences )
+    {
+        const mat4x4 rotation = math::rotate( vec3(1.0f, 0.0f, 0.0f), 0.5f );
+        for ( vector<shared_ptr<Geometry> >::const_iterator i = quadrics.begin(); i != quadrics.end(); ++i )
+        {
+            check_derivatives( **i, rotation, 0.3f, 0.4f );
+            check_derivatives( **i, rotation, 0.7f, 0.6f );
+        }
+    }
+
+    TEST_FIXTURE( DicingTest, cubic_patch_derivatives_match_finite_differences )
+    {
+        const mat4x4 rotation = math::rotate( vec3(1.0f, 0.0f, 0.0f), 0.5f );
+        check_derivatives( *patches.front(), rotation, 0.3f, 0.4f );
+        check_derivatives( *patches.front(), rotation, 0.7f, 0.6f );
+    }
+
+    TEST_FIXTURE( DicingTest, quadric_normals_from_derivatives_match_normals_from_positions )
+    {
+        for ( vector<shared_ptr<Geometry> >::const_iterator i = quadrics.begin(); i != quadrics.end(); ++i )
+        {
+            check_normals( **i, transform );
+        }
+    }
+}
@@ -132,6 +132,32 @@ SUITE( GeometricFunctions )
         );
     }
     
+    TEST_FIXTURE( GeometricFunctionTest, normalized_dot_products )
+    {
+        z[0] = vec3( 3.0f, 0.0f, 4.0f );
+        z[1] = vec3( 0.0f, -2.0f, 0.0f );
+        z[2] = vec3( 1.0f, 1.0f, 1.0f );
+        z[3] = vec3( 0.0f, 0.0f, 0.0f );
+        P[0] = vec3( 0.0f, 0.0f, 2.0f );
+        P[1] = vec3( 0.0f, 1.0f, 0.0f );
+        P[2] = vec3( -1.0f, -1.0f, -1.0f );
+        P[3] = vec3( 1.0f, 0.0f, 0.0f );
+        test(
+            "surface normalized_dot_products_test() { \n"
+            "   x = normalize(z) . normalize(P); \n"
+            "   y = normalize(z) . P; \n"
+            "}"
+        );
+        CHECK_CLOSE( 0.8f, x[0], TOLERANCE );
+        CHECK_CLOSE( -1.0f, x[1], TOLERANCE );
+        CHECK_CLOSE( -1.0f, x[2], TOLERANCE );
+        CHECK_CLOSE( 0.0f, x[3], TOLERANCE );
+        CHECK_CLOSE( 1.6f, y[0], TOLERANCE );
+        CHECK_CLOSE( -1.0f, y[1], TOLERANCE );
+        CHECK_CLOSE( -sqrtf(3.0f), y[2], TOLERANCE );
+        CHECK_CLOSE( 0.0f, y[3], TOLERANCE );
+    }
+
     TEST_FIXTURE( GeometricFunctionTest, depth )
     {
         const float near_clip_distance = renderer.options().near_clip_distance();
@@ -0,0 +1,263 @@
+
+#include <UnitTest++/UnitTest++.h>
+#include <reyes/Shader.hpp>
+#include <reyes/Grid.hpp>
+#include <reyes/Value.hpp>
+#include <reyes/ErrorPolicy.hpp>
+#include <reyes/SymbolTable.hpp>
+#include <reyes/Renderer.hpp>
+#include <reyes/VirtualMachine.hpp>
+#include <reyes/NativeShader.hpp>
+#include <reyes/NativeGenerator.hpp>
+#include <reyes/assert.hpp>
+#include <math/vec3.ipp>
+#include <math.h>
+#include <string>
+#include <string.h>
+#include <stdio.h>
+
+using std::string;
+using std::shared_ptr;
+using namespace math;
+using namespace reyes;
+
+static const float TOLERANCE = 0.001f;
+
+static int native_initializes = 0;
+static int native_shades = 0;
+
+static void native_initialize( NativeVirtualMachine& /*virtual_machine*/ )
+{
+    ++native_initializes;
+}
+
+static void native_shade( NativeVirtualMachine& /*virtual_machine*/ )
+{
+    ++native_shades;
+}
+
+// Generated by reyes_shaderc when building reyes_test (see reyes_test.forge).
+void add_test_native_shaders( reyes::Renderer& renderer );
+
+SUITE( NativeShaders )
+{
+    struct NativeShadersTest
+    {
+        Grid grid;
+        float* y;
+        ErrorPolicy error_policy;
+        SymbolTable symbol_table;
+        shared_ptr<Shader> shader;
+
+        NativeShadersTest()
+        : grid(),
+          y( NULL ),
+          error_policy(),
+          symbol_table(),
+          shader()
+        {
+            grid.resize( 2, 2 );
+            shared_ptr<Value> x_value = grid.add_value( "x", TYPE_FLOAT );
+            x_value->zero();
+            shared_ptr<Value> y_value = grid.add_value( "y", TYPE_FLOAT );
+            y_value->zero();
+            y = y_value->float_values();
+
+            symbol_table.add_symbols()
+                ( "x", TYPE_FLOAT )
+                ( "y", TYPE_FLOAT )
+            ;
+        }
+
+        void compile( const char* source )
+        {
+            shader.reset( new Shader(source, source + strlen(source), symbol_table, error_policy) );
+            CHECK_EQUAL( 0, error_policy.total_errors() );
+        }
+    };
+
+    TEST_FIXTURE( NativeShadersTest, generated_source_branches_instead_of_jumping )
+    {
+        compile(
+            "surface generated_source_branches_instead_of_jumping() { \n"
+            "   if ( x > 0 ) { \n"
+            "       y = 1; \n"
+            "   } \n"
+            "}"
+        );
+
+        NativeGenerator native_generator;
+        native_generator.generate( *shader, "shaders/if statement.sl" );
+        native_generator.generate_registration( "add_test_shaders" );
+        const string& source = native_generator.source();
+        CHECK( source.find("if ( virtual_machine.mask_empty() )") != string::npos );
+        CHECK( source.find("goto operation_") != string::npos );
+        CHECK( source.find("virtual_machine.execute( ") != string::npos );
+        CHECK( source.find("const reyes::NativeShader if_statement_native_shader =") != string::npos );
+        CHECK( source.find("\"if statement.sl\"") != string::npos );
+        CHECK( source.find("renderer.add_native_shader( &if_statement_native_shader );") != string::npos );
+
+        char fingerprint [32];
+        snprintf( fingerprint, sizeof(fingerprint), "0x%016llxull", (unsigned long long) shader->fingerprint() );
+        CHECK( source.find(fingerprint) != string::npos );
+    }
+
+    TEST_FIXTURE( NativeShadersTest, generated_source_calls_kernels_chosen_by_dispatch )
+    {
+        compile(
+            "surface generated_source_calls_kernels_chosen_by_dispatch( float scale = 2; ) { \n"
+            "   y = x * x; \n"
+            "   y = -y * scale; \n"
+            "   if ( x > scale ) { \n"
+            "       y += 1; \n"
+            "   } \n"
+            "}"
+        );
+
+        NativeGenerator native_generator;
+        native_generator.generate( *shader, "kernels.sl" );
+        const string& source = native_generator.source();
+        CHECK( source.find("reyes::multiply_v1v1( ") != string::npos );
+        CHECK( source.find("reyes::multiply_v1u1( ") != string::npos );
+        CHECK( source.find("reyes::negate_v1( ") != string::npos );
+        CHECK( source.find("reyes::greater_v1u1( ") != string::npos );
+        CHECK( source.find("reyes::add_assign_v1u1( ") != string::npos );
+        CHECK( source.find("reyes::assign_v1v1( ") != string::npos );
+        CHECK( source.find("virtual_machine.mask()") != string::npos );
+        CHECK( source.find("_operations") == string::npos );
+    }
+
+    TEST_FIXTURE( NativeShadersTest, native_shader_executes_instead_of_interpreting )
+    {
+        compile(
+            "surface native_shader_executes_instead_of_interpreting() { \n"
+            "   y = 1; \n"
+            "}"
+        );
+
+        NativeShader native_shader = { "native.sl", shader->fingerprint(), &native_initialize, &native_shade };
+        shader->set_native_shader( &native_shader );
+        native_initializes = 0;
+        native_shades = 0;
+        VirtualMachine virtual_machine;
+        virtual_machine.initialize( grid, *shader );
+        virtual_machine.shade( grid, grid, *shader );
+        CHECK_EQUAL( 1, native_initializes );
+        CHECK_EQUAL( 1, native_shades );
+        CHECK_EQUAL( 0.0f, y[0] );
+
+        shader->set_native_shader( NULL );
+        virtual_machine.shade( grid, grid, *shader );
+        CHECK_EQUAL( 1, native_shades );
+        CHECK_EQUAL( 1.0f, y[0] );
+    }
+
+    TEST( renderer_only_uses_native_shaders_with_matching_fingerprints )
+    {
+        Renderer renderer;
+        Shader shader( SHADERS_PATH "constant.sl", renderer.symbol_table(), renderer.error_policy() );
+
+        NativeShader constant = { "constant.sl", shader.fingerprint(), &native_initialize, &native_shade };
+        NativeShader matte = { "matte.sl", shader.fingerprint() + 1, &native_initialize, &native_shade };
+        renderer.add_native_shader( &constant );
+        renderer.add_native_shader( &matte );
+        CHECK( renderer.find_native_shader(SHADERS_PATH "constant.sl") == &constant );
+        CHECK( renderer.shader(SHADERS_PATH "constant.sl")->native_shader() == &constant );
+        CHECK( renderer.shader(SHADERS_PATH "matte.sl")->native_shader() == NULL );
+        CHECK( renderer.shader(SHADERS_PATH "plastic.sl")->native_shader() == NULL );
+    }
+
+    struct NativeComparisonTest
+    {
+        Renderer interpreted;
+        Renderer native;
+
+        NativeComparisonTest()
+        : interpreted(),
+          native()
+        {
+            add_test_native_shaders( native );
+            begin( interpreted );
+            begin( native );
+        }
+
+        static void begin( Renderer& renderer )
+        {
+            renderer.begin();
+            renderer.perspective( float(M_PI) / 2.0f );
+            renderer.projection();
+            renderer.begin_world();
+            renderer.light_shader( SHADERS_PATH "ambientlight.sl" );
+            renderer.light_shader( SHADERS_PATH "pointlight.sl" );
+        }
+
+        static void shade( Renderer& renderer, const char* filename, Grid* grid )
+        {
+            REYES_ASSERT( grid );
+            const int SIZE = 4;
+            grid->resize( SIZE, SIZE );
+            vec3* P = grid->value( "P", TYPE_POINT ).vec3_values();
+            float* s = grid->value( "s", TYPE_FLOAT ).float_values();
+            float* t = grid->value( "t", TYPE_FLOAT ).float_values();
+            for ( int y = 0; y < SIZE; ++y )
+            {
+                for ( int x = 0; x < SIZE; ++x )
+                {
+                    const int i = y * SIZE + x;
+                    s[i] = float(x) / float(SIZE - 1);
+                    t[i] = float(y) / float(SIZE - 1);
+                    P[i] = vec3( s[i] * 2.0f - 1.0f, t[i] * 2.0f - 1.0f, 2.0f + s[i] * t[i] );
+                }
+            }
+            renderer.surface_shader( filename );
+            renderer.surface_shade( *grid );
+        }
+
+        void check( const char* filename )
+        {
+            CHECK( interpreted.shader(filename)->native_shader() == NULL );
+            CHECK( native.shader(filename)->native_shader() != NULL );
+
+            Grid interpreted_grid;
+            Grid native_grid;
+            shade( interpreted, filename, &interpreted_grid );
+            shade( native, filename, &native_grid );
+            const vec3* interpreted_Ci = interpreted_grid.value( "Ci", TYPE_COLOR ).vec3_values();
+            const vec3* native_Ci = native_grid.value( "Ci", TYPE_COLOR ).vec3_values();
+            const vec3* interpreted_Oi = interpreted_grid.value( "Oi", TYPE_COLOR ).vec3_values();
+            const vec3* native_Oi = native_grid.value( "Oi", TYPE_COLOR ).vec3_values();
+            for ( unsigned int i = 0; i < interpreted_grid.size(); ++i )
+            {
+                CHECK_CLOSE( interpreted_Ci[i].x, native_Ci[i].x, TOLERANCE );
+                CHECK_CLOSE( interpreted_Ci[i].y, native_Ci[i].y, TOLERANCE );
+                CHECK_CLOSE( interpreted_Ci[i].z, native_Ci[i].z, TOLERANCE );
+                CHECK_CLOSE( interpreted_Oi[i].x, native_Oi[i].x, TOLERANCE );
+            }
+        }
+    };
+
+    TEST_FIXTURE( NativeComparisonTest, generated_constant_matches_interpreter )
+    {
+        check( SHADERS_PATH "constant.sl" );
+    }
+
+    TEST_FIXTURE( NativeComparisonTest, generated_matte_matches_interpreter )
+    {
+        check( SHADERS_PATH "matte.sl" );
+    }
+
+    TEST_FIXTURE( NativeComparisonTest, generated_metal_matches_interpreter )
+    {
+        check( SHADERS_PATH "metal.sl" );
+    }
+
+    TEST_FIXTURE( NativeComparisonTest, generated_plastic_matches_interpreter )
+    {
+        check( SHADERS_PATH "plastic.sl" );
+    }
+
+    TEST_FIXTURE( NativeComparisonTest, generated_control_flow_matches_interpreter )
+    {
+        check( REYES_TEST_PATH "native.sl" );
+    }
+}
@@ -0,0 +1,199 @@
+
+#include <UnitTest++/UnitTest++.h>
+#include <reyes/Shader.hpp>
+#include <reyes/Symbol.hpp>
+#include <reyes/Grid.hpp>
+#include <reyes/Value.hpp>
+#include <reyes/ErrorPolicy.hpp>
+#include <reyes/SymbolTable.hpp>
+#include <reyes/VirtualMachine.hpp>
+#include <reyes/assert.hpp>
+#include <string.h>
+
+using std::vector;
+using std::shared_ptr;
+using namespace math;
+using namespace reyes;
+
+static const float TOLERANCE = 0.01f;
+
+SUITE( Optimization )
+{
+    struct OptimizationTest
+    {
+        Grid grid;
+        float* x;
+        float* y;
+        ErrorPolicy error_policy;
+        SymbolTable symbol_table;
+        shared_ptr<Shader> shader;
+     
+        OptimizationTest()
+        : grid(),
+          x( NULL ),
+          y( NULL ),
+          error_policy(),
+          symbol_table(),
+          shader()
+        {
+            grid.resize( 2, 2 );
+            shared_ptr<Value> x_value = grid.add_value( "x", TYPE_FLOAT );
+            x_value->zero();
+            x = x_value->float_values();
+            x[0] = 1.0f;
+            x[1] = 2.0f;
+            x[2] = 3.0f;
+            x[3] = 4.0f;
+            
+            shared_ptr<Value> y_value = grid.add_value( "y", TYPE_FLOAT );
+            y_value->zero();
+            y = y_value->float_values();
+
+            symbol_table.add_symbols()
+                ( "x", TYPE_FLOAT )
+                ( "y", TYPE_FLOAT )
+            ;
+        }
+        
+        void test( const char* source )
+        {
+            shader.reset( new Shader(source, source + strlen(source), symbol_table, error_policy) );
+            CHECK_EQUAL( 0, error_policy.total_errors() );
+            VirtualMachine virtual_machine;
+            virtual_machine.initialize( grid, *shader );
+            virtual_machine.shade( grid, grid, *shader );
+        }
+    };
+
+    TEST_FIXTURE( OptimizationTest, arithmetic_on_literals_is_folded )
+    {
+        test(
+            "surface arithmetic_on_literals_is_folded() { \n"
+            "   y = -(2 * 3 + 1) / 2; \n"
+            "}"
+        );
+        CHECK_EQUAL( 1, shader->constants() );
+        CHECK_CLOSE( -3.5f, y[0], TOLERANCE );
+        CHECK_CLOSE( -3.5f, y[3], TOLERANCE );
+    }
+
+    TEST_FIXTURE( OptimizationTest, division_by_zero_is_not_folded )
+    {
+        test(
+            "surface division_by_zero_is_not_folded() { \n"
+            "   y = x + 1 / 0; \n"
+            "}"
+        );
+        CHECK_EQUAL( 2, shader->constants() );
+    }
+
+    TEST_FIXTURE( OptimizationTest, variable_assigned_literal_is_propagated )
+    {
+        test(
+            "surface variable_assigned_literal_is_propagated() { \n"
+            "   float scale = 4; \n"
+            "   y = x * scale; \n"
+            "}"
+        );
+        CHECK( !shader->find_symbol("scale") );
+        CHECK_CLOSE( 4.0f, y[0], TOLERANCE );
+        CHECK_CLOSE( 8.0f, y[1], TOLERANCE );
+        CHECK_CLOSE( 12.0f, y[2], TOLERANCE );
+        CHECK_CLOSE( 16.0f, y[3], TOLERANCE );
+    }
+
+    TEST_FIXTURE( OptimizationTest, variable_assigned_twice_is_not_propagated )
+    {
+        test(
+            "surface variable_assigned_twice_is_not_propagated() { \n"
+            "   float scale = 4; \n"
+            "   scale += 1; \n"
+            "   y = x * scale; \n"
+            "}"
+        );
+        CHECK( shader->find_symbol("scale") );
+        CHECK_CLOSE( 5.0f, y[0], TOLERANCE );
+        CHECK_CLOSE( 20.0f, y[3], TOLERANCE );
+    }
+
+    TEST_FIXTURE( OptimizationTest, copy_of_parameter_is_propagated )
+    {
+        test(
+            "surface copy_of_parameter_is_propagated( float Kd = 3; ) { \n"
+            "   float scale = Kd; \n"
+            "   float other_scale = scale; \n"
+            "   y = x * other_scale; \n"
+            "}"
+        );
+        CHECK( !shader->find_symbol("scale") );
+        CHECK( !shader->find_symbol("other_scale") );
+        CHECK_CLOSE( 3.0f, y[0], TOLERANCE );
+        CHECK_CLOSE( 12.0f, y[3], TOLERANCE );
+    }
+
+    TEST_FIXTURE( OptimizationTest, copy_of_changed_variable_is_not_propagated )
+    {
+        test(
+            "surface copy_of_changed_variable_is_not_propagated( float Kd = 3; ) { \n"
+            "   float scale = Kd; \n"
+            "   float saved = scale; \n"
+            "   scale = 2; \n"
+            "   y = x * saved + scale; \n"
+            "}"
+        );
+        CHECK( shader->find_symbol("saved") );
+        CHECK_CLOSE( 5.0f, y[0], TOLERANCE );
+        CHECK_CLOSE( 14.0f, y[3], TOLERANCE );
+    }
+
+    TEST_FIXTURE( OptimizationTest, branch_on_literals_is_pruned )
+    {
+        test(
+            "surface branch_on_literals_is_pruned() { \n"
+            "   float debug = 0; \n"
+            "   if ( debug > 0 && 1 < 2 ) { \n"
+            "       y = 1; \n"
+            "   } else { \n"
+            "       y = x; \n"
+            "   } \n"
+            "}"
+        );
+        CHECK( !shader->find_symbol("debug") );
+        CHECK_CLOSE( 1.0f, y[0], TOLERANCE );
+        CHECK_CLOSE( 2.0f, y[1], TOLERANCE );
+        CHECK_CLOSE( 3.0f, y[2], TOLERANCE );
+        CHECK_CLOSE( 4.0f, y[3], TOLERANCE );
+    }
+
+    TEST_FIXTURE( OptimizationTest, loop_on_literals_is_pruned )
+    {
+        test(
+            "surface loop_on_literals_is_pruned() { \n"
+            "   uniform float i; \n"
+            "   for ( i = 2; 2 < 1; i += 1 ) { \n"
+            "       y += x; \n"
+            "   } \n"
+            "   while ( 2 < 1 ) { \n"
+            "       y += x; \n"
+            "   } \n"
+            "   y += i; \n"
+            "}"
+        );
+        CHECK_CLOSE( 2.0f, y[0], TOLERANCE );
+        CHECK_CLOSE( 2.0f, y[3], TOLERANCE );
+    }
+
+    TEST_FIXTURE( OptimizationTest, unread_variable_is_removed )
+    {
+        test(
+            "surface unread_variable_is_removed() { \n"
+            "   float unused = x * 2; \n"
+            "   unused += 1; \n"
+            "   y = x; \n"
+            "}"
+        );
+        CHECK( !shader->find_symbol("unused") );
+        CHECK_CLOSE( 1.0f, y[0], TOLERANCE );
+        CHECK_CLOSE( 4.0f, y[3], TOLERANCE );
+    }
+}
@@ -0,0 +1,246 @@
+
+#include <UnitTest++/UnitTest++.h>
+#include <reyes/Options.hpp>
+#include <reyes/Renderer.hpp>
+#include <reyes/Grid.hpp>
+#include <reyes/Value.hpp>
+#include <reyes/ImageBuffer.hpp>
+#include <reyes/ImageBufferFormat.hpp>
+#include <reyes/assert.hpp>
+#include "TemporaryDirectory.hpp"
+#include <math/vec3.ipp>
+#include <string>
+#include <stdlib.h>
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+using std::string;
+using namespace math;
+using namespace reyes;
+
+SUITE( RenderModes )
+{
+    struct RenderModesTest
+    {
+        TemporaryDirectory directory;
+        Options options;
+        ImageBuffer immediate;
+
+        RenderModesTest()
+        : directory(),
+          options(),
+          immediate()
+        {
+            options.set_resolution( 128, 128, 1.0f );
+            options.set_dither( 0.0f );
+            render( options, &describe_occluded_spheres, "immediate", &immediate );
+        }
+
+        // Describe a large sphere in front of a small sphere that it hides 
+        // and a third sphere that is partly visible beside it.  The hidden
+        // sphere is described first so that it is only culled when the
+        // primitives are sorted front to back.
+        static void describe_occluded_spheres( Renderer& renderer )
+        {
+            Grid& ambientlight = renderer.light_shader( SHADERS_PATH "ambientlight.sl" );
+            ambientlight["intensity"] = 0.2f;
+            Grid& pointlight = renderer.light_shader( SHADERS_PATH "pointlight.sl" );
+            pointlight["intensity"] = 64.0f;
+            pointlight["from"] = vec3( 4.0f, 4.0f, 0.0f );
+            renderer.surface_shader( SHADERS_PATH "matte.sl" );
+
+            renderer.begin_transform();
+            renderer.translate( 0.0f, 0.0f, 16.0f );
+            renderer.color( vec3(1.0f, 0.0f, 0.0f) );
+            renderer.sphere( 1.0f );
+            renderer.end_transform();
+
+            renderer.begin_transform();
+            renderer.translate( 4.0f, 3.0f, 12.0f );
+            renderer.color( vec3(0.0f, 1.0f, 0.0f) );
+            renderer.sphere( 2.0f );
+            renderer.end_transform();
+
+            renderer.begin_transform();
+            renderer.translate( 0.0f, 0.0f, 6.0f );
+            renderer.color( vec3(0.0f, 0.0f, 1.0f) );
+            renderer.sphere( 3.0f );
+            renderer.end_transform();
+        }
+
+        // Describe two spheres side by side and write the surface and light
+        // shader parameters between them without changing any other 
+        // attribute so that only the parameters distinguish them.
+        static void describe_parameter_changes( Renderer& renderer )
+        {
+            Grid& pointlight = renderer.light_shader( SHADERS_PATH "pointlight.sl" );
+            pointlight["from"] = vec3( 0.0f, 0.0f, 0.0f );
+            Grid& matte = renderer.surface_shader( SHADERS_PATH "matte.sl" );
+            renderer.color( vec3(1.0f, 1.0f, 1.0f) );
+
+            pointlight["intensity"] = 16.0f;
+            matte["Kd"] = 0.25f;
+            renderer.begin_transform();
+            renderer.translate( -2.0f, 0.0f, 6.0f );
+            renderer.sphere( 1.5f );
+            renderer.end_transform();
+
+            pointlight["intensity"] = 32.0f;
+            matte["Kd"] = 1.0f;
+            renderer.begin_transform();
+            renderer.translate( 2.0f, 0.0f, 6.0f );
+            renderer.sphere( 1.5f );
+            renderer.end_transform();
+        }
+
+        int render( const Options& options, void (*describe)(Renderer& renderer), const char* name, ImageBuffer* image_buffer )
+        {
+            REYES_ASSERT( describe );
+            REYES_ASSERT( name );
+            REYES_ASSERT( image_buffer );
+
+            Renderer renderer;
+            renderer.set_options( options );
+            renderer.begin();
+            renderer.perspective( float(M_PI) / 2.0f );
+            renderer.projection();
+            renderer.begin_world();
+            describe( renderer );
+            renderer.end_world();
+            renderer.end();
+
+            const string filename = directory.file( name );
+            renderer.save_image( "%s", filename.c_str() );
+            image_buffer->load( filename.c_str() );
+            return renderer.occluded_grids();
+        }
+
+        // Count the pixels in \e actual that differ from \e expected by more
+        // than rounding in any channel.
+        static int different_pixels( const ImageBuffer& expected, const ImageBuffer& actual )
+        {
+            REYES_ASSERT( actual.width() == expected.width() );
+            REYES_ASSERT( actual.height() == expected.height() );
+            int different_pixels = 0;
+            for ( int y = 0; y < expected.height(); ++y )
+            {
+                for ( int x = 0; x < expected.width(); ++x )
+                {
+                    const unsigned char* expected_pixel = expected.u8_data( x, y );
+                    const unsigned char* actual_pixel = actual.u8_data( x, y );
+                    bool different = false;
+                    for ( int i = 0; i < expected.elements(); ++i )
+                    {
+                        different = different || abs( int(expected_pixel[i]) - int(actual_pixel[i]) ) > 1;
+                    }
+                    different_pixels += different ? 1 : 0;
+                }
+            }
+            return different_pixels;
+        }
+
+        int different_pixels( const ImageBuffer& image_buffer ) const
+        {
+            return different_pixels( immediate, image_buffer );
+        }
+    };
+
+    TEST_FIXTURE( RenderModesTest, immediate_image_is_not_empty )
+    {
+        const unsigned char* center = immediate.u8_data( 64, 64 );
+        CHECK( center[2] > 0 );
+        CHECK_EQUAL( 0, int(center[0]) );
+    }
+
+    TEST_FIXTURE( RenderModesTest, bucketed_image_matches_immediate_image )
+    {
+        options.set_bucket_size( 16, 16 );
+        options.set_threads( 1 );
+        ImageBuffer bucketed;
+        render( options, &describe_occluded_spheres, "bucketed", &bucketed );
+        CHECK_EQUAL( 0, different_pixels(bucketed) );
+    }
+
+    TEST_FIXTURE( RenderModesTest, threaded_image_matches_immediate_image )
+    {
+        options.set_bucket_size( 16, 16 );
+        options.set_threads( 4 );
+        ImageBuffer threaded;
+        render( options, &describe_occluded_spheres, "threaded", &threaded );
+        CHECK_EQUAL( 0, different_pixels(threaded) );
+    }
+
+    TEST_FIXTURE( RenderModesTest, retained_image_matches_immediate_image )
+    {
+        options.set_retained( true );
+        ImageBuffer retained;
+        render( options, &describe_occluded_spheres, "retained", &retained );
+        CHECK_EQUAL( 0, different_pixels(retained) );
+    }
+
+    TEST_FIXTURE( RenderModesTest, front_to_back_culls_hidden_geometry )
+    {
+        options.set_retained( true );
+        ImageBuffer retained;
+        const int described_order_occluded_grids = render( options, &describe_occluded_spheres, "retained", &retained );
+
+        options.set_front_to_back( true );
+        ImageBuffer front_to_back;
+        const int front_to_back_occluded_grids = render( options, &describe_occluded_spheres, "front_to_back", &front_to_back );
+        CHECK( front_to_back_occluded_grids > 0 );
+        CHECK( front_to_back_occluded_grids > described_order_occluded_grids );
+        CHECK_EQUAL( 0, different_pixels(front_to_back) );
+    }
+
+    TEST_FIXTURE( RenderModesTest, bucketed_front_to_back_culls_hidden_geometry )
+    {
+        options.set_bucket_size( 16, 16 );
+        options.set_threads( 4 );
+        options.set_retained( true );
+        options.set_front_to_back( true );
+        ImageBuffer front_to_back;
+        CHECK( render(options, &describe_occluded_spheres, "bucketed_front_to_back", &front_to_back) > 0 );
+        CHECK_EQUAL( 0, different_pixels(front_to_back) );
+    }
+
+    TEST_FIXTURE( RenderModesTest, immediate_primitives_use_parameters_written_before_them )
+    {
+        ImageBuffer parameters;
+        render( options, &describe_parameter_changes, "immediate_parameters", &parameters );
+
+        // The left sphere has a quarter of the diffuse coefficient and half 
+        // the light intensity of the right sphere.
+        const unsigned char* left = parameters.u8_data( 32, 64 );
+        const unsigned char* right = parameters.u8_data( 96, 64 );
+        CHECK( right[0] > 0 );
+        CHECK( int(left[0]) < int(right[0]) );
+    }
+
+    TEST_FIXTURE( RenderModesTest, retained_primitives_use_parameters_written_before_them )
+    {
+        ImageBuffer expected;
+        render( options, &describe_parameter_changes, "immediate_parameters", &expected );
+
+        options.set_retained( true );
+        ImageBuffer retained;
+        render( options, &describe_parameter_changes, "retained_parameters", &retained );
+        CHECK_EQUAL( 0, different_pixels(expected, retained) );
+    }
+
+    TEST_FIXTURE( RenderModesTest, bucketed_primitives_use_parameters_written_before_them )
+    {
+        ImageBuffer expected;
+        render( options, &describe_parameter_changes, "immediate_parameters", &expected );
+
+        options.set_bucket_size( 16, 16 );
+        options.set_threads( 1 );
+        ImageBuffer bucketed;
+        render( options, &describe_parameter_changes, "bucketed_parameters", &bucketed );
+        CHECK_EQUAL( 0, different_pixels(expected, bucketed) );
+
+        options.set_threads( 4 );
+        ImageBuffer threaded;
+        render( options, &describe_parameter_changes, "threaded_parameters", &threaded );
+        CHECK_EQUAL( 0, different_pixels(expected, threaded) );
+    }
+}
@@ -0,0 +1,328 @@
+
+#include <UnitTest++/UnitTest++.h>
+#include <reyes/Shader.hpp>
+#include <reyes/Symbol.hpp>
+#include <reyes/Grid.hpp>
+#include <reyes/Value.hpp>
+#include <reyes/ErrorPolicy.hpp>
+#include <reyes/SymbolTable.hpp>
+#include <reyes/VirtualMachine.hpp>
+#include <reyes/ShaderCache.hpp>
+#include <reyes/hash.hpp>
+#include <reyes/assert.hpp>
+#include "TemporaryDirectory.hpp"
+#include <string.h>
+#include <stdio.h>
+
+using std::string;
+using std::vector;
+using std::shared_ptr;
+using namespace reyes;
+
+static const float TOLERANCE = 0.01f;
+
+SUITE( ShaderCaching )
+{
+    struct ShaderCachingTest
+    {
+        Grid grid;
+        float* y;
+        ErrorPolicy error_policy;
+        SymbolTable symbol_table;
+        shared_ptr<Shader> shader;
+
+        ShaderCachingTest()
+        : grid(),
+          y( NULL ),
+          error_policy(),
+          symbol_table(),
+          shader()
+        {
+            grid.resize( 2, 2 );
+            shared_ptr<Value> x_value = grid.add_value( "x", TYPE_FLOAT );
+            x_value->zero();
+            float* x = x_value->float_values();
+            x[0] = 1.0f;
+            x[1] = 2.0f;
+            x[2] = 3.0f;
+            x[3] = 4.0f;
+
+            shared_ptr<Value> y_value = grid.add_value( "y", TYPE_FLOAT );
+            y_value->zero();
+            y = y_value->float_values();
+
+            symbol_table.add_symbols()
+                ( "x", TYPE_FLOAT )
+                ( "y", TYPE_FLOAT )
+            ;
+        }
+
+        void compile( const char* source )
+        {
+            shader.reset( new Shader(source, source + strlen(source), symbol_table, error_policy) );
+            CHECK_EQUAL( 0, error_policy.total_errors() );
+        }
+
+        void shade( Shader& shader )
+        {
+            VirtualMachine virtual_machine;
+            virtual_machine.initialize( grid, shader );
+            virtual_machine.shade( grid, grid, shader );
+        }
+    };
+
+    struct ShaderCacheTest : public ShaderCachingTest
+    {
+        TemporaryDirectory sources;
+        TemporaryDirectory cache_directory;
+        ShaderCache cache;
+        string filename;
+
+        ShaderCacheTest()
+        : ShaderCachingTest(),
+          sources(),
+          cache_directory(),
+          cache( cache_directory.path.c_str() ),
+          filename( sources.file("shader.sl") )
+        {
+            write_source( "surface doubled() { y = x * 2; }" );
+        }
+
+        void write_source( const char* source )
+        {
+            vector<unsigned char> data( source, source + strlen(source) );
+            write( filename, data );
+        }
+
+        void cache_shader()
+        {
+            const int errors = error_policy.total_errors();
+            shader.reset( cache.shader(filename.c_str(), symbol_table, error_policy) );
+            CHECK( shader );
+            CHECK_EQUAL( errors, error_policy.total_errors() );
+        }
+
+        void check_doubled()
+        {
+            shade( *shader );
+            CHECK_CLOSE( 2.0f, y[0], TOLERANCE );
+            CHECK_CLOSE( 4.0f, y[1], TOLERANCE );
+            CHECK_CLOSE( 6.0f, y[2], TOLERANCE );
+            CHECK_CLOSE( 8.0f, y[3], TOLERANCE );
+        }
+
+        static vector<unsigned char> read( const string& path )
+        {
+            vector<unsigned char> data;
+            FILE* file = fopen( path.c_str(), "rb" );
+            if ( file )
+            {
+                unsigned char buffer [1024];
+                size_t read = 0;
+                while ( (read = fread(buffer, 1, sizeof(buffer), file)) > 0 )
+                {
+                    data.insert( data.end(), buffer, buffer + read );
+                }
+                fclose( file );
+            }
+            return data;
+        }
+
+        static void write( const string& path, const vector<unsigned char>& data )
+        {
+            FILE* file = fopen( path.c_str(), "wb" );
+            REYES_ASSERT( file );
+            if ( file )
+            {
+                fwrite( &data[0], 1, data.size(), file );
+                fclose( file );
+            }
+        }
+
+        static ShaderCacheHeader header( const vector<unsigned char>& data )
+        {
+            ShaderCacheHeader header;
+            memset( &header, 0, sizeof(header) );
+            REYES_ASSERT( data.size() >= sizeof(header) );
+            memcpy( &header, &data[0], sizeof(header) );
+            return header;
+        }
+
+        static void set_header( const ShaderCacheHeader& header, vector<unsigned char>* data )
+        {
+            REYES_ASSERT( data && data->size() >= sizeof(header) );
+            memcpy( &(*data)[0], &header, sizeof(header) );
+        }
+
+        void check_rejected_and_recompiled( const vector<unsigned char>& rejected_data )
+        {
+            const string path = cache.path( filename.c_str(), symbol_table );
+            const vector<unsigned char> data = read( path );
+            write( path, rejected_data );
+            cache_shader();
+            check_doubled();
+            CHECK( read(path) == data );
+            CHECK_EQUAL( 1u, cache_directory.files().size() );
+        }
+    };
+
+    TEST_FIXTURE( ShaderCachingTest, saved_shader_loads_and_shades_the_same )
+    {
+        compile(
+            "surface saved_shader_loads_and_shades_the_same( string name = \"plastic\"; float scale = 2; ) { \n"
+            "   y = sqrt( x ) * scale; \n"
+            "   if ( x > 2 ) { \n"
+            "       y += 1; \n"
+            "   } \n"
+            "}"
+        );
+
+        vector<unsigned char> data;
+        shader->save( symbol_table, &data );
+
+        Shader loaded_shader;
+        CHECK( loaded_shader.load(&data[0], &data[0] + data.size(), symbol_table) );
+        CHECK( loaded_shader.code() == shader->code() );
+        CHECK_EQUAL( shader->parameters(), loaded_shader.parameters() );
+        CHECK_EQUAL( shader->constants(), loaded_shader.constants() );
+        CHECK_EQUAL( shader->registers(), loaded_shader.registers() );
+        CHECK_EQUAL( shader->symbols().size(), loaded_shader.symbols().size() );
+        CHECK_EQUAL( shader->operations().size(), loaded_shader.operations().size() );
+        CHECK( shader->fingerprint() == loaded_shader.fingerprint() );
+        CHECK( loaded_shader.find_symbol("sqrt")->function() != NULL );
+        CHECK( loaded_shader.find_symbol("name") );
+
+        shade( loaded_shader );
+        CHECK_CLOSE( 2.0f, y[0], TOLERANCE );
+        CHECK_CLOSE( 2.83f, y[1], TOLERANCE );
+        CHECK_CLOSE( 4.46f, y[2], TOLERANCE );
+        CHECK_CLOSE( 5.0f, y[3], TOLERANCE );
+    }
+
+    TEST_FIXTURE( ShaderCachingTest, truncated_shader_is_not_loaded )
+    {
+        compile(
+            "surface truncated_shader_is_not_loaded() { \n"
+            "   y = x; \n"
+            "}"
+        );
+
+        vector<unsigned char> data;
+        shader->save( symbol_table, &data );
+
+        Shader loaded_shader;
+        CHECK( !loaded_shader.load(&data[0], &data[0] + data.size() - 1, symbol_table) );
+        CHECK( loaded_shader.code().empty() );
+        CHECK( loaded_shader.symbols().empty() );
+    }
+
+    TEST_FIXTURE( ShaderCacheTest, shader_is_cached_in_file_named_for_its_key )
+    {
+        const string path = cache.path( filename.c_str(), symbol_table );
+        CHECK( path.size() == cache_directory.path.size() + 1 + 16 + 5 );
+        CHECK( path.compare(0, cache_directory.path.size(), cache_directory.path) == 0 );
+        CHECK( path.compare(path.size() - 5, 5, ".rslc") == 0 );
+        CHECK( read(path).empty() );
+
+        cache_shader();
+        check_doubled();
+
+        // Only the renamed file is left, no temporary files.
+        const vector<string> files = cache_directory.files();
+        CHECK_EQUAL( 1u, files.size() );
+        CHECK( !files.empty() && cache_directory.file(files[0].c_str()) == path );
+
+        const vector<unsigned char> data = read( path );
+        const ShaderCacheHeader header = ShaderCacheTest::header( data );
+        CHECK_EQUAL( SHADER_CACHE_MAGIC, header.magic );
+        CHECK_EQUAL( SHADER_CACHE_VERSION, header.version );
+        CHECK( header.symbols == symbol_table.fingerprint() );
+        CHECK( header.length == data.size() - sizeof(header) );
+        CHECK( header.checksum == hash(&data[0] + sizeof(header), data.size() - sizeof(header)) );
+    }
+
+    TEST_FIXTURE( ShaderCacheTest, key_changes_with_source_and_symbols )
+    {
+        const string path = cache.path( filename.c_str(), symbol_table );
+        write_source( "surface doubled() { y = x + x; }" );
+        const string edited_path = cache.path( filename.c_str(), symbol_table );
+        CHECK( edited_path != path );
+
+        symbol_table.add_symbols()
+            ( "z", TYPE_FLOAT )
+        ;
+        CHECK( cache.path(filename.c_str(), symbol_table) != edited_path );
+        CHECK( cache.path(sources.file("missing.sl").c_str(), symbol_table).empty() );
+    }
+
+    TEST_FIXTURE( ShaderCacheTest, cached_shader_is_loaded_without_compiling )
+    {
+        cache_shader();
+        const string path = cache.path( filename.c_str(), symbol_table );
+
+        // Replace the cached shader with a differently behaving one under the
+        // same key to tell loading from compiling.
+        compile( "surface tripled() { y = x * 3; }" );
+        vector<unsigned char> data( sizeof(ShaderCacheHeader) );
+        shader->save( symbol_table, &data );
+        ShaderCacheHeader header = ShaderCacheTest::header( read(path) );
+        header.length = data.size() - sizeof(header);
+        header.checksum = hash( &data[0] + sizeof(header), data.size() - sizeof(header) );
+        set_header( header, &data );
+        write( path, data );
+
+        cache_shader();
+        shade( *shader );
+        CHECK_CLOSE( 3.0f, y[0], TOLERANCE );
+        CHECK_CLOSE( 12.0f, y[3], TOLERANCE );
+        CHECK( read(path) == data );
+    }
+
+    TEST_FIXTURE( ShaderCacheTest, wrong_version_is_recompiled )
+    {
+        cache_shader();
+        vector<unsigned char> data = read( cache.path(filename.c_str(), symbol_table) );
+        ShaderCacheHeader header = ShaderCacheTest::header( data );
+        header.version += 1;
+        set_header( header, &data );
+        check_rejected_and_recompiled( data );
+    }
+
+    TEST_FIXTURE( ShaderCacheTest, wrong_symbol_table_is_recompiled )
+    {
+        cache_shader();
+        vector<unsigned char> data = read( cache.path(filename.c_str(), symbol_table) );
+        ShaderCacheHeader header = ShaderCacheTest::header( data );
+        header.symbols += 1;
+        set_header( header, &data );
+        check_rejected_and_recompiled( data );
+    }
+
+    TEST_FIXTURE( ShaderCacheTest, bad_checksum_is_recompiled )
+    {
+        cache_shader();
+        vector<unsigned char> data = read( cache.path(filename.c_str(), symbol_table) );
+        data.back() ^= 0xff;
+        check_rejected_and_recompiled( data );
+    }
+
+    TEST_FIXTURE( ShaderCacheTest, truncated_file_is_recompiled )
+    {
+        cache_shader();
+        vector<unsigned char> data = read( cache.path(filename.c_str(), symbol_table) );
+        data.resize( sizeof(ShaderCacheHeader) / 2 );
+        check_rejected_and_recompiled( data );
+    }
+
+    TEST( symbol_table_fingerprint_changes_with_symbols )
+    {
+        SymbolTable symbol_table;
+        SymbolTable other_symbol_table;
+        CHECK( symbol_table.fingerprint() == other_symbol_table.fingerprint() );
+
+        other_symbol_table.add_symbols()
+            ( "z", TYPE_FLOAT )
+        ;
+        CHECK( symbol_table.fingerprint() != other_symbol_table.fingerprint() );
+    }
+}
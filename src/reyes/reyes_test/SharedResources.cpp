@@ -0,0 +1,152 @@
+
+#include <UnitTest++/UnitTest++.h>
+#include <reyes/Registry.hpp>
+#include <reyes/Renderer.hpp>
+#include <reyes/Shader.hpp>
+#include <reyes/Texture.hpp>
+#include <reyes/ImageBuffer.hpp>
+#include <reyes/ImageBufferFormat.hpp>
+#include <reyes/assert.hpp>
+#include "TemporaryDirectory.hpp"
+#include <thread>
+#include <vector>
+#include <string>
+#include <string.h>
+#include <stdio.h>
+
+using std::vector;
+using std::string;
+using std::thread;
+using std::shared_ptr;
+using namespace reyes;
+
+SUITE( SharedResources )
+{
+    TEST( shader_is_found_after_it_is_added )
+    {
+        Registry registry;
+        shared_ptr<Shader> shader( new Shader() );
+        CHECK( registry.add_shader("shader", shader) == shader );
+        CHECK( registry.find_shader("shader") == shader );
+        CHECK( !registry.find_shader("other") );
+    }
+
+    TEST( first_shader_added_is_kept )
+    {
+        Registry registry;
+        shared_ptr<Shader> shader( new Shader() );
+        shared_ptr<Shader> other_shader( new Shader() );
+        registry.add_shader( "shader", shader );
+        CHECK( registry.add_shader("shader", other_shader) == shader );
+        CHECK( registry.find_shader("shader") == shader );
+    }
+
+    TEST( shader_is_released_when_no_longer_used )
+    {
+        Registry registry;
+        shared_ptr<Shader> shader( new Shader() );
+        registry.add_shader( "shader", shader );
+        shader.reset();
+        CHECK( !registry.find_shader("shader") );
+
+        shared_ptr<Shader> other_shader( new Shader() );
+        CHECK( registry.add_shader("shader", other_shader) == other_shader );
+    }
+
+    TEST( renderers_share_shaders )
+    {
+        Renderer renderer;
+        Renderer other_renderer;
+        Shader* shader = renderer.shader( SHADERS_PATH "ambientlight.sl" );
+        CHECK( shader );
+        CHECK( other_renderer.shader(SHADERS_PATH "ambientlight.sl") == shader );
+        CHECK( renderer.shader(SHADERS_PATH "ambientlight.sl") == shader );
+    }
+
+    void write_source( const string& filename, const char* source )
+    {
+        FILE* file = fopen( filename.c_str(), "wb" );
+        REYES_ASSERT( file );
+        if ( file )
+        {
+            fwrite( source, 1, strlen(source), file );
+            fclose( file );
+        }
+    }
+
+    void write_texture( const string& filename, int size )
+    {
+        ImageBuffer image_buffer;
+        image_buffer.reset( size, size, 3, FORMAT_U8 );
+        image_buffer.save_png( filename.c_str() );
+    }
+
+    TEST( renderers_compile_edited_shaders_again )
+    {
+        TemporaryDirectory directory;
+        const string filename = directory.file( "edited.sl" );
+        write_source( filename, "surface edited() { Ci = 0; }" );
+        Renderer renderer;
+        Shader* shader = renderer.shader( filename.c_str() );
+        CHECK( shader );
+
+        write_source( filename, "surface edited() { Ci = 1; }" );
+        Renderer other_renderer;
+        Shader* edited_shader = other_renderer.shader( filename.c_str() );
+        CHECK( edited_shader );
+        CHECK( edited_shader != shader );
+    }
+
+    TEST( renderers_load_rewritten_textures_again )
+    {
+        TemporaryDirectory directory;
+        const string filename = directory.file( "rewritten.png" );
+        write_texture( filename, 1 );
+        Renderer renderer;
+        renderer.texture( filename.c_str() );
+        Texture* texture = renderer.find_texture( filename.c_str() );
+        CHECK( texture );
+
+        Renderer other_renderer;
+        other_renderer.texture( filename.c_str() );
+        CHECK( other_renderer.find_texture(filename.c_str()) == texture );
+
+        write_texture( filename, 2 );
+        Renderer rewritten_renderer;
+        rewritten_renderer.texture( filename.c_str() );
+        Texture* rewritten_texture = rewritten_renderer.find_texture( filename.c_str() );
+        CHECK( rewritten_texture );
+        CHECK( rewritten_texture != texture );
+    }
+
+    TEST( renderers_on_different_threads_share_shaders )
+    {
+        const int THREADS = 8;
+        vector<Shader*> shaders( THREADS, (Shader*) NULL );
+        vector<Renderer*> renderers( THREADS, (Renderer*) NULL );
+        vector<thread> threads;
+        for ( int i = 0; i < THREADS; ++i )
+        {
+            renderers[i] = new Renderer();
+        }
+        for ( int i = 0; i < THREADS; ++i )
+        {
+            threads.push_back( thread([&renderers, &shaders, i]() {
+                shaders[i] = renderers[i]->shader( SHADERS_PATH "pointlight.sl" );
+            }) );
+        }
+        for ( int i = 0; i < THREADS; ++i )
+        {
+            threads[i].join();
+        }
+        for ( int i = 0; i < THREADS; ++i )
+        {
+            CHECK( shaders[i] );
+            CHECK( shaders[i] == shaders[0] );
+        }
+        for ( int i = 0; i < THREADS; ++i )
+        {
+            delete renderers[i];
+        }
+    }
+}
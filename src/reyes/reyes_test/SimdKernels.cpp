@@ -0,0 +1,161 @@
+
+#include <UnitTest++/UnitTest++.h>
+#include <reyes/reyes_virtual_machine/simd.hpp>
+#include <reyes/reyes_virtual_machine/ConditionMask.hpp>
+#include <math.h>
+
+using namespace reyes;
+
+SUITE( SimdKernels )
+{
+    // Long enough to cover full, empty, mixed, and partial mask words and a 
+    // scalar tail after the last full block of lanes.
+    static const unsigned int LENGTH = 219;
+
+    // The stride between the planes of the x, y, and z components when lhs 
+    // and rhs are used as values stored in planes.
+    static const unsigned int PLANE_STRIDE = LENGTH / 3;
+
+    struct SimdKernelsTest
+    {
+        float lhs[LENGTH];
+        float rhs[LENGTH];
+        uint64_t mask[(LENGTH + MASK_WORD_BITS - 1) / MASK_WORD_BITS];
+        float expected[LENGTH];
+        float result[LENGTH];
+        int expected_flags[LENGTH];
+        int result_flags[LENGTH];
+
+        SimdKernelsTest()
+        {
+            for ( unsigned int i = 0; i < LENGTH; ++i )
+            {
+                lhs[i] = float(i) * 0.5f - 3.0f;
+                rhs[i] = float(i % 5) + 0.25f;
+            }
+            mask[0] = ~uint64_t(0);
+            mask[1] = 0;
+            mask[2] = 0xf0f0f0f00000ffa5ULL;
+            mask[3] = 0x5a5f0f1ULL;
+            rhs[4] = lhs[4];
+            rhs[12] = lhs[12];
+            lhs[6 + PLANE_STRIDE] = 0.0f;
+            lhs[6 + 2 * PLANE_STRIDE] = 0.0f;
+        }
+
+        void check_binary( SimdKernels::BinaryFunction kernel, SimdKernels::BinaryFunction reference )
+        {
+            reference( expected, lhs, rhs, LENGTH );
+            kernel( result, lhs, rhs, LENGTH );
+            CHECK_ARRAY_CLOSE( expected, result, LENGTH, 1e-6f );
+        }
+
+        void check_assign( SimdKernels::AssignFunction kernel, SimdKernels::AssignFunction reference, const uint64_t* mask )
+        {
+            for ( unsigned int i = 0; i < LENGTH; ++i )
+            {
+                expected[i] = float(i) + 1.0f;
+                result[i] = float(i) + 1.0f;
+            }
+            reference( expected, rhs, mask, LENGTH );
+            kernel( result, rhs, mask, LENGTH );
+            CHECK_ARRAY_CLOSE( expected, result, LENGTH, 1e-6f );
+        }
+
+        void check_compare( SimdKernels::CompareFunction kernel, SimdKernels::CompareFunction reference )
+        {
+            reference( expected_flags, lhs, rhs, LENGTH );
+            kernel( result_flags, lhs, rhs, LENGTH );
+            CHECK_ARRAY_EQUAL( expected_flags, result_flags, LENGTH );
+        }
+
+        void check_dot_planes( SimdKernels::DotFunction kernel, SimdKernels::DotFunction reference )
+        {
+            reference( expected, lhs, PLANE_STRIDE, rhs, PLANE_STRIDE, PLANE_STRIDE );
+            kernel( result, lhs, PLANE_STRIDE, rhs, PLANE_STRIDE, PLANE_STRIDE );
+            CHECK_ARRAY_CLOSE( expected, result, PLANE_STRIDE, 1e-5f );
+        }
+
+        void check_normalize_planes( SimdKernels::NormalizeFunction kernel, SimdKernels::NormalizeFunction reference )
+        {
+            reference( expected, PLANE_STRIDE, lhs, PLANE_STRIDE, PLANE_STRIDE );
+            kernel( result, PLANE_STRIDE, lhs, PLANE_STRIDE, PLANE_STRIDE );
+            CHECK_ARRAY_CLOSE( expected, result, 3 * PLANE_STRIDE, 1e-6f );
+            CHECK_EQUAL( 0.0f, result[6] );
+            CHECK_EQUAL( 0.0f, result[6 + PLANE_STRIDE] );
+            CHECK_EQUAL( 0.0f, result[6 + 2 * PLANE_STRIDE] );
+        }
+
+        void check( SimdLevel level )
+        {
+            const SimdKernels& kernels = simd_kernels( level );
+            const SimdKernels& reference = simd_kernels( SIMD_SCALAR );
+            check_binary( kernels.add, reference.add );
+            check_binary( kernels.subtract, reference.subtract );
+            check_binary( kernels.multiply, reference.multiply );
+            check_binary( kernels.divide, reference.divide );
+            for ( int masked = 0; masked < 2; ++masked )
+            {
+                const uint64_t* assign_mask = masked ? mask : nullptr;
+                check_assign( kernels.assign, reference.assign, assign_mask );
+                check_assign( kernels.add_assign, reference.add_assign, assign_mask );
+                check_assign( kernels.subtract_assign, reference.subtract_assign, assign_mask );
+                check_assign( kernels.multiply_assign, reference.multiply_assign, assign_mask );
+                check_assign( kernels.divide_assign, reference.divide_assign, assign_mask );
+            }
+            check_compare( kernels.equal, reference.equal );
+            check_compare( kernels.not_equal, reference.not_equal );
+            check_compare( kernels.less, reference.less );
+            check_compare( kernels.less_equal, reference.less_equal );
+            check_compare( kernels.greater, reference.greater );
+            check_compare( kernels.greater_equal, reference.greater_equal );
+            check_dot_planes( kernels.dot_planes, reference.dot_planes );
+            check_normalize_planes( kernels.normalize_planes, reference.normalize_planes );
+        }
+    };
+
+    TEST( selected_kernels_match_cpu_level )
+    {
+        CHECK( simd_kernels().level <= simd_cpu_level() );
+    }
+
+    TEST_FIXTURE( SimdKernelsTest, scalar_plane_kernels_match_interleaved_results )
+    {
+        const SimdKernels& kernels = simd_kernels( SIMD_SCALAR );
+        kernels.dot_planes( result, lhs, PLANE_STRIDE, rhs, PLANE_STRIDE, PLANE_STRIDE );
+        for ( unsigned int i = 0; i < PLANE_STRIDE; ++i )
+        {
+            const float* x = &lhs[i];
+            const float* y = &rhs[i];
+            const float dot = x[0] * y[0] + x[PLANE_STRIDE] * y[PLANE_STRIDE] + x[2 * PLANE_STRIDE] * y[2 * PLANE_STRIDE];
+            CHECK_CLOSE( dot, result[i], 1e-5f );
+        }
+
+        kernels.normalize_planes( result, PLANE_STRIDE, lhs, PLANE_STRIDE, PLANE_STRIDE );
+        for ( unsigned int i = 0; i < PLANE_STRIDE; ++i )
+        {
+            const float* x = &lhs[i];
+            const float length = sqrtf( x[0] * x[0] + x[PLANE_STRIDE] * x[PLANE_STRIDE] + x[2 * PLANE_STRIDE] * x[2 * PLANE_STRIDE] );
+            for ( unsigned int j = 0; j < 3; ++j )
+            {
+                CHECK_CLOSE( length > 0.0f ? x[j * PLANE_STRIDE] / length : 0.0f, result[i + j * PLANE_STRIDE], 1e-6f );
+            }
+        }
+    }
+
+    TEST_FIXTURE( SimdKernelsTest, sse4_kernels_match_scalar_kernels )
+    {
+        if ( simd_cpu_level() >= SIMD_SSE4 )
+        {
+            check( SIMD_SSE4 );
+        }
+    }
+
+    TEST_FIXTURE( SimdKernelsTest, avx2_kernels_match_scalar_kernels )
+    {
+        if ( simd_cpu_level() >= SIMD_AVX2 )
+        {
+            check( SIMD_AVX2 );
+        }
+    }
+}
@@ -0,0 +1,211 @@
+
+#include "CaptureErrorPolicy.hpp"
+#include <UnitTest++/UnitTest++.h>
+#include <reyes/Shader.hpp>
+#include <reyes/Symbol.hpp>
+#include <reyes/Grid.hpp>
+#include <reyes/Value.hpp>
+#include <reyes/ErrorPolicy.hpp>
+#include <reyes/SymbolTable.hpp>
+#include <reyes/VirtualMachine.hpp>
+#include <reyes/Renderer.hpp>
+#include <reyes/ErrorCode.hpp>
+#include <reyes/assert.hpp>
+#include <algorithm>
+#include <string.h>
+
+using std::vector;
+using std::shared_ptr;
+using namespace math;
+using namespace reyes;
+
+static const float TOLERANCE = 0.01f;
+
+SUITE( StorageInference )
+{
+    struct StorageInferenceTest
+    {
+        Grid grid;
+        float* x;
+        float* y;
+        ErrorPolicy error_policy;
+        SymbolTable symbol_table;
+        shared_ptr<Shader> shader;
+     
+        StorageInferenceTest()
+        : grid(),
+          x( NULL ),
+          y( NULL ),
+          error_policy(),
+          symbol_table(),
+          shader()
+        {
+            grid.resize( 2, 2 );
+            shared_ptr<Value> x_value = grid.add_value( "x", TYPE_FLOAT );
+            x_value->zero();
+            x = x_value->float_values();
+            
+            shared_ptr<Value> y_value = grid.add_value( "y", TYPE_FLOAT );
+            y_value->zero();
+            y = y_value->float_values();
+
+            symbol_table.add_symbols()
+                ( "x", TYPE_FLOAT )
+                ( "y", TYPE_FLOAT )
+            ;
+        }
+        
+        void test( const char* source )
+        {
+            shader.reset( new Shader(source, source + strlen(source), symbol_table, error_policy) );
+            VirtualMachine virtual_machine;
+            virtual_machine.initialize( grid, *shader );
+            virtual_machine.shade( grid, grid, *shader );
+        }
+
+        ValueStorage storage( const char* identifier ) const
+        {
+            REYES_ASSERT( shader );
+            shared_ptr<Symbol> symbol = shader->find_symbol( identifier );
+            CHECK( symbol );
+            return symbol ? symbol->storage() : STORAGE_NULL;
+        }
+    };
+
+    TEST_FIXTURE( StorageInferenceTest, variable_assigned_uniform_values_is_uniform )
+    {
+        x[0] = 1.0f;
+        x[1] = 2.0f;
+        x[2] = 3.0f;
+        x[3] = 4.0f;
+        test(
+            "surface variable_assigned_uniform_values_is_uniform( float Kd = 0.5; ) { \n"
+            "   float scale = 2 * Kd; \n"
+            "   float offset; \n"
+            "   offset = scale + 1; \n"
+            "   y = scale * x + offset; \n"
+            "}"
+        );
+        CHECK_EQUAL( STORAGE_UNIFORM, storage("scale") );
+        CHECK_EQUAL( STORAGE_UNIFORM, storage("offset") );
+        CHECK_CLOSE( 3.0f, y[0], TOLERANCE );
+        CHECK_CLOSE( 4.0f, y[1], TOLERANCE );
+        CHECK_CLOSE( 5.0f, y[2], TOLERANCE );
+        CHECK_CLOSE( 6.0f, y[3], TOLERANCE );
+    }
+
+    TEST_FIXTURE( StorageInferenceTest, variable_assigned_varying_value_is_varying )
+    {
+        x[0] = 1.0f;
+        x[1] = 2.0f;
+        x[2] = 3.0f;
+        x[3] = 4.0f;
+        test(
+            "surface variable_assigned_varying_value_is_varying() { \n"
+            "   float a = 1; \n"
+            "   float b = a; \n"
+            "   b += x; \n"
+            "   a = b * 2; \n"
+            "   y = a; \n"
+            "}"
+        );
+        CHECK_EQUAL( STORAGE_VARYING, storage("a") );
+        CHECK_EQUAL( STORAGE_VARYING, storage("b") );
+        CHECK_CLOSE( 4.0f, y[0], TOLERANCE );
+        CHECK_CLOSE( 6.0f, y[1], TOLERANCE );
+        CHECK_CLOSE( 8.0f, y[2], TOLERANCE );
+        CHECK_CLOSE( 10.0f, y[3], TOLERANCE );
+    }
+
+    TEST_FIXTURE( StorageInferenceTest, variable_assigned_in_varying_if_is_varying )
+    {
+        x[0] = 1.0f;
+        x[2] = 1.0f;
+        test(
+            "surface variable_assigned_in_varying_if_is_varying() { \n"
+            "   float a = 0; \n"
+            "   if ( x > 0 ) { \n"
+            "       a = 1; \n"
+            "   } \n"
+            "   y = a; \n"
+            "}"
+        );
+        CHECK_EQUAL( STORAGE_VARYING, storage("a") );
+        CHECK_CLOSE( 1.0f, y[0], TOLERANCE );
+        CHECK_CLOSE( 0.0f, y[1], TOLERANCE );
+        CHECK_CLOSE( 1.0f, y[2], TOLERANCE );
+        CHECK_CLOSE( 0.0f, y[3], TOLERANCE );
+    }
+
+    TEST_FIXTURE( StorageInferenceTest, variable_assigned_in_uniform_loop_is_uniform )
+    {
+        test(
+            "surface variable_assigned_in_uniform_loop_is_uniform() { \n"
+            "   float i = 0; \n"
+            "   float sum = 0; \n"
+            "   while ( i < 4 ) { \n"
+            "       sum += i; \n"
+            "       i += 1; \n"
+            "   } \n"
+            "   y = sum; \n"
+            "}"
+        );
+        CHECK_EQUAL( STORAGE_UNIFORM, storage("i") );
+        CHECK_EQUAL( STORAGE_UNIFORM, storage("sum") );
+        CHECK_CLOSE( 6.0f, y[0], TOLERANCE );
+        CHECK_CLOSE( 6.0f, y[1], TOLERANCE );
+        CHECK_CLOSE( 6.0f, y[2], TOLERANCE );
+        CHECK_CLOSE( 6.0f, y[3], TOLERANCE );
+    }
+
+    TEST_FIXTURE( StorageInferenceTest, variable_assigned_in_loop_with_varying_break_is_varying )
+    {
+        x[0] = 1.0f;
+        x[2] = 1.0f;
+        test(
+            "surface variable_assigned_in_loop_with_varying_break_is_varying() { \n"
+            "   float i; \n"
+            "   for ( i = 0; i < 4; i += 1 ) { \n"
+            "       if ( x > 0 ) { \n"
+            "           break; \n"
+            "       } \n"
+            "   } \n"
+            "   y = i; \n"
+            "}"
+        );
+        CHECK_EQUAL( STORAGE_VARYING, storage("i") );
+        CHECK_CLOSE( 0.0f, y[0], TOLERANCE );
+        CHECK_CLOSE( 4.0f, y[1], TOLERANCE );
+        CHECK_CLOSE( 0.0f, y[2], TOLERANCE );
+        CHECK_CLOSE( 4.0f, y[3], TOLERANCE );
+    }
+
+    TEST_FIXTURE( StorageInferenceTest, variable_with_declared_storage_is_unchanged )
+    {
+        test(
+            "surface variable_with_declared_storage_is_unchanged() { \n"
+            "   varying float a = 1; \n"
+            "   y = a; \n"
+            "}"
+        );
+        CHECK_EQUAL( STORAGE_VARYING, storage("a") );
+        CHECK_CLOSE( 1.0f, y[0], TOLERANCE );
+        CHECK_CLOSE( 1.0f, y[3], TOLERANCE );
+    }
+
+    TEST( errors_found_before_inference_still_fail_analysis )
+    {
+        const char* source =
+            "light errors_found_before_inference_still_fail_analysis( float intensity = 1; point to = point \"shader\" (0, 0, 1); ) { \n"
+            "   float scale = intensity; \n"
+            "   Cl = scale; \n"
+            "   solar( to, 0.0 ) \n"
+            "       Cl = scale; \n"
+            "}"
+        ;
+        Renderer renderer;
+        CaptureErrorPolicy error_policy;
+        Shader shader( source, source + strlen(source), renderer.symbol_table(), error_policy );
+        CHECK( std::find(error_policy.errors.begin(), error_policy.errors.end(), int(RENDER_ERROR_SEMANTIC_ANALYSIS_FAILED)) != error_policy.errors.end() );
+    }
+}
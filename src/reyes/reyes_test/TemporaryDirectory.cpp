@@ -0,0 +1,100 @@
+//
+// TemporaryDirectory.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "TemporaryDirectory.hpp"
+#include <reyes/assert.hpp>
+#include <stdlib.h>
+#include <stdio.h>
+
+#if defined(BUILD_OS_WINDOWS)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+using std::string;
+using std::vector;
+using namespace reyes;
+
+TemporaryDirectory::TemporaryDirectory()
+: path()
+{
+#if defined(BUILD_OS_WINDOWS)
+    char temporary_path [MAX_PATH];
+    char name [MAX_PATH];
+    GetTempPathA( sizeof(temporary_path), temporary_path );
+    GetTempFileNameA( temporary_path, "rys", 0, name );
+    DeleteFileA( name );
+    CreateDirectoryA( name, NULL );
+    path = name;
+    for ( string::iterator i = path.begin(); i != path.end(); ++i )
+    {
+        *i = *i == '\\' ? '/' : *i;
+    }
+#else
+    const char* temporary_path = getenv( "TMPDIR" );
+    string name = string( temporary_path && *temporary_path ? temporary_path : "/tmp" ) + "/reyes_test.XXXXXX";
+    const char* created_path = mkdtemp( &name[0] );
+    REYES_ASSERT( created_path );
+    path = created_path ? created_path : "";
+#endif
+}
+
+TemporaryDirectory::~TemporaryDirectory()
+{
+    vector<string> files = TemporaryDirectory::files();
+    for ( vector<string>::const_iterator i = files.begin(); i != files.end(); ++i )
+    {
+        remove( file(i->c_str()).c_str() );
+    }
+#if defined(BUILD_OS_WINDOWS)
+    RemoveDirectoryA( path.c_str() );
+#else
+    rmdir( path.c_str() );
+#endif
+}
+
+std::string TemporaryDirectory::file( const char* name ) const
+{
+    REYES_ASSERT( name );
+    return path + "/" + name;
+}
+
+std::vector<std::string> TemporaryDirectory::files() const
+{
+    vector<string> files;
+#if defined(BUILD_OS_WINDOWS)
+    WIN32_FIND_DATAA find_data;
+    HANDLE find = FindFirstFileA( (path + "/*").c_str(), &find_data );
+    if ( find != INVALID_HANDLE_VALUE )
+    {
+        do
+        {
+            if ( !(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) )
+            {
+                files.push_back( find_data.cFileName );
+            }
+        }
+        while ( FindNextFileA(find, &find_data) );
+        FindClose( find );
+    }
+#else
+    DIR* directory = opendir( path.c_str() );
+    if ( directory )
+    {
+        while ( struct dirent* entry = readdir(directory) )
+        {
+            const string name = entry->d_name;
+            if ( name != "." && name != ".." )
+            {
+                files.push_back( name );
+            }
+        }
+        closedir( directory );
+    }
+#endif
+    return files;
+}
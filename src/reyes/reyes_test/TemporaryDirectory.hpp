@@ -0,0 +1,26 @@
+#ifndef REYES_TEMPORARYDIRECTORY_HPP_INCLUDED
+#define REYES_TEMPORARYDIRECTORY_HPP_INCLUDED
+
+#include <vector>
+#include <string>
+
+namespace reyes
+{
+
+/**
+// A uniquely named directory created in the system's temporary directory 
+// and removed, along with any files written into it, when destroyed.
+*/
+struct TemporaryDirectory
+{
+    std::string path; ///< The path of the directory (with forward slashes and without a trailing separator).
+
+    TemporaryDirectory();
+    ~TemporaryDirectory();
+    std::string file( const char* name ) const;
+    std::vector<std::string> files() const;
+};
+
+}
+
+#endif
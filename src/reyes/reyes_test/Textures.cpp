@@ -0,0 +1,190 @@
+
+#include <UnitTest++/UnitTest++.h>
+#include <reyes/Texture.hpp>
+#include <reyes/ImageBuffer.hpp>
+#include <reyes/ImageBufferFormat.hpp>
+#include <reyes/Renderer.hpp>
+#include <reyes/Shader.hpp>
+#include <reyes/Grid.hpp>
+#include <reyes/Value.hpp>
+#include <reyes/assert.hpp>
+#include "TemporaryDirectory.hpp"
+#include <math/vec4.ipp>
+#include <math/mat4x4.ipp>
+#include <string>
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <string.h>
+
+using std::string;
+using std::shared_ptr;
+using namespace math;
+using namespace reyes;
+
+static const float TOLERANCE = 0.01f;
+
+SUITE( Textures )
+{
+    struct CheckerboardTexture
+    {
+        Texture texture;
+
+        CheckerboardTexture()
+        : texture( TEXTURE_COLOR, math::identity(), math::identity() )
+        {
+            const int SIZE = 8;
+            ImageBuffer* image_buffer = texture.image_buffers();
+            image_buffer->reset( SIZE, SIZE, 3, FORMAT_U8 );
+            for ( int y = 0; y < SIZE; ++y )
+            {
+                for ( int x = 0; x < SIZE; ++x )
+                {
+                    unsigned char* texel = image_buffer->u8_data( x, y );
+                    texel[0] = texel[1] = texel[2] = (x + y) % 2 ? 255 : 0;
+                }
+            }
+            texture.generate_mipmaps();
+        }
+    };
+
+    TEST_FIXTURE( CheckerboardTexture, mip_pyramid_halves_down_to_one_texel )
+    {
+        CHECK_EQUAL( 4, texture.levels() );
+        CHECK_EQUAL( 8, texture.level(0).width() );
+        CHECK_EQUAL( 4, texture.level(1).width() );
+        CHECK_EQUAL( 2, texture.level(2).width() );
+        CHECK_EQUAL( 1, texture.level(3).width() );
+        CHECK_EQUAL( 1, texture.level(3).height() );
+    }
+
+    TEST_FIXTURE( CheckerboardTexture, small_footprint_looks_up_full_resolution_texels )
+    {
+        CHECK_CLOSE( 0.0f, texture.color(0.0f, 0.0f, 0.0f, 0.0f).x, TOLERANCE );
+        CHECK_CLOSE( 1.0f, texture.color(1.0f / 7.0f, 0.0f, 0.0f, 0.0f).x, TOLERANCE );
+    }
+
+    TEST_FIXTURE( CheckerboardTexture, lookup_between_texels_is_interpolated )
+    {
+        CHECK_CLOSE( 0.5f, texture.color(0.5f / 7.0f, 0.0f, 0.0f, 0.0f).x, TOLERANCE );
+    }
+
+    TEST_FIXTURE( CheckerboardTexture, large_footprint_averages_texels )
+    {
+        CHECK_CLOSE( 0.5f, texture.color(0.0f, 0.0f, 1.0f, 1.0f).x, TOLERANCE );
+        CHECK_CLOSE( 0.5f, texture.color(0.25f, 0.75f, 0.25f, 0.25f).x, TOLERANCE );
+    }
+
+    struct TextureLookupTest
+    {
+        TemporaryDirectory directory;
+        string filename;
+        Renderer renderer;
+        Grid grid;
+        float* s;
+        float* t;
+        vec3* Ci;
+
+        TextureLookupTest()
+        : directory(),
+          filename( directory.file("checkerboard.png") ),
+          renderer(),
+          grid(),
+          s( NULL ),
+          t( NULL ),
+          Ci( NULL )
+        {
+            const int SIZE = 8;
+            ImageBuffer image_buffer;
+            image_buffer.reset( SIZE, SIZE, 3, FORMAT_U8 );
+            for ( int y = 0; y < SIZE; ++y )
+            {
+                for ( int x = 0; x < SIZE; ++x )
+                {
+                    unsigned char* texel = image_buffer.u8_data( x, y );
+                    texel[0] = texel[1] = texel[2] = (x + y) % 2 ? 255 : 0;
+                }
+            }
+            image_buffer.save_png( filename.c_str() );
+
+            renderer.begin();
+            renderer.perspective( float(M_PI) / 2.0f );
+            renderer.projection();
+            renderer.begin_world();
+
+            grid.resize( 2, 2 );
+            shared_ptr<Value> P_value = grid.add_value( "P", TYPE_POINT );
+            P_value->zero();
+
+            shared_ptr<Value> s_value = grid.add_value( "s", TYPE_FLOAT );
+            s_value->zero();
+            s = s_value->float_values();
+
+            shared_ptr<Value> t_value = grid.add_value( "t", TYPE_FLOAT );
+            t_value->zero();
+            t = t_value->float_values();
+
+            shared_ptr<Value> Ci_value = grid.add_value( "Ci", TYPE_COLOR );
+            Ci_value->zero();
+            Ci = Ci_value->vec3_values();
+        }
+
+        void shade( float width )
+        {
+            s[0] = 0.0f;
+            s[1] = width;
+            s[2] = 0.0f;
+            s[3] = width;
+            t[0] = 0.0f;
+            t[1] = 0.0f;
+            t[2] = width;
+            t[3] = width;
+
+            renderer.texture( filename.c_str() );
+            const string source = "surface lookup() { Ci = color texture( \"" + filename + "\", s, t ); }";
+            Shader shader( source.c_str(), source.c_str() + source.size(), renderer.symbol_table(), renderer.error_policy() );
+            renderer.surface_shader( &shader );
+            renderer.surface_shade( grid );
+        }
+    };
+
+    TEST_FIXTURE( TextureLookupTest, minified_lookup_uses_coarser_level )
+    {
+        // Each micropolygon spans the whole texture so the single texel 
+        // level is looked up and gives the checkerboard's average.
+        shade( 1.0f );
+        CHECK_CLOSE( 0.5f, Ci[0].x, TOLERANCE );
+        CHECK_CLOSE( 0.5f, Ci[1].x, TOLERANCE );
+        CHECK_CLOSE( 0.5f, Ci[2].x, TOLERANCE );
+        CHECK_CLOSE( 0.5f, Ci[3].x, TOLERANCE );
+    }
+
+    TEST_FIXTURE( TextureLookupTest, magnified_lookup_uses_full_resolution_level )
+    {
+        shade( 0.001f );
+        CHECK_CLOSE( 0.0f, Ci[0].x, TOLERANCE );
+        CHECK_CLOSE( 0.0f, Ci[3].x, TOLERANCE );
+    }
+
+    TEST_FIXTURE( TextureLookupTest, environment_maps_have_no_mip_pyramid )
+    {
+        renderer.environment( filename.c_str() );
+        const Texture* texture = renderer.find_texture( filename.c_str() );
+        CHECK( texture );
+        CHECK( texture && texture->levels() == 1 );
+    }
+
+    TEST( odd_sized_textures_clamp_to_their_edges )
+    {
+        Texture texture( TEXTURE_COLOR, math::identity(), math::identity() );
+        ImageBuffer* image_buffer = texture.image_buffers();
+        image_buffer->reset( 3, 1, 3, FORMAT_U8 );
+        for ( int x = 0; x < 3; ++x )
+        {
+            unsigned char* texel = image_buffer->u8_data( x, 0 );
+            texel[0] = texel[1] = texel[2] = 255;
+        }
+        texture.generate_mipmaps();
+        CHECK_EQUAL( 2, texture.levels() );
+        CHECK_CLOSE( 1.0f, texture.color(0.5f, 0.5f, 1.0f, 1.0f).x, TOLERANCE );
+    }
+}
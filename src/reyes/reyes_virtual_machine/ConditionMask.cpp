@@ -6,20 +6,53 @@
 #include "ConditionMask.hpp"
 #include <reyes/Value.hpp>
 #include <reyes/assert.hpp>
+#include <algorithm>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using std::min;
 using namespace reyes;
 
+static int count_trailing_zeros( uint64_t bits )
+{
+    REYES_ASSERT( bits != 0 );
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward64( &index, bits );
+    return int(index);
+#else
+    return __builtin_ctzll( bits );
+#endif
+}
+
+static int count_bits( uint64_t bits )
+{
+#if defined(_MSC_VER)
+    return int(__popcnt64( bits ));
+#else
+    return __builtin_popcountll( bits );
+#endif
+}
+
 ConditionMask::ConditionMask()
 : mask_(),
+  size_( 0 ),
   processed_( 0 )
 {
 }
 
-const std::vector<unsigned char>& ConditionMask::mask() const
+const std::vector<uint64_t>& ConditionMask::mask() const
 {
     return mask_;
 }
 
+unsigned int ConditionMask::size() const
+{
+    return size_;
+}
+
 int ConditionMask::processed() const
 {
     return processed_;
@@ -30,7 +63,17 @@ bool ConditionMask::empty() const
     return processed_ == 0;
 }
 
-void ConditionMask::generate( std::shared_ptr<Value> value )
+/**
+// Does this mask specify that every element is to be processed?
+//
+// Kernels given a full mask can ignore it and run at unmasked speed.
+*/
+bool ConditionMask::full() const
+{
+    return processed_ == int(size_);
+}
+
+void ConditionMask::generate( const Value* value )
 {
     REYES_ASSERT( value );
     REYES_ASSERT( value->type() == TYPE_INTEGER );
@@ -38,48 +81,113 @@ void ConditionMask::generate( std::shared_ptr<Value> value )
     const unsigned int size = value->size();
     const int* values = value->int_values();
 
-    mask_.insert( mask_.end(), size, 0 );
-    processed_ = 0;
-    unsigned char* mask = &mask_[0];
+    size_ = size;
+    mask_.assign( (size + MASK_WORD_BITS - 1) / MASK_WORD_BITS, 0 );
+    uint64_t* mask = mask_.empty() ? nullptr : &mask_[0];
     for ( unsigned int i = 0; i < size; ++i )
     {
-        int process = values[i];
-        mask[i] = process != 0;
-        processed_ += process != 0;
+        mask[i / MASK_WORD_BITS] |= uint64_t(values[i] != 0) << (i % MASK_WORD_BITS);
     }
+    count_processed();
 }
 
-void ConditionMask::generate( const ConditionMask& condition_mask, std::shared_ptr<Value> value )
+void ConditionMask::generate( const ConditionMask& condition_mask, const Value* value )
 {
     REYES_ASSERT( value );
     REYES_ASSERT( value->type() == TYPE_INTEGER );
-    REYES_ASSERT( condition_mask.mask_.size() == value->size() );
-    
-    const unsigned int size = value->size();
-    const int* values = value->int_values();
-    const unsigned char* existing_mask = &condition_mask.mask_[0];
+    REYES_ASSERT( condition_mask.size_ == value->size() );
 
-    mask_.insert( mask_.end(), size, 0 );
-    processed_ = 0;
-    unsigned char* mask = &mask_[0];
-    for ( unsigned int i = 0; i < size; ++i )
+    generate( value );
+    for ( unsigned int i = 0; i < mask_.size(); ++i )
     {
-        int process = values[i] && existing_mask[i];
-        mask[i] = process != 0;
-        processed_ += process != 0;
+        mask_[i] &= condition_mask.mask_[i];
     }
+    count_processed();
 }
 
 void ConditionMask::invert()
 {
-    const int size = int(mask_.size());
-    unsigned char* mask = &mask_[0];
-    
+    for ( unsigned int i = 0; i < mask_.size(); ++i )
+    {
+        mask_[i] = ~mask_[i];
+    }
+
+    // Keep the bits past the last element clear so that whole word tests 
+    // and counts only ever see real elements.
+    const unsigned int tail = size_ % MASK_WORD_BITS;
+    if ( tail != 0 )
+    {
+        mask_.back() &= (uint64_t(1) << tail) - 1;
+    }
+    count_processed();
+}
+
+void ConditionMask::count_processed()
+{
     processed_ = 0;
-    for ( int i = 0; i < size; ++i )
+    for ( unsigned int i = 0; i < mask_.size(); ++i )
+    {
+        processed_ += count_bits( mask_[i] );
+    }
+}
+
+/**
+// Find the next run of consecutive elements that a condition mask selects.
+//
+// Masked kernels walk these runs instead of testing each element so that 
+// words with every element set merge into long unmasked loops and words
+// with no elements set are skipped with a single test.  Start with 
+// \e begin and \e end zeroed and call until false is returned.
+//
+// @param mask
+//  The bits of the condition mask, one per element.
+//
+// @param length
+//  The number of elements covered by \e mask.
+//
+// @param begin
+//  Set to the index of the first element in the next run.
+//
+// @param end
+//  Holds the end of the previous run on entry and is set to one past the 
+//  last element in the next run.
+//
+// @return
+//  True if another run was found otherwise false.
+*/
+bool reyes::next_active_range( const uint64_t* mask, unsigned int length, unsigned int* begin, unsigned int* end )
+{
+    REYES_ASSERT( mask );
+    REYES_ASSERT( begin );
+    REYES_ASSERT( end );
+
+    unsigned int i = *end;
+    while ( i < length )
+    {
+        const uint64_t bits = mask[i / MASK_WORD_BITS] >> (i % MASK_WORD_BITS);
+        if ( bits )
+        {
+            i += count_trailing_zeros( bits );
+            break;
+        }
+        i = (i / MASK_WORD_BITS + 1) * MASK_WORD_BITS;
+    }
+    if ( i >= length )
+    {
+        return false;
+    }
+
+    *begin = i;
+    while ( i < length )
     {
-        int process = !mask[i];
-        mask[i] = process != 0;
-        processed_ += process != 0;
+        const uint64_t bits = ~mask[i / MASK_WORD_BITS] >> (i % MASK_WORD_BITS);
+        if ( bits )
+        {
+            i += count_trailing_zeros( bits );
+            break;
+        }
+        i = (i / MASK_WORD_BITS + 1) * MASK_WORD_BITS;
     }
+    *end = min( i, length );
+    return true;
 }
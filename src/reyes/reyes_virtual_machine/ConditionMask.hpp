@@ -3,27 +3,41 @@
 
 #include <vector>
 #include <memory>
+#include <stdint.h>
 
 namespace reyes
 {
 
 class Value;
 
+/**
+// The number of elements packed into each word of a condition mask.
+*/
+static const unsigned int MASK_WORD_BITS = 64;
+
 class ConditionMask
 {
-    std::vector<unsigned char> mask_; ///< The mask that specifies whether or not an element is to be processed.
+    std::vector<uint64_t> mask_; ///< The mask, one bit per element, that specifies whether or not an element is to be processed.
+    unsigned int size_; ///< The number of elements covered by this mask.
     int processed_; ///< The number of elements that are to be processed by this mask.
 
 public:
     ConditionMask();
-    const std::vector<unsigned char>& mask() const;
+    const std::vector<uint64_t>& mask() const;
+    unsigned int size() const;
     int processed() const;
     bool empty() const;
-    void generate( std::shared_ptr<Value> value );
-    void generate( const ConditionMask& condition_mask, std::shared_ptr<Value> value );
+    bool full() const;
+    void generate( const Value* value );
+    void generate( const ConditionMask& condition_mask, const Value* value );
     void invert();
+
+private:
+    void count_processed();
 };
 
+bool next_active_range( const uint64_t* mask, unsigned int length, unsigned int* begin, unsigned int* end );
+
 }
 
 #endif
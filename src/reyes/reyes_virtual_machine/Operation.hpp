@@ -0,0 +1,46 @@
+#ifndef REYES_OPERATION_HPP_INCLUDED
+#define REYES_OPERATION_HPP_INCLUDED
+
+#include <reyes/VirtualMachine.hpp>
+
+namespace reyes
+{
+
+/**
+// The maximum number of arguments encoded with any instruction (see
+// INSTRUCTION_ILLUMINATE_AXIS_ANGLE).
+*/
+static const int OPERATION_ARGUMENTS = 7;
+
+/**
+// An instruction decoded once, when its Shader is created, so that the
+// virtual machine can execute it without decoding anything.
+//
+// The handler that executes the instruction is stored directly (direct
+// threading) and operands are stored as register indices.  Registers
+// allocated for results and the operations that jumps land on are
+// resolved during decoding.  Reset instructions only direct register
+// allocation and so never become operations.
+//
+// Operations that write or read vec3 temporaries stored in planes are 
+// marked so that native code executes them through their handlers rather
+// than calling interleaved kernels directly (see 
+// VirtualMachine::decode_planes()).
+*/
+struct Operation
+{
+    typedef void (VirtualMachine::*Handler)( const Operation& operation );
+
+    Handler handler; ///< The member function of VirtualMachine that executes this operation.
+    int instruction; ///< The instruction that this operation was decoded from.
+    int dispatch; ///< The dispatch word encoded with the instruction.
+    int address; ///< The address of the instruction in its shader's byte code.
+    int result; ///< The register that receives the result of this operation or -1 if it has no result.
+    int target; ///< The index of the operation that this operation jumps to or -1 if it doesn't jump.
+    int arguments [OPERATION_ARGUMENTS]; ///< The arguments encoded with the instruction, usually register indices.
+    bool planes; ///< True if this operation writes or reads values stored in planes.
+};
+
+}
+
+#endif
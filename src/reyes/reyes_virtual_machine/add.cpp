@@ -2,6 +2,7 @@
 #include "add.hpp"
 #include "Dispatch.hpp"
 #include "Instruction.hpp"
+#include "simd.hpp"
 #include <reyes/assert.hpp>
 
 namespace reyes
@@ -111,40 +112,22 @@ void add_v4u4( float* result, const float* lhs, const float* rhs, unsigned int l
 
 void add_v1v1( float* result, const float* lhs, const float* rhs, unsigned int length )
 {
-    for ( unsigned int i = 0; i < length; ++i )
-    {
-        result[i] = lhs[i] + rhs[i];
-    }
+    simd_kernels().add( result, lhs, rhs, length );
 }
 
 void add_v2v2( float* result, const float* lhs, const float* rhs, unsigned int length )
 {
-    for ( unsigned int i = 0; i < length; ++i )
-    {
-        result[i * 2 + 0] = lhs[i * 2 + 0] + rhs[i * 2 + 0];
-        result[i * 2 + 1] = lhs[i * 2 + 1] + rhs[i * 2 + 1];
-    }
+    add_v1v1( result, lhs, rhs, length * 2 );
 }
 
 void add_v3v3( float* result, const float* lhs, const float* rhs, unsigned int length )
 {
-    for ( unsigned int i = 0; i < length; ++i )
-    {
-        result[i * 3 + 0] = lhs[i * 3 + 0] + rhs[i * 3 + 0];
-        result[i * 3 + 1] = lhs[i * 3 + 1] + rhs[i * 3 + 1];
-        result[i * 3 + 2] = lhs[i * 3 + 2] + rhs[i * 3 + 2];
-    }
+    add_v1v1( result, lhs, rhs, length * 3 );
 }
 
 void add_v4v4( float* result, const float* lhs, const float* rhs, unsigned int length )
 {
-    for ( unsigned int i = 0; i < length; ++i )
-    {
-        result[i * 4 + 0] = lhs[i * 4 + 0] + rhs[i * 4 + 0];
-        result[i * 4 + 1] = lhs[i * 4 + 1] + rhs[i * 4 + 1];
-        result[i * 4 + 2] = lhs[i * 4 + 2] + rhs[i * 4 + 2];
-        result[i * 4 + 3] = lhs[i * 4 + 3] + rhs[i * 4 + 3];
-    }
+    add_v1v1( result, lhs, rhs, length * 4 );
 }
 
 void add( int dispatch, float* result, const float* lhs, const float* rhs, unsigned int length )
@@ -6,6 +6,23 @@ namespace reyes
 
 void add( int dispatch, float* result, const float* lhs, const float* rhs, unsigned int length );
 
+void add_u1u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void add_u2u2( float* result, const float* lhs, const float* rhs, unsigned int length );
+void add_u3u3( float* result, const float* lhs, const float* rhs, unsigned int length );
+void add_u4u4( float* result, const float* lhs, const float* rhs, unsigned int length );
+void add_u1v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void add_u2v2( float* result, const float* lhs, const float* rhs, unsigned int length );
+void add_u3v3( float* result, const float* lhs, const float* rhs, unsigned int length );
+void add_u4v4( float* result, const float* lhs, const float* rhs, unsigned int length );
+void add_v1u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void add_v2u2( float* result, const float* lhs, const float* rhs, unsigned int length );
+void add_v3u3( float* result, const float* lhs, const float* rhs, unsigned int length );
+void add_v4u4( float* result, const float* lhs, const float* rhs, unsigned int length );
+void add_v1v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void add_v2v2( float* result, const float* lhs, const float* rhs, unsigned int length );
+void add_v3v3( float* result, const float* lhs, const float* rhs, unsigned int length );
+void add_v4v4( float* result, const float* lhs, const float* rhs, unsigned int length );
+
 }
 
 #endif
@@ -1,7 +1,9 @@
 
 #include "add_assign.hpp"
 #include "Dispatch.hpp"
+#include "ConditionMask.hpp"
 #include "Instruction.hpp"
+#include "simd.hpp"
 #include <reyes/assert.hpp>
 
 namespace reyes
@@ -33,7 +35,7 @@ void add_assign_u4u4( float* result, const float* rhs, unsigned int /*length*/ )
     result[0 + 3] += rhs[0 + 3];
 }
 
-void add_assign_v1u1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void add_assign_v1u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -44,9 +46,11 @@ void add_assign_v1u1( float* result, const float* rhs, const unsigned char* mask
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i] += rhs[0];
             }
@@ -54,7 +58,7 @@ void add_assign_v1u1( float* result, const float* rhs, const unsigned char* mask
     }
 }
 
-void add_assign_v2u2( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void add_assign_v2u2( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -66,9 +70,11 @@ void add_assign_v2u2( float* result, const float* rhs, const unsigned char* mask
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 2 + 0] += rhs[0 + 0];
                 result[i * 2 + 1] += rhs[0 + 1];
@@ -77,7 +83,7 @@ void add_assign_v2u2( float* result, const float* rhs, const unsigned char* mask
     }
 }
 
-void add_assign_v3u3( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void add_assign_v3u3( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -90,9 +96,11 @@ void add_assign_v3u3( float* result, const float* rhs, const unsigned char* mask
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 3 + 0] += rhs[0 + 0];
                 result[i * 3 + 1] += rhs[0 + 1];
@@ -102,7 +110,7 @@ void add_assign_v3u3( float* result, const float* rhs, const unsigned char* mask
     }
 }
 
-void add_assign_v4u4( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void add_assign_v4u4( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -116,9 +124,11 @@ void add_assign_v4u4( float* result, const float* rhs, const unsigned char* mask
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 4 + 0] += rhs[0 + 0];
                 result[i * 4 + 1] += rhs[0 + 1];
@@ -129,103 +139,63 @@ void add_assign_v4u4( float* result, const float* rhs, const unsigned char* mask
     }
 }
 
-void add_assign_v1v1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void add_assign_v1v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
-    if ( !mask )
-    {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            result[i] += rhs[i];
-        }
-    }
-    else
-    {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            if ( mask[i] )
-            {
-                result[i] += rhs[i];
-            }
-        }
-    }
+    simd_kernels().add_assign( result, rhs, mask, length );
 }
 
-void add_assign_v2v2( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void add_assign_v2v2( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            result[i * 2 + 0] += rhs[i * 2 + 0];
-            result[i * 2 + 1] += rhs[i * 2 + 1];
-        }
+        add_assign_v1v1( result, rhs, nullptr, length * 2 );
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
-            {
-                result[i * 2 + 0] += rhs[i * 2 + 0];
-                result[i * 2 + 1] += rhs[i * 2 + 1];
-            }
+            add_assign_v1v1( result + begin * 2, rhs + begin * 2, nullptr, (end - begin) * 2 );
         }
     }
 }
 
-void add_assign_v3v3( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void add_assign_v3v3( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            result[i * 3 + 0] += rhs[i * 3 + 0];
-            result[i * 3 + 1] += rhs[i * 3 + 1];
-            result[i * 3 + 2] += rhs[i * 3 + 2];
-        }
+        add_assign_v1v1( result, rhs, nullptr, length * 3 );
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
-            {
-                result[i * 3 + 0] += rhs[i * 3 + 0];
-                result[i * 3 + 1] += rhs[i * 3 + 1];
-                result[i * 3 + 2] += rhs[i * 3 + 2];
-            }
+            add_assign_v1v1( result + begin * 3, rhs + begin * 3, nullptr, (end - begin) * 3 );
         }
     }
 }
 
-void add_assign_v4v4( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void add_assign_v4v4( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            result[i * 4 + 0] += rhs[i * 4 + 0];
-            result[i * 4 + 1] += rhs[i * 4 + 1];
-            result[i * 4 + 2] += rhs[i * 4 + 2];
-            result[i * 4 + 3] += rhs[i * 4 + 3];
-        }
+        add_assign_v1v1( result, rhs, nullptr, length * 4 );
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
-            {
-                result[i * 4 + 0] += rhs[i * 4 + 0];
-                result[i * 4 + 1] += rhs[i * 4 + 1];
-                result[i * 4 + 2] += rhs[i * 4 + 2];
-                result[i * 4 + 3] += rhs[i * 4 + 3];
-            }
+            add_assign_v1v1( result + begin * 4, rhs + begin * 4, nullptr, (end - begin) * 4 );
         }
     }
 }
 
-void add_assign( int dispatch, float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void add_assign( int dispatch, float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( rhs );
@@ -5,7 +5,9 @@
 
 #include "assign.hpp"
 #include "Dispatch.hpp"
+#include "ConditionMask.hpp"
 #include "Instruction.hpp"
+#include "simd.hpp"
 #include <reyes/assert.hpp>
 
 namespace reyes
@@ -58,7 +60,7 @@ void assign_u4u4( float* result, const float* rhs, unsigned int /*length*/ )
     result[3] = rhs[3];
 }
 
-void assign_v1u1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign_v1u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -69,9 +71,11 @@ void assign_v1u1( float* result, const float* rhs, const unsigned char* mask, un
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i] = rhs[0];
             }
@@ -79,7 +83,7 @@ void assign_v1u1( float* result, const float* rhs, const unsigned char* mask, un
     }
 }
 
-void assign_v2u1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign_v2u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -91,9 +95,11 @@ void assign_v2u1( float* result, const float* rhs, const unsigned char* mask, un
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 4 + 0] = rhs[0];
                 result[i * 4 + 1] = rhs[0];
@@ -102,7 +108,7 @@ void assign_v2u1( float* result, const float* rhs, const unsigned char* mask, un
     }
 }
 
-void assign_v3u1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign_v3u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -115,9 +121,11 @@ void assign_v3u1( float* result, const float* rhs, const unsigned char* mask, un
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 4 + 0] = rhs[0];
                 result[i * 4 + 1] = rhs[0];
@@ -127,7 +135,7 @@ void assign_v3u1( float* result, const float* rhs, const unsigned char* mask, un
     }
 }
 
-void assign_v4u1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign_v4u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -141,9 +149,11 @@ void assign_v4u1( float* result, const float* rhs, const unsigned char* mask, un
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 4 + 0] = rhs[0];
                 result[i * 4 + 1] = rhs[0];
@@ -154,7 +164,7 @@ void assign_v4u1( float* result, const float* rhs, const unsigned char* mask, un
     }
 }
 
-void assign_v2u2( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign_v2u2( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -166,9 +176,11 @@ void assign_v2u2( float* result, const float* rhs, const unsigned char* mask, un
     }
     else 
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 2 + 0] = rhs[0];
                 result[i * 2 + 1] = rhs[1];
@@ -177,7 +189,7 @@ void assign_v2u2( float* result, const float* rhs, const unsigned char* mask, un
     }
 }
 
-void assign_v3u3( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign_v3u3( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -190,9 +202,11 @@ void assign_v3u3( float* result, const float* rhs, const unsigned char* mask, un
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 3 + 0] = rhs[0];
                 result[i * 3 + 1] = rhs[1];
@@ -202,7 +216,7 @@ void assign_v3u3( float* result, const float* rhs, const unsigned char* mask, un
     }
 }
 
-void assign_v4u4( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign_v4u4( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -216,9 +230,11 @@ void assign_v4u4( float* result, const float* rhs, const unsigned char* mask, un
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 4 + 0] = rhs[0];
                 result[i * 4 + 1] = rhs[1];
@@ -229,28 +245,12 @@ void assign_v4u4( float* result, const float* rhs, const unsigned char* mask, un
     }
 }
 
-void assign_v1v1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign_v1v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
-    if ( !mask )
-    {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            result[i] = rhs[i];
-        }
-    }
-    else
-    {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            if ( mask[i] )
-            {
-                result[i] = rhs[i];
-            }
-        }
-    }
+    simd_kernels().assign( result, rhs, mask, length );
 }
 
-void assign_v2v1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign_v2v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -262,9 +262,11 @@ void assign_v2v1( float* result, const float* rhs, const unsigned char* mask, un
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 4 + 0] = rhs[i + 0];
                 result[i * 4 + 1] = rhs[i + 0];
@@ -273,7 +275,7 @@ void assign_v2v1( float* result, const float* rhs, const unsigned char* mask, un
     }
 }
 
-void assign_v3v1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign_v3v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -286,9 +288,11 @@ void assign_v3v1( float* result, const float* rhs, const unsigned char* mask, un
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 4 + 0] = rhs[i + 0];
                 result[i * 4 + 1] = rhs[i + 0];
@@ -298,7 +302,7 @@ void assign_v3v1( float* result, const float* rhs, const unsigned char* mask, un
     }
 }
 
-void assign_v4v1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign_v4v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -312,9 +316,11 @@ void assign_v4v1( float* result, const float* rhs, const unsigned char* mask, un
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 4 + 0] = rhs[i + 0];
                 result[i * 4 + 1] = rhs[i + 0];
@@ -325,82 +331,58 @@ void assign_v4v1( float* result, const float* rhs, const unsigned char* mask, un
     }
 }
 
-void assign_v2v2( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign_v2v2( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            result[i * 2 + 0] = rhs[i * 2 + 0];
-            result[i * 2 + 1] = rhs[i * 2 + 1];
-        }
+        assign_v1v1( result, rhs, nullptr, length * 2 );
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
-            {
-                result[i * 2 + 0] = rhs[i * 2 + 0];
-                result[i * 2 + 1] = rhs[i * 2 + 1];
-            }
+            assign_v1v1( result + begin * 2, rhs + begin * 2, nullptr, (end - begin) * 2 );
         }
     }
 }
 
-void assign_v3v3( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign_v3v3( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            result[i * 3 + 0] = rhs[i * 3 + 0];
-            result[i * 3 + 1] = rhs[i * 3 + 1];
-            result[i * 3 + 2] = rhs[i * 3 + 2];
-        }
+        assign_v1v1( result, rhs, nullptr, length * 3 );
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
-            {
-                result[i * 3 + 0] = rhs[i * 3 + 0];
-                result[i * 3 + 1] = rhs[i * 3 + 1];
-                result[i * 3 + 2] = rhs[i * 3 + 2];
-            }
+            assign_v1v1( result + begin * 3, rhs + begin * 3, nullptr, (end - begin) * 3 );
         }
     }
 }
 
-void assign_v4v4( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign_v4v4( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            result[i * 4 + 0] = rhs[i * 4 + 0];
-            result[i * 4 + 1] = rhs[i * 4 + 1];
-            result[i * 4 + 2] = rhs[i * 4 + 2];
-            result[i * 4 + 3] = rhs[i * 4 + 3];
-        }
+        assign_v1v1( result, rhs, nullptr, length * 4 );
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
-            {
-                result[i * 4 + 0] = rhs[i * 4 + 0];
-                result[i * 4 + 1] = rhs[i * 4 + 1];
-                result[i * 4 + 2] = rhs[i * 4 + 2];
-                result[i * 4 + 3] = rhs[i * 4 + 3];
-            }
+            assign_v1v1( result + begin * 4, rhs + begin * 4, nullptr, (end - begin) * 4 );
         }
     }
 }
 
-void assign_v16v16( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign_v16v16( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -414,9 +396,11 @@ void assign_v16v16( float* result, const float* rhs, const unsigned char* mask,
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 for ( unsigned int j = 0; j < 16; ++j )
                 {
@@ -427,7 +411,7 @@ void assign_v16v16( float* result, const float* rhs, const unsigned char* mask,
     }
 }
 
-void assign( int dispatch, float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void assign( int dispatch, float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( rhs );
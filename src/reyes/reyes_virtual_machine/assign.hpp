@@ -1,10 +1,35 @@
 #ifndef REYES_ASSIGN_HPP_INCLUDED
 #define REYES_ASSIGN_HPP_INCLUDED
 
+#include <stdint.h>
+
 namespace reyes
 {
 
-void assign( int dispatch, float* result, const float* rhs, const unsigned char* mask, unsigned int length );
+void assign( int dispatch, float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+
+void assign_u1u1( float* result, const float* rhs, unsigned int length );
+void assign_u2u1( float* result, const float* rhs, unsigned int length );
+void assign_u3u1( float* result, const float* rhs, unsigned int length );
+void assign_u4u1( float* result, const float* rhs, unsigned int length );
+void assign_u2u2( float* result, const float* rhs, unsigned int length );
+void assign_u3u3( float* result, const float* rhs, unsigned int length );
+void assign_u4u4( float* result, const float* rhs, unsigned int length );
+void assign_v1u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void assign_v2u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void assign_v3u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void assign_v4u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void assign_v2u2( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void assign_v3u3( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void assign_v4u4( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void assign_v1v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void assign_v2v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void assign_v3v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void assign_v4v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void assign_v2v2( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void assign_v3v3( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void assign_v4v4( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void assign_v16v16( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
 
 }
 
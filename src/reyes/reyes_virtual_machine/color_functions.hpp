@@ -10,9 +10,9 @@ class Grid;
 class Value;
 class Renderer;
 
-void comp( const Renderer& renderer, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> c, std::shared_ptr<Value> index );
-void setcomp( const Renderer& renderer, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> c, std::shared_ptr<Value> index, std::shared_ptr<Value> value );
-void ctransform_function( const Renderer& renderer, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> fromspace, std::shared_ptr<Value> color );
+void comp( const Renderer& renderer, const Grid& grid, Value* result, Value* c, Value* index );
+void setcomp( const Renderer& renderer, const Grid& grid, Value* result, Value* c, Value* index, Value* value );
+void ctransform_function( const Renderer& renderer, const Grid& grid, Value* result, Value* fromspace, Value* color );
 
 }
 
@@ -2,6 +2,7 @@
 #include "divide.hpp"
 #include "Dispatch.hpp"
 #include "Instruction.hpp"
+#include "simd.hpp"
 #include <reyes/assert.hpp>
 
 namespace reyes
@@ -111,10 +112,7 @@ void divide_v4u1( float* result, const float* lhs, const float* rhs, unsigned in
 
 void divide_v1v1( float* result, const float* lhs, const float* rhs, unsigned int length )
 {
-    for ( unsigned int i = 0; i < length; ++i )
-    {
-        result[i] = lhs[i] / rhs[i];
-    }
+    simd_kernels().divide( result, lhs, rhs, length );
 }
 
 void divide_v2v1( float* result, const float* lhs, const float* rhs, unsigned int length )
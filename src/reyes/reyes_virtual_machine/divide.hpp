@@ -6,6 +6,23 @@ namespace reyes
 
 void divide( int dispatch, float* result, const float* lhs, const float* rhs, unsigned int length );
 
+void divide_u1u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void divide_u2u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void divide_u3u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void divide_u4u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void divide_u1v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void divide_u2v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void divide_u3v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void divide_u4v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void divide_v1u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void divide_v2u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void divide_v3u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void divide_v4u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void divide_v1v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void divide_v2v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void divide_v3v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void divide_v4v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+
 }
 
 #endif
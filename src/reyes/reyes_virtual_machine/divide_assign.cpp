@@ -5,7 +5,9 @@
 
 #include "divide_assign.hpp"
 #include "Dispatch.hpp"
+#include "ConditionMask.hpp"
 #include "Instruction.hpp"
+#include "simd.hpp"
 #include <reyes/assert.hpp>
 
 namespace reyes
@@ -37,7 +39,7 @@ void divide_assign_u4u1( float* result, const float* rhs, unsigned int /*length*
     result[0 + 3] /= rhs[0];
 }
 
-void divide_assign_v1u1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void divide_assign_v1u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -48,9 +50,11 @@ void divide_assign_v1u1( float* result, const float* rhs, const unsigned char* m
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i] /= rhs[0];
             }
@@ -58,7 +62,7 @@ void divide_assign_v1u1( float* result, const float* rhs, const unsigned char* m
     }
 }
 
-void divide_assign_v2u1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void divide_assign_v2u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -70,9 +74,11 @@ void divide_assign_v2u1( float* result, const float* rhs, const unsigned char* m
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 2 + 0] /= rhs[0];
                 result[i * 2 + 1] /= rhs[0];
@@ -81,7 +87,7 @@ void divide_assign_v2u1( float* result, const float* rhs, const unsigned char* m
     }
 }
 
-void divide_assign_v3u1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void divide_assign_v3u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -94,9 +100,11 @@ void divide_assign_v3u1( float* result, const float* rhs, const unsigned char* m
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 3 + 0] /= rhs[0];
                 result[i * 3 + 1] /= rhs[0];
@@ -106,7 +114,7 @@ void divide_assign_v3u1( float* result, const float* rhs, const unsigned char* m
     }
 }
 
-void divide_assign_v4u1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void divide_assign_v4u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -120,9 +128,11 @@ void divide_assign_v4u1( float* result, const float* rhs, const unsigned char* m
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 4 + 0] /= rhs[0];
                 result[i * 4 + 1] /= rhs[0];
@@ -133,28 +143,12 @@ void divide_assign_v4u1( float* result, const float* rhs, const unsigned char* m
     }
 }
 
-void divide_assign_v1v1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void divide_assign_v1v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
-    if ( !mask )
-    {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            result[i] /= rhs[i];
-        }
-    }
-    else
-    {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            if ( mask[i] )
-            {
-                result[i] /= rhs[i];
-            }
-        }
-    }
+    simd_kernels().divide_assign( result, rhs, mask, length );
 }
 
-void divide_assign_v2v1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void divide_assign_v2v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -166,9 +160,11 @@ void divide_assign_v2v1( float* result, const float* rhs, const unsigned char* m
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 2 + 0] /= rhs[i];
                 result[i * 2 + 1] /= rhs[i];
@@ -177,7 +173,7 @@ void divide_assign_v2v1( float* result, const float* rhs, const unsigned char* m
     }
 }
 
-void divide_assign_v3v1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void divide_assign_v3v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -190,9 +186,11 @@ void divide_assign_v3v1( float* result, const float* rhs, const unsigned char* m
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 3 + 0] /= rhs[i];
                 result[i * 3 + 1] /= rhs[i];
@@ -202,7 +200,7 @@ void divide_assign_v3v1( float* result, const float* rhs, const unsigned char* m
     }
 }
 
-void divide_assign_v4v1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void divide_assign_v4v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -216,9 +214,11 @@ void divide_assign_v4v1( float* result, const float* rhs, const unsigned char* m
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 4 + 0] /= rhs[i];
                 result[i * 4 + 1] /= rhs[i];
@@ -229,7 +229,7 @@ void divide_assign_v4v1( float* result, const float* rhs, const unsigned char* m
     }
 }
 
-void divide_assign( int dispatch, float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void divide_assign( int dispatch, float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     switch ( dispatch )
     {
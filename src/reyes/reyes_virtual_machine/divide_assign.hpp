@@ -1,10 +1,25 @@
 #ifndef REYES_DIVIDE_ASSIGN_HPP_INCLUDED
 #define REYES_DIVIDE_ASSIGN_HPP_INCLUDED
 
+#include <stdint.h>
+
 namespace reyes
 {
     
-void divide_assign( int dispatch, float* result, const float* rhs, const unsigned char* mask, unsigned int length );
+void divide_assign( int dispatch, float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+
+void divide_assign_u1u1( float* result, const float* rhs, unsigned int length );
+void divide_assign_u2u1( float* result, const float* rhs, unsigned int length );
+void divide_assign_u3u1( float* result, const float* rhs, unsigned int length );
+void divide_assign_u4u1( float* result, const float* rhs, unsigned int length );
+void divide_assign_v1u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void divide_assign_v2u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void divide_assign_v3u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void divide_assign_v4u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void divide_assign_v1v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void divide_assign_v2v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void divide_assign_v3v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+void divide_assign_v4v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
 
 }
 
@@ -6,6 +6,7 @@
 #include "dot.hpp"
 #include "Dispatch.hpp"
 #include "Instruction.hpp"
+#include "simd.hpp"
 #include <reyes/assert.hpp>
 #include <math/vec3.ipp>
 
@@ -55,6 +56,51 @@ void dot_u3u3( float* result, const float* lhs, const float* rhs )
 	dot_v3v3( result, lhs, rhs, 1 );
 }
 
+/**
+// Calculate the dot products of vec3 values stored in planes (see 
+// Value::reset_planes()) passed as their x planes and the strides between
+// their planes.
+*/
+void dot_p3p3( float* result, const float* lhs, unsigned int lhs_stride, const float* rhs, unsigned int rhs_stride, unsigned int length )
+{
+    REYES_ASSERT( result );
+    REYES_ASSERT( lhs );
+    REYES_ASSERT( rhs );
+
+    simd_kernels().dot_planes( result, lhs, lhs_stride, rhs, rhs_stride, length );
+}
+
+void dot_p3v3( float* result, const float* lhs, unsigned int lhs_stride, const float* rhs, unsigned int length )
+{
+    REYES_ASSERT( result );
+    REYES_ASSERT( lhs );
+    REYES_ASSERT( rhs );
+
+    const float* lhs_y = lhs + lhs_stride;
+    const float* lhs_z = lhs + 2 * lhs_stride;
+    for ( unsigned int i = 0; i < length; ++i )
+    {
+        result[i] = lhs[i] * rhs[i * 3 + 0] + lhs_y[i] * rhs[i * 3 + 1] + lhs_z[i] * rhs[i * 3 + 2];
+    }
+}
+
+void dot_p3u3( float* result, const float* lhs, unsigned int lhs_stride, const float* rhs, unsigned int length )
+{
+    REYES_ASSERT( result );
+    REYES_ASSERT( lhs );
+    REYES_ASSERT( rhs );
+
+    const float x = rhs[0];
+    const float y = rhs[1];
+    const float z = rhs[2];
+    const float* lhs_y = lhs + lhs_stride;
+    const float* lhs_z = lhs + 2 * lhs_stride;
+    for ( unsigned int i = 0; i < length; ++i )
+    {
+        result[i] = lhs[i] * x + lhs_y[i] * y + lhs_z[i] * z;
+    }
+}
+
 void dot( int dispatch, float* result, const float* lhs, const float* rhs, unsigned int length )
 {
 	switch ( dispatch )
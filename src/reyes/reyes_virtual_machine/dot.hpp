@@ -6,6 +6,14 @@ namespace reyes
 	
 void dot( int dispatch, float* result, const float* lhs, const float* rhs, unsigned int length );
 
+void dot_v3v3( float* result, const float* lhs, const float* rhs, unsigned int length );
+void dot_u3v3( float* result, const float* lhs, const float* rhs, unsigned int length );
+void dot_v3u3( float* result, const float* lhs, const float* rhs, unsigned int length );
+void dot_u3u3( float* result, const float* lhs, const float* rhs );
+void dot_p3p3( float* result, const float* lhs, unsigned int lhs_stride, const float* rhs, unsigned int rhs_stride, unsigned int length );
+void dot_p3v3( float* result, const float* lhs, unsigned int lhs_stride, const float* rhs, unsigned int length );
+void dot_p3u3( float* result, const float* lhs, unsigned int lhs_stride, const float* rhs, unsigned int length );
+
 }
 
 #endif
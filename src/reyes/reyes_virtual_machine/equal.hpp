@@ -6,6 +6,23 @@ namespace reyes
 
 void equal( int dispatch, int* result, const float* lhs, const float* rhs, unsigned int length );
 
+void equal_u1u1( int* result, const float* lhs, const float* rhs, unsigned int length );
+void equal_u2u2( int* result, const float* lhs, const float* rhs, unsigned int length );
+void equal_u3u3( int* result, const float* lhs, const float* rhs, unsigned int length );
+void equal_u4u4( int* result, const float* lhs, const float* rhs, unsigned int length );
+void equal_u1v1( int* result, const float* lhs, const float* rhs, unsigned int length );
+void equal_u2v2( int* result, const float* lhs, const float* rhs, unsigned int length );
+void equal_u3v3( int* result, const float* lhs, const float* rhs, unsigned int length );
+void equal_u4v4( int* result, const float* lhs, const float* rhs, unsigned int length );
+void equal_v1u1( int* result, const float* lhs, const float* rhs, unsigned int length );
+void equal_v2u2( int* result, const float* lhs, const float* rhs, unsigned int length );
+void equal_v3u3( int* result, const float* lhs, const float* rhs, unsigned int length );
+void equal_v4u4( int* result, const float* lhs, const float* rhs, unsigned int length );
+void equal_v1v1( int* result, const float* lhs, const float* rhs, unsigned int length );
+void equal_v2v2( int* result, const float* lhs, const float* rhs, unsigned int length );
+void equal_v3v3( int* result, const float* lhs, const float* rhs, unsigned int length );
+void equal_v4v4( int* result, const float* lhs, const float* rhs, unsigned int length );
+
 }
 
 #endif
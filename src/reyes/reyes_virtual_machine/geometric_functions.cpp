@@ -22,13 +22,12 @@
 #include <math.h>
 
 using std::max;
-using std::shared_ptr;
 using namespace math;
 
 namespace reyes
 {
 
-void xcomp( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> p )
+void xcomp( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( p );
@@ -44,7 +43,7 @@ void xcomp( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<
     }
 }
 
-void ycomp( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> p )
+void ycomp( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( p );
@@ -60,7 +59,7 @@ void ycomp( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<
     }
 }
 
-void zcomp( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> p )
+void zcomp( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( p );
@@ -76,7 +75,7 @@ void zcomp( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<
     }
 }
 
-void setxcomp( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> p, std::shared_ptr<Value> x )
+void setxcomp( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* p, Value* x )
 {
     REYES_ASSERT( p );
     REYES_ASSERT( x );
@@ -91,7 +90,7 @@ void setxcomp( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_p
     }
 }
 
-void setycomp( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> p, std::shared_ptr<Value> y )
+void setycomp( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* p, Value* y )
 {
     REYES_ASSERT( p );
     REYES_ASSERT( y );
@@ -106,7 +105,7 @@ void setycomp( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_p
     }
 }
 
-void setzcomp( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> p, std::shared_ptr<Value> z )
+void setzcomp( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* p, Value* z )
 {
     REYES_ASSERT( p );
     REYES_ASSERT( z );
@@ -121,7 +120,7 @@ void setzcomp( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_p
     }
 }
 
-void length( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> x )
+void length( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* x )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( x );
@@ -137,7 +136,7 @@ void length( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr
     }
 }
 
-void normalize( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> n )
+void normalize( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* n )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( n );
@@ -166,7 +165,7 @@ void normalize( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_
     }    
 }
 
-void distance( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> p0, std::shared_ptr<Value> p1 )
+void distance( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* p0, Value* p1 )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( p0 );
@@ -185,7 +184,7 @@ void distance( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_p
     }
 }
 
-void rotate( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> q, std::shared_ptr<Value> angle, std::shared_ptr<Value> p0, std::shared_ptr<Value> p1 )
+void rotate( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* q, Value* angle, Value* p0, Value* p1 )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( q );
@@ -208,7 +207,7 @@ void rotate( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr
     }    
 }
 
-void area( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> p )
+void area( const Renderer& /*renderer*/, const Grid& grid, Value* result, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( p );
@@ -240,12 +239,12 @@ void area( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Value
     }
 }
 
-void faceforward_vv( const Renderer& renderer, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> n, std::shared_ptr<Value> i )
+void faceforward_vv( const Renderer& renderer, const Grid& grid, Value* result, Value* n, Value* i )
 {
     faceforward_vvv( renderer, grid, result, n, i, n );
 }
 
-void faceforward_vvv( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> n, std::shared_ptr<Value> i, std::shared_ptr<Value> nref )
+void faceforward_vvv( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* n, Value* i, Value* nref )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( n );
@@ -280,7 +279,7 @@ void faceforward_vvv( const Renderer& /*renderer*/, const Grid& /*grid*/, std::s
     }    
 }
 
-void reflect( const Renderer& /*render*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> i, std::shared_ptr<Value> n )
+void reflect( const Renderer& /*render*/, const Grid& /*grid*/, Value* result, Value* i, Value* n )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( i );
@@ -298,7 +297,7 @@ void reflect( const Renderer& /*render*/, const Grid& /*grid*/, std::shared_ptr<
     }
 }
 
-void refract( const Renderer& /*render*/, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> incident, std::shared_ptr<Value> normal, std::shared_ptr<Value> eta_value )
+void refract( const Renderer& /*render*/, const Grid& grid, Value* result, Value* incident, Value* normal, Value* eta_value )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( incident );
@@ -324,7 +323,7 @@ void refract( const Renderer& /*render*/, const Grid& grid, std::shared_ptr<Valu
     }
 }
 
-void fresnel( const Renderer& /*render*/, const Grid& grid, std::shared_ptr<Value> /*result*/, std::shared_ptr<Value> incident, std::shared_ptr<Value> normal, std::shared_ptr<Value> eta_value, std::shared_ptr<Value> Kr, std::shared_ptr<Value> Kt )
+void fresnel( const Renderer& /*render*/, const Grid& grid, Value* /*result*/, Value* incident, Value* normal, Value* eta_value, Value* Kr, Value* Kt )
 {
     REYES_ASSERT( incident );
     REYES_ASSERT( normal );
@@ -369,7 +368,7 @@ void fresnel( const Renderer& /*render*/, const Grid& grid, std::shared_ptr<Valu
     }
 }
 
-void transform_sv( const Renderer& renderer, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> tospace, std::shared_ptr<Value> p )
+void transform_sv( const Renderer& renderer, const Grid& /*grid*/, Value* result, Value* tospace, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( tospace );
@@ -389,7 +388,7 @@ void transform_sv( const Renderer& renderer, const Grid& /*grid*/, std::shared_p
     }
 }
 
-void transform_ssv( const Renderer& renderer, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> fromspace, std::shared_ptr<Value> tospace, std::shared_ptr<Value> p )
+void transform_ssv( const Renderer& renderer, const Grid& /*grid*/, Value* result, Value* fromspace, Value* tospace, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( fromspace );
@@ -411,7 +410,7 @@ void transform_ssv( const Renderer& renderer, const Grid& /*grid*/, std::shared_
     }
 }
 
-void transform_mv( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> m, std::shared_ptr<Value> p )
+void transform_mv( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* m, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( m );
@@ -428,7 +427,7 @@ void transform_mv( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shar
     );
 }
 
-void transform_smv( const Renderer& renderer, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> fromspace, std::shared_ptr<Value> m, std::shared_ptr<Value> p )
+void transform_smv( const Renderer& renderer, const Grid& /*grid*/, Value* result, Value* fromspace, Value* m, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( fromspace );
@@ -451,7 +450,7 @@ void transform_smv( const Renderer& renderer, const Grid& /*grid*/, std::shared_
     }
 }
 
-void vtransform_sv( const Renderer& renderer, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> tospace, std::shared_ptr<Value> p )
+void vtransform_sv( const Renderer& renderer, const Grid& /*grid*/, Value* result, Value* tospace, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( tospace );
@@ -467,7 +466,7 @@ void vtransform_sv( const Renderer& renderer, const Grid& /*grid*/, std::shared_
     );    
 }
 
-void vtransform_ssv( const Renderer& renderer, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> fromspace, std::shared_ptr<Value> tospace, std::shared_ptr<Value> p )
+void vtransform_ssv( const Renderer& renderer, const Grid& /*grid*/, Value* result, Value* fromspace, Value* tospace, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( fromspace );
@@ -485,7 +484,7 @@ void vtransform_ssv( const Renderer& renderer, const Grid& /*grid*/, std::shared
     );
 }
 
-void vtransform_mv( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> m, std::shared_ptr<Value> p )
+void vtransform_mv( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* m, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( m );
@@ -502,7 +501,7 @@ void vtransform_mv( const Renderer& /*renderer*/, const Grid& /*grid*/, std::sha
     );    
 }
 
-void vtransform_smv( const Renderer& renderer, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> fromspace, std::shared_ptr<Value> m, std::shared_ptr<Value> p )
+void vtransform_smv( const Renderer& renderer, const Grid& /*grid*/, Value* result, Value* fromspace, Value* m, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( fromspace );
@@ -521,7 +520,7 @@ void vtransform_smv( const Renderer& renderer, const Grid& /*grid*/, std::shared
     );    
 }
 
-void ntransform_sv( const Renderer& renderer, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> tospace, std::shared_ptr<Value> p )
+void ntransform_sv( const Renderer& renderer, const Grid& /*grid*/, Value* result, Value* tospace, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( tospace );
@@ -537,7 +536,7 @@ void ntransform_sv( const Renderer& renderer, const Grid& /*grid*/, std::shared_
     );
 }
 
-void ntransform_ssv( const Renderer& renderer, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> fromspace, std::shared_ptr<Value> tospace, std::shared_ptr<Value> p )
+void ntransform_ssv( const Renderer& renderer, const Grid& /*grid*/, Value* result, Value* fromspace, Value* tospace, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( fromspace );
@@ -555,7 +554,7 @@ void ntransform_ssv( const Renderer& renderer, const Grid& /*grid*/, std::shared
     );
 }
 
-void ntransform_mv( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> m, std::shared_ptr<Value> p )
+void ntransform_mv( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* m, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( m );
@@ -572,7 +571,7 @@ void ntransform_mv( const Renderer& /*renderer*/, const Grid& /*grid*/, std::sha
     );
 }
 
-void ntransform_smv( const Renderer& renderer, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> fromspace, std::shared_ptr<Value> m, std::shared_ptr<Value> p )
+void ntransform_smv( const Renderer& renderer, const Grid& /*grid*/, Value* result, Value* fromspace, Value* m, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( fromspace );
@@ -591,7 +590,7 @@ void ntransform_smv( const Renderer& renderer, const Grid& /*grid*/, std::shared
     );
 }
 
-void depth( const Renderer& renderer, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> p )
+void depth( const Renderer& renderer, const Grid& /*grid*/, Value* result, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( p );
@@ -607,22 +606,22 @@ void depth( const Renderer& renderer, const Grid& /*grid*/, std::shared_ptr<Valu
     }
 }
 
-void calculatenormal( const Renderer& renderer, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> p )
+void calculatenormal( const Renderer& renderer, const Grid& grid, Value* result, Value* p )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( p );
     
-    shared_ptr<Value> dpdu( new Value() );
-    du_vec3( renderer, grid, dpdu, p );
+    Value dpdu;
+    du_vec3( renderer, grid, &dpdu, p );
 
-    shared_ptr<Value> dpdv( new Value() );
-    dv_vec3( renderer, grid, dpdv, p );
+    Value dpdv;
+    dv_vec3( renderer, grid, &dpdv, p );
     
     result->reset( p->type(), p->storage(), p->size() );
     
     const int size = result->size();
-    const vec3* dpdu_values = dpdu->vec3_values();
-    const vec3* dpdv_values = dpdv->vec3_values();
+    const vec3* dpdu_values = dpdu.vec3_values();
+    const vec3* dpdv_values = dpdv.vec3_values();
     vec3* values = result->vec3_values();
     
     if ( renderer.attributes().geometry_left_handed() )
@@ -6,6 +6,7 @@
 #include "greater.hpp"
 #include "Dispatch.hpp"
 #include "Instruction.hpp"
+#include "simd.hpp"
 #include <reyes/assert.hpp>
 
 namespace reyes
@@ -34,10 +35,7 @@ void greater_v1u1( int* result, const float* lhs, const float* rhs, unsigned int
 
 void greater_v1v1( int* result, const float* lhs, const float* rhs, unsigned int length )
 {
-    for ( unsigned int i = 0; i < length; ++i )
-    {
-        result[i] = lhs[i] > rhs[i];
-    }
+    simd_kernels().greater( result, lhs, rhs, length );
 }
 
 void greater( int dispatch, int* result, const float* lhs, const float* rhs, unsigned int length )
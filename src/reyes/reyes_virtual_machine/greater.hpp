@@ -6,6 +6,11 @@ namespace reyes
 
 void greater( int dispatch, int* result, const float* lhs, const float* rhs, unsigned int length );
 
+void greater_u1u1( int* result, const float* lhs, const float* rhs, unsigned int length );
+void greater_u1v1( int* result, const float* lhs, const float* rhs, unsigned int length );
+void greater_v1u1( int* result, const float* lhs, const float* rhs, unsigned int length );
+void greater_v1v1( int* result, const float* lhs, const float* rhs, unsigned int length );
+
 }
 
 #endif
@@ -6,6 +6,7 @@
 #include "less.hpp"
 #include "Dispatch.hpp"
 #include "Instruction.hpp"
+#include "simd.hpp"
 #include <reyes/assert.hpp>
 
 namespace reyes
@@ -34,10 +35,7 @@ void less_v1u1( int* result, const float* lhs, const float* rhs, unsigned int le
 
 void less_v1v1( int* result, const float* lhs, const float* rhs, unsigned int length )
 {
-    for ( unsigned int i = 0; i < length; ++i )
-    {
-        result[i] = lhs[i] < rhs[i];
-    }
+    simd_kernels().less( result, lhs, rhs, length );
 }
 
 void less( int dispatch, int* result, const float* lhs, const float* rhs, unsigned int length )
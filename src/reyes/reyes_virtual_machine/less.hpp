@@ -6,6 +6,11 @@ namespace reyes
 
 void less( int dispatch, int* result, const float* lhs, const float* rhs, unsigned int length );
 
+void less_u1u1( int* result, const float* lhs, const float* rhs, unsigned int length );
+void less_u1v1( int* result, const float* lhs, const float* rhs, unsigned int length );
+void less_v1u1( int* result, const float* lhs, const float* rhs, unsigned int length );
+void less_v1v1( int* result, const float* lhs, const float* rhs, unsigned int length );
+
 }
 
 #endif
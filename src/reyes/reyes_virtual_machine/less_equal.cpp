@@ -6,6 +6,7 @@
 #include "less_equal.hpp"
 #include "Dispatch.hpp"
 #include "Instruction.hpp"
+#include "simd.hpp"
 #include <reyes/assert.hpp>
 
 namespace reyes
@@ -34,10 +35,7 @@ void less_equal_v1u1( int* result, const float* lhs, const float* rhs, unsigned
 
 void less_equal_v1v1( int* result, const float* lhs, const float* rhs, unsigned int length )
 {
-    for ( unsigned int i = 0; i < length; ++i )
-    {
-        result[i] = lhs[i] <= rhs[i];
-    }
+    simd_kernels().less_equal( result, lhs, rhs, length );
 }
 
 void less_equal( int dispatch, int* result, const float* lhs, const float* rhs, unsigned int length )
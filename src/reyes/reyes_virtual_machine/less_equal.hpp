@@ -6,6 +6,11 @@ namespace reyes
 
 void less_equal( int dispatch, int* result, const float* lhs, const float* rhs, unsigned int length );
 
+void less_equal_u1u1( int* result, const float* lhs, const float* rhs, unsigned int length );
+void less_equal_u1v1( int* result, const float* lhs, const float* rhs, unsigned int length );
+void less_equal_v1u1( int* result, const float* lhs, const float* rhs, unsigned int length );
+void less_equal_v1v1( int* result, const float* lhs, const float* rhs, unsigned int length );
+
 }
 
 #endif
@@ -6,6 +6,11 @@ namespace reyes
 
 void logical_and( int dispatch, int* result, const int* lhs, const int* rhs, unsigned int length );
 
+void logical_and_u1u1( int* result, const int* lhs, const int* rhs, unsigned int length );
+void logical_and_u1v1( int* result, const int* lhs, const int* rhs, unsigned int length );
+void logical_and_v1u1( int* result, const int* lhs, const int* rhs, unsigned int length );
+void logical_and_v1v1( int* result, const int* lhs, const int* rhs, unsigned int length );
+
 }
 
 #endif
@@ -17,7 +17,7 @@ using namespace math;
 namespace reyes
 {
 
-void radians( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> degrees )
+void radians( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* degrees )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( degrees );
@@ -33,7 +33,7 @@ void radians( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_pt
     }
 }
 
-void degrees( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> radians )
+void degrees( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* radians )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( radians );
@@ -49,7 +49,7 @@ void degrees( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_pt
     }
 }
 
-void sin( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> a )
+void sin( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* a )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( a );
@@ -65,7 +65,7 @@ void sin( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Va
     }
 }
 
-void asin( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> a )
+void asin( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* a )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( a );
@@ -81,7 +81,7 @@ void asin( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<V
     }
 }
 
-void cos( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> a )
+void cos( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* a )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( a );
@@ -97,7 +97,7 @@ void cos( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Va
     }
 }
 
-void acos( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> a )
+void acos( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* a )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( a );
@@ -113,7 +113,7 @@ void acos( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<V
     }
 }
 
-void tan( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> a )
+void tan( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* a )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( a );
@@ -129,7 +129,7 @@ void tan( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Va
     }
 }
 
-void atan( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> yoverx )
+void atan( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* yoverx )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( yoverx );
@@ -145,7 +145,7 @@ void atan( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<V
     }
 }
 
-void atan2( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> y, std::shared_ptr<Value> x )
+void atan2( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* y, Value* x )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( y );
@@ -164,7 +164,7 @@ void atan2( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<
     }
 }
 
-void pow( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> x, std::shared_ptr<Value> y )
+void pow( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* x, Value* y )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( x );
@@ -183,7 +183,7 @@ void pow( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Va
     }
 }
 
-void exp( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> x )
+void exp( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* x )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( x );
@@ -199,7 +199,7 @@ void exp( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Va
     }
 }
 
-void sqrt( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> x )
+void sqrt( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* x )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( x );
@@ -215,7 +215,7 @@ void sqrt( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<V
     }
 }
 
-void inversesqrt( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> x )
+void inversesqrt( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* x )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( x );
@@ -231,7 +231,7 @@ void inversesqrt( const Renderer& /*renderer*/, const Grid& /*grid*/, std::share
     }
 }
 
-void log( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> x )
+void log( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* x )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( x );
@@ -247,7 +247,7 @@ void log( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Va
     }
 }
 
-void logb( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> x, std::shared_ptr<Value> base )
+void logb( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* x, Value* base )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( x );
@@ -266,7 +266,7 @@ void logb( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<V
     }
 }
 
-void mod( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> a, std::shared_ptr<Value> b )
+void mod( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* a, Value* b )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( a );
@@ -285,7 +285,7 @@ void mod( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Va
     }
 }
 
-void abs( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> x )
+void abs( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* x )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( x );
@@ -301,7 +301,7 @@ void abs( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Va
     }
 }
 
-void sign( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> x )
+void sign( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* x )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( x );
@@ -317,7 +317,7 @@ void sign( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<V
     }
 }
 
-void mix_float( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> x, std::shared_ptr<Value> y, std::shared_ptr<Value> alpha )
+void mix_float( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* x, Value* y, Value* alpha )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( x );
@@ -337,7 +337,7 @@ void mix_float( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_
     }
 }
 
-void mix_vec3( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> x, std::shared_ptr<Value> y, std::shared_ptr<Value> alpha )
+void mix_vec3( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* x, Value* y, Value* alpha )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( x );
@@ -359,7 +359,7 @@ void mix_vec3( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_p
     }
 }
 
-void floor( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> x )
+void floor( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* x )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( x );
@@ -375,7 +375,7 @@ void floor( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<
     }
 }
 
-void ceil( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> x )
+void ceil( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* x )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( x );
@@ -391,7 +391,7 @@ void ceil( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<V
     }
 }
 
-void round( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> x )
+void round( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* x )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( x );
@@ -407,7 +407,7 @@ void round( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<
     }
 }
 
-void step( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> min, std::shared_ptr<Value> x )
+void step( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* min, Value* x )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( min );
@@ -425,7 +425,7 @@ void step( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<V
     }
 }
 
-void smoothstep( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> min, std::shared_ptr<Value> max, std::shared_ptr<Value> x )
+void smoothstep( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* min, Value* max, Value* x )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( min );
@@ -446,7 +446,7 @@ void smoothstep( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared
     }
 }
 
-void du_float( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> p )
+void du_float( const Renderer& /*renderer*/, const Grid& grid, Value* result, Value* p )
 {
     REYES_ASSERT( p );
     REYES_ASSERT( p->type() >= TYPE_COLOR && p->type() <= TYPE_NORMAL );
@@ -481,7 +481,7 @@ void du_float( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<V
     }
 }
 
-void du_vec3( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> p )
+void du_vec3( const Renderer& /*renderer*/, const Grid& grid, Value* result, Value* p )
 {
     REYES_ASSERT( p );
     REYES_ASSERT( p->type() >= TYPE_COLOR && p->type() <= TYPE_NORMAL );
@@ -516,7 +516,7 @@ void du_vec3( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Va
     }
 }
 
-void dv_float( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> p )
+void dv_float( const Renderer& /*renderer*/, const Grid& grid, Value* result, Value* p )
 {
     REYES_ASSERT( p );
     REYES_ASSERT( p->type() >= TYPE_COLOR && p->type() <= TYPE_NORMAL );
@@ -556,7 +556,7 @@ void dv_float( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<V
     }                            
 }
 
-void dv_vec3( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> p )
+void dv_vec3( const Renderer& /*renderer*/, const Grid& grid, Value* result, Value* p )
 {
     REYES_ASSERT( p );
     REYES_ASSERT( p->type() >= TYPE_COLOR && p->type() <= TYPE_NORMAL );
@@ -596,7 +596,7 @@ void dv_vec3( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Va
     }                            
 }
 
-void deriv_float( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> y, std::shared_ptr<Value> x )
+void deriv_float( const Renderer& /*renderer*/, const Grid& grid, Value* result, Value* y, Value* x )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( y );
@@ -659,7 +659,7 @@ void deriv_float( const Renderer& /*renderer*/, const Grid& grid, std::shared_pt
     }                            
 }
 
-void deriv_vec3( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> y, std::shared_ptr<Value> x )
+void deriv_vec3( const Renderer& /*renderer*/, const Grid& grid, Value* result, Value* y, Value* x )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( y );
@@ -722,14 +722,14 @@ void deriv_vec3( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr
     }                            
 }
 
-void uniform_float_random( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result )
+void uniform_float_random( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result )
 {
     REYES_ASSERT( result );
     result->reset( TYPE_FLOAT, STORAGE_UNIFORM, 1 );
     result->float_values()[0] = (float(rand()) / (RAND_MAX / 2) - 1.0f);
 }
 
-void uniform_vec3_random( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result )
+void uniform_vec3_random( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result )
 {
     REYES_ASSERT( result );
     result->reset( TYPE_POINT, STORAGE_UNIFORM, 1 );
@@ -740,7 +740,7 @@ void uniform_vec3_random( const Renderer& /*renderer*/, const Grid& /*grid*/, st
     );
 }
 
-void float_random( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Value> result )
+void float_random( const Renderer& /*renderer*/, const Grid& grid, Value* result )
 {
     REYES_ASSERT( result );
     
@@ -753,7 +753,7 @@ void float_random( const Renderer& /*renderer*/, const Grid& grid, std::shared_p
     }    
 }
 
-void vec3_random( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Value> result )
+void vec3_random( const Renderer& /*renderer*/, const Grid& grid, Value* result )
 {
     REYES_ASSERT( result );
 
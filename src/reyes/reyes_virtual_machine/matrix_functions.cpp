@@ -13,7 +13,7 @@ using namespace math;
 namespace reyes
 {
 
-void comp_matrix( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> matrix, std::shared_ptr<Value> row_value, std::shared_ptr<Value> column_value )
+void comp_matrix( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* matrix, Value* row_value, Value* column_value )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( matrix );
@@ -32,7 +32,7 @@ void comp_matrix( const Renderer& /*renderer*/, const Grid& /*grid*/, std::share
     values[0] = m.m[row * 4 + column];
 }
 
-void setcomp_matrix( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> /*result*/, std::shared_ptr<Value> matrix, std::shared_ptr<Value> row_value, std::shared_ptr<Value> column_value, std::shared_ptr<Value> value )
+void setcomp_matrix( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* /*result*/, Value* matrix, Value* row_value, Value* column_value, Value* value )
 {
     REYES_ASSERT( matrix );
     REYES_ASSERT( matrix->storage() == STORAGE_UNIFORM );
@@ -49,7 +49,7 @@ void setcomp_matrix( const Renderer& /*renderer*/, const Grid& /*grid*/, std::sh
     values[0].m[row * 4 + column] = value->float_value();
 }
 
-void determinant( const Renderer& /*render*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> matrix )
+void determinant( const Renderer& /*render*/, const Grid& /*grid*/, Value* result, Value* matrix )
 {
     REYES_ASSERT( matrix );
     REYES_ASSERT( matrix->storage() == STORAGE_UNIFORM );
@@ -60,7 +60,7 @@ void determinant( const Renderer& /*render*/, const Grid& /*grid*/, std::shared_
     values[0] = math::determinant( m );
 }
 
-void translate_matrix( const Renderer& /*render*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> matrix, std::shared_ptr<Value> t )
+void translate_matrix( const Renderer& /*render*/, const Grid& /*grid*/, Value* result, Value* matrix, Value* t )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( matrix );
@@ -74,7 +74,7 @@ void translate_matrix( const Renderer& /*render*/, const Grid& /*grid*/, std::sh
     values[0] = m * math::translate( t->vec3_value() );
 }
 
-void rotate_matrix( const Renderer& /*render*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> matrix, std::shared_ptr<Value> angle, std::shared_ptr<Value> axis )
+void rotate_matrix( const Renderer& /*render*/, const Grid& /*grid*/, Value* result, Value* matrix, Value* angle, Value* axis )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( matrix );
@@ -90,7 +90,7 @@ void rotate_matrix( const Renderer& /*render*/, const Grid& /*grid*/, std::share
     values[0] = m * math::rotate( axis->vec3_value(), angle->float_value() );
 }
 
-void scale_matrix( const Renderer& /*render*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> matrix, std::shared_ptr<Value> s )
+void scale_matrix( const Renderer& /*render*/, const Grid& /*grid*/, Value* result, Value* matrix, Value* s )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( matrix );
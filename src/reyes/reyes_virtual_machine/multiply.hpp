@@ -6,6 +6,35 @@ namespace reyes
 
 void multiply( int dispatch, float* result, const float* lhs, const float* rhs, unsigned int length );
 
+void multiply_u1u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_u2u2( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_u3u3( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_u4u4( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_u1v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_u2v2( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_u3v3( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_u4v4( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_v1u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_v2u2( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_v3u3( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_v4u4( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_v1v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_v2v2( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_v3v3( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_v4v4( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_u2u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_u3u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_u4u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_u2v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_u3v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_u4v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_v2u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_v3u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_v4u1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_v2v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_v3v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+void multiply_v4v1( float* result, const float* lhs, const float* rhs, unsigned int length );
+
 }
 
 #endif
@@ -5,7 +5,9 @@
 
 #include "multiply_assign.hpp"
 #include "Dispatch.hpp"
+#include "ConditionMask.hpp"
 #include "Instruction.hpp"
+#include "simd.hpp"
 #include <reyes/assert.hpp>
 
 namespace reyes
@@ -58,7 +60,7 @@ void multiply_assign_u4u4( float* result, const float* rhs, unsigned int /*lengt
     result[0 + 3] *= rhs[0 + 3];
 }
 
-void multiply_assign_v1u1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void multiply_assign_v1u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -69,9 +71,11 @@ void multiply_assign_v1u1( float* result, const float* rhs, const unsigned char*
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i] *= rhs[0];
             }
@@ -79,7 +83,7 @@ void multiply_assign_v1u1( float* result, const float* rhs, const unsigned char*
     }
 }
 
-void multiply_assign_v2u1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void multiply_assign_v2u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -91,9 +95,11 @@ void multiply_assign_v2u1( float* result, const float* rhs, const unsigned char*
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 2 + 0] *= rhs[0];
                 result[i * 2 + 1] *= rhs[0];
@@ -102,7 +108,7 @@ void multiply_assign_v2u1( float* result, const float* rhs, const unsigned char*
     }
 }
 
-void multiply_assign_v3u1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void multiply_assign_v3u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -115,9 +121,11 @@ void multiply_assign_v3u1( float* result, const float* rhs, const unsigned char*
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 3 + 0] *= rhs[0];
                 result[i * 3 + 1] *= rhs[0];
@@ -127,7 +135,7 @@ void multiply_assign_v3u1( float* result, const float* rhs, const unsigned char*
     }
 }
 
-void multiply_assign_v4u1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void multiply_assign_v4u1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -141,9 +149,11 @@ void multiply_assign_v4u1( float* result, const float* rhs, const unsigned char*
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 4 + 0] *= rhs[0];
                 result[i * 4 + 1] *= rhs[0];
@@ -154,28 +164,12 @@ void multiply_assign_v4u1( float* result, const float* rhs, const unsigned char*
     }
 }
 
-void multiply_assign_v1v1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void multiply_assign_v1v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
-    if ( !mask )
-    {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            result[i] *= rhs[i];
-        }
-    }
-    else
-    {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            if ( mask[i] )
-            {
-                result[i] *= rhs[i];
-            }
-        }
-    }
+    simd_kernels().multiply_assign( result, rhs, mask, length );
 }
 
-void multiply_assign_v2v1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void multiply_assign_v2v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -187,9 +181,11 @@ void multiply_assign_v2v1( float* result, const float* rhs, const unsigned char*
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 2 + 0] *= rhs[i];
                 result[i * 2 + 1] *= rhs[i];
@@ -198,7 +194,7 @@ void multiply_assign_v2v1( float* result, const float* rhs, const unsigned char*
     }
 }
 
-void multiply_assign_v3v1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void multiply_assign_v3v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -211,9 +207,11 @@ void multiply_assign_v3v1( float* result, const float* rhs, const unsigned char*
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 3 + 0] *= rhs[i];
                 result[i * 3 + 1] *= rhs[i];
@@ -223,7 +221,7 @@ void multiply_assign_v3v1( float* result, const float* rhs, const unsigned char*
     }
 }
 
-void multiply_assign_v4v1( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void multiply_assign_v4v1( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -237,9 +235,11 @@ void multiply_assign_v4v1( float* result, const float* rhs, const unsigned char*
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 4 + 0] *= rhs[i];
                 result[i * 4 + 1] *= rhs[i];
@@ -250,7 +250,7 @@ void multiply_assign_v4v1( float* result, const float* rhs, const unsigned char*
     }
 }
 
-void multiply_assign_v2u2( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void multiply_assign_v2u2( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -262,9 +262,11 @@ void multiply_assign_v2u2( float* result, const float* rhs, const unsigned char*
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 2 + 0] *= rhs[0 + 0];
                 result[i * 2 + 1] *= rhs[0 + 1];
@@ -273,7 +275,7 @@ void multiply_assign_v2u2( float* result, const float* rhs, const unsigned char*
     }
 }
 
-void multiply_assign_v3u3( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void multiply_assign_v3u3( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -286,9 +288,11 @@ void multiply_assign_v3u3( float* result, const float* rhs, const unsigned char*
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 3 + 0] *= rhs[0 + 0];
                 result[i * 3 + 1] *= rhs[0 + 1];
@@ -298,7 +302,7 @@ void multiply_assign_v3u3( float* result, const float* rhs, const unsigned char*
     }
 }
 
-void multiply_assign_v4u4( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void multiply_assign_v4u4( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
@@ -312,9 +316,11 @@ void multiply_assign_v4u4( float* result, const float* rhs, const unsigned char*
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
+            for ( unsigned int i = begin; i < end; ++i )
             {
                 result[i * 4 + 0] *= rhs[0 + 0];
                 result[i * 4 + 1] *= rhs[0 + 1];
@@ -325,82 +331,58 @@ void multiply_assign_v4u4( float* result, const float* rhs, const unsigned char*
     }
 }
 
-void multiply_assign_v2v2( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void multiply_assign_v2v2( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            result[i * 2 + 0] *= rhs[i * 2 + 0];
-            result[i * 2 + 1] *= rhs[i * 2 + 1];
-        }
+        multiply_assign_v1v1( result, rhs, nullptr, length * 2 );
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
-            {
-                result[i * 2 + 0] *= rhs[i * 2 + 0];
-                result[i * 2 + 1] *= rhs[i * 2 + 1];
-            }
+            multiply_assign_v1v1( result + begin * 2, rhs + begin * 2, nullptr, (end - begin) * 2 );
         }
     }
 }
 
-void multiply_assign_v3v3( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void multiply_assign_v3v3( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            result[i * 3 + 0] *= rhs[i * 3 + 0];
-            result[i * 3 + 1] *= rhs[i * 3 + 1];
-            result[i * 3 + 2] *= rhs[i * 3 + 2];
-        }
+        multiply_assign_v1v1( result, rhs, nullptr, length * 3 );
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
-            {
-                result[i * 3 + 0] *= rhs[i * 3 + 0];
-                result[i * 3 + 1] *= rhs[i * 3 + 1];
-                result[i * 3 + 2] *= rhs[i * 3 + 2];
-            }
+            multiply_assign_v1v1( result + begin * 3, rhs + begin * 3, nullptr, (end - begin) * 3 );
         }
     }
 }
 
-void multiply_assign_v4v4( float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void multiply_assign_v4v4( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     if ( !mask )
     {
-        for ( unsigned int i = 0; i < length; ++i )
-        {
-            result[i * 4 + 0] *= rhs[i * 4 + 0];
-            result[i * 4 + 1] *= rhs[i * 4 + 1];
-            result[i * 4 + 2] *= rhs[i * 4 + 2];
-            result[i * 4 + 3] *= rhs[i * 4 + 3];
-        }
+        multiply_assign_v1v1( result, rhs, nullptr, length * 4 );
     }
     else
     {
-        for ( unsigned int i = 0; i < length; ++i )
+        unsigned int begin = 0;
+        unsigned int end = 0;
+        while ( next_active_range(mask, length, &begin, &end) )
         {
-            if ( mask[i] )
-            {
-                result[i * 4 + 0] *= rhs[i * 4 + 0];
-                result[i * 4 + 1] *= rhs[i * 4 + 1];
-                result[i * 4 + 2] *= rhs[i * 4 + 2];
-                result[i * 4 + 3] *= rhs[i * 4 + 3];
-            }
+            multiply_assign_v1v1( result + begin * 4, rhs + begin * 4, nullptr, (end - begin) * 4 );
         }
     }
 }
 
-void multiply_assign( int dispatch, float* result, const float* rhs, const unsigned char* mask, unsigned int length )
+void multiply_assign( int dispatch, float* result, const float* rhs, const uint64_t* mask, unsigned int length )
 {
     switch ( dispatch )
     {
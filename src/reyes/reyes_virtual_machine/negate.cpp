@@ -47,32 +47,17 @@ void negate_v1( float* result, const float* rhs, unsigned int length )
 
 void negate_v2( float* result, const float* rhs, unsigned int length )
 {
-    for ( unsigned int i = 0; i < length; ++i )
-    {
-        result[i * 2 + 0] = -rhs[i * 2 + 0];
-        result[i * 2 + 1] = -rhs[i * 2 + 1];
-    }
+    negate_v1( result, rhs, length * 2 );
 }
 
 void negate_v3( float* result, const float* rhs, unsigned int length )
 {
-    for ( unsigned int i = 0; i < length; ++i )
-    {
-        result[i * 3 + 0] = -rhs[i * 3 + 0];
-        result[i * 3 + 1] = -rhs[i * 3 + 1];
-        result[i * 3 + 2] = -rhs[i * 3 + 2];
-    }
+    negate_v1( result, rhs, length * 3 );
 }
 
 void negate_v4( float* result, const float* rhs, unsigned int length )
 {
-    for ( unsigned int i = 0; i < length; ++i )
-    {
-        result[i * 4 + 0] = -rhs[i * 4 + 0];
-        result[i * 4 + 1] = -rhs[i * 4 + 1];
-        result[i * 4 + 2] = -rhs[i * 4 + 2];
-        result[i * 4 + 3] = -rhs[i * 4 + 3];
-    }
+    negate_v1( result, rhs, length * 4 );
 }
 
 void negate( unsigned int dispatch, float* result, const float* rhs, unsigned int length )
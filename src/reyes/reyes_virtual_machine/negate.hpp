@@ -6,6 +6,15 @@ namespace reyes
 
 void negate( unsigned int dispatch, float* result, const float* rhs, unsigned int length );
 
+void negate_u1( float* result, const float* rhs, unsigned int length );
+void negate_u2( float* result, const float* rhs, unsigned int length );
+void negate_u3( float* result, const float* rhs, unsigned int length );
+void negate_u4( float* result, const float* rhs, unsigned int length );
+void negate_v1( float* result, const float* rhs, unsigned int length );
+void negate_v2( float* result, const float* rhs, unsigned int length );
+void negate_v3( float* result, const float* rhs, unsigned int length );
+void negate_v4( float* result, const float* rhs, unsigned int length );
+
 }
 
 #endif
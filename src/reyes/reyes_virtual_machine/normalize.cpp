@@ -0,0 +1,50 @@
+//
+// normalize.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "normalize.hpp"
+#include "simd.hpp"
+#include <reyes/assert.hpp>
+
+namespace reyes
+{
+
+/**
+// Normalize vec3 values stored in planes (see Value::reset_planes()) into 
+// planes.
+//
+// Zero length values are copied unchanged just as the normalize() built-in
+// function does.  The result may be the same planes as \e rhs.
+*/
+void normalize_p3p3( float* result, unsigned int result_stride, const float* rhs, unsigned int rhs_stride, unsigned int length )
+{
+    REYES_ASSERT( result );
+    REYES_ASSERT( rhs );
+
+    simd_kernels().normalize_planes( result, result_stride, rhs, rhs_stride, length );
+}
+
+/**
+// Normalize interleaved vec3 values into planes.
+//
+// The values are split into the result's planes first and then normalized 
+// in place a plane at a time.
+*/
+void normalize_p3v3( float* result, unsigned int result_stride, const float* rhs, unsigned int length )
+{
+    REYES_ASSERT( result );
+    REYES_ASSERT( rhs );
+
+    float* result_y = result + result_stride;
+    float* result_z = result + 2 * result_stride;
+    for ( unsigned int i = 0; i < length; ++i )
+    {
+        result[i] = rhs[i * 3 + 0];
+        result_y[i] = rhs[i * 3 + 1];
+        result_z[i] = rhs[i * 3 + 2];
+    }
+    normalize_p3p3( result, result_stride, result, result_stride, length );
+}
+
+}
@@ -0,0 +1,12 @@
+#ifndef REYES_NORMALIZE_HPP_INCLUDED
+#define REYES_NORMALIZE_HPP_INCLUDED
+
+namespace reyes
+{
+
+void normalize_p3p3( float* result, unsigned int result_stride, const float* rhs, unsigned int rhs_stride, unsigned int length );
+void normalize_p3v3( float* result, unsigned int result_stride, const float* rhs, unsigned int length );
+
+}
+
+#endif
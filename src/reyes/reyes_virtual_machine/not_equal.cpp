@@ -6,6 +6,7 @@
 #include "not_equal.hpp"
 #include "Dispatch.hpp"
 #include "Instruction.hpp"
+#include "simd.hpp"
 #include <reyes/assert.hpp>
 
 namespace reyes
@@ -115,10 +116,7 @@ void not_equal_v4u4( int* result, const float* lhs, const float* rhs, unsigned i
 
 void not_equal_v1v1( int* result, const float* lhs, const float* rhs, unsigned int length )
 {
-    for ( unsigned int i = 0; i < length; ++i )
-    {
-        result[i] = lhs[i] != rhs[i];
-    }
+    simd_kernels().not_equal( result, lhs, rhs, length );
 }
 
 void not_equal_v2v2( int* result, const float* lhs, const float* rhs, unsigned int length )
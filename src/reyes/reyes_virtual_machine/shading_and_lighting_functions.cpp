@@ -24,7 +24,7 @@ using namespace math;
 namespace reyes
 {
 
-void ambient( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Value> color )
+void ambient( const Renderer& /*renderer*/, const Grid& grid, Value* color )
 {
     REYES_ASSERT( color );
     
@@ -52,7 +52,7 @@ void ambient( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Va
     }
 }
 
-void diffuse( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Value> color, std::shared_ptr<Value> normal )
+void diffuse( const Renderer& /*renderer*/, const Grid& grid, Value* color, Value* normal )
 {
     REYES_ASSERT( color );
     REYES_ASSERT( normal );
@@ -61,7 +61,7 @@ void diffuse( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Va
     color->reset( TYPE_COLOR, STORAGE_VARYING, grid.size() );
     color->zero();
 
-    std::shared_ptr<Value> P = grid.find_value( "P" );
+    const Value* P = grid.find_value( GRID_SLOT_P ).get();
     REYES_ASSERT( P );
     REYES_ASSERT( P->type() == TYPE_POINT );
     REYES_ASSERT( P->storage() == STORAGE_VARYING );
@@ -162,7 +162,7 @@ void diffuse( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Va
     }    
 }
 
-void specular( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Value> color, std::shared_ptr<Value> normal, std::shared_ptr<Value> view, std::shared_ptr<Value> roughness_value )
+void specular( const Renderer& /*renderer*/, const Grid& grid, Value* color, Value* normal, Value* view, Value* roughness_value )
 {
     REYES_ASSERT( color );
     REYES_ASSERT( normal );
@@ -172,7 +172,7 @@ void specular( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<V
     color->reset( TYPE_COLOR, STORAGE_VARYING, grid.size() );
     color->zero();
     
-    std::shared_ptr<Value> P = grid.find_value( "P" );
+    const Value* P = grid.find_value( GRID_SLOT_P ).get();
     REYES_ASSERT( P );
     REYES_ASSERT( P->type() == TYPE_POINT );
     REYES_ASSERT( P->storage() == STORAGE_VARYING );
@@ -277,7 +277,7 @@ void specular( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<V
     }
 }
 
-void specularbrdf( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shared_ptr<Value> result, std::shared_ptr<Value> l, std::shared_ptr<Value> n, std::shared_ptr<Value> v, std::shared_ptr<Value> roughness_value )
+void specularbrdf( const Renderer& /*renderer*/, const Grid& /*grid*/, Value* result, Value* l, Value* n, Value* v, Value* roughness_value )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( l );
@@ -303,7 +303,7 @@ void specularbrdf( const Renderer& /*renderer*/, const Grid& /*grid*/, std::shar
     }
 }
 
-void phong( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> normal, std::shared_ptr<Value> view, std::shared_ptr<Value> power_value )
+void phong( const Renderer& /*renderer*/, const Grid& grid, Value* result, Value* normal, Value* view, Value* power_value )
 {
     REYES_ASSERT( result );
     REYES_ASSERT( normal );
@@ -313,7 +313,7 @@ void phong( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Valu
     result->reset( TYPE_COLOR, STORAGE_VARYING, grid.size() );
     result->zero();
     
-    std::shared_ptr<Value> P = grid.find_value( "P" );
+    const Value* P = grid.find_value( GRID_SLOT_P ).get();
     REYES_ASSERT( P );
     REYES_ASSERT( P->type() == TYPE_POINT );
     REYES_ASSERT( P->storage() == STORAGE_VARYING );
@@ -418,7 +418,7 @@ void phong( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Valu
     }
 }
 
-void trace( const Renderer& /*renderer*/, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> /*point*/, std::shared_ptr<Value> /*reflection*/ )
+void trace( const Renderer& /*renderer*/, const Grid& grid, Value* result, Value* /*point*/, Value* /*reflection*/ )
 {
     REYES_ASSERT( result );
     result->reset( TYPE_COLOR, STORAGE_VARYING, grid.size() );
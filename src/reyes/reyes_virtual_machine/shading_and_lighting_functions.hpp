@@ -10,12 +10,12 @@ class Grid;
 class Value;
 class Renderer;
 
-void ambient( const Renderer& renderer, const Grid& grid, std::shared_ptr<Value> result );
-void diffuse( const Renderer& renderer, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> n );
-void specular( const Renderer& renderer, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> n, std::shared_ptr<Value> v, std::shared_ptr<Value> roughness );
-void specularbrdf( const Renderer& renderer, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> l, std::shared_ptr<Value> n, std::shared_ptr<Value> v, std::shared_ptr<Value> roughness );
-void phong( const Renderer& renderer, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> normal, std::shared_ptr<Value> view, std::shared_ptr<Value> size_value );
-void trace( const Renderer& renderer, const Grid& grid, std::shared_ptr<Value> result, std::shared_ptr<Value> point, std::shared_ptr<Value> reflection );
+void ambient( const Renderer& renderer, const Grid& grid, Value* result );
+void diffuse( const Renderer& renderer, const Grid& grid, Value* result, Value* n );
+void specular( const Renderer& renderer, const Grid& grid, Value* result, Value* n, Value* v, Value* roughness );
+void specularbrdf( const Renderer& renderer, const Grid& grid, Value* result, Value* l, Value* n, Value* v, Value* roughness );
+void phong( const Renderer& renderer, const Grid& grid, Value* result, Value* normal, Value* view, Value* size_value );
+void trace( const Renderer& renderer, const Grid& grid, Value* result, Value* point, Value* reflection );
 
 }
 
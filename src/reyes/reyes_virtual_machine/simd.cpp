@@ -0,0 +1,342 @@
+//
+// simd.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "simd.hpp"
+#include "ConditionMask.hpp"
+#include <reyes/assert.hpp>
+#include <math.h>
+
+#if defined(REYES_SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace reyes
+{
+
+static void add_scalar( float* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    for ( unsigned int i = 0; i < length; ++i )
+    {
+        result[i] = lhs[i] + rhs[i];
+    }
+}
+
+static void subtract_scalar( float* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    for ( unsigned int i = 0; i < length; ++i )
+    {
+        result[i] = lhs[i] - rhs[i];
+    }
+}
+
+static void multiply_scalar( float* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    for ( unsigned int i = 0; i < length; ++i )
+    {
+        result[i] = lhs[i] * rhs[i];
+    }
+}
+
+static void divide_scalar( float* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    for ( unsigned int i = 0; i < length; ++i )
+    {
+        result[i] = lhs[i] / rhs[i];
+    }
+}
+
+static void assign_scalar( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
+{
+    if ( !mask )
+    {
+        for ( unsigned int i = 0; i < length; ++i )
+        {
+            result[i] = rhs[i];
+        }
+    }
+    else
+    {
+        for ( unsigned int i = 0; i < length; ++i )
+        {
+            if ( (mask[i / MASK_WORD_BITS] >> (i % MASK_WORD_BITS)) & 1 )
+            {
+                result[i] = rhs[i];
+            }
+        }
+    }
+}
+
+static void add_assign_scalar( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
+{
+    if ( !mask )
+    {
+        for ( unsigned int i = 0; i < length; ++i )
+        {
+            result[i] += rhs[i];
+        }
+    }
+    else
+    {
+        for ( unsigned int i = 0; i < length; ++i )
+        {
+            if ( (mask[i / MASK_WORD_BITS] >> (i % MASK_WORD_BITS)) & 1 )
+            {
+                result[i] += rhs[i];
+            }
+        }
+    }
+}
+
+static void subtract_assign_scalar( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
+{
+    if ( !mask )
+    {
+        for ( unsigned int i = 0; i < length; ++i )
+        {
+            result[i] -= rhs[i];
+        }
+    }
+    else
+    {
+        for ( unsigned int i = 0; i < length; ++i )
+        {
+            if ( (mask[i / MASK_WORD_BITS] >> (i % MASK_WORD_BITS)) & 1 )
+            {
+                result[i] -= rhs[i];
+            }
+        }
+    }
+}
+
+static void multiply_assign_scalar( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
+{
+    if ( !mask )
+    {
+        for ( unsigned int i = 0; i < length; ++i )
+        {
+            result[i] *= rhs[i];
+        }
+    }
+    else
+    {
+        for ( unsigned int i = 0; i < length; ++i )
+        {
+            if ( (mask[i / MASK_WORD_BITS] >> (i % MASK_WORD_BITS)) & 1 )
+            {
+                result[i] *= rhs[i];
+            }
+        }
+    }
+}
+
+static void divide_assign_scalar( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
+{
+    if ( !mask )
+    {
+        for ( unsigned int i = 0; i < length; ++i )
+        {
+            result[i] /= rhs[i];
+        }
+    }
+    else
+    {
+        for ( unsigned int i = 0; i < length; ++i )
+        {
+            if ( (mask[i / MASK_WORD_BITS] >> (i % MASK_WORD_BITS)) & 1 )
+            {
+                result[i] /= rhs[i];
+            }
+        }
+    }
+}
+
+static void equal_scalar( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    for ( unsigned int i = 0; i < length; ++i )
+    {
+        result[i] = lhs[i] == rhs[i];
+    }
+}
+
+static void not_equal_scalar( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    for ( unsigned int i = 0; i < length; ++i )
+    {
+        result[i] = lhs[i] != rhs[i];
+    }
+}
+
+static void less_scalar( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    for ( unsigned int i = 0; i < length; ++i )
+    {
+        result[i] = lhs[i] < rhs[i];
+    }
+}
+
+static void less_equal_scalar( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    for ( unsigned int i = 0; i < length; ++i )
+    {
+        result[i] = lhs[i] <= rhs[i];
+    }
+}
+
+static void greater_scalar( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    for ( unsigned int i = 0; i < length; ++i )
+    {
+        result[i] = lhs[i] > rhs[i];
+    }
+}
+
+static void greater_equal_scalar( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    for ( unsigned int i = 0; i < length; ++i )
+    {
+        result[i] = lhs[i] >= rhs[i];
+    }
+}
+
+static void dot_planes_scalar( float* result, const float* lhs, unsigned int lhs_stride, const float* rhs, unsigned int rhs_stride, unsigned int length )
+{
+    const float* lhs_y = lhs + lhs_stride;
+    const float* lhs_z = lhs + 2 * lhs_stride;
+    const float* rhs_y = rhs + rhs_stride;
+    const float* rhs_z = rhs + 2 * rhs_stride;
+    for ( unsigned int i = 0; i < length; ++i )
+    {
+        result[i] = lhs[i] * rhs[i] + lhs_y[i] * rhs_y[i] + lhs_z[i] * rhs_z[i];
+    }
+}
+
+static void normalize_planes_scalar( float* result, unsigned int result_stride, const float* rhs, unsigned int rhs_stride, unsigned int length )
+{
+    float* result_y = result + result_stride;
+    float* result_z = result + 2 * result_stride;
+    const float* rhs_y = rhs + rhs_stride;
+    const float* rhs_z = rhs + 2 * rhs_stride;
+    for ( unsigned int i = 0; i < length; ++i )
+    {
+        const float x = rhs[i];
+        const float y = rhs_y[i];
+        const float z = rhs_z[i];
+        const float norm = sqrtf( x * x + y * y + z * z );
+        result[i] = norm > 0.0f ? x / norm : x;
+        result_y[i] = norm > 0.0f ? y / norm : y;
+        result_z[i] = norm > 0.0f ? z / norm : z;
+    }
+}
+
+static const SimdKernels SCALAR_KERNELS =
+{
+    SIMD_SCALAR,
+    &add_scalar,
+    &subtract_scalar,
+    &multiply_scalar,
+    &divide_scalar,
+    &assign_scalar,
+    &add_assign_scalar,
+    &subtract_assign_scalar,
+    &multiply_assign_scalar,
+    &divide_assign_scalar,
+    &equal_scalar,
+    &not_equal_scalar,
+    &less_scalar,
+    &less_equal_scalar,
+    &greater_scalar,
+    &greater_equal_scalar,
+    &dot_planes_scalar,
+    &normalize_planes_scalar
+};
+
+/**
+// Detect the widest instruction set that both the CPU and the operating
+// system support.
+//
+// @return
+//  The best SimdLevel that kernels can be run with on this machine.
+*/
+SimdLevel simd_cpu_level()
+{
+#if defined(REYES_SIMD_X86) && defined(_MSC_VER)
+    int info[4] = { 0, 0, 0, 0 };
+    __cpuid( info, 0 );
+    const int maximum_leaf = info[0];
+
+    __cpuid( info, 1 );
+    const bool sse4 = (info[2] & (1 << 19)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    bool avx2 = false;
+    if ( maximum_leaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6 )
+    {
+        __cpuidex( info, 7, 0 );
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    return avx2 ? SIMD_AVX2 : sse4 ? SIMD_SSE4 : SIMD_SCALAR;
+#elif defined(REYES_SIMD_X86) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports("avx2") )
+    {
+        return SIMD_AVX2;
+    }
+    if ( __builtin_cpu_supports("sse4.1") )
+    {
+        return SIMD_SSE4;
+    }
+    return SIMD_SCALAR;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+/**
+// Get the kernels for the best instruction set supported by this machine.
+//
+// The table is selected the first time this function is called and the
+// same table is returned from then on.
+*/
+const SimdKernels& simd_kernels()
+{
+    static const SimdKernels& kernels = simd_kernels( simd_cpu_level() );
+    return kernels;
+}
+
+/**
+// Get the kernels for a specific instruction set.
+//
+// Falls back to the next narrowest instruction set if kernels for
+// \e level weren't compiled into this build.
+*/
+const SimdKernels& simd_kernels( SimdLevel level )
+{
+    const SimdKernels* kernels = nullptr;
+    switch ( level )
+    {
+        case SIMD_AVX2:
+            kernels = simd_avx2_kernels();
+            if ( kernels )
+            {
+                break;
+            }
+            // fall through
+
+        case SIMD_SSE4:
+            kernels = simd_sse4_kernels();
+            break;
+
+        case SIMD_SCALAR:
+            break;
+
+        default:
+            REYES_ASSERT( false );
+            break;
+    }
+    return kernels ? *kernels : SCALAR_KERNELS;
+}
+
+}
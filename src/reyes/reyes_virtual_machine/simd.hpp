@@ -0,0 +1,75 @@
+#ifndef REYES_SIMD_HPP_INCLUDED
+#define REYES_SIMD_HPP_INCLUDED
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define REYES_SIMD_X86
+#endif
+
+#include <stdint.h>
+
+namespace reyes
+{
+
+/**
+// Instruction set used by the vectorized kernels.
+*/
+enum SimdLevel
+{
+    SIMD_SCALAR, ///< Plain C++ loops, always available.
+    SIMD_SSE4, ///< SSE4.1 four wide kernels.
+    SIMD_AVX2 ///< AVX2 eight wide kernels.
+};
+
+/**
+// Kernels that process a single contiguous plane of floats.
+//
+// The varying kernels in the virtual machine's arithmetic library forward
+// to these once interleaved values have been flattened to a plane (see
+// add_v3v3() and friends).  Each table is filled by one instruction set and
+// the table for the best instruction set supported by the CPU is selected
+// once at startup by simd_kernels().
+//
+// Masked kernels take the bits of a ConditionMask and only write elements
+// whose bit is set, a null mask writes every element.
+//
+// Plane kernels take vec3 values stored in planes (see 
+// Value::reset_planes()) as a pointer to their x plane and the stride, in
+// floats, from one plane to the next.
+*/
+struct SimdKernels
+{
+    typedef void (*BinaryFunction)( float* result, const float* lhs, const float* rhs, unsigned int length );
+    typedef void (*AssignFunction)( float* result, const float* rhs, const uint64_t* mask, unsigned int length );
+    typedef void (*CompareFunction)( int* result, const float* lhs, const float* rhs, unsigned int length );
+    typedef void (*DotFunction)( float* result, const float* lhs, unsigned int lhs_stride, const float* rhs, unsigned int rhs_stride, unsigned int length );
+    typedef void (*NormalizeFunction)( float* result, unsigned int result_stride, const float* rhs, unsigned int rhs_stride, unsigned int length );
+
+    SimdLevel level; ///< The instruction set these kernels are implemented with.
+    BinaryFunction add;
+    BinaryFunction subtract;
+    BinaryFunction multiply;
+    BinaryFunction divide;
+    AssignFunction assign;
+    AssignFunction add_assign;
+    AssignFunction subtract_assign;
+    AssignFunction multiply_assign;
+    AssignFunction divide_assign;
+    CompareFunction equal;
+    CompareFunction not_equal;
+    CompareFunction less;
+    CompareFunction less_equal;
+    CompareFunction greater;
+    CompareFunction greater_equal;
+    DotFunction dot_planes;
+    NormalizeFunction normalize_planes;
+};
+
+SimdLevel simd_cpu_level();
+const SimdKernels& simd_kernels();
+const SimdKernels& simd_kernels( SimdLevel level );
+const SimdKernels* simd_sse4_kernels();
+const SimdKernels* simd_avx2_kernels();
+
+}
+
+#endif
@@ -0,0 +1,430 @@
+//
+// simd_avx2.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "simd.hpp"
+#include "ConditionMask.hpp"
+
+#if defined(REYES_SIMD_X86)
+
+#include <immintrin.h>
+#include <algorithm>
+
+#if defined(__GNUC__)
+#define REYES_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define REYES_TARGET_AVX2
+#endif
+
+using std::min;
+
+namespace reyes
+{
+
+/**
+// Expand the low 8 bits of a condition mask word into a lane mask with
+// all bits set in each lane whose bit is set.
+*/
+static REYES_TARGET_AVX2 __m256 lane_mask( uint64_t bits )
+{
+    const __m256i lanes = _mm256_setr_epi32( 1, 2, 4, 8, 16, 32, 64, 128 );
+    const __m256i selected = _mm256_and_si256( _mm256_set1_epi32(int(bits & 0xff)), lanes );
+    return _mm256_castsi256_ps( _mm256_cmpeq_epi32(selected, lanes) );
+}
+
+static REYES_TARGET_AVX2 void add_avx2( float* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    unsigned int i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+    {
+        _mm256_storeu_ps( result + i, _mm256_add_ps(_mm256_loadu_ps(lhs + i), _mm256_loadu_ps(rhs + i)) );
+    }
+    simd_kernels( SIMD_SCALAR ).add( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_AVX2 void subtract_avx2( float* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    unsigned int i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+    {
+        _mm256_storeu_ps( result + i, _mm256_sub_ps(_mm256_loadu_ps(lhs + i), _mm256_loadu_ps(rhs + i)) );
+    }
+    simd_kernels( SIMD_SCALAR ).subtract( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_AVX2 void multiply_avx2( float* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    unsigned int i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+    {
+        _mm256_storeu_ps( result + i, _mm256_mul_ps(_mm256_loadu_ps(lhs + i), _mm256_loadu_ps(rhs + i)) );
+    }
+    simd_kernels( SIMD_SCALAR ).multiply( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_AVX2 void divide_avx2( float* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    unsigned int i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+    {
+        _mm256_storeu_ps( result + i, _mm256_div_ps(_mm256_loadu_ps(lhs + i), _mm256_loadu_ps(rhs + i)) );
+    }
+    simd_kernels( SIMD_SCALAR ).divide( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_AVX2 void assign_avx2( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
+{
+    if ( !mask )
+    {
+        unsigned int i = 0;
+        for ( ; i + 8 <= length; i += 8 )
+        {
+            _mm256_storeu_ps( result + i, _mm256_loadu_ps(rhs + i) );
+        }
+        simd_kernels( SIMD_SCALAR ).assign( result + i, rhs + i, nullptr, length - i );
+    }
+    else
+    {
+        for ( unsigned int begin = 0; begin < length; begin += MASK_WORD_BITS )
+        {
+            const uint64_t bits = mask[begin / MASK_WORD_BITS];
+            const unsigned int end = min( begin + MASK_WORD_BITS, length );
+            if ( bits == ~uint64_t(0) )
+            {
+                assign_avx2( result + begin, rhs + begin, nullptr, end - begin );
+            }
+            else if ( bits != 0 )
+            {
+                unsigned int i = begin;
+                for ( ; i + 8 <= end; i += 8 )
+                {
+                    const __m256 values = _mm256_loadu_ps( result + i );
+                    const __m256 results = _mm256_loadu_ps( rhs + i );
+                    _mm256_storeu_ps( result + i, _mm256_blendv_ps(values, results, lane_mask(bits >> (i - begin))) );
+                }
+                for ( ; i < end; ++i )
+                {
+                    if ( (bits >> (i - begin)) & 1 )
+                    {
+                        result[i] = rhs[i];
+                    }
+                }
+            }
+        }
+    }
+}
+
+static REYES_TARGET_AVX2 void add_assign_avx2( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
+{
+    if ( !mask )
+    {
+        unsigned int i = 0;
+        for ( ; i + 8 <= length; i += 8 )
+        {
+            _mm256_storeu_ps( result + i, _mm256_add_ps(_mm256_loadu_ps(result + i), _mm256_loadu_ps(rhs + i)) );
+        }
+        simd_kernels( SIMD_SCALAR ).add_assign( result + i, rhs + i, nullptr, length - i );
+    }
+    else
+    {
+        for ( unsigned int begin = 0; begin < length; begin += MASK_WORD_BITS )
+        {
+            const uint64_t bits = mask[begin / MASK_WORD_BITS];
+            const unsigned int end = min( begin + MASK_WORD_BITS, length );
+            if ( bits == ~uint64_t(0) )
+            {
+                add_assign_avx2( result + begin, rhs + begin, nullptr, end - begin );
+            }
+            else if ( bits != 0 )
+            {
+                unsigned int i = begin;
+                for ( ; i + 8 <= end; i += 8 )
+                {
+                    const __m256 values = _mm256_loadu_ps( result + i );
+                    const __m256 results = _mm256_add_ps( values, _mm256_loadu_ps(rhs + i) );
+                    _mm256_storeu_ps( result + i, _mm256_blendv_ps(values, results, lane_mask(bits >> (i - begin))) );
+                }
+                for ( ; i < end; ++i )
+                {
+                    if ( (bits >> (i - begin)) & 1 )
+                    {
+                        result[i] += rhs[i];
+                    }
+                }
+            }
+        }
+    }
+}
+
+static REYES_TARGET_AVX2 void subtract_assign_avx2( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
+{
+    if ( !mask )
+    {
+        unsigned int i = 0;
+        for ( ; i + 8 <= length; i += 8 )
+        {
+            _mm256_storeu_ps( result + i, _mm256_sub_ps(_mm256_loadu_ps(result + i), _mm256_loadu_ps(rhs + i)) );
+        }
+        simd_kernels( SIMD_SCALAR ).subtract_assign( result + i, rhs + i, nullptr, length - i );
+    }
+    else
+    {
+        for ( unsigned int begin = 0; begin < length; begin += MASK_WORD_BITS )
+        {
+            const uint64_t bits = mask[begin / MASK_WORD_BITS];
+            const unsigned int end = min( begin + MASK_WORD_BITS, length );
+            if ( bits == ~uint64_t(0) )
+            {
+                subtract_assign_avx2( result + begin, rhs + begin, nullptr, end - begin );
+            }
+            else if ( bits != 0 )
+            {
+                unsigned int i = begin;
+                for ( ; i + 8 <= end; i += 8 )
+                {
+                    const __m256 values = _mm256_loadu_ps( result + i );
+                    const __m256 results = _mm256_sub_ps( values, _mm256_loadu_ps(rhs + i) );
+                    _mm256_storeu_ps( result + i, _mm256_blendv_ps(values, results, lane_mask(bits >> (i - begin))) );
+                }
+                for ( ; i < end; ++i )
+                {
+                    if ( (bits >> (i - begin)) & 1 )
+                    {
+                        result[i] -= rhs[i];
+                    }
+                }
+            }
+        }
+    }
+}
+
+static REYES_TARGET_AVX2 void multiply_assign_avx2( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
+{
+    if ( !mask )
+    {
+        unsigned int i = 0;
+        for ( ; i + 8 <= length; i += 8 )
+        {
+            _mm256_storeu_ps( result + i, _mm256_mul_ps(_mm256_loadu_ps(result + i), _mm256_loadu_ps(rhs + i)) );
+        }
+        simd_kernels( SIMD_SCALAR ).multiply_assign( result + i, rhs + i, nullptr, length - i );
+    }
+    else
+    {
+        for ( unsigned int begin = 0; begin < length; begin += MASK_WORD_BITS )
+        {
+            const uint64_t bits = mask[begin / MASK_WORD_BITS];
+            const unsigned int end = min( begin + MASK_WORD_BITS, length );
+            if ( bits == ~uint64_t(0) )
+            {
+                multiply_assign_avx2( result + begin, rhs + begin, nullptr, end - begin );
+            }
+            else if ( bits != 0 )
+            {
+                unsigned int i = begin;
+                for ( ; i + 8 <= end; i += 8 )
+                {
+                    const __m256 values = _mm256_loadu_ps( result + i );
+                    const __m256 results = _mm256_mul_ps( values, _mm256_loadu_ps(rhs + i) );
+                    _mm256_storeu_ps( result + i, _mm256_blendv_ps(values, results, lane_mask(bits >> (i - begin))) );
+                }
+                for ( ; i < end; ++i )
+                {
+                    if ( (bits >> (i - begin)) & 1 )
+                    {
+                        result[i] *= rhs[i];
+                    }
+                }
+            }
+        }
+    }
+}
+
+static REYES_TARGET_AVX2 void divide_assign_avx2( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
+{
+    if ( !mask )
+    {
+        unsigned int i = 0;
+        for ( ; i + 8 <= length; i += 8 )
+        {
+            _mm256_storeu_ps( result + i, _mm256_div_ps(_mm256_loadu_ps(result + i), _mm256_loadu_ps(rhs + i)) );
+        }
+        simd_kernels( SIMD_SCALAR ).divide_assign( result + i, rhs + i, nullptr, length - i );
+    }
+    else
+    {
+        for ( unsigned int begin = 0; begin < length; begin += MASK_WORD_BITS )
+        {
+            const uint64_t bits = mask[begin / MASK_WORD_BITS];
+            const unsigned int end = min( begin + MASK_WORD_BITS, length );
+            if ( bits == ~uint64_t(0) )
+            {
+                divide_assign_avx2( result + begin, rhs + begin, nullptr, end - begin );
+            }
+            else if ( bits != 0 )
+            {
+                unsigned int i = begin;
+                for ( ; i + 8 <= end; i += 8 )
+                {
+                    const __m256 values = _mm256_loadu_ps( result + i );
+                    const __m256 results = _mm256_div_ps( values, _mm256_loadu_ps(rhs + i) );
+                    _mm256_storeu_ps( result + i, _mm256_blendv_ps(values, results, lane_mask(bits >> (i - begin))) );
+                }
+                for ( ; i < end; ++i )
+                {
+                    if ( (bits >> (i - begin)) & 1 )
+                    {
+                        result[i] /= rhs[i];
+                    }
+                }
+            }
+        }
+    }
+}
+
+static REYES_TARGET_AVX2 void equal_avx2( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    const __m256i one = _mm256_set1_epi32( 1 );
+    unsigned int i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+    {
+        const __m256 lanes = _mm256_cmp_ps( _mm256_loadu_ps(lhs + i), _mm256_loadu_ps(rhs + i), _CMP_EQ_OQ );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>(result + i), _mm256_and_si256(_mm256_castps_si256(lanes), one) );
+    }
+    simd_kernels( SIMD_SCALAR ).equal( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_AVX2 void not_equal_avx2( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    const __m256i one = _mm256_set1_epi32( 1 );
+    unsigned int i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+    {
+        const __m256 lanes = _mm256_cmp_ps( _mm256_loadu_ps(lhs + i), _mm256_loadu_ps(rhs + i), _CMP_NEQ_UQ );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>(result + i), _mm256_and_si256(_mm256_castps_si256(lanes), one) );
+    }
+    simd_kernels( SIMD_SCALAR ).not_equal( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_AVX2 void less_avx2( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    const __m256i one = _mm256_set1_epi32( 1 );
+    unsigned int i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+    {
+        const __m256 lanes = _mm256_cmp_ps( _mm256_loadu_ps(lhs + i), _mm256_loadu_ps(rhs + i), _CMP_LT_OQ );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>(result + i), _mm256_and_si256(_mm256_castps_si256(lanes), one) );
+    }
+    simd_kernels( SIMD_SCALAR ).less( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_AVX2 void less_equal_avx2( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    const __m256i one = _mm256_set1_epi32( 1 );
+    unsigned int i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+    {
+        const __m256 lanes = _mm256_cmp_ps( _mm256_loadu_ps(lhs + i), _mm256_loadu_ps(rhs + i), _CMP_LE_OQ );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>(result + i), _mm256_and_si256(_mm256_castps_si256(lanes), one) );
+    }
+    simd_kernels( SIMD_SCALAR ).less_equal( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_AVX2 void greater_avx2( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    const __m256i one = _mm256_set1_epi32( 1 );
+    unsigned int i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+    {
+        const __m256 lanes = _mm256_cmp_ps( _mm256_loadu_ps(lhs + i), _mm256_loadu_ps(rhs + i), _CMP_GT_OQ );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>(result + i), _mm256_and_si256(_mm256_castps_si256(lanes), one) );
+    }
+    simd_kernels( SIMD_SCALAR ).greater( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_AVX2 void greater_equal_avx2( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    const __m256i one = _mm256_set1_epi32( 1 );
+    unsigned int i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+    {
+        const __m256 lanes = _mm256_cmp_ps( _mm256_loadu_ps(lhs + i), _mm256_loadu_ps(rhs + i), _CMP_GE_OQ );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>(result + i), _mm256_and_si256(_mm256_castps_si256(lanes), one) );
+    }
+    simd_kernels( SIMD_SCALAR ).greater_equal( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_AVX2 void dot_planes_avx2( float* result, const float* lhs, unsigned int lhs_stride, const float* rhs, unsigned int rhs_stride, unsigned int length )
+{
+    unsigned int i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+    {
+        const __m256 x = _mm256_mul_ps( _mm256_loadu_ps(lhs + i), _mm256_loadu_ps(rhs + i) );
+        const __m256 y = _mm256_mul_ps( _mm256_loadu_ps(lhs + lhs_stride + i), _mm256_loadu_ps(rhs + rhs_stride + i) );
+        const __m256 z = _mm256_mul_ps( _mm256_loadu_ps(lhs + 2 * lhs_stride + i), _mm256_loadu_ps(rhs + 2 * rhs_stride + i) );
+        _mm256_storeu_ps( result + i, _mm256_add_ps(_mm256_add_ps(x, y), z) );
+    }
+    simd_kernels( SIMD_SCALAR ).dot_planes( result + i, lhs + i, lhs_stride, rhs + i, rhs_stride, length - i );
+}
+
+static REYES_TARGET_AVX2 void normalize_planes_avx2( float* result, unsigned int result_stride, const float* rhs, unsigned int rhs_stride, unsigned int length )
+{
+    const __m256 zero = _mm256_setzero_ps();
+    unsigned int i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+    {
+        const __m256 x = _mm256_loadu_ps( rhs + i );
+        const __m256 y = _mm256_loadu_ps( rhs + rhs_stride + i );
+        const __m256 z = _mm256_loadu_ps( rhs + 2 * rhs_stride + i );
+        const __m256 norm = _mm256_sqrt_ps( _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)) );
+        const __m256 nonzero = _mm256_cmp_ps( norm, zero, _CMP_GT_OQ );
+        _mm256_storeu_ps( result + i, _mm256_blendv_ps(x, _mm256_div_ps(x, norm), nonzero) );
+        _mm256_storeu_ps( result + result_stride + i, _mm256_blendv_ps(y, _mm256_div_ps(y, norm), nonzero) );
+        _mm256_storeu_ps( result + 2 * result_stride + i, _mm256_blendv_ps(z, _mm256_div_ps(z, norm), nonzero) );
+    }
+    simd_kernels( SIMD_SCALAR ).normalize_planes( result + i, result_stride, rhs + i, rhs_stride, length - i );
+}
+
+static const SimdKernels AVX2_KERNELS =
+{
+    SIMD_AVX2,
+    &add_avx2,
+    &subtract_avx2,
+    &multiply_avx2,
+    &divide_avx2,
+    &assign_avx2,
+    &add_assign_avx2,
+    &subtract_assign_avx2,
+    &multiply_assign_avx2,
+    &divide_assign_avx2,
+    &equal_avx2,
+    &not_equal_avx2,
+    &less_avx2,
+    &less_equal_avx2,
+    &greater_avx2,
+    &greater_equal_avx2,
+    &dot_planes_avx2,
+    &normalize_planes_avx2
+};
+
+const SimdKernels* simd_avx2_kernels()
+{
+    return &AVX2_KERNELS;
+}
+
+}
+
+#else
+
+namespace reyes
+{
+
+const SimdKernels* simd_avx2_kernels()
+{
+    return nullptr;
+}
+
+}
+
+#endif
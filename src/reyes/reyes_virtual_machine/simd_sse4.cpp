@@ -0,0 +1,430 @@
+//
+// simd_sse4.cpp
+// Copyright (c) Charles Baker. All rights reserved.
+//
+
+#include "simd.hpp"
+#include "ConditionMask.hpp"
+
+#if defined(REYES_SIMD_X86)
+
+#include <immintrin.h>
+#include <algorithm>
+
+#if defined(__GNUC__)
+#define REYES_TARGET_SSE4 __attribute__((target("sse4.1")))
+#else
+#define REYES_TARGET_SSE4
+#endif
+
+using std::min;
+
+namespace reyes
+{
+
+/**
+// Expand the low 4 bits of a condition mask word into a lane mask with
+// all bits set in each lane whose bit is set.
+*/
+static REYES_TARGET_SSE4 __m128 lane_mask( uint64_t bits )
+{
+    const __m128i lanes = _mm_setr_epi32( 1, 2, 4, 8 );
+    const __m128i selected = _mm_and_si128( _mm_set1_epi32(int(bits & 0xf)), lanes );
+    return _mm_castsi128_ps( _mm_cmpeq_epi32(selected, lanes) );
+}
+
+static REYES_TARGET_SSE4 void add_sse4( float* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    unsigned int i = 0;
+    for ( ; i + 4 <= length; i += 4 )
+    {
+        _mm_storeu_ps( result + i, _mm_add_ps(_mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i)) );
+    }
+    simd_kernels( SIMD_SCALAR ).add( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_SSE4 void subtract_sse4( float* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    unsigned int i = 0;
+    for ( ; i + 4 <= length; i += 4 )
+    {
+        _mm_storeu_ps( result + i, _mm_sub_ps(_mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i)) );
+    }
+    simd_kernels( SIMD_SCALAR ).subtract( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_SSE4 void multiply_sse4( float* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    unsigned int i = 0;
+    for ( ; i + 4 <= length; i += 4 )
+    {
+        _mm_storeu_ps( result + i, _mm_mul_ps(_mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i)) );
+    }
+    simd_kernels( SIMD_SCALAR ).multiply( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_SSE4 void divide_sse4( float* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    unsigned int i = 0;
+    for ( ; i + 4 <= length; i += 4 )
+    {
+        _mm_storeu_ps( result + i, _mm_div_ps(_mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i)) );
+    }
+    simd_kernels( SIMD_SCALAR ).divide( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_SSE4 void assign_sse4( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
+{
+    if ( !mask )
+    {
+        unsigned int i = 0;
+        for ( ; i + 4 <= length; i += 4 )
+        {
+            _mm_storeu_ps( result + i, _mm_loadu_ps(rhs + i) );
+        }
+        simd_kernels( SIMD_SCALAR ).assign( result + i, rhs + i, nullptr, length - i );
+    }
+    else
+    {
+        for ( unsigned int begin = 0; begin < length; begin += MASK_WORD_BITS )
+        {
+            const uint64_t bits = mask[begin / MASK_WORD_BITS];
+            const unsigned int end = min( begin + MASK_WORD_BITS, length );
+            if ( bits == ~uint64_t(0) )
+            {
+                assign_sse4( result + begin, rhs + begin, nullptr, end - begin );
+            }
+            else if ( bits != 0 )
+            {
+                unsigned int i = begin;
+                for ( ; i + 4 <= end; i += 4 )
+                {
+                    const __m128 values = _mm_loadu_ps( result + i );
+                    const __m128 results = _mm_loadu_ps( rhs + i );
+                    _mm_storeu_ps( result + i, _mm_blendv_ps(values, results, lane_mask(bits >> (i - begin))) );
+                }
+                for ( ; i < end; ++i )
+                {
+                    if ( (bits >> (i - begin)) & 1 )
+                    {
+                        result[i] = rhs[i];
+                    }
+                }
+            }
+        }
+    }
+}
+
+static REYES_TARGET_SSE4 void add_assign_sse4( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
+{
+    if ( !mask )
+    {
+        unsigned int i = 0;
+        for ( ; i + 4 <= length; i += 4 )
+        {
+            _mm_storeu_ps( result + i, _mm_add_ps(_mm_loadu_ps(result + i), _mm_loadu_ps(rhs + i)) );
+        }
+        simd_kernels( SIMD_SCALAR ).add_assign( result + i, rhs + i, nullptr, length - i );
+    }
+    else
+    {
+        for ( unsigned int begin = 0; begin < length; begin += MASK_WORD_BITS )
+        {
+            const uint64_t bits = mask[begin / MASK_WORD_BITS];
+            const unsigned int end = min( begin + MASK_WORD_BITS, length );
+            if ( bits == ~uint64_t(0) )
+            {
+                add_assign_sse4( result + begin, rhs + begin, nullptr, end - begin );
+            }
+            else if ( bits != 0 )
+            {
+                unsigned int i = begin;
+                for ( ; i + 4 <= end; i += 4 )
+                {
+                    const __m128 values = _mm_loadu_ps( result + i );
+                    const __m128 results = _mm_add_ps( values, _mm_loadu_ps(rhs + i) );
+                    _mm_storeu_ps( result + i, _mm_blendv_ps(values, results, lane_mask(bits >> (i - begin))) );
+                }
+                for ( ; i < end; ++i )
+                {
+                    if ( (bits >> (i - begin)) & 1 )
+                    {
+                        result[i] += rhs[i];
+                    }
+                }
+            }
+        }
+    }
+}
+
+static REYES_TARGET_SSE4 void subtract_assign_sse4( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
+{
+    if ( !mask )
+    {
+        unsigned int i = 0;
+        for ( ; i + 4 <= length; i += 4 )
+        {
+            _mm_storeu_ps( result + i, _mm_sub_ps(_mm_loadu_ps(result + i), _mm_loadu_ps(rhs + i)) );
+        }
+        simd_kernels( SIMD_SCALAR ).subtract_assign( result + i, rhs + i, nullptr, length - i );
+    }
+    else
+    {
+        for ( unsigned int begin = 0; begin < length; begin += MASK_WORD_BITS )
+        {
+            const uint64_t bits = mask[begin / MASK_WORD_BITS];
+            const unsigned int end = min( begin + MASK_WORD_BITS, length );
+            if ( bits == ~uint64_t(0) )
+            {
+                subtract_assign_sse4( result + begin, rhs + begin, nullptr, end - begin );
+            }
+            else if ( bits != 0 )
+            {
+                unsigned int i = begin;
+                for ( ; i + 4 <= end; i += 4 )
+                {
+                    const __m128 values = _mm_loadu_ps( result + i );
+                    const __m128 results = _mm_sub_ps( values, _mm_loadu_ps(rhs + i) );
+                    _mm_storeu_ps( result + i, _mm_blendv_ps(values, results, lane_mask(bits >> (i - begin))) );
+                }
+                for ( ; i < end; ++i )
+                {
+                    if ( (bits >> (i - begin)) & 1 )
+                    {
+                        result[i] -= rhs[i];
+                    }
+                }
+            }
+        }
+    }
+}
+
+static REYES_TARGET_SSE4 void multiply_assign_sse4( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
+{
+    if ( !mask )
+    {
+        unsigned int i = 0;
+        for ( ; i + 4 <= length; i += 4 )
+        {
+            _mm_storeu_ps( result + i, _mm_mul_ps(_mm_loadu_ps(result + i), _mm_loadu_ps(rhs + i)) );
+        }
+        simd_kernels( SIMD_SCALAR ).multiply_assign( result + i, rhs + i, nullptr, length - i );
+    }
+    else
+    {
+        for ( unsigned int begin = 0; begin < length; begin += MASK_WORD_BITS )
+        {
+            const uint64_t bits = mask[begin / MASK_WORD_BITS];
+            const unsigned int end = min( begin + MASK_WORD_BITS, length );
+            if ( bits == ~uint64_t(0) )
+            {
+                multiply_assign_sse4( result + begin, rhs + begin, nullptr, end - begin );
+            }
+            else if ( bits != 0 )
+            {
+                unsigned int i = begin;
+                for ( ; i + 4 <= end; i += 4 )
+                {
+                    const __m128 values = _mm_loadu_ps( result + i );
+                    const __m128 results = _mm_mul_ps( values, _mm_loadu_ps(rhs + i) );
+                    _mm_storeu_ps( result + i, _mm_blendv_ps(values, results, lane_mask(bits >> (i - begin))) );
+                }
+                for ( ; i < end; ++i )
+                {
+                    if ( (bits >> (i - begin)) & 1 )
+                    {
+                        result[i] *= rhs[i];
+                    }
+                }
+            }
+        }
+    }
+}
+
+static REYES_TARGET_SSE4 void divide_assign_sse4( float* result, const float* rhs, const uint64_t* mask, unsigned int length )
+{
+    if ( !mask )
+    {
+        unsigned int i = 0;
+        for ( ; i + 4 <= length; i += 4 )
+        {
+            _mm_storeu_ps( result + i, _mm_div_ps(_mm_loadu_ps(result + i), _mm_loadu_ps(rhs + i)) );
+        }
+        simd_kernels( SIMD_SCALAR ).divide_assign( result + i, rhs + i, nullptr, length - i );
+    }
+    else
+    {
+        for ( unsigned int begin = 0; begin < length; begin += MASK_WORD_BITS )
+        {
+            const uint64_t bits = mask[begin / MASK_WORD_BITS];
+            const unsigned int end = min( begin + MASK_WORD_BITS, length );
+            if ( bits == ~uint64_t(0) )
+            {
+                divide_assign_sse4( result + begin, rhs + begin, nullptr, end - begin );
+            }
+            else if ( bits != 0 )
+            {
+                unsigned int i = begin;
+                for ( ; i + 4 <= end; i += 4 )
+                {
+                    const __m128 values = _mm_loadu_ps( result + i );
+                    const __m128 results = _mm_div_ps( values, _mm_loadu_ps(rhs + i) );
+                    _mm_storeu_ps( result + i, _mm_blendv_ps(values, results, lane_mask(bits >> (i - begin))) );
+                }
+                for ( ; i < end; ++i )
+                {
+                    if ( (bits >> (i - begin)) & 1 )
+                    {
+                        result[i] /= rhs[i];
+                    }
+                }
+            }
+        }
+    }
+}
+
+static REYES_TARGET_SSE4 void equal_sse4( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    const __m128i one = _mm_set1_epi32( 1 );
+    unsigned int i = 0;
+    for ( ; i + 4 <= length; i += 4 )
+    {
+        const __m128 lanes = _mm_cmpeq_ps( _mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(result + i), _mm_and_si128(_mm_castps_si128(lanes), one) );
+    }
+    simd_kernels( SIMD_SCALAR ).equal( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_SSE4 void not_equal_sse4( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    const __m128i one = _mm_set1_epi32( 1 );
+    unsigned int i = 0;
+    for ( ; i + 4 <= length; i += 4 )
+    {
+        const __m128 lanes = _mm_cmpneq_ps( _mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(result + i), _mm_and_si128(_mm_castps_si128(lanes), one) );
+    }
+    simd_kernels( SIMD_SCALAR ).not_equal( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_SSE4 void less_sse4( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    const __m128i one = _mm_set1_epi32( 1 );
+    unsigned int i = 0;
+    for ( ; i + 4 <= length; i += 4 )
+    {
+        const __m128 lanes = _mm_cmplt_ps( _mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(result + i), _mm_and_si128(_mm_castps_si128(lanes), one) );
+    }
+    simd_kernels( SIMD_SCALAR ).less( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_SSE4 void less_equal_sse4( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    const __m128i one = _mm_set1_epi32( 1 );
+    unsigned int i = 0;
+    for ( ; i + 4 <= length; i += 4 )
+    {
+        const __m128 lanes = _mm_cmple_ps( _mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(result + i), _mm_and_si128(_mm_castps_si128(lanes), one) );
+    }
+    simd_kernels( SIMD_SCALAR ).less_equal( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_SSE4 void greater_sse4( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    const __m128i one = _mm_set1_epi32( 1 );
+    unsigned int i = 0;
+    for ( ; i + 4 <= length; i += 4 )
+    {
+        const __m128 lanes = _mm_cmpgt_ps( _mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(result + i), _mm_and_si128(_mm_castps_si128(lanes), one) );
+    }
+    simd_kernels( SIMD_SCALAR ).greater( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_SSE4 void greater_equal_sse4( int* result, const float* lhs, const float* rhs, unsigned int length )
+{
+    const __m128i one = _mm_set1_epi32( 1 );
+    unsigned int i = 0;
+    for ( ; i + 4 <= length; i += 4 )
+    {
+        const __m128 lanes = _mm_cmpge_ps( _mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(result + i), _mm_and_si128(_mm_castps_si128(lanes), one) );
+    }
+    simd_kernels( SIMD_SCALAR ).greater_equal( result + i, lhs + i, rhs + i, length - i );
+}
+
+static REYES_TARGET_SSE4 void dot_planes_sse4( float* result, const float* lhs, unsigned int lhs_stride, const float* rhs, unsigned int rhs_stride, unsigned int length )
+{
+    unsigned int i = 0;
+    for ( ; i + 4 <= length; i += 4 )
+    {
+        const __m128 x = _mm_mul_ps( _mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i) );
+        const __m128 y = _mm_mul_ps( _mm_loadu_ps(lhs + lhs_stride + i), _mm_loadu_ps(rhs + rhs_stride + i) );
+        const __m128 z = _mm_mul_ps( _mm_loadu_ps(lhs + 2 * lhs_stride + i), _mm_loadu_ps(rhs + 2 * rhs_stride + i) );
+        _mm_storeu_ps( result + i, _mm_add_ps(_mm_add_ps(x, y), z) );
+    }
+    simd_kernels( SIMD_SCALAR ).dot_planes( result + i, lhs + i, lhs_stride, rhs + i, rhs_stride, length - i );
+}
+
+static REYES_TARGET_SSE4 void normalize_planes_sse4( float* result, unsigned int result_stride, const float* rhs, unsigned int rhs_stride, unsigned int length )
+{
+    const __m128 zero = _mm_setzero_ps();
+    unsigned int i = 0;
+    for ( ; i + 4 <= length; i += 4 )
+    {
+        const __m128 x = _mm_loadu_ps( rhs + i );
+        const __m128 y = _mm_loadu_ps( rhs + rhs_stride + i );
+        const __m128 z = _mm_loadu_ps( rhs + 2 * rhs_stride + i );
+        const __m128 norm = _mm_sqrt_ps( _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)) );
+        const __m128 nonzero = _mm_cmpgt_ps( norm, zero );
+        _mm_storeu_ps( result + i, _mm_blendv_ps(x, _mm_div_ps(x, norm), nonzero) );
+        _mm_storeu_ps( result + result_stride + i, _mm_blendv_ps(y, _mm_div_ps(y, norm), nonzero) );
+        _mm_storeu_ps( result + 2 * result_stride + i, _mm_blendv_ps(z, _mm_div_ps(z, norm), nonzero) );
+    }
+    simd_kernels( SIMD_SCALAR ).normalize_planes( result + i, result_stride, rhs + i, rhs_stride, length - i );
+}
+
+static const SimdKernels SSE4_KERNELS =
+{
+    SIMD_SSE4,
+    &add_sse4,
+    &subtract_sse4,
+    &multiply_sse4,
+    &divide_sse4,
+    &assign_sse4,
+    &add_assign_sse4,
+    &subtract_assign_sse4,
+    &multiply_assign_sse4,
+    &divide_assign_sse4,
+    &equal_sse4,
+    &not_equal_sse4,
+    &less_sse4,
+    &less_equal_sse4,
+    &greater_sse4,
+    &greater_equal_sse4,
+    &dot_planes_sse4,
+    &normalize_planes_sse4
+};
+
+const SimdKernels* simd_sse4_kernels()
+{
+    return &SSE4_KERNELS;
+}
+
+}
+
+#else
+
+namespace reyes
+{
+
+const SimdKernels* simd_sse4_kernels()
+{
+    return nullptr;
+}
+
+}
+
+#endif